@@ -0,0 +1,1123 @@
+/**
+ * Headless rendering benchmark.
+ * Runs scripted scenes on a GLFW null platform window with an OSMesa
+ * software context, so it needs neither a display nor a GPU. Each scene
+ * renders a number of frames and prints one JSON object per line with
+ * frame time percentiles and per frame GL call counts.
+ *
+ * --capture records the measured frames of every scene run to a Y4M file,
+ * the readback and copy for the writer thread then count in the frame times.
+ *
+ * usage: opengl-bench [--frames N] [--scene NAME] [--capture FILE.y4m]
+ */
+#define GLXT_IMPLEMENTATION
+#define GLXT_WITH_IO_HELPER 1
+#ifndef GLXT_PROFILER_ENABLED
+    #define GLXT_PROFILER_ENABLED 1
+#endif
+#include "glxt.h"
+#define GLXT_COMMAND_IMPLEMENTATION
+#include "glxt_command.h"
+#define GLXT_MESH_IMPLEMENTATION
+#include "glxt_mesh.h"
+#define GLXT_BUFFER_POOL_IMPLEMENTATION
+#include "glxt_buffer_pool.h"
+#define GLXT_SHADER_IMPLEMENTATION
+#include "glxt_shader.h"
+#define GLXT_CAPTURE_IMPLEMENTATION
+#include "glxt_capture.h"
+#define GLXT_RENDER_QUEUE_IMPLEMENTATION
+#include "glxt_render_queue.h"
+#define GLXT_TRANSFORM_IMPLEMENTATION
+#include "glxt_transform.h"
+// Before glxt_bvh.h, which adds the glfwe event picker when it sees glfwe
+#include "glfwe.h"
+#define GLXT_BVH_IMPLEMENTATION
+#include "glxt_bvh.h"
+#define GLXT_ALLOCATOR_IMPLEMENTATION
+#include "glxt_allocator.h"
+#define GLXT_ATLAS_IMPLEMENTATION
+#include "glxt_atlas.h"
+#define GLXT_TEXT_IMPLEMENTATION
+#include "glxt_text.h"
+
+#include <GLFW/glfw3.h>
+#include <llama.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 360
+#define BENCH_DEFAULT_FRAMES 200
+#define BENCH_WARMUP_FRAMES 5
+
+#define TRIANGLES_PER_FRAME 50000
+#define DRAW_CALLS_PER_FRAME 2000
+#define UNIFORM_UPDATES_PER_FRAME 10000
+#define STREAM_TEXTURE_SIZE 512
+#define MATH_ELEMENTS 100000
+#define QUEUE_PROGRAMS 4
+#define QUEUE_TEXTURES 8
+#define QUEUE_MATERIALS 16
+#define TRANSFORM_NODES 100000
+#define TRANSFORM_ROOTS 1000
+#define TRANSFORM_MOVING_ROOTS 10
+#define BVH_BOXES 1000000
+#define BVH_WORLD_SIZE 1000.0f
+#define BVH_RAYS_PER_FRAME 100
+#define FILE_LOAD_SIZE (16 * 1024 * 1024)
+#define FILE_LOAD_PATH "./opengl-bench-file-load.bin"
+#define TEXT_LABELS 500
+#define TEXT_LABEL_LENGTH 100
+#define TEXT_SIZE 8.0f
+#define POOL_MESHES 1000
+#define POOL_MESH_MAX_VERTICES 64
+#define POOL_CHURN_PER_FRAME 50
+#define POOL_DEFRAGMENT_INTERVAL 20
+
+typedef struct BenchCounters {
+    size_t draw_calls;
+    size_t vertices;
+    size_t bytes_uploaded;
+    size_t state_calls;
+    size_t state_calls_elided;
+    size_t uniform_uploads;
+    size_t uniform_uploads_elided;
+} BenchCounters;
+
+/**
+ * reset and report may be NULL. reset runs after the warmup frames so the
+ * scene's own timers and totals only cover measured frames, report appends
+ * the scene's fields to its JSON line.
+ */
+typedef struct BenchScene {
+    const char* name;
+    bool (*init)(void);
+    void (*frame)(size_t frame);
+    void (*deinit)(void);
+    void (*reset)(void);
+    void (*report)(size_t frames);
+} BenchScene;
+
+static const char* quad_vert_source =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_pos;\n"
+    "uniform vec2 u_offset;\n"
+    "uniform float u_scale;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(a_pos * u_scale + u_offset, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* quad_frag_source =
+    "#version 330 core\n"
+    "layout(location = 0) out vec4 o_color;\n"
+    "uniform vec4 u_color;\n"
+    "void main() {\n"
+    "    o_color = u_color;\n"
+    "}\n";
+
+// Same quads as draw_calls, offset and color come from the instance stream
+static const char* instanced_vert_source =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_pos;\n"
+    "layout(location = 1) in vec2 i_offset;\n"
+    "layout(location = 2) in vec4 i_color;\n"
+    "uniform float u_scale;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(a_pos * u_scale + i_offset, 0.0, 1.0);\n"
+    "    v_color = i_color;\n"
+    "}\n";
+
+static const char* instanced_frag_source =
+    "#version 330 core\n"
+    "layout(location = 0) out vec4 o_color;\n"
+    "in vec4 v_color;\n"
+    "void main() {\n"
+    "    o_color = v_color;\n"
+    "}\n";
+
+typedef struct BenchInstance {
+    float offset[2];
+    float color[4];
+} BenchInstance;
+
+static const float quad_vertices[] = {
+    -1.0f, -1.0f,  1.0f, -1.0f,  1.0f,  1.0f,
+    -1.0f, -1.0f,  1.0f,  1.0f, -1.0f,  1.0f,
+};
+
+static struct {
+    uint32_t shader_program;
+    uint32_t vao;
+    uint32_t vbo;
+    GLXTUniform u_offset;
+    GLXTUniform u_scale;
+    GLXTUniform u_color;
+    GLXTTextureStream stream;
+    GLXTInstanceStream instances;
+    uint8_t* pixels;
+    vec4_t* points;
+    vec4_t* transformed;
+    mat4_t* matrices;
+    mat4_t* products;
+    double math_seconds;
+    uint32_t queue_programs[QUEUE_PROGRAMS];
+    GLXTUniform queue_offsets[QUEUE_PROGRAMS];
+    GLXTUniform queue_colors[QUEUE_PROGRAMS];
+    GLXTUniform queue_scales[QUEUE_PROGRAMS];
+    uint32_t queue_textures[QUEUE_TEXTURES];
+    GLXTRenderQueue queue;
+    GLXTRenderQueueStats queue_totals;
+    GLXTTransformHierarchy transforms;
+    GLXTTransformNode* transform_roots;
+    double transform_seconds;
+    double transform_static_seconds;
+    size_t transforms_updated;
+    GLXTBVH bvh;
+    GLXTAABB* bvh_boxes;
+    uint32_t* bvh_visible;
+    uint8_t* bvh_flags;
+    double bvh_build_seconds;
+    double bvh_refit_seconds;
+    double bvh_cull_seconds;
+    double bvh_batch_cull_seconds;
+    double bvh_ray_seconds;
+    size_t bvh_visible_count;
+    size_t bvh_ray_hits;
+    size_t bvh_pick_hits;
+    double file_view_seconds;
+    double file_fread_seconds;
+    uint64_t file_checksum;
+    GLXTFont text_font;
+    GLXTTextRenderer text;
+    char (*text_labels)[TEXT_LABEL_LENGTH + 1];
+    GLXTTextStats text_totals;
+    GLXTBufferPool pool;
+    GLXTBufferAllocation pool_meshes[POOL_MESHES];
+    double pool_churn_seconds;
+    double pool_defragment_seconds;
+    size_t pool_defragmentations;
+    size_t pool_bytes_moved;
+    size_t pool_stale_checks;
+    size_t pool_stale_accepted;
+} scene;
+
+static float bench_random(void)
+{
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static bool quad_init(void)
+{
+    scene.shader_program = glxt_create_shader_program(quad_vert_source, quad_frag_source);
+    if(scene.shader_program == 0) return false;
+    scene.u_offset = glxt_get_shader_uniform(scene.shader_program, "u_offset");
+    scene.u_scale = glxt_get_shader_uniform(scene.shader_program, "u_scale");
+    scene.u_color = glxt_get_shader_uniform(scene.shader_program, "u_color");
+
+    scene.vao = glxt_create_vertex_array();
+    glxt_enable_vertex_array(scene.vao);
+    scene.vbo = glxt_create_vertex_buffer(sizeof(quad_vertices), quad_vertices);
+    glxt_set_vertex_attrib(0, 2, GL_FLOAT, false, 2 * sizeof(float), (const void*)0);
+    glxt_disable_vertex_array();
+    return !glxt_has_failure();
+}
+
+static void quad_deinit(void)
+{
+    glxt_destroy_vertex_buffer(scene.vbo);
+    glxt_destroy_vertex_array(scene.vao);
+    glxt_destroy_shader_program(scene.shader_program);
+}
+
+static bool instanced_init(void)
+{
+    scene.shader_program = glxt_create_shader_program(instanced_vert_source, instanced_frag_source);
+    if(scene.shader_program == 0) return false;
+    scene.u_scale = glxt_get_shader_uniform(scene.shader_program, "u_scale");
+
+    scene.vao = glxt_create_vertex_array();
+    glxt_enable_vertex_array(scene.vao);
+    scene.vbo = glxt_create_vertex_buffer(sizeof(quad_vertices), quad_vertices);
+    glxt_set_vertex_attrib(0, 2, GL_FLOAT, false, 2 * sizeof(float), (const void*)0);
+    glxt_disable_vertex_array();
+
+    if(!glxt_create_instance_stream(&scene.instances, sizeof(BenchInstance), DRAW_CALLS_PER_FRAME))
+        return false;
+    glxt_add_instance_stream_attrib(&scene.instances, 1, 2, GL_FLOAT, false, offsetof(BenchInstance, offset));
+    glxt_add_instance_stream_attrib(&scene.instances, 2, 4, GL_FLOAT, false, offsetof(BenchInstance, color));
+    return !glxt_has_failure();
+}
+
+static void instanced_frame(size_t frame)
+{
+    const float scale = 0.01f;
+    BenchInstance* instances = glxt_begin_instance_stream_update(&scene.instances);
+    if(instances == NULL) return;
+    for(size_t i = 0; i < DRAW_CALLS_PER_FRAME; ++i) {
+        BenchInstance instance = {
+            .offset = { bench_random() * 2.0f - 1.0f, bench_random() * 2.0f - 1.0f },
+            .color = { (float)(i % 7) / 7.0f, (float)(i % 5) / 5.0f, (float)(i % 3) / 3.0f, 1.0f },
+        };
+        instances[i] = instance;
+    }
+    glxt_end_instance_stream_update(&scene.instances, DRAW_CALLS_PER_FRAME);
+
+    glxt_enable_shader_program(scene.shader_program);
+    glxt_enable_vertex_array(scene.vao);
+    glxt_enable_instance_stream(&scene.instances);
+    glxt_set_uniform(scene.u_scale, &scale, 1);
+    glxt_draw_arrays_instanced(GL_TRIANGLES, 0, 6, (int)scene.instances.instances_count);
+}
+
+static void instanced_deinit(void)
+{
+    glxt_destroy_instance_stream(&scene.instances);
+    quad_deinit();
+}
+
+static bool triangles_init(void)
+{
+    return glxt_batch_init(TRIANGLES_PER_FRAME * 3);
+}
+
+static void triangles_frame(size_t frame)
+{
+    glxt_batch_begin();
+    for(size_t i = 0; i < TRIANGLES_PER_FRAME; ++i) {
+        float x = bench_random() * 2.0f - 1.0f;
+        float y = bench_random() * 2.0f - 1.0f;
+        GLXTBatchVertex a = { .pos = { x, y }, .color = { 1.0f, 0.5f, 0.2f, 1.0f } };
+        GLXTBatchVertex b = { .pos = { x + 0.01f, y }, .color = { 0.2f, 1.0f, 0.5f, 1.0f } };
+        GLXTBatchVertex c = { .pos = { x, y + 0.01f }, .color = { 0.5f, 0.2f, 1.0f, 1.0f } };
+        glxt_batch_push_triangle(a, b, c);
+    }
+    glxt_batch_end();
+}
+
+static void triangles_deinit(void)
+{
+    glxt_batch_deinit();
+}
+
+static void draw_calls_frame(size_t frame)
+{
+    const float scale = 0.01f;
+    glxt_enable_shader_program(scene.shader_program);
+    glxt_enable_vertex_array(scene.vao);
+    glxt_set_uniform(scene.u_scale, &scale, 1);
+    for(size_t i = 0; i < DRAW_CALLS_PER_FRAME; ++i) {
+        float offset[2] = { bench_random() * 2.0f - 1.0f, bench_random() * 2.0f - 1.0f };
+        float color[4] = { (float)(i % 7) / 7.0f, (float)(i % 5) / 5.0f, (float)(i % 3) / 3.0f, 1.0f };
+        glxt_set_uniform(scene.u_offset, offset, 1);
+        glxt_set_uniform(scene.u_color, color, 1);
+        glxt_draw_vertex_array(0, 6);
+    }
+}
+
+// Mostly redundant updates, this measures how much the uniform cache saves
+static void uniforms_frame(size_t frame)
+{
+    const float scale = 0.5f;
+    const float offset[2] = { 0.0f, 0.0f };
+    glxt_enable_shader_program(scene.shader_program);
+    glxt_enable_vertex_array(scene.vao);
+    for(size_t i = 0; i < UNIFORM_UPDATES_PER_FRAME; ++i) {
+        float color[4] = { (float)((frame + i / 100) % 10) / 10.0f, 0.5f, 0.5f, 1.0f };
+        glxt_set_uniform(scene.u_scale, &scale, 1);
+        glxt_set_uniform(scene.u_offset, offset, 1);
+        glxt_set_uniform(scene.u_color, color, 1);
+    }
+    glxt_draw_vertex_array(0, 6);
+}
+
+static bool texture_uploads_init(void)
+{
+    GLXTTexture2DDesc desc = {
+        .width = STREAM_TEXTURE_SIZE,
+        .height = STREAM_TEXTURE_SIZE,
+        .internal_format = GL_RGBA8,
+        .format = GL_RGBA,
+        .type = GL_UNSIGNED_BYTE,
+    };
+    scene.pixels = malloc(STREAM_TEXTURE_SIZE * STREAM_TEXTURE_SIZE * 4);
+    if(scene.pixels == NULL) return false;
+    if(!glxt_create_texture_stream(&scene.stream, &desc)) return false;
+    return glxt_batch_init(6);
+}
+
+static void texture_uploads_frame(size_t frame)
+{
+    memset(scene.pixels, (int)(frame & 0xFF), STREAM_TEXTURE_SIZE * STREAM_TEXTURE_SIZE * 4);
+    glxt_update_texture_stream(&scene.stream, 0, 0, STREAM_TEXTURE_SIZE, STREAM_TEXTURE_SIZE, scene.pixels);
+
+    GLXTBatchVertex a = { .pos = { -1.0f, -1.0f }, .color = { 1, 1, 1, 1 }, .uv = { 0.0f, 0.0f } };
+    GLXTBatchVertex b = { .pos = {  1.0f, -1.0f }, .color = { 1, 1, 1, 1 }, .uv = { 1.0f, 0.0f } };
+    GLXTBatchVertex c = { .pos = {  1.0f,  1.0f }, .color = { 1, 1, 1, 1 }, .uv = { 1.0f, 1.0f } };
+    GLXTBatchVertex d = { .pos = { -1.0f,  1.0f }, .color = { 1, 1, 1, 1 }, .uv = { 0.0f, 1.0f } };
+    glxt_batch_begin();
+    glxt_batch_set_material(0, scene.stream.texture);
+    glxt_batch_push_quad(a, b, c, d);
+    glxt_batch_end();
+}
+
+static void texture_uploads_deinit(void)
+{
+    glxt_batch_deinit();
+    glxt_destroy_texture_stream(&scene.stream);
+    free(scene.pixels);
+}
+
+static bool render_queue_init(void)
+{
+    if(!quad_init()) return false;
+    for(size_t i = 0; i < QUEUE_PROGRAMS; ++i) {
+        scene.queue_programs[i] = glxt_create_shader_program(quad_vert_source, quad_frag_source);
+        if(scene.queue_programs[i] == 0) return false;
+        scene.queue_offsets[i] = glxt_get_shader_uniform(scene.queue_programs[i], "u_offset");
+        scene.queue_colors[i] = glxt_get_shader_uniform(scene.queue_programs[i], "u_color");
+        scene.queue_scales[i] = glxt_get_shader_uniform(scene.queue_programs[i], "u_scale");
+    }
+    for(size_t i = 0; i < QUEUE_TEXTURES; ++i) {
+        uint8_t texel[4] = { (uint8_t)(i * 32), 128, 255, 255 };
+        scene.queue_textures[i] = glxt_create_texture2d(1, 1, 4, texel);
+    }
+    glxt_render_queue_init(&scene.queue);
+    memset(&scene.queue_totals, 0, sizeof(scene.queue_totals));
+    return !glxt_has_failure();
+}
+
+// The draw_calls quads spread over programs, textures and materials in random order
+static void render_queue_frame(size_t frame)
+{
+    const float scale = 0.01f;
+    for(size_t i = 0; i < DRAW_CALLS_PER_FRAME; ++i) {
+        size_t program = (size_t)rand() % QUEUE_PROGRAMS;
+        size_t material = (size_t)rand() % QUEUE_MATERIALS;
+        float offset[2] = { bench_random() * 2.0f - 1.0f, bench_random() * 2.0f - 1.0f };
+        float color[4] = { (float)material / QUEUE_MATERIALS, 0.5f, 0.5f, material % 4 == 0 ? 0.5f : 1.0f };
+        GLXTRenderDraw draw = {
+            .translucent = material % 4 == 0,
+            .material = (uint32_t)material,
+            .depth = bench_random(),
+            .shader_program = scene.queue_programs[program],
+            .vao = scene.vao,
+            .texture = scene.queue_textures[(size_t)rand() % QUEUE_TEXTURES],
+            .mode = GL_TRIANGLES,
+            .count = 6,
+        };
+        GLXTRenderUniform uniforms[] = {
+            { scene.queue_scales[program], &scale, 1, sizeof(scale) },
+            { scene.queue_offsets[program], offset, 1, sizeof(offset) },
+            { scene.queue_colors[program], color, 1, sizeof(color) },
+        };
+        glxt_render_queue_push(&scene.queue, &draw, uniforms, 3);
+    }
+    glxt_render_queue_flush(&scene.queue);
+
+    // Only the measured frames, run_scene resets the counters after the warmup
+    if(frame < BENCH_WARMUP_FRAMES) return;
+    GLXTRenderQueueStats stats = glxt_render_queue_stats(&scene.queue);
+    scene.queue_totals.draws += stats.draws;
+    scene.queue_totals.program_changes_submitted += stats.program_changes_submitted;
+    scene.queue_totals.program_changes_sorted += stats.program_changes_sorted;
+    scene.queue_totals.texture_changes_submitted += stats.texture_changes_submitted;
+    scene.queue_totals.texture_changes_sorted += stats.texture_changes_sorted;
+    scene.queue_totals.material_changes_submitted += stats.material_changes_submitted;
+    scene.queue_totals.material_changes_sorted += stats.material_changes_sorted;
+}
+
+static void render_queue_deinit(void)
+{
+    glxt_render_queue_deinit(&scene.queue);
+    for(size_t i = 0; i < QUEUE_TEXTURES; ++i) glxt_destroy_texture2d(scene.queue_textures[i]);
+    for(size_t i = 0; i < QUEUE_PROGRAMS; ++i) glxt_destroy_shader_program(scene.queue_programs[i]);
+    quad_deinit();
+}
+
+static void render_queue_reset(void)
+{
+    memset(&scene.queue_totals, 0, sizeof(scene.queue_totals));
+}
+
+static void render_queue_report(size_t frames)
+{
+    // Per frame state changes in submission order against sorted order
+    const GLXTRenderQueueStats* totals = &scene.queue_totals;
+    printf(",\"queue\":{\"program_changes\":[%.1f,%.1f],\"texture_changes\":[%.1f,%.1f],"
+        "\"material_changes\":[%.1f,%.1f]}",
+        (double)totals->program_changes_submitted / frames, (double)totals->program_changes_sorted / frames,
+        (double)totals->texture_changes_submitted / frames, (double)totals->texture_changes_sorted / frames,
+        (double)totals->material_changes_submitted / frames, (double)totals->material_changes_sorted / frames);
+}
+
+static bool math_init(void)
+{
+    scene.points = malloc(sizeof(vec4_t) * MATH_ELEMENTS);
+    scene.transformed = malloc(sizeof(vec4_t) * MATH_ELEMENTS);
+    scene.matrices = malloc(sizeof(mat4_t) * MATH_ELEMENTS);
+    scene.products = malloc(sizeof(mat4_t) * MATH_ELEMENTS);
+    if(scene.points == NULL || scene.transformed == NULL || scene.matrices == NULL || scene.products == NULL)
+        return false;
+    for(size_t i = 0; i < MATH_ELEMENTS; ++i) {
+        scene.points[i] = vec4(bench_random(), bench_random(), bench_random(), 1.0f);
+        scene.matrices[i] = mat4_translation(vec3(bench_random(), bench_random(), bench_random()));
+    }
+    scene.math_seconds = 0.0;
+    return true;
+}
+
+// CPU only, reports llama.h throughput per element in the scene extras
+static void math_frame(size_t frame)
+{
+    mat4_t m = mat4_dot(mat4_euler_xyz(0.1f * frame, 0.2f, 0.3f), mat4_translation(vec3(1.0f, 2.0f, 3.0f)));
+    uint64_t start = glfwGetTimerValue();
+    mat4_transform_vec4_array(m, scene.points, scene.transformed, MATH_ELEMENTS);
+    mat4_dot_array(scene.matrices, scene.matrices, scene.products, MATH_ELEMENTS);
+    for(size_t i = 0; i < MATH_ELEMENTS; i += 64)
+        scene.products[i] = mat4_inverse(scene.matrices[i]);
+    scene.math_seconds += (double)(glfwGetTimerValue() - start) / glfwGetTimerFrequency();
+}
+
+static void math_deinit(void)
+{
+    free(scene.points);
+    free(scene.transformed);
+    free(scene.matrices);
+    free(scene.products);
+}
+
+static void math_reset(void)
+{
+    scene.math_seconds = 0.0;
+}
+
+static void math_report(size_t frames)
+{
+    // Per frame: one vec4 transform and one mat4 dot per element, plus an inverse every 64
+    printf(",\"math_ns_per_element\":%.3f", scene.math_seconds * 1e9 / ((double)frames * MATH_ELEMENTS));
+}
+
+static bool transforms_init(void)
+{
+    scene.transform_roots = malloc(sizeof(GLXTTransformNode) * TRANSFORM_ROOTS);
+    if(scene.transform_roots == NULL) return false;
+    if(!glxt_transform_hierarchy_init(&scene.transforms, TRANSFORM_NODES, 0)) return false;
+
+    // Every root gets a random tree, each node under an earlier node of its tree
+    size_t per_root = TRANSFORM_NODES / TRANSFORM_ROOTS;
+    GLXTTransformNode tree[TRANSFORM_NODES / TRANSFORM_ROOTS];
+    for(size_t root = 0; root < TRANSFORM_ROOTS; ++root) {
+        for(size_t i = 0; i < per_root; ++i) {
+            GLXTTransformNode parent = i > 0 ? tree[(size_t)rand() % i] : 0;
+            tree[i] = glxt_transform_create(&scene.transforms, parent);
+            if(tree[i] == 0) return false;
+            glxt_transform_set_local(&scene.transforms, tree[i],
+                vec3(bench_random(), bench_random(), bench_random()),
+                vec3(bench_random(), bench_random(), bench_random()), vec3(1.0f, 1.0f, 1.0f));
+        }
+        scene.transform_roots[root] = tree[0];
+    }
+    glxt_transform_update(&scene.transforms);
+    scene.transform_seconds = 0.0;
+    scene.transform_static_seconds = 0.0;
+    scene.transforms_updated = 0;
+    return true;
+}
+
+// CPU only, a few subtrees move per frame and the rest of the scene is static
+static void transforms_frame(size_t frame)
+{
+    for(size_t i = 0; i < TRANSFORM_MOVING_ROOTS; ++i) {
+        size_t root = (frame * TRANSFORM_MOVING_ROOTS + i) % TRANSFORM_ROOTS;
+        glxt_transform_set_rotation(&scene.transforms, scene.transform_roots[root], vec3(0.0f, 0.01f * frame, 0.0f));
+    }
+    uint64_t start = glfwGetTimerValue();
+    glxt_transform_update(&scene.transforms);
+    uint64_t middle = glfwGetTimerValue();
+    scene.transforms_updated += glxt_transform_stats(&scene.transforms).updated;
+    glxt_transform_update(&scene.transforms);
+    uint64_t end = glfwGetTimerValue();
+    scene.transform_seconds += (double)(middle - start) / glfwGetTimerFrequency();
+    scene.transform_static_seconds += (double)(end - middle) / glfwGetTimerFrequency();
+}
+
+static void transforms_deinit(void)
+{
+    glxt_transform_hierarchy_deinit(&scene.transforms);
+    free(scene.transform_roots);
+}
+
+static void transforms_reset(void)
+{
+    scene.transform_seconds = 0.0;
+    scene.transform_static_seconds = 0.0;
+    scene.transforms_updated = 0;
+}
+
+static void transforms_report(size_t frames)
+{
+    // The second update of a frame has nothing dirty, it is the cost of a static scene
+    printf(",\"transforms\":{\"nodes\":%d,\"update_us\":%.3f,\"static_update_us\":%.3f,"
+        "\"updated_per_frame\":%.1f}",
+        TRANSFORM_NODES, scene.transform_seconds * 1e6 / frames, scene.transform_static_seconds * 1e6 / frames,
+        (double)scene.transforms_updated / frames);
+}
+
+static void bvh_reset(void)
+{
+    scene.bvh_refit_seconds = 0.0;
+    scene.bvh_cull_seconds = 0.0;
+    scene.bvh_batch_cull_seconds = 0.0;
+    scene.bvh_ray_seconds = 0.0;
+    scene.bvh_visible_count = 0;
+    scene.bvh_ray_hits = 0;
+    scene.bvh_pick_hits = 0;
+}
+
+static bool bvh_init(void)
+{
+    scene.bvh_boxes = malloc(sizeof(GLXTAABB) * BVH_BOXES);
+    scene.bvh_visible = malloc(sizeof(uint32_t) * BVH_BOXES);
+    scene.bvh_flags = malloc(BVH_BOXES);
+    if(scene.bvh_boxes == NULL || scene.bvh_visible == NULL || scene.bvh_flags == NULL) return false;
+    for(size_t i = 0; i < BVH_BOXES; ++i) {
+        vec3_t center = vec3((bench_random() - 0.5f) * BVH_WORLD_SIZE, (bench_random() - 0.5f) * 0.1f * BVH_WORLD_SIZE,
+            (bench_random() - 0.5f) * BVH_WORLD_SIZE);
+        float half = 0.1f + bench_random();
+        scene.bvh_boxes[i].min = vec3(center.x - half, center.y - half, center.z - half);
+        scene.bvh_boxes[i].max = vec3(center.x + half, center.y + half, center.z + half);
+    }
+
+    glxt_bvh_init(&scene.bvh);
+    uint64_t start = glfwGetTimerValue();
+    if(!glxt_bvh_build(&scene.bvh, scene.bvh_boxes, BVH_BOXES)) return false;
+    scene.bvh_build_seconds = (double)(glfwGetTimerValue() - start) / glfwGetTimerFrequency();
+    bvh_reset();
+    return true;
+}
+
+// CPU only: every box moves a little, then a turning camera culls and picks
+static void bvh_frame(size_t frame)
+{
+    float step = (frame & 1) ? -0.05f : 0.05f;
+    for(size_t i = 0; i < BVH_BOXES; ++i) {
+        scene.bvh_boxes[i].min.y += step;
+        scene.bvh_boxes[i].max.y += step;
+    }
+    double frequency = (double)glfwGetTimerFrequency();
+    uint64_t start = glfwGetTimerValue();
+    glxt_bvh_refit(&scene.bvh, scene.bvh_boxes);
+    uint64_t refitted = glfwGetTimerValue();
+
+    mat4_t view = mat4_dot(mat4_translation(vec3(0.0f, -20.0f, 0.0f)), mat4_euler_xyz(0.0f, 0.05f * frame, 0.0f));
+    mat4_t projection = mat4_perspective(1.0f, (float)BENCH_WIDTH / BENCH_HEIGHT, 0.1f, 300.0f);
+    mat4_t view_projection = mat4_dot(view, projection);
+    GLXTFrustum frustum = glxt_frustum_from_matrix(view_projection);
+    uint64_t cull_start = glfwGetTimerValue();
+    scene.bvh_visible_count += glxt_bvh_cull(&scene.bvh, &frustum, scene.bvh_visible, BVH_BOXES);
+    uint64_t culled = glfwGetTimerValue();
+    glxt_frustum_cull_aabbs(&frustum, scene.bvh_boxes, BVH_BOXES, scene.bvh_flags);
+    uint64_t batch_culled = glfwGetTimerValue();
+
+    mat4_t inverse = mat4_inverse(view_projection);
+    GLXTRay rays[BVH_RAYS_PER_FRAME];
+    for(size_t i = 0; i < BVH_RAYS_PER_FRAME; ++i)
+        rays[i] = glxt_ray_from_cursor(bench_random() * BENCH_WIDTH, bench_random() * BENCH_HEIGHT,
+            BENCH_WIDTH, BENCH_HEIGHT, inverse);
+    uint64_t rays_start = glfwGetTimerValue();
+    for(size_t i = 0; i < BVH_RAYS_PER_FRAME; ++i) {
+        GLXTRayHit hit;
+        scene.bvh_ray_hits += glxt_bvh_raycast(&scene.bvh, &rays[i], LLAMA_INFINITY, NULL, NULL, &hit);
+    }
+    uint64_t end = glfwGetTimerValue();
+
+    // One scripted click per frame through the same path a window's glfwe events take
+    GLXTBVHPicker picker = { .width = BENCH_WIDTH, .height = BENCH_HEIGHT, .inverse_view_projection = inverse };
+    GLFWEEvent events[2] = {
+        { .type = GLFWE_EVENT_CURSOR_MOVED,
+            .mouse = { (int)(bench_random() * BENCH_WIDTH), (int)(bench_random() * BENCH_HEIGHT) } },
+        { .type = GLFWE_EVENT_MOUSE_KEY_LEFT_DOWN },
+    };
+    for(size_t i = 0; i < 2; ++i) {
+        GLXTRayHit hit;
+        scene.bvh_pick_hits += glxt_bvh_pick_event(&scene.bvh, &picker, &events[i], NULL, NULL, &hit);
+    }
+
+    scene.bvh_refit_seconds += (double)(refitted - start) / frequency;
+    scene.bvh_cull_seconds += (double)(culled - cull_start) / frequency;
+    scene.bvh_batch_cull_seconds += (double)(batch_culled - culled) / frequency;
+    scene.bvh_ray_seconds += (double)(end - rays_start) / frequency;
+}
+
+static void bvh_deinit(void)
+{
+    glxt_bvh_deinit(&scene.bvh);
+    free(scene.bvh_boxes);
+    free(scene.bvh_visible);
+    free(scene.bvh_flags);
+}
+
+static void bvh_report(size_t frames)
+{
+    // Tree against brute force culling of the same boxes
+    printf(",\"bvh\":{\"boxes\":%d,\"nodes\":%zu,\"depth\":%u,\"build_ms\":%.3f,\"refit_ms\":%.3f,"
+        "\"cull_ms\":%.3f,\"batch_cull_ms\":%.3f,\"ray_us\":%.3f,\"visible\":%.1f,\"ray_hits\":%.1f,"
+        "\"pick_hits\":%.2f}",
+        BVH_BOXES, scene.bvh.nodes_count, scene.bvh.depth, scene.bvh_build_seconds * 1e3,
+        scene.bvh_refit_seconds * 1e3 / frames, scene.bvh_cull_seconds * 1e3 / frames,
+        scene.bvh_batch_cull_seconds * 1e3 / frames,
+        scene.bvh_ray_seconds * 1e6 / ((double)frames * BVH_RAYS_PER_FRAME),
+        (double)scene.bvh_visible_count / frames, (double)scene.bvh_ray_hits / frames,
+        (double)scene.bvh_pick_hits / frames);
+}
+
+static bool file_load_init(void)
+{
+    uint32_t* words = malloc(FILE_LOAD_SIZE);
+    if(words == NULL) return false;
+    for(size_t i = 0; i < FILE_LOAD_SIZE / sizeof(uint32_t); ++i) words[i] = (uint32_t)rand();
+    FILE* f = fopen(FILE_LOAD_PATH, "wb");
+    bool written = f != NULL && fwrite(words, 1, FILE_LOAD_SIZE, f) == FILE_LOAD_SIZE;
+    if(f != NULL) fclose(f);
+    free(words);
+    scene.file_view_seconds = 0.0;
+    scene.file_fread_seconds = 0.0;
+    scene.file_checksum = 0;
+    return written;
+}
+
+static uint64_t file_load_checksum(const char* data, size_t size)
+{
+    uint64_t sum = 0;
+    for(size_t i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum += word;
+    }
+    return sum;
+}
+
+// CPU only: the same file through glxt_load_file and through the fread helpers, both read to the end
+static void file_load_frame(size_t frame)
+{
+    double frequency = (double)glfwGetTimerFrequency();
+    uint64_t start = glfwGetTimerValue();
+    GLXTFileView view;
+    if(glxt_load_file(FILE_LOAD_PATH, &view)) {
+        scene.file_checksum += file_load_checksum(view.data, view.size);
+        glxt_release_file(&view);
+    }
+    uint64_t viewed = glfwGetTimerValue();
+
+    size_t size = glxt_get_file_size_path(FILE_LOAD_PATH);
+    char* data = malloc(size + 1);
+    if(data != NULL) {
+        glxt_read_file_data_path(FILE_LOAD_PATH, data);
+        data[size] = '\0';
+        scene.file_checksum -= file_load_checksum(data, size);
+        free(data);
+    }
+    uint64_t end = glfwGetTimerValue();
+
+    scene.file_view_seconds += (double)(viewed - start) / frequency;
+    scene.file_fread_seconds += (double)(end - viewed) / frequency;
+}
+
+static void file_load_deinit(void)
+{
+    remove(FILE_LOAD_PATH);
+}
+
+static void file_load_reset(void)
+{
+    scene.file_view_seconds = 0.0;
+    scene.file_fread_seconds = 0.0;
+}
+
+static void file_load_report(size_t frames)
+{
+    // Both paths read the same bytes, a non-zero checksum means they disagreed
+    double megabytes = (double)FILE_LOAD_SIZE * frames / (1024.0 * 1024.0);
+    printf(",\"file_load\":{\"bytes\":%d,\"view_mb_s\":%.1f,\"fread_mb_s\":%.1f,\"checksum\":%llu}",
+        FILE_LOAD_SIZE, megabytes / scene.file_view_seconds, megabytes / scene.file_fread_seconds,
+        (unsigned long long)scene.file_checksum);
+}
+
+static bool text_init(void)
+{
+    scene.text_labels = malloc(sizeof(*scene.text_labels) * TEXT_LABELS);
+    if(scene.text_labels == NULL) return false;
+    for(size_t i = 0; i < TEXT_LABELS; ++i) {
+        for(size_t j = 0; j < TEXT_LABEL_LENGTH; ++j)
+            scene.text_labels[i][j] = (char)('!' + (i * 7 + j) % ('~' - '!' + 1));
+        scene.text_labels[i][TEXT_LABEL_LENGTH] = '\0';
+    }
+    if(!glxt_font_init(&scene.text_font, &(GLXTFontDesc){ 0 })) return false;
+    if(!glxt_text_renderer_init(&scene.text)) return false;
+    memset(&scene.text_totals, 0, sizeof(scene.text_totals));
+    return true;
+}
+
+// 50k static glyphs in labels plus one counter that changes every frame
+static void text_frame(size_t frame)
+{
+    const float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    char counter[32];
+    snprintf(counter, sizeof(counter), "frame %zu", frame);
+
+    glxt_text_begin(&scene.text);
+    for(size_t i = 0; i < TEXT_LABELS; ++i) {
+        float y = (float)((i % (BENCH_HEIGHT / 8)) * 8);
+        float x = (float)((i / (BENCH_HEIGHT / 8)) * 8);
+        glxt_text_add(&scene.text, &scene.text_font, scene.text_labels[i], x, y, TEXT_SIZE, color);
+    }
+    glxt_text_add(&scene.text, &scene.text_font, counter, 0.0f, 0.0f, 2.0f * TEXT_SIZE, color);
+    glxt_text_draw(&scene.text, BENCH_WIDTH, BENCH_HEIGHT);
+
+    GLXTTextStats stats = glxt_text_stats(&scene.text);
+    scene.text_totals.glyphs += stats.glyphs;
+    scene.text_totals.glyphs_shaped += stats.glyphs_shaped;
+    scene.text_totals.runs_cached += stats.runs_cached;
+    scene.text_totals.instances_uploaded += stats.instances_uploaded;
+}
+
+static void text_deinit(void)
+{
+    glxt_text_renderer_deinit(&scene.text);
+    glxt_font_deinit(&scene.text_font);
+    free(scene.text_labels);
+}
+
+static void text_reset(void)
+{
+    memset(&scene.text_totals, 0, sizeof(scene.text_totals));
+}
+
+static void text_report(size_t frames)
+{
+    // Static labels are neither shaped nor uploaded again after the first frame
+    printf(",\"text\":{\"glyphs\":%.1f,\"glyphs_shaped\":%.1f,\"runs_cached\":%.1f,"
+        "\"instances_uploaded\":%.1f}",
+        (double)scene.text_totals.glyphs / frames, (double)scene.text_totals.glyphs_shaped / frames,
+        (double)scene.text_totals.runs_cached / frames, (double)scene.text_totals.instances_uploaded / frames);
+}
+
+// A random polygon of 3 to POOL_MESH_MAX_VERTICES vertices somewhere on screen, as a triangle fan
+static GLXTBufferAllocation buffer_pool_add_mesh(void)
+{
+    float vertices[POOL_MESH_MAX_VERTICES * 2];
+    uint16_t indices[(POOL_MESH_MAX_VERTICES - 2) * 3];
+    size_t vertices_count = 3 + (size_t)rand() % (POOL_MESH_MAX_VERTICES - 2);
+    float x = bench_random() * 2.0f - 1.0f, y = bench_random() * 2.0f - 1.0f;
+    for(size_t i = 0; i < vertices_count; ++i) {
+        float angle = 2.0f * LLAMA_PI * (float)i / (float)vertices_count;
+        vertices[i * 2 + 0] = x + 0.02f * cosf(angle);
+        vertices[i * 2 + 1] = y + 0.02f * sinf(angle);
+    }
+    for(size_t i = 0; i + 2 < vertices_count; ++i) {
+        indices[i * 3 + 0] = 0;
+        indices[i * 3 + 1] = (uint16_t)(i + 1);
+        indices[i * 3 + 2] = (uint16_t)(i + 2);
+    }
+    return glxt_buffer_pool_add(&scene.pool, vertices, vertices_count, indices, GL_UNSIGNED_SHORT,
+        (vertices_count - 2) * 3);
+}
+
+/**
+ * Frees the mesh at index and adds a new one in its place. The pool hands
+ * out the lowest unused slot and this is the only one, so the new mesh
+ * reuses the freed slot and the old handle has to be rejected from now on.
+ */
+static bool buffer_pool_replace_mesh(size_t index)
+{
+    GLXTBufferAllocation stale = scene.pool_meshes[index];
+    glxt_buffer_pool_free(&scene.pool, stale);
+    scene.pool_meshes[index] = buffer_pool_add_mesh();
+    if(scene.pool_meshes[index] == 0) return false;
+
+    bool reused = (scene.pool_meshes[index] & 0xFFFFFF) == (stale & 0xFFFFFF);
+    bool accepted = glxt_buffer_pool_range(&scene.pool, stale).vertices_count != 0;
+    scene.pool_stale_checks += reused;
+    scene.pool_stale_accepted += reused && accepted;
+    return reused && !accepted;
+}
+
+static bool buffer_pool_init(void)
+{
+    if(!quad_init()) return false;
+    const GLXTMeshAttrib attribs[] = { { 0, 2, GL_FLOAT, false, 0 } };
+    GLXTBufferPoolDesc desc = {
+        .vertex_size = 2 * sizeof(float),
+        .max_vertices = POOL_MESHES * POOL_MESH_MAX_VERTICES,
+        .max_indices = POOL_MESHES * (POOL_MESH_MAX_VERTICES - 2) * 3,
+        .dynamic = true,
+        .attribs = attribs,
+        .attribs_count = 1,
+    };
+    if(!glxt_buffer_pool_init(&scene.pool, &desc)) return false;
+    for(size_t i = 0; i < POOL_MESHES; ++i) {
+        scene.pool_meshes[i] = buffer_pool_add_mesh();
+        if(scene.pool_meshes[i] == 0) return false;
+    }
+
+    scene.pool_stale_checks = 0;
+    scene.pool_stale_accepted = 0;
+    if(!buffer_pool_replace_mesh(0)) {
+        fprintf(stderr, "buffer_pool: a freed handle was still accepted after its slot was reused\n");
+        return false;
+    }
+    return !glxt_has_failure();
+}
+
+// Meshes come and go every frame, the pool is compacted every POOL_DEFRAGMENT_INTERVAL frames
+static void buffer_pool_frame(size_t frame)
+{
+    double frequency = (double)glfwGetTimerFrequency();
+    uint64_t start = glfwGetTimerValue();
+    for(size_t i = 0; i < POOL_CHURN_PER_FRAME; ++i) buffer_pool_replace_mesh((size_t)rand() % POOL_MESHES);
+    uint64_t churned = glfwGetTimerValue();
+    if(frame % POOL_DEFRAGMENT_INTERVAL == 0) glxt_buffer_pool_defragment(&scene.pool);
+    uint64_t end = glfwGetTimerValue();
+    scene.pool_churn_seconds += (double)(churned - start) / frequency;
+    scene.pool_defragment_seconds += (double)(end - churned) / frequency;
+
+    const float scale = 1.0f;
+    const float offset[2] = { 0.0f, 0.0f };
+    const float color[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+    glxt_enable_shader_program(scene.shader_program);
+    glxt_set_uniform(scene.u_scale, &scale, 1);
+    glxt_set_uniform(scene.u_offset, offset, 1);
+    glxt_set_uniform(scene.u_color, color, 1);
+    glxt_buffer_pool_enable(&scene.pool);
+    for(size_t i = 0; i < POOL_MESHES; ++i) glxt_buffer_pool_draw(&scene.pool, scene.pool_meshes[i], GL_TRIANGLES);
+}
+
+static void buffer_pool_deinit(void)
+{
+    glxt_buffer_pool_deinit(&scene.pool);
+    quad_deinit();
+}
+
+static void buffer_pool_reset(void)
+{
+    GLXTBufferPoolStats stats = glxt_buffer_pool_stats(&scene.pool);
+    scene.pool_churn_seconds = 0.0;
+    scene.pool_defragment_seconds = 0.0;
+    scene.pool_defragmentations = stats.defragmentations;
+    scene.pool_bytes_moved = stats.bytes_moved;
+}
+
+static void buffer_pool_report(size_t frames)
+{
+    // stale_accepted counts freed handles the pool took after their slot was reused, anything but 0 is a bug
+    GLXTBufferPoolStats stats = glxt_buffer_pool_stats(&scene.pool);
+    printf(",\"buffer_pool\":{\"meshes\":%d,\"churn_us\":%.3f,\"defragment_ms\":%.3f,"
+        "\"defragmentations\":%zu,\"bytes_moved\":%.1f,\"vertices_used\":%zu,\"largest_free_vertices\":%zu,"
+        "\"stale_checks\":%zu,\"stale_accepted\":%zu}",
+        POOL_MESHES, scene.pool_churn_seconds * 1e6 / frames, scene.pool_defragment_seconds * 1e3 / frames,
+        stats.defragmentations - scene.pool_defragmentations,
+        (double)(stats.bytes_moved - scene.pool_bytes_moved) / frames,
+        stats.vertices_used, stats.largest_free_vertices, scene.pool_stale_checks, scene.pool_stale_accepted);
+}
+
+static const BenchScene scenes[] = {
+    { "triangles", triangles_init, triangles_frame, triangles_deinit, NULL, NULL },
+    { "draw_calls", quad_init, draw_calls_frame, quad_deinit, NULL, NULL },
+    { "instanced", instanced_init, instanced_frame, instanced_deinit, NULL, NULL },
+    { "uniforms", quad_init, uniforms_frame, quad_deinit, NULL, NULL },
+    { "texture_uploads", texture_uploads_init, texture_uploads_frame, texture_uploads_deinit, NULL, NULL },
+    { "render_queue", render_queue_init, render_queue_frame, render_queue_deinit,
+        render_queue_reset, render_queue_report },
+    { "math", math_init, math_frame, math_deinit, math_reset, math_report },
+    { "transforms", transforms_init, transforms_frame, transforms_deinit, transforms_reset, transforms_report },
+    { "bvh", bvh_init, bvh_frame, bvh_deinit, bvh_reset, bvh_report },
+    { "buffer_pool", buffer_pool_init, buffer_pool_frame, buffer_pool_deinit, buffer_pool_reset, buffer_pool_report },
+    { "text", text_init, text_frame, text_deinit, text_reset, text_report },
+    { "file_load", file_load_init, file_load_frame, file_load_deinit, file_load_reset, file_load_report },
+};
+
+static int compare_double(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, size_t count, double p)
+{
+    size_t index = (size_t)(p * (double)(count - 1) + 0.5);
+    return sorted[index];
+}
+
+static BenchCounters read_counters(void)
+{
+    GLXTFrameCounters frame = glxt_frame_counters();
+    GLXTStateStats state = glxt_state_stats();
+    GLXTUniformStats uniforms = glxt_uniform_stats();
+    BenchCounters counters = {
+        .draw_calls = frame.draw_calls,
+        .vertices = frame.vertices,
+        .bytes_uploaded = frame.bytes_uploaded,
+        .state_calls = state.calls_issued,
+        .state_calls_elided = state.calls_elided,
+        .uniform_uploads = uniforms.uploads,
+        .uniform_uploads_elided = uniforms.uploads_elided,
+    };
+    return counters;
+}
+
+static bool run_scene(const BenchScene* bench, size_t frames, GLFWwindow* window)
+{
+    srand(1);
+    if(!bench->init()) {
+        fprintf(stderr, "scene %s failed to initialize: %s\n", bench->name, glxt_failure_reason());
+        return false;
+    }
+
+    double* times = malloc(sizeof(double) * frames);
+    if(times == NULL) return false;
+
+    // The warmup frames are not measured, they absorb shader compiles and first uploads
+    for(size_t i = 0; i < BENCH_WARMUP_FRAMES; ++i) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        bench->frame(i);
+        glfwSwapBuffers(window);
+    }
+    glFinish();
+    glxt_reset_frame_counters();
+    glxt_reset_state_stats();
+    GLXTUniformStats uniforms_before = glxt_uniform_stats();
+    if(bench->reset != NULL) bench->reset();
+
+    uint64_t frequency = glfwGetTimerFrequency();
+    for(size_t i = 0; i < frames; ++i) {
+        uint64_t start = glfwGetTimerValue();
+        glClear(GL_COLOR_BUFFER_BIT);
+        bench->frame(BENCH_WARMUP_FRAMES + i);
+        glxt_capture_frame();
+        glfwSwapBuffers(window);
+        // Software rendering runs in the driver, finish so the frame includes it
+        glFinish();
+        times[i] = (double)(glfwGetTimerValue() - start) * 1000.0 / frequency;
+    }
+
+    BenchCounters counters = read_counters();
+    counters.uniform_uploads -= uniforms_before.uploads;
+    counters.uniform_uploads_elided -= uniforms_before.uploads_elided;
+
+    double total = 0.0;
+    for(size_t i = 0; i < frames; ++i) total += times[i];
+    qsort(times, frames, sizeof(double), compare_double);
+
+    printf("{\"scene\":\"%s\",\"frames\":%zu,"
+        "\"frame_ms\":{\"mean\":%.4f,\"p50\":%.4f,\"p90\":%.4f,\"p99\":%.4f,\"max\":%.4f},"
+        "\"per_frame\":{\"draw_calls\":%.1f,\"vertices\":%.1f,\"bytes_uploaded\":%.1f,"
+        "\"state_calls\":%.1f,\"state_calls_elided\":%.1f,"
+        "\"uniform_uploads\":%.1f,\"uniform_uploads_elided\":%.1f}",
+        bench->name, frames,
+        total / frames, percentile(times, frames, 0.5), percentile(times, frames, 0.9),
+        percentile(times, frames, 0.99), times[frames - 1],
+        (double)counters.draw_calls / frames, (double)counters.vertices / frames,
+        (double)counters.bytes_uploaded / frames,
+        (double)counters.state_calls / frames, (double)counters.state_calls_elided / frames,
+        (double)counters.uniform_uploads / frames, (double)counters.uniform_uploads_elided / frames);
+    if(bench->report != NULL) bench->report(frames);
+    printf("}\n");
+    fflush(stdout);
+
+    free(times);
+    bench->deinit();
+    return !glxt_has_failure();
+}
+
+int main(int argc, char** argv)
+{
+    size_t frames = BENCH_DEFAULT_FRAMES;
+    const char* only_scene = NULL;
+    const char* capture_path = NULL;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            only_scene = argv[++i];
+        } else if(strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--frames N] [--scene NAME] [--capture FILE.y4m]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if(frames == 0) frames = 1;
+
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if(!glfwInit()) {
+        fprintf(stderr, "%s\n", "Failed to initialize GLFW");
+        return EXIT_FAILURE;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(BENCH_WIDTH, BENCH_HEIGHT, "opengl-bench", NULL, NULL);
+    if(window == NULL) {
+        fprintf(stderr, "%s\n", "Failed to create an OSMesa context, is libOSMesa installed?");
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    gladLoadGLES2Loader((GLADloadproc)glfwGetProcAddress);
+    glxt_set_viewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+
+    printf("{\"renderer\":\"%s\",\"version\":\"%s\",\"frames\":%zu}\n",
+        (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION), frames);
+
+    if(capture_path != NULL) {
+        GLXTCaptureDesc capture = {
+            .path = capture_path,
+            .format = GLXT_CAPTURE_Y4M,
+            .width = BENCH_WIDTH,
+            .height = BENCH_HEIGHT,
+        };
+        if(!glxt_capture_begin(&capture)) {
+            fprintf(stderr, "%s: %s\n", capture_path, glxt_failure_reason());
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return EXIT_FAILURE;
+        }
+    }
+
+    int status = EXIT_SUCCESS;
+    size_t scenes_run = 0;
+    for(size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+        if(only_scene != NULL && strcmp(only_scene, scenes[i].name) != 0) continue;
+        scenes_run += 1;
+        if(!run_scene(&scenes[i], frames, window)) {
+            fprintf(stderr, "scene %s failed: %s\n", scenes[i].name, glxt_failure_reason());
+            status = EXIT_FAILURE;
+        }
+    }
+    if(scenes_run == 0) {
+        fprintf(stderr, "unknown scene %s\n", only_scene);
+        status = EXIT_FAILURE;
+    }
+
+    if(capture_path != NULL) {
+        glxt_capture_end();
+        GLXTCaptureStats stats = glxt_capture_stats();
+        printf("{\"capture\":\"%s\",\"frames_written\":%zu,\"frames_dropped\":%zu,"
+            "\"readback_stalls\":%zu,\"writer_stalls\":%zu,\"bytes_written\":%zu}\n",
+            capture_path, stats.frames_written, stats.frames_dropped,
+            stats.readback_stalls, stats.writer_stalls, stats.bytes_written);
+        if(stats.write_failed) status = EXIT_FAILURE;
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return status;
+}
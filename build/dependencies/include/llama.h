@@ -22,6 +22,12 @@
  * (2) Platform
  * If you are working on linux or other posix platform
  * You will need to link with the math library
+ *
+ * (3) SIMD
+ * The 4x4 matrix and vec4 operations use SSE when the compiler targets
+ * it (always the case on x86_64) and the batch functions use AVX when
+ * built with -mavx. Define LLAMA_NO_SIMD before including to force the
+ * scalar code.
  * 
  ***************************************************/
 
@@ -52,6 +58,23 @@
 
 #define LLADEF static inline
 
+#if !defined(LLAMA_NO_SIMD)
+	#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		#define LLAMA_SSE 1
+		#include <xmmintrin.h>
+	#endif
+	#if defined(__AVX__)
+		#define LLAMA_AVX 1
+		#include <immintrin.h>
+	#endif
+#endif
+#ifndef LLAMA_SSE
+	#define LLAMA_SSE 0
+#endif
+#ifndef LLAMA_AVX
+	#define LLAMA_AVX 0
+#endif
+
 typedef union vec2 {
 	float elements[2];
 	struct {
@@ -159,6 +182,10 @@ typedef union mat4 {
 // LLADEF mat4_t mat4_euler_y(float angle_radians);
 // LLADEF mat4_t mat4_euler_z(float angle_radians);
 // LLADEF mat4_t mat4_euler_xyz(float x_radians, float y_radians, float z_radians);
+// LLADEF vec4_t mat4_mul_vec4(mat4_t m, vec4_t v);
+// LLADEF void mat4_transform_vec4_array(mat4_t m, const vec4_t* src, vec4_t* dst, size_t count);
+// LLADEF void mat4_transform_vec3_array(mat4_t m, const vec3_t* src, vec3_t* dst, size_t count);
+// LLADEF void mat4_dot_array(const mat4_t* a, const mat4_t* b, mat4_t* dst, size_t count);
 
 // vec2
 LLADEF vec2_t vec2(float x, float y) {
@@ -340,52 +367,83 @@ LLADEF vec4_t vec4_ones() {
 }
 
 LLADEF vec4_t vec4_add(vec4_t a, vec4_t b) {
+#if LLAMA_SSE
+	vec4_t res;
+	_mm_storeu_ps(res.elements, _mm_add_ps(_mm_loadu_ps(a.elements), _mm_loadu_ps(b.elements)));
+	return res;
+#else
 	return vec4(
 		a.x + b.x,
 		a.y + b.y,
 		a.z + b.z,
 		a.w + b.w
 	);
+#endif
 }
 
 LLADEF vec4_t vec4_sub(vec4_t a, vec4_t b) {
+#if LLAMA_SSE
+	vec4_t res;
+	_mm_storeu_ps(res.elements, _mm_sub_ps(_mm_loadu_ps(a.elements), _mm_loadu_ps(b.elements)));
+	return res;
+#else
 	return vec4(
 		a.x - b.x,
 		a.y - b.y,
 		a.z - b.z,
 		a.w - b.w
 	);
+#endif
 }
 
 LLADEF vec4_t vec4_mul(vec4_t a, vec4_t b) {
+#if LLAMA_SSE
+	vec4_t res;
+	_mm_storeu_ps(res.elements, _mm_mul_ps(_mm_loadu_ps(a.elements), _mm_loadu_ps(b.elements)));
+	return res;
+#else
 	return vec4(
 		a.x * b.x,
 		a.y * b.y,
 		a.z * b.z,
 		a.w * b.w
 	);
+#endif
 }
 
 LLADEF vec4_t vec4_div(vec4_t a, vec4_t b) {
+#if LLAMA_SSE
+	vec4_t res;
+	_mm_storeu_ps(res.elements, _mm_div_ps(_mm_loadu_ps(a.elements), _mm_loadu_ps(b.elements)));
+	return res;
+#else
 	return vec4(
 		a.x / b.x,
 		a.y / b.y,
 		a.z / b.z,
 		a.w / b.w
 	);
+#endif
 }
 
 LLADEF float vec4_dot(vec4_t a, vec4_t b) {
+#if LLAMA_SSE
+	__m128 p = _mm_mul_ps(_mm_loadu_ps(a.elements), _mm_loadu_ps(b.elements));
+	p = _mm_add_ps(p, _mm_movehl_ps(p, p));
+	p = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(p);
+#else
     float p = 0;
     p += a.x * b.x;
     p += a.y * b.y;
     p += a.z * b.z;
     p += a.w * b.w;
     return p;
+#endif
 }
 
 LLADEF float vec4_length(vec4_t a) {
-	return sqrtf( a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w );	
+	return sqrtf( vec4_dot(a, a) );
 }
 
 LLADEF void vec4_normalize(vec4_t* a) {
@@ -446,8 +504,28 @@ LLADEF mat4_t mat4_div(mat4_t a, mat4_t b) {
 	return res;
 }
 
+#if LLAMA_SSE
+static inline __m128 _llama_mat4_row_dot(const float* a_row, const __m128 b[4]) {
+	__m128 r = _mm_mul_ps(_mm_set1_ps(a_row[0]), b[0]);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a_row[1]), b[1]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a_row[2]), b[2]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a_row[3]), b[3]));
+	return r;
+}
+#endif
+
 LLADEF mat4_t mat4_dot(mat4_t a, mat4_t b) {
-	mat4_t res = mat4_identity();
+	mat4_t res;
+#if LLAMA_SSE
+	const __m128 b_rows[4] = {
+		_mm_loadu_ps(&b.elements[0]), _mm_loadu_ps(&b.elements[4]),
+		_mm_loadu_ps(&b.elements[8]), _mm_loadu_ps(&b.elements[12]),
+	};
+	for(int i = 0; i < 4; ++i) {
+		_mm_storeu_ps(&res.elements[i * 4], _llama_mat4_row_dot(&a.elements[i * 4], b_rows));
+	}
+	return res;
+#else
     const float* a_ptr = a.elements;
     const float* b_ptr = b.elements;
     float* dst_ptr = res.elements;
@@ -461,9 +539,10 @@ LLADEF mat4_t mat4_dot(mat4_t a, mat4_t b) {
                 a_ptr[3] * b_ptr[12 + j];
             dst_ptr++;
         }
-        b_ptr += 4;
+        a_ptr += 4;
     }
     return res;
+#endif
 }
 
 LLADEF mat4_t mat4_ortho(float left, float right, float bottom, float top, float near, float far) {
@@ -525,7 +604,79 @@ LLADEF mat4_t Mat4_look_at(vec3_t pos, vec3_t target, vec3_t up) {
 	return result;	
 }
 
+#if LLAMA_SSE
+#define _LLAMA_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+#define _LLAMA_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+// 2x2 blocks stored row major in one register
+static inline __m128 _llama_mat2_mul(__m128 a, __m128 b) {
+	return _mm_add_ps(_mm_mul_ps(a, _LLAMA_SWIZZLE(b, 0, 3, 0, 3)),
+		_mm_mul_ps(_LLAMA_SWIZZLE(a, 1, 0, 3, 2), _LLAMA_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+static inline __m128 _llama_mat2_adj_mul(__m128 a, __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(_LLAMA_SWIZZLE(a, 3, 3, 0, 0), b),
+		_mm_mul_ps(_LLAMA_SWIZZLE(a, 1, 1, 2, 2), _LLAMA_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+static inline __m128 _llama_mat2_mul_adj(__m128 a, __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(a, _LLAMA_SWIZZLE(b, 3, 0, 3, 0)),
+		_mm_mul_ps(_LLAMA_SWIZZLE(a, 1, 0, 3, 2), _LLAMA_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Blockwise inversion through 2x2 sub matrices, see Eric Zhang's
+// "Fast 4x4 Matrix Inverse with SSE SIMD, Explained"
+static inline mat4_t _llama_mat4_inverse_sse(const mat4_t* matrix) {
+	__m128 r0 = _mm_loadu_ps(&matrix->elements[0]);
+	__m128 r1 = _mm_loadu_ps(&matrix->elements[4]);
+	__m128 r2 = _mm_loadu_ps(&matrix->elements[8]);
+	__m128 r3 = _mm_loadu_ps(&matrix->elements[12]);
+
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	__m128 det_sub = _mm_sub_ps(
+		_mm_mul_ps(_LLAMA_SHUFFLE(r0, r2, 0, 2, 0, 2), _LLAMA_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(_LLAMA_SHUFFLE(r0, r2, 1, 3, 1, 3), _LLAMA_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	__m128 det_a = _LLAMA_SWIZZLE(det_sub, 0, 0, 0, 0);
+	__m128 det_b = _LLAMA_SWIZZLE(det_sub, 1, 1, 1, 1);
+	__m128 det_c = _LLAMA_SWIZZLE(det_sub, 2, 2, 2, 2);
+	__m128 det_d = _LLAMA_SWIZZLE(det_sub, 3, 3, 3, 3);
+
+	__m128 d_c = _llama_mat2_adj_mul(D, C);
+	__m128 a_b = _llama_mat2_adj_mul(A, B);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, A), _llama_mat2_mul(B, d_c));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, D), _llama_mat2_mul(C, a_b));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, C), _llama_mat2_mul_adj(D, a_b));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, B), _llama_mat2_mul_adj(A, d_c));
+
+	__m128 det = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+	__m128 tr = _mm_mul_ps(a_b, _LLAMA_SWIZZLE(d_c, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+	tr = _mm_add_ps(tr, _LLAMA_SWIZZLE(tr, 1, 0, 1, 0));
+	det = _mm_sub_ps(det, _LLAMA_SWIZZLE(tr, 0, 0, 0, 0));
+
+	__m128 inverse_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, inverse_det);
+	y = _mm_mul_ps(y, inverse_det);
+	z = _mm_mul_ps(z, inverse_det);
+	w = _mm_mul_ps(w, inverse_det);
+
+	mat4_t result;
+	_mm_storeu_ps(&result.elements[0], _LLAMA_SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(&result.elements[4], _LLAMA_SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(&result.elements[8], _LLAMA_SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(&result.elements[12], _LLAMA_SHUFFLE(z, w, 2, 0, 2, 0));
+	return result;
+}
+#endif
+
 LLADEF mat4_t mat4_inverse(mat4_t matrix) {
+#if LLAMA_SSE
+	return _llama_mat4_inverse_sse(&matrix);
+#else
 	const float* m = matrix.elements;
 
     float t0 = m[10] * m[15];
@@ -581,6 +732,7 @@ LLADEF mat4_t mat4_inverse(mat4_t matrix) {
     o[15] = d * ((t22 * m[10] + t16 * m[2] + t21 * m[6]) - (t20 * m[6] + t23 * m[10] + t17 * m[2]));
 
     return result;
+#endif
 }
 
 LLADEF mat4_t mat4_translation(vec3_t position) {
@@ -600,6 +752,19 @@ LLADEF mat4_t mat4_scale(vec3_t scale) {
 }
 
 LLADEF mat4_t mat4_transpose(mat4_t matrix) {
+#if LLAMA_SSE
+	__m128 r0 = _mm_loadu_ps(&matrix.elements[0]);
+	__m128 r1 = _mm_loadu_ps(&matrix.elements[4]);
+	__m128 r2 = _mm_loadu_ps(&matrix.elements[8]);
+	__m128 r3 = _mm_loadu_ps(&matrix.elements[12]);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	mat4_t transposed;
+	_mm_storeu_ps(&transposed.elements[0], r0);
+	_mm_storeu_ps(&transposed.elements[4], r1);
+	_mm_storeu_ps(&transposed.elements[8], r2);
+	_mm_storeu_ps(&transposed.elements[12], r3);
+	return transposed;
+#else
 	mat4_t out_matrix = mat4_identity();
     out_matrix.elements[0] = matrix.elements[0];
     out_matrix.elements[1] = matrix.elements[4];
@@ -618,6 +783,114 @@ LLADEF mat4_t mat4_transpose(mat4_t matrix) {
     out_matrix.elements[14] = matrix.elements[11];
     out_matrix.elements[15] = matrix.elements[15];
     return out_matrix;
+#endif
+}
+
+// Vector transforms. Storage is column major, elements[12..14] hold the translation, so
+// mat4_mul_vec4(m, v) == m * v and mat4_dot(a, b) == b * a: a is applied first
+LLADEF vec4_t mat4_mul_vec4(mat4_t m, vec4_t v) {
+	vec4_t res;
+#if LLAMA_SSE
+	const __m128 columns[4] = {
+		_mm_loadu_ps(&m.elements[0]), _mm_loadu_ps(&m.elements[4]),
+		_mm_loadu_ps(&m.elements[8]), _mm_loadu_ps(&m.elements[12]),
+	};
+	_mm_storeu_ps(res.elements, _llama_mat4_row_dot(v.elements, columns));
+#else
+	for(int i = 0; i < 4; ++i) {
+		res.elements[i] = m.elements[i] * v.x + m.elements[4 + i] * v.y
+			+ m.elements[8 + i] * v.z + m.elements[12 + i] * v.w;
+	}
+#endif
+	return res;
+}
+
+/**
+ * Batch versions, working on arrays to amortize the loads of the shared
+ * matrix. dst may alias src. vec3 inputs are treated as points (w = 1).
+ */
+LLADEF void mat4_transform_vec4_array(mat4_t m, const vec4_t* src, vec4_t* dst, size_t count) {
+#if LLAMA_SSE
+	const __m128 columns[4] = {
+		_mm_loadu_ps(&m.elements[0]), _mm_loadu_ps(&m.elements[4]),
+		_mm_loadu_ps(&m.elements[8]), _mm_loadu_ps(&m.elements[12]),
+	};
+	for(size_t i = 0; i < count; ++i) {
+		_mm_storeu_ps(dst[i].elements, _llama_mat4_row_dot(src[i].elements, columns));
+	}
+#else
+	for(size_t i = 0; i < count; ++i) {
+		dst[i] = mat4_mul_vec4(m, src[i]);
+	}
+#endif
+}
+
+LLADEF void mat4_transform_vec3_array(mat4_t m, const vec3_t* src, vec3_t* dst, size_t count) {
+#if LLAMA_SSE
+	const __m128 c0 = _mm_loadu_ps(&m.elements[0]);
+	const __m128 c1 = _mm_loadu_ps(&m.elements[4]);
+	const __m128 c2 = _mm_loadu_ps(&m.elements[8]);
+	const __m128 c3 = _mm_loadu_ps(&m.elements[12]);
+	for(size_t i = 0; i < count; ++i) {
+		__m128 r = _mm_add_ps(c3, _mm_mul_ps(_mm_set1_ps(src[i].x), c0));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(src[i].y), c1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(src[i].z), c2));
+		float out[4];
+		_mm_storeu_ps(out, r);
+		dst[i].x = out[0];
+		dst[i].y = out[1];
+		dst[i].z = out[2];
+	}
+#else
+	for(size_t i = 0; i < count; ++i) {
+		vec4_t p = mat4_mul_vec4(m, vec4(src[i].x, src[i].y, src[i].z, 1.0f));
+		dst[i].x = p.x;
+		dst[i].y = p.y;
+		dst[i].z = p.z;
+	}
+#endif
+}
+
+// dst[i] = mat4_dot(a[i], b[i])
+LLADEF void mat4_dot_array(const mat4_t* a, const mat4_t* b, mat4_t* dst, size_t count) {
+#if LLAMA_AVX
+	for(size_t i = 0; i < count; ++i) {
+		// Each 256 bit register holds two rows, the b rows are repeated in both halves
+		const __m256 b0 = _mm256_broadcast_ps((const __m128*)&b[i].elements[0]);
+		const __m256 b1 = _mm256_broadcast_ps((const __m128*)&b[i].elements[4]);
+		const __m256 b2 = _mm256_broadcast_ps((const __m128*)&b[i].elements[8]);
+		const __m256 b3 = _mm256_broadcast_ps((const __m128*)&b[i].elements[12]);
+		__m256 rows[2];
+		for(int half = 0; half < 2; ++half) {
+			__m256 ar = _mm256_loadu_ps(&a[i].elements[half * 8]);
+			__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			rows[half] = r;
+		}
+		_mm256_storeu_ps(&dst[i].elements[0], rows[0]);
+		_mm256_storeu_ps(&dst[i].elements[8], rows[1]);
+	}
+#elif LLAMA_SSE
+	for(size_t i = 0; i < count; ++i) {
+		const __m128 b_rows[4] = {
+			_mm_loadu_ps(&b[i].elements[0]), _mm_loadu_ps(&b[i].elements[4]),
+			_mm_loadu_ps(&b[i].elements[8]), _mm_loadu_ps(&b[i].elements[12]),
+		};
+		__m128 rows[4];
+		for(int r = 0; r < 4; ++r) {
+			rows[r] = _llama_mat4_row_dot(&a[i].elements[r * 4], b_rows);
+		}
+		for(int r = 0; r < 4; ++r) {
+			_mm_storeu_ps(&dst[i].elements[r * 4], rows[r]);
+		}
+	}
+#else
+	for(size_t i = 0; i < count; ++i) {
+		dst[i] = mat4_dot(a[i], b[i]);
+	}
+#endif
 }
 
 LLADEF mat4_t mat4_euler_x(float angle_radians) {
@@ -1,9 +1,33 @@
 #ifndef GLFWE_H
 #define GLFWE_H
 
-#define GLFWE_MAXIMUM_FRAME_EVENT 64
+#include <stddef.h>
+
+/**
+ * Events are pushed by the GLFW callbacks, so on the thread that calls
+ * glfwe_events_flush (the main thread, as GLFW requires), into a single
+ * producer single consumer lock-free ring. glfwe_poll_events may run on
+ * another thread, e.g. the render thread.
+ * Consecutive cursor moves and window move/resize events coming from the
+ * same flush are coalesced into the latest one. Events that do not fit in
+ * the ring are dropped and counted.
+ */
+#ifndef GLFWE_EVENT_RING_SIZE
+    #define GLFWE_EVENT_RING_SIZE 1024
+#endif
 
+// Declared like windows.h does, so either header may come first and includers don't get windows.h
+#if defined(_WIN32)
+typedef int BOOL;
+    #ifndef FALSE
+        #define FALSE 0
+    #endif
+    #ifndef TRUE
+        #define TRUE 1
+    #endif
+#else
 typedef enum { FALSE = 0, TRUE, } BOOL;
+#endif
 
 typedef enum GLFWEEventType {
     GLFWE_EVENT_NONE = 0,
@@ -25,8 +49,15 @@ typedef enum GLFWEEventType {
     GLFWE_EVENT_WINDOW_FOCUS_LOST,
 } GLFWEEventType;
 
+typedef enum GLFWEFlushMode {
+    GLFWE_FLUSH_POLL = 0,
+    GLFWE_FLUSH_WAIT,
+    GLFWE_FLUSH_WAIT_TIMEOUT,
+} GLFWEFlushMode;
+
 typedef struct GLFWEEvent {
     int type;
+    double time;
     struct { int code; char printable; } key;
     struct { int x, y; } mouse;
     struct { int x, y, w, h; } window;
@@ -35,135 +66,248 @@ typedef struct GLFWEEvent {
 
 typedef struct GLFWwindow GLFWwindow;
 
+typedef struct GLFWEStats {
+    size_t pushed;
+    size_t coalesced;
+    size_t dropped;
+} GLFWEStats;
+
 BOOL glfwe_init(GLFWwindow* window);
 BOOL glfwe_poll_events(GLFWEEvent* event);
-void glfwe_events_flush(void);
+/**
+ * GLFWE_FLUSH_POLL never blocks, GLFWE_FLUSH_WAIT blocks until an event
+ * arrives and GLFWE_FLUSH_WAIT_TIMEOUT waits at most timeout_seconds.
+ */
+void glfwe_events_flush(GLFWEFlushMode mode, double timeout_seconds);
+GLFWEStats glfwe_stats(void);
 
 #endif
 
-#ifdef GLFWE_IMPLEMENTATION
+#if defined(GLFWE_IMPLEMENTATION) && !defined(GLFWE_IMPLEMENTATION_INCLUDED)
+#define GLFWE_IMPLEMENTATION_INCLUDED
 
 #include <stddef.h>
+#include <string.h>
 #include <GLFW/glfw3.h>
 
-#ifndef GLFWE_MAXIMUM_FRAME_EVENT
-    #define GLFWE_MAXIMUM_FRAME_EVENT 64
+// Loads acquire, stores release, adds are relaxed; MSVC without C11 atomics gets the Interlocked functions
+#if defined(_MSC_VER) && defined(__STDC_NO_ATOMICS__)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    typedef volatile size_t _GLFWEAtomic;
+#else
+    #include <stdatomic.h>
+    typedef atomic_size_t _GLFWEAtomic;
+#endif
+
+static inline size_t _glfwe_atomic_load(_GLFWEAtomic* a)
+{
+#if defined(_MSC_VER) && defined(__STDC_NO_ATOMICS__)
+    return (size_t)InterlockedExchangeAddSizeT(a, 0);
+#else
+    return atomic_load_explicit(a, memory_order_acquire);
+#endif
+}
+
+static inline void _glfwe_atomic_store(_GLFWEAtomic* a, size_t v)
+{
+#if defined(_MSC_VER) && defined(__STDC_NO_ATOMICS__)
+    InterlockedExchangePointer((PVOID volatile*)a, (PVOID)v);
+#else
+    atomic_store_explicit(a, v, memory_order_release);
+#endif
+}
+
+static inline void _glfwe_atomic_add(_GLFWEAtomic* a, size_t v)
+{
+#if defined(_MSC_VER) && defined(__STDC_NO_ATOMICS__)
+    InterlockedExchangeAddSizeT(a, v);
+#else
+    atomic_fetch_add_explicit(a, v, memory_order_relaxed);
+#endif
+}
+
+#if (GLFWE_EVENT_RING_SIZE & (GLFWE_EVENT_RING_SIZE - 1)) != 0
+    #error "GLFWE_EVENT_RING_SIZE must be a power of two"
 #endif
 
 static struct {
     BOOL initialized;
     GLFWwindow* window;
-    size_t events_count;
-    size_t events_iterator;
-    GLFWEEvent events[GLFWE_MAXIMUM_FRAME_EVENT];
+
+    // head is only written by the producer, tail only by the consumer
+    GLFWEEvent events[GLFWE_EVENT_RING_SIZE];
+    _Alignas(64) _GLFWEAtomic head;
+    _Alignas(64) _GLFWEAtomic tail;
+
+    // Producer side, a coalescable event is held back until something else
+    // arrives or the flush ends
+    GLFWEEvent pending;
+    BOOL has_pending;
+
+    _GLFWEAtomic pushed;
+    _GLFWEAtomic coalesced;
+    _GLFWEAtomic dropped;
 } GLFWE = {0};
 
-static void glfwe_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+static void glfwe_push_event(const GLFWEEvent* event)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
+    size_t head = _glfwe_atomic_load(&GLFWE.head);
+    size_t tail = _glfwe_atomic_load(&GLFWE.tail);
+    if(head - tail >= GLFWE_EVENT_RING_SIZE) {
+        _glfwe_atomic_add(&GLFWE.dropped, 1);
+        return;
+    }
 
-    GLFWE.events[GLFWE.events_count].key.code = key;
-    GLFWE.events[GLFWE.events_count].key.printable = '\0';
-    if(key >= GLFW_KEY_SPACE && key <= GLFW_KEY_WORLD_2) {
-        GLFWE.events[GLFWE.events_count].key.printable = (char)key;
+    GLFWE.events[head & (GLFWE_EVENT_RING_SIZE - 1)] = *event;
+    _glfwe_atomic_store(&GLFWE.head, head + 1);
+    _glfwe_atomic_add(&GLFWE.pushed, 1);
+}
+
+static void glfwe_publish_pending(void)
+{
+    if(!GLFWE.has_pending) return;
+    glfwe_push_event(&GLFWE.pending);
+    GLFWE.has_pending = FALSE;
+}
+
+static BOOL glfwe_is_coalescable(int type)
+{
+    return type == GLFWE_EVENT_CURSOR_MOVED
+        || type == GLFWE_EVENT_WINDOW_RESIZED
+        || type == GLFWE_EVENT_WINDOW_FRAMEBUFFER_RESIZED
+        || type == GLFWE_EVENT_WINDOW_MOVED;
+}
+
+static void glfwe_emit(GLFWEEvent* event)
+{
+    event->time = glfwGetTime();
+    if(GLFWE.has_pending && GLFWE.pending.type == event->type) {
+        GLFWE.pending = *event;
+        _glfwe_atomic_add(&GLFWE.coalesced, 1);
+        return;
     }
 
+    glfwe_publish_pending();
+    if(glfwe_is_coalescable(event->type)) {
+        GLFWE.pending = *event;
+        GLFWE.has_pending = TRUE;
+    } else {
+        glfwe_push_event(event);
+    }
+}
+
+static void glfwe_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    GLFWEEvent event = {0};
+    event.key.code = key;
+    event.key.printable = '\0';
+    if(key >= GLFW_KEY_SPACE && key <= GLFW_KEY_WORLD_2) {
+        event.key.printable = (char)key;
+    }
 
     if(action == GLFW_PRESS)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_KEY_PRESSED;
+        event.type = GLFWE_EVENT_KEY_PRESSED;
     if(action == GLFW_RELEASE)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_KEY_RELEASED;
+        event.type = GLFWE_EVENT_KEY_RELEASED;
     if(action == GLFW_REPEAT)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_KEY_REPEATED;
+        event.type = GLFWE_EVENT_KEY_REPEATED;
 
-    GLFWE.events_count += 1;
+    glfwe_emit(&event);
 }
+
 static void glfwe_cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-
-    GLFWE.events[GLFWE.events_count].mouse.x = (int)xpos;
-    GLFWE.events[GLFWE.events_count].mouse.y = (int)ypos;
-    GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_CURSOR_MOVED;
-    GLFWE.events_count += 1;
+    GLFWEEvent event = {0};
+    event.mouse.x = (int)xpos;
+    event.mouse.y = (int)ypos;
+    event.type = GLFWE_EVENT_CURSOR_MOVED;
+    glfwe_emit(&event);
 }
 
 static void glfwe_mouse_button_callback(
     GLFWwindow* window, int button, int action, int mods)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-
+    GLFWEEvent event = {0};
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_MOUSE_KEY_RIGHT_DOWN;
+        event.type = GLFWE_EVENT_MOUSE_KEY_RIGHT_DOWN;
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_MOUSE_KEY_RIGHT_UP;
+        event.type = GLFWE_EVENT_MOUSE_KEY_RIGHT_UP;
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_MOUSE_KEY_LEFT_DOWN;
+        event.type = GLFWE_EVENT_MOUSE_KEY_LEFT_DOWN;
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_MOUSE_KEY_LEFT_UP;
+        event.type = GLFWE_EVENT_MOUSE_KEY_LEFT_UP;
 
-    GLFWE.events_count += 1;
+    // Other buttons have no event type
+    if(event.type == GLFWE_EVENT_NONE) return;
+    glfwe_emit(&event);
 }
 
-void glfwe_window_size_callback(GLFWwindow* window, int width, int height)
+static void glfwe_window_size_callback(GLFWwindow* window, int width, int height)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-    GLFWE.events[GLFWE.events_count].window.w = width;
-    GLFWE.events[GLFWE.events_count].window.h = height;
-    GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_WINDOW_RESIZED;
-    GLFWE.events_count += 1;
+    GLFWEEvent event = {0};
+    event.window.w = width;
+    event.window.h = height;
+    event.type = GLFWE_EVENT_WINDOW_RESIZED;
+    glfwe_emit(&event);
 }
 
-void glfwe_window_pos_callback(GLFWwindow* window, int xpos, int ypos)
+static void glfwe_window_pos_callback(GLFWwindow* window, int xpos, int ypos)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-    GLFWE.events[GLFWE.events_count].window.x = xpos;
-    GLFWE.events[GLFWE.events_count].window.y = ypos;
-    GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_WINDOW_MOVED;
-    GLFWE.events_count += 1;
+    GLFWEEvent event = {0};
+    event.window.x = xpos;
+    event.window.y = ypos;
+    event.type = GLFWE_EVENT_WINDOW_MOVED;
+    glfwe_emit(&event);
 }
 
-void glfwe_framebuffer_size_callback(GLFWwindow* window, int width, int height)
+static void glfwe_framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-    GLFWE.events[GLFWE.events_count].framebuffer.w = width;
-    GLFWE.events[GLFWE.events_count].framebuffer.h = height;
-    GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_WINDOW_FRAMEBUFFER_RESIZED;
-    GLFWE.events_count += 1;
+    GLFWEEvent event = {0};
+    event.framebuffer.w = width;
+    event.framebuffer.h = height;
+    event.type = GLFWE_EVENT_WINDOW_FRAMEBUFFER_RESIZED;
+    glfwe_emit(&event);
 }
 
-void glfwe_cursor_enter_callback(GLFWwindow* window, int enter) 
+static void glfwe_cursor_enter_callback(GLFWwindow* window, int enter)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-
+    GLFWEEvent event = {0};
     if(enter) {
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_CURSOR_ENTER_WINDOW;
+        event.type = GLFWE_EVENT_CURSOR_ENTER_WINDOW;
     } else {
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_CURSOR_LEAVE_WINDOW;
+        event.type = GLFWE_EVENT_CURSOR_LEAVE_WINDOW;
     }
-
-    GLFWE.events_count += 1;
+    glfwe_emit(&event);
 }
 
-void glfwe_window_focus_callback(GLFWwindow* window, int focused)
+static void glfwe_window_focus_callback(GLFWwindow* window, int focused)
 {
-    if(GLFWE.events_count + 1 > GLFWE_MAXIMUM_FRAME_EVENT) return;
-
+    GLFWEEvent event = {0};
     if(focused) {
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_WINDOW_FOCUS_GAINED;
+        event.type = GLFWE_EVENT_WINDOW_FOCUS_GAINED;
     } else {
-        GLFWE.events[GLFWE.events_count].type = GLFWE_EVENT_WINDOW_FOCUS_LOST;
+        event.type = GLFWE_EVENT_WINDOW_FOCUS_LOST;
     }
-
-    GLFWE.events_count += 1;
+    glfwe_emit(&event);
 }
 
+static void glfwe_window_close_callback(GLFWwindow* window)
+{
+    GLFWEEvent event = {0};
+    event.type = GLFWE_EVENT_QUIT;
+    glfwe_emit(&event);
+}
 
 BOOL glfwe_init(GLFWwindow* window)
 {
     if(window == NULL) return FALSE;
-    GLFWE.events_count = 0;
-    GLFWE.events_iterator = 0;
+    _glfwe_atomic_store(&GLFWE.head, 0);
+    _glfwe_atomic_store(&GLFWE.tail, 0);
+    _glfwe_atomic_store(&GLFWE.pushed, 0);
+    _glfwe_atomic_store(&GLFWE.coalesced, 0);
+    _glfwe_atomic_store(&GLFWE.dropped, 0);
+    GLFWE.has_pending = FALSE;
     GLFWE.window = window;
     glfwSetKeyCallback(window, glfwe_key_callback);
     glfwSetCursorPosCallback(window, glfwe_cursor_pos_callback);
@@ -173,24 +317,41 @@ BOOL glfwe_init(GLFWwindow* window)
     glfwSetFramebufferSizeCallback(window, glfwe_framebuffer_size_callback);
     glfwSetCursorEnterCallback(window, glfwe_cursor_enter_callback);
     glfwSetWindowFocusCallback(window, glfwe_window_focus_callback);
+    glfwSetWindowCloseCallback(window, glfwe_window_close_callback);
+    GLFWE.initialized = TRUE;
     return TRUE;
 }
 
-void glfwe_events_flush(void)
+void glfwe_events_flush(GLFWEFlushMode mode, double timeout_seconds)
 {
-    GLFWE.events_count = 0;
-    GLFWE.events_iterator = 0;
-    glfwWaitEvents();
+    switch(mode) {
+        case GLFWE_FLUSH_WAIT: glfwWaitEvents(); break;
+        case GLFWE_FLUSH_WAIT_TIMEOUT: glfwWaitEventsTimeout(timeout_seconds); break;
+        case GLFWE_FLUSH_POLL:
+        default: glfwPollEvents(); break;
+    }
+    glfwe_publish_pending();
 }
 
 BOOL glfwe_poll_events(GLFWEEvent* event)
 {
-    if(GLFWE.events_iterator > GLFWE.events_count) return FALSE;
+    size_t tail = _glfwe_atomic_load(&GLFWE.tail);
+    size_t head = _glfwe_atomic_load(&GLFWE.head);
+    if(tail == head) return FALSE;
 
-    *event = GLFWE.events[GLFWE.events_iterator];
-    GLFWE.events_iterator += 1;
+    *event = GLFWE.events[tail & (GLFWE_EVENT_RING_SIZE - 1)];
+    _glfwe_atomic_store(&GLFWE.tail, tail + 1);
     return TRUE;
 }
 
+GLFWEStats glfwe_stats(void)
+{
+    GLFWEStats stats = {
+        .pushed = _glfwe_atomic_load(&GLFWE.pushed),
+        .coalesced = _glfwe_atomic_load(&GLFWE.coalesced),
+        .dropped = _glfwe_atomic_load(&GLFWE.dropped),
+    };
+    return stats;
+}
 
-#endif // GLFWE_IMPLEMENTATION
\ No newline at end of file
+#endif // GLFWE_IMPLEMENTATION
@@ -19,6 +19,26 @@
     void glxt_read_file_data_path(const char* file_path, char* writable);
 #endif
 
+/**
+ * Whole-file loading.
+ * glxt_load_file returns a read-only, NUL-terminated view of a file that
+ * must be given back with glxt_release_file. Files of at least
+ * GLXT_FILE_MMAP_THRESHOLD bytes are memory mapped (zero copies), smaller
+ * ones are read into a single heap buffer with one read call.
+ */
+#ifndef GLXT_FILE_MMAP_THRESHOLD
+    #define GLXT_FILE_MMAP_THRESHOLD (64 * 1024)
+#endif
+
+typedef struct GLXTFileView {
+    const char* data;
+    size_t size;
+    bool mapped;
+} GLXTFileView;
+
+bool glxt_load_file(const char* file_path, GLXTFileView* view);
+void glxt_release_file(GLXTFileView* view);
+
 enum {
     GLXT_SHADER_UNIFORM_FLOAT = 0,
     GLXT_SHADER_UNIFORM_VEC2,
@@ -34,6 +54,85 @@ enum {
 bool glxt_has_failure(void);
 const char* glxt_failure_reason(void);
 
+/**
+ * GL state shadowing.
+ * glxt keeps a copy of the bound program, vertex array, buffers per target,
+ * active texture unit and 2D texture per unit, framebuffer, blend/depth
+ * state, viewport and pack/unpack alignments, and filters out calls that
+ * would not change anything. Every glxt function binds through this layer;
+ * uploads and readbacks that need an alignment of 1 put the previous one
+ * back after. If GL state is changed
+ * behind glxt's back (raw GL calls, other libraries), call
+ * glxt_invalidate_state so the next call of each kind reaches the driver.
+ */
+#ifndef GLXT_MAXIMUM_TEXTURE_UNITS
+    #define GLXT_MAXIMUM_TEXTURE_UNITS 16
+#endif
+
+typedef struct GLXTStateStats {
+    size_t calls_issued;
+    size_t calls_elided;
+} GLXTStateStats;
+
+void glxt_invalidate_state(void);
+GLXTStateStats glxt_state_stats(void);
+void glxt_reset_state_stats(void);
+void glxt_bind_buffer(uint32_t target, uint32_t buffer);
+void glxt_bind_texture2d(uint32_t unit, uint32_t texture);
+// Binds to GL_FRAMEBUFFER, both for drawing and reading
+void glxt_bind_framebuffer(uint32_t framebuffer);
+void glxt_set_blend(bool enabled, uint32_t src_factor, uint32_t dst_factor);
+void glxt_set_depth_test(bool enabled, uint32_t func);
+void glxt_set_depth_mask(bool enabled);
+void glxt_set_viewport(int x, int y, int width, int height);
+
+/**
+ * Frame counters.
+ * Draw calls, vertices submitted and bytes uploaded to buffers and
+ * textures by glxt functions. They are only counted when
+ * GLXT_PROFILER_ENABLED is non-zero (see glxt_profiler.h), otherwise the
+ * counting compiles out and the counters stay at zero.
+ */
+#ifndef GLXT_PROFILER_ENABLED
+    #define GLXT_PROFILER_ENABLED 0
+#endif
+
+typedef struct GLXTFrameCounters {
+    size_t draw_calls;
+    size_t vertices;
+    size_t bytes_uploaded;
+} GLXTFrameCounters;
+
+GLXTFrameCounters glxt_frame_counters(void);
+void glxt_reset_frame_counters(void);
+
+/**
+ * Scratch memory.
+ * A stack of temporary memory glxt takes its transient buffers from
+ * (info logs, program binaries, rebased indices) instead of the heap.
+ * Frees come in reverse order of the allocations, freeing a block also
+ * releases everything allocated after it. Requests that do not fit in the
+ * GLXT_SCRATCH_SIZE block fall back to malloc and count as heap
+ * allocations, as does allocating the block itself on first use.
+ * bytes_in_use and high_water only count the block.
+ */
+#ifndef GLXT_SCRATCH_SIZE
+    #define GLXT_SCRATCH_SIZE (256 * 1024)
+#endif
+
+typedef struct GLXTAllocatorStats {
+    size_t allocations;
+    size_t bytes_in_use;
+    size_t high_water;
+    size_t heap_allocations;
+} GLXTAllocatorStats;
+
+void* glxt_scratch_alloc(size_t size);
+void glxt_scratch_free(void* pointer);
+GLXTAllocatorStats glxt_scratch_stats(void);
+// Returns the block to the heap, it is allocated again on the next use
+void glxt_scratch_deinit(void);
+
 uint32_t glxt_create_vertex_array(void);
 void glxt_destroy_vertex_array(uint32_t vao);
 void glxt_enable_vertex_array(uint32_t vao);
@@ -41,9 +140,25 @@ void glxt_disable_vertex_array(void);
 
 void glxt_set_vertex_attrib(uint32_t index, int comp_count, int attr_type, 
     bool normalized, size_t vertex_size, const void *attr_offset);
+// Advance the attribute once every divisor instances, 0 means per vertex
+void glxt_set_vertex_attrib_divisor(uint32_t index, uint32_t divisor);
+void glxt_set_instance_attrib(uint32_t index, int comp_count, int attr_type,
+    bool normalized, size_t instance_size, const void *attr_offset, uint32_t divisor);
 void glxt_draw_vertex_array(int offset, int count);
 void glxt_draw_vertex_array_elements(int offset, int count, const void* buffer);
 
+/**
+ * Draws with an explicit primitive mode (GL_TRIANGLES, GL_LINES, GL_POINTS,
+ * GL_TRIANGLE_STRIP...). Element offsets are in bytes into the bound index
+ * buffer and index_type is GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or
+ * GL_UNSIGNED_INT.
+ */
+void glxt_draw_arrays(uint32_t mode, int first, int count);
+void glxt_draw_arrays_instanced(uint32_t mode, int first, int count, int instances_count);
+void glxt_draw_elements(uint32_t mode, int count, uint32_t index_type, size_t offset);
+void glxt_draw_elements_instanced(uint32_t mode, int count, uint32_t index_type, size_t offset,
+    int instances_count);
+
 uint32_t glxt_create_vertex_buffer(size_t buffer_size, const void* buffer_data);
 void glxt_update_vertex_buffer(uint32_t vbo, size_t buffer_size, const void* buffer_data, int offset);
 void glxt_destroy_vertex_buffer(uint32_t vbo);
@@ -64,20 +179,334 @@ void glxt_set_shader_uniform(uint32_t shader_program, const char* name,
     const void* data, int uniform_type, int count);
 void glxt_set_shader_uniform_mat4(uint32_t shader_program, const char* name, const void* data);
 
+/**
+ * Shader program binary cache.
+ * Once initialized with an existing, writable directory,
+ * glxt_create_shader_program first looks for a program binary keyed by a
+ * hash of both shader sources and the GL vendor/renderer/version strings
+ * and loads it with glProgramBinary. A missing or rejected binary falls
+ * back to compiling from source, and the freshly linked binary is stored.
+ * glxt_program_cache_prewarm compiles and stores binaries ahead of time
+ * and returns how many new entries were written.
+ */
+#define GLXT_MAXIMUM_PATH 512
+
+typedef struct GLXTShaderSources {
+    const char* vert_source;
+    const char* frag_source;
+} GLXTShaderSources;
+
+typedef struct GLXTProgramCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t rejected;
+    size_t stores;
+} GLXTProgramCacheStats;
+
+bool glxt_program_cache_init(const char* directory);
+void glxt_program_cache_deinit(void);
+size_t glxt_program_cache_prewarm(const GLXTShaderSources* sources, size_t count);
+GLXTProgramCacheStats glxt_program_cache_stats(void);
+
+/**
+ * Uniform reflection.
+ * Every program created with glxt_create_shader_program has its active
+ * uniforms enumerated at link time into a hashed table. Look a uniform up
+ * once by name and keep the handle; glxt_set_uniform then costs no string
+ * lookup, and uploads of a value identical to the last one are skipped.
+ * Like glUniform*, the setters apply to the currently enabled program;
+ * glxt_set_uniform on a uniform of any other program fails and uploads
+ * nothing. The named setters keep their old behaviour when glxt did not
+ * bind shader_program itself (a raw glUseProgram): they upload to the GL
+ * program as is, bypassing and invalidating that uniform's cached value.
+ * Values written behind glxt's back (raw glUniform* calls) are not tracked.
+ *
+ * Uniform blocks registered with glxt_register_uniform_block are bound to
+ * their binding point in every program that declares them, so a single
+ * uniform buffer (e.g. per-frame camera data) can be shared by all programs.
+ */
+#ifndef GLXT_MAXIMUM_SHADER_PROGRAMS
+    #define GLXT_MAXIMUM_SHADER_PROGRAMS 64
+#endif
+
+#ifndef GLXT_MAXIMUM_UNIFORM_BLOCKS
+    #define GLXT_MAXIMUM_UNIFORM_BLOCKS 16
+#endif
+
+#define GLXT_MAXIMUM_UNIFORM_NAME 64
+
+typedef uint32_t GLXTUniform;
+
+typedef struct GLXTUniformStats {
+    size_t uploads;
+    size_t uploads_elided;
+} GLXTUniformStats;
+
+GLXTUniform glxt_get_shader_uniform(uint32_t shader_program, const char* name);
+void glxt_set_uniform(GLXTUniform uniform, const void* data, int count);
+GLXTUniformStats glxt_uniform_stats(void);
+
+uint32_t glxt_create_uniform_buffer(size_t buffer_size, const void* buffer_data);
+void glxt_update_uniform_buffer(uint32_t ubo, size_t buffer_size, const void* buffer_data, int offset);
+void glxt_destroy_uniform_buffer(uint32_t ubo);
+void glxt_enable_uniform_buffer(uint32_t ubo, uint32_t binding);
+bool glxt_register_uniform_block(const char* block_name, uint32_t binding);
+bool glxt_bind_shader_uniform_block(uint32_t shader_program, const char* block_name, uint32_t binding);
+
+/**
+ * 2D textures.
+ * Storage is immutable (glTexStorage2D). comp selects an 8 bit per channel
+ * format with 1 to 4 channels; glxt_create_texture2d_from_desc takes
+ * explicit formats, filters and wrapping, zero fields pick the defaults.
+ * glxt_enable_texture2d binds to texture unit 0.
+ */
+typedef struct GLXTTexture2DDesc {
+    uint32_t width;
+    uint32_t height;
+    uint32_t internal_format;
+    uint32_t format;
+    uint32_t type;
+    bool mipmaps;
+    uint32_t min_filter;
+    uint32_t mag_filter;
+    uint32_t wrap;
+} GLXTTexture2DDesc;
+
 uint32_t glxt_create_texture2d(uint32_t width, uint32_t height, int comp, const uint8_t* data);
+uint32_t glxt_create_texture2d_from_desc(const GLXTTexture2DDesc* desc, const void* data);
+void glxt_update_texture2d(uint32_t texture, int x, int y, uint32_t width, uint32_t height,
+    int comp, const uint8_t* data);
+void glxt_generate_texture2d_mipmaps(uint32_t texture);
 void glxt_destroy_texture2d(uint32_t texture);
 void glxt_enable_texture2d(uint32_t texture);
 void glxt_disable_texture2d(uint32_t texture);
 
+/**
+ * Streaming texture updates.
+ * A texture stream owns a ring of GLXT_TEXTURE_STREAM_BUFFERS pixel unpack
+ * buffers, each large enough for the whole texture. Updates are copied (or
+ * written directly between begin/end) into the next free buffer and
+ * uploaded with glTexSubImage2D sourcing from it, so the call returns as
+ * soon as the copy is queued. A buffer is reused only once its fence has
+ * signaled; having to wait for one counts as a stall. A region that does
+ * not lie within the texture fails with GLXT_OPENGL_INVALID_VALUE.
+ */
+#ifndef GLXT_TEXTURE_STREAM_BUFFERS
+    #define GLXT_TEXTURE_STREAM_BUFFERS 3
+#endif
+
+typedef struct GLXTTextureStream {
+    uint32_t texture;
+    uint32_t width, height;
+    uint32_t format, type;
+    size_t pixel_size;
+    bool mipmaps;
+    uint32_t buffers[GLXT_TEXTURE_STREAM_BUFFERS];
+    void* fences[GLXT_TEXTURE_STREAM_BUFFERS];
+    size_t buffer_index;
+    bool mapped;
+    size_t uploads;
+    size_t stalls;
+} GLXTTextureStream;
+
+bool glxt_create_texture_stream(GLXTTextureStream* stream, const GLXTTexture2DDesc* desc);
+void glxt_destroy_texture_stream(GLXTTextureStream* stream);
+void* glxt_begin_texture_stream_update(GLXTTextureStream* stream);
+void glxt_end_texture_stream_update(GLXTTextureStream* stream, int x, int y, uint32_t width, uint32_t height);
+void glxt_update_texture_stream(GLXTTextureStream* stream, int x, int y, uint32_t width, uint32_t height,
+    const void* pixels);
+
+/**
+ * Render targets.
+ * A framebuffer object with a color texture and an optional depth (or
+ * depth-stencil) renderbuffer. Textures are immutable, so resizing
+ * replaces color_texture with a new one. glxt_bind_render_target also
+ * sets the viewport to the size of the target; NULL binds the default
+ * framebuffer and leaves the viewport to the caller.
+ */
+typedef struct GLXTRenderTargetDesc {
+    uint32_t width;
+    uint32_t height;
+    // Formats and sampling of the color texture, its size is ignored.
+    // A zero internal_format picks GL_RGBA8, a zero wrap clamps to edge.
+    GLXTTexture2DDesc color;
+    // 0 for no depth, otherwise GL_DEPTH_COMPONENT24, GL_DEPTH24_STENCIL8...
+    uint32_t depth_format;
+} GLXTRenderTargetDesc;
+
+typedef struct GLXTRenderTarget {
+    uint32_t framebuffer;
+    uint32_t color_texture;
+    uint32_t depth_renderbuffer;
+    uint32_t width, height;
+    GLXTTexture2DDesc color;
+    uint32_t depth_format;
+} GLXTRenderTarget;
+
+bool glxt_create_render_target(GLXTRenderTarget* target, const GLXTRenderTargetDesc* desc);
+bool glxt_resize_render_target(GLXTRenderTarget* target, uint32_t width, uint32_t height);
+void glxt_destroy_render_target(GLXTRenderTarget* target);
+void glxt_bind_render_target(const GLXTRenderTarget* target);
+
+/**
+ * Asynchronous pixel readback.
+ * A readback stream owns a ring of GLXT_READBACK_STREAM_BUFFERS pixel pack
+ * buffers. glxt_queue_readback starts a glReadPixels of the bound
+ * framebuffer into the next free buffer and fences it, so it returns
+ * without waiting for the GPU. Frames come out in order, typically a
+ * couple of frames later: glxt_begin_readback maps the oldest one once its
+ * fence has signaled, or waits for it when asked to, which counts as a
+ * stall. glxt_end_readback releases it. Rows are bottom-up, as GL reads
+ * them. Queueing while every buffer is pending fails with
+ * GLXT_READBACK_STREAM_FULL, the oldest frame has to be taken first.
+ */
+#ifndef GLXT_READBACK_STREAM_BUFFERS
+    #define GLXT_READBACK_STREAM_BUFFERS 3
+#endif
+
+typedef struct GLXTReadbackStream {
+    uint32_t width, height;
+    uint32_t format, type;
+    size_t pixel_size;
+    uint32_t buffers[GLXT_READBACK_STREAM_BUFFERS];
+    void* fences[GLXT_READBACK_STREAM_BUFFERS];
+    uint64_t frames[GLXT_READBACK_STREAM_BUFFERS];
+    // Oldest pending buffer
+    size_t head;
+    size_t pending;
+    bool mapped;
+    uint64_t next_frame;
+    size_t reads;
+    size_t stalls;
+} GLXTReadbackStream;
+
+bool glxt_create_readback_stream(GLXTReadbackStream* stream, uint32_t width, uint32_t height,
+    uint32_t format, uint32_t type);
+void glxt_destroy_readback_stream(GLXTReadbackStream* stream);
+// Reads width x height pixels at (x, y) of the bound framebuffer
+bool glxt_queue_readback(GLXTReadbackStream* stream, int x, int y);
+// NULL while the oldest frame is not ready (without wait) or nothing is pending
+const void* glxt_begin_readback(GLXTReadbackStream* stream, bool wait, uint64_t* frame);
+void glxt_end_readback(GLXTReadbackStream* stream);
+
+/**
+ * Streaming per-instance data.
+ * An instance stream owns a ring of GLXT_INSTANCE_STREAM_BUFFERS vertex
+ * buffers, each holding max_instances records of instance_size bytes.
+ * Every frame the instance records are written into the next buffer (or
+ * copied with glxt_update_instance_stream), then glxt_enable_instance_stream
+ * points the registered attributes of the bound vertex array at it with a
+ * divisor of 1. Moving on to the next buffer fences the previous one, which
+ * is reused only once every draw that read it has completed; having to wait
+ * for it counts as a stall.
+ *
+ * A mat4 attribute takes four consecutive locations, register it as four
+ * vec4 attributes 16 bytes apart.
+ */
+#ifndef GLXT_INSTANCE_STREAM_BUFFERS
+    #define GLXT_INSTANCE_STREAM_BUFFERS 3
+#endif
+
+#ifndef GLXT_INSTANCE_STREAM_MAXIMUM_ATTRIBS
+    #define GLXT_INSTANCE_STREAM_MAXIMUM_ATTRIBS 8
+#endif
+
+typedef struct GLXTInstanceAttrib {
+    uint32_t index;
+    int comp_count;
+    int attr_type;
+    bool normalized;
+    size_t offset;
+} GLXTInstanceAttrib;
+
+typedef struct GLXTInstanceStream {
+    uint32_t buffers[GLXT_INSTANCE_STREAM_BUFFERS];
+    void* fences[GLXT_INSTANCE_STREAM_BUFFERS];
+    size_t buffer_index;
+    size_t instance_size;
+    size_t max_instances;
+    size_t instances_count;
+    GLXTInstanceAttrib attribs[GLXT_INSTANCE_STREAM_MAXIMUM_ATTRIBS];
+    size_t attribs_count;
+    bool written;
+    bool mapped;
+    size_t uploads;
+    size_t stalls;
+} GLXTInstanceStream;
+
+bool glxt_create_instance_stream(GLXTInstanceStream* stream, size_t instance_size, size_t max_instances);
+void glxt_destroy_instance_stream(GLXTInstanceStream* stream);
+bool glxt_add_instance_stream_attrib(GLXTInstanceStream* stream, uint32_t index, int comp_count,
+    int attr_type, bool normalized, size_t offset);
+void* glxt_begin_instance_stream_update(GLXTInstanceStream* stream);
+void glxt_end_instance_stream_update(GLXTInstanceStream* stream, size_t instances_count);
+void glxt_update_instance_stream(GLXTInstanceStream* stream, const void* instances, size_t instances_count);
+void glxt_enable_instance_stream(GLXTInstanceStream* stream);
+
+/**
+ * Batched immediate-mode renderer.
+ * Primitives are accumulated on the CPU and flushed as a single draw call
+ * whenever the material (shader program + texture) or primitive type changes,
+ * or when the staging buffer is full. Flushed vertices are streamed into a
+ * ring of GLXT_BATCH_RING_SEGMENTS vertex buffer regions guarded by fences,
+ * so the CPU never waits for a region the GPU is still reading from.
+ *
+ * Custom shader programs must use the same attribute locations as the
+ * builtin one: 0 = vec2 position, 1 = vec4 color, 2 = vec2 uv.
+ * Texture is bound to unit 0.
+ */
+#ifndef GLXT_BATCH_RING_SEGMENTS
+    #define GLXT_BATCH_RING_SEGMENTS 3
+#endif
+
+enum {
+    GLXT_BATCH_TRIANGLES = 0,
+    GLXT_BATCH_LINES,
+};
+
+typedef struct GLXTBatchVertex {
+    struct { float x, y; } pos;
+    struct { float r, g, b, a; } color;
+    struct { float u, v; } uv;
+} GLXTBatchVertex;
+
+typedef struct GLXTBatchStats {
+    size_t draw_calls;
+    size_t vertices;
+    size_t flushes_on_state_change;
+    size_t flushes_on_capacity;
+    size_t fence_waits;
+} GLXTBatchStats;
+
+bool glxt_batch_init(size_t max_vertices);
+void glxt_batch_deinit(void);
+void glxt_batch_begin(void);
+void glxt_batch_end(void);
+void glxt_batch_flush(void);
+void glxt_batch_set_material(uint32_t shader_program, uint32_t texture);
+void glxt_batch_push_vertices(int primitive, const GLXTBatchVertex* vertices, size_t count);
+void glxt_batch_push_triangle(GLXTBatchVertex a, GLXTBatchVertex b, GLXTBatchVertex c);
+void glxt_batch_push_quad(GLXTBatchVertex a, GLXTBatchVertex b, GLXTBatchVertex c, GLXTBatchVertex d);
+void glxt_batch_push_line(GLXTBatchVertex a, GLXTBatchVertex b);
+GLXTBatchStats glxt_batch_stats(void);
 
 #endif // GLXT_H
 
-#ifndef GLXT_IMPLEMENTATION
+#if defined(GLXT_IMPLEMENTATION) && !defined(GLXT_IMPLEMENTATION_INCLUDED)
+#define GLXT_IMPLEMENTATION_INCLUDED
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <glad/glad.h>
 
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
 enum {
     GLXT_NO_ERROR = 0,
     GLXT_INVALID_NULL_ARGUMENTS,
@@ -93,11 +522,146 @@ enum {
     GLXT_SHADER_PROGRAM_LINKING_FAILURE,
 
     GLXT_FAILED_TO_OPEN_FILE,
+    GLXT_OUT_OF_MEMORY,
+    GLXT_BATCH_NOT_INITIALIZED,
+    GLXT_TOO_MANY_SHADER_PROGRAMS,
+    GLXT_TOO_MANY_UNIFORM_BLOCKS,
+    GLXT_INVALID_UNIFORM_HANDLE,
+    GLXT_UNIFORM_BLOCK_NOT_FOUND,
+    GLXT_PROGRAM_BINARY_UNSUPPORTED,
+    GLXT_FAILED_TO_READ_FILE,
+    GLXT_LOADER_NOT_INITIALIZED,
+    GLXT_LOADER_QUEUE_FULL,
+    GLXT_LOADER_THREAD_FAILURE,
+    GLXT_LOADER_DECODE_FAILURE,
+    GLXT_LOADER_UPLOAD_FAILURE,
+    GLXT_INVALID_TEXTURE_FORMAT,
+    GLXT_TEXTURE_STREAM_NOT_MAPPED,
+    GLXT_ATLAS_FULL,
+    GLXT_ATLAS_INVALID_FILE,
+    GLXT_FAILED_TO_WRITE_FILE,
+    GLXT_COMMAND_LIST_INCOMPLETE,
+    GLXT_INSTANCE_STREAM_NOT_MAPPED,
+    GLXT_TOO_MANY_INSTANCE_ATTRIBS,
+    GLXT_MESH_INVALID_FILE,
+    GLXT_BUFFER_POOL_FULL,
+    GLXT_SHADER_INCLUDE_NOT_FOUND,
+    GLXT_SHADER_INCLUDE_TOO_DEEP,
+    GLXT_FRAMEBUFFER_INCOMPLETE,
+    GLXT_READBACK_STREAM_FULL,
+    GLXT_CAPTURE_THREAD_FAILURE,
+    GLXT_INVALID_TRANSFORM_NODE,
+    GLXT_TRANSFORM_THREAD_FAILURE,
+    GLXT_UNIFORM_PROGRAM_NOT_BOUND,
+    GLXT_UNIFORM_DATA_TOO_SMALL,
+};
+
+typedef struct _GLXTUniformInfo {
+    char name[GLXT_MAXIMUM_UNIFORM_NAME];
+    uint32_t hash;
+    int location;
+    uint32_t type;
+    int array_size;
+    size_t element_size;
+    size_t value_offset;
+    bool cached;
+} _GLXTUniformInfo;
+
+typedef struct _GLXTProgramInfo {
+    uint32_t shader_program;
+    uint8_t generation;
+    size_t uniforms_count;
+    _GLXTUniformInfo* uniforms;
+    uint16_t* table;
+    size_t table_capacity;
+    uint8_t* values;
+} _GLXTProgramInfo;
+
+#define _GLXT_STATE_UNKNOWN 0xFFFFFFFFu
+
+enum {
+    _GLXT_BUFFER_TARGET_ARRAY = 0,
+    _GLXT_BUFFER_TARGET_ELEMENT_ARRAY,
+    _GLXT_BUFFER_TARGET_UNIFORM,
+    _GLXT_BUFFER_TARGET_PIXEL_PACK,
+    _GLXT_BUFFER_TARGET_PIXEL_UNPACK,
+    _GLXT_BUFFER_TARGET_COPY_READ,
+    _GLXT_BUFFER_TARGET_COPY_WRITE,
+    _GLXT_BUFFER_TARGET_TRANSFORM_FEEDBACK,
+    _GLXT_BUFFER_TARGET_COUNT,
 };
 
 struct {
     int last_failure;
     uint32_t default_shader_program;
+
+    // Zero initialized bindings match the defaults of a fresh context,
+    // the fixed function state is unknown until glxt sets it once
+    struct {
+        uint32_t shader_program;
+        uint32_t vertex_array;
+        uint32_t buffers[_GLXT_BUFFER_TARGET_COUNT];
+        uint32_t active_texture_unit;
+        uint32_t textures2d[GLXT_MAXIMUM_TEXTURE_UNITS];
+        uint32_t framebuffer;
+        bool blend_known;
+        bool blend_enabled;
+        uint32_t blend_src, blend_dst;
+        bool depth_test_known;
+        bool depth_test_enabled;
+        uint32_t depth_func;
+        bool depth_mask_known;
+        bool depth_mask;
+        bool viewport_known;
+        int viewport[4];
+        bool unpack_alignment_known;
+        int unpack_alignment;
+        bool pack_alignment_known;
+        int pack_alignment;
+        GLXTStateStats stats;
+    } state;
+
+    GLXTFrameCounters counters;
+
+    struct {
+        uint8_t* base;
+        size_t offset;
+        GLXTAllocatorStats stats;
+    } scratch;
+
+    struct {
+        bool initialized;
+        uint32_t vao;
+        uint32_t vbo;
+        uint32_t white_texture;
+        GLXTBatchVertex* vertices;
+        size_t vertices_count;
+        size_t capacity;
+        int primitive;
+        uint32_t shader_program;
+        uint32_t texture;
+        size_t segment;
+        size_t segment_cursor;
+        GLsync fences[GLXT_BATCH_RING_SEGMENTS];
+        GLXTBatchStats stats;
+    } batch;
+
+    _GLXTProgramInfo programs[GLXT_MAXIMUM_SHADER_PROGRAMS];
+    size_t last_program_slot;
+    GLXTUniformStats uniform_stats;
+
+    struct {
+        char name[GLXT_MAXIMUM_UNIFORM_NAME];
+        uint32_t binding;
+    } uniform_blocks[GLXT_MAXIMUM_UNIFORM_BLOCKS];
+    size_t uniform_blocks_count;
+
+    struct {
+        bool enabled;
+        char directory[GLXT_MAXIMUM_PATH];
+        uint64_t driver_hash;
+        GLXTProgramCacheStats stats;
+    } program_cache;
 } GLXT = {0};
 
 bool glxt_has_failure(void)
@@ -124,6 +688,7 @@ const char* glxt_failure_reason(void)
         case GLXT_NO_ERROR: return NULL;
         case GLXT_INVALID_NULL_ARGUMENTS: return "ERROR: Invalid null arguments";
         case GLXT_FAILED_TO_OPEN_FILE: return "ERROR: Failed to open a file";
+        case GLXT_FAILED_TO_READ_FILE: return "ERROR: Failed to read a file";
         case GLXT_OPENGL_INVALID_ENUM: return "ERROR: GL_INVALID_ENUM";
         case GLXT_OPENGL_INVALID_VALUE: return "ERROR: GL_INVALID_VALUE";
         case GLXT_OPENGL_INVALID_OPERATION: return "ERROR: GL_INVALID_OPERATION";
@@ -134,11 +699,326 @@ const char* glxt_failure_reason(void)
         case GLXT_VERTEX_SHADER_COMPILATION_FAILURE: return "ERROR: Vertex shader compilation failure";
         case GLXT_FRAGMENT_SHADER_COMPILATION_FAILURE: return "ERROR: Fragment shader compilation failure";
         case GLXT_SHADER_PROGRAM_LINKING_FAILURE: return "ERROR: Shader program linking failure";
+        case GLXT_OUT_OF_MEMORY: return "ERROR: Out of memory";
+        case GLXT_BATCH_NOT_INITIALIZED: return "ERROR: Batch renderer is not initialized";
+        case GLXT_TOO_MANY_SHADER_PROGRAMS: return "ERROR: Too many shader programs to reflect";
+        case GLXT_TOO_MANY_UNIFORM_BLOCKS: return "ERROR: Too many registered uniform blocks";
+        case GLXT_INVALID_UNIFORM_HANDLE: return "ERROR: Invalid uniform handle";
+        case GLXT_UNIFORM_BLOCK_NOT_FOUND: return "ERROR: Uniform block not found";
+        case GLXT_PROGRAM_BINARY_UNSUPPORTED: return "ERROR: Program binaries are not supported by the driver";
+        case GLXT_LOADER_NOT_INITIALIZED: return "ERROR: Asset loader is not initialized";
+        case GLXT_LOADER_QUEUE_FULL: return "ERROR: Asset loader queue is full";
+        case GLXT_LOADER_THREAD_FAILURE: return "ERROR: Failed to start asset loader threads";
+        case GLXT_LOADER_DECODE_FAILURE: return "ERROR: Asset decoding failure";
+        case GLXT_LOADER_UPLOAD_FAILURE: return "ERROR: Asset upload failure";
+        case GLXT_INVALID_TEXTURE_FORMAT: return "ERROR: Invalid texture format";
+        case GLXT_TEXTURE_STREAM_NOT_MAPPED: return "ERROR: Texture stream update was not begun";
+        case GLXT_ATLAS_FULL: return "ERROR: Image does not fit in the atlas";
+        case GLXT_ATLAS_INVALID_FILE: return "ERROR: Invalid atlas file";
+        case GLXT_FAILED_TO_WRITE_FILE: return "ERROR: Failed to write a file";
+        case GLXT_COMMAND_LIST_INCOMPLETE: return "ERROR: Command list recording failed, list skipped";
+        case GLXT_INSTANCE_STREAM_NOT_MAPPED: return "ERROR: Instance stream update was not begun";
+        case GLXT_TOO_MANY_INSTANCE_ATTRIBS: return "ERROR: Instance stream has too many attributes";
+        case GLXT_MESH_INVALID_FILE: return "ERROR: Invalid mesh file";
+        case GLXT_BUFFER_POOL_FULL: return "ERROR: Buffer pool is full";
+        case GLXT_SHADER_INCLUDE_NOT_FOUND: return "ERROR: Shader include not found";
+        case GLXT_SHADER_INCLUDE_TOO_DEEP: return "ERROR: Shader includes nested too deeply";
+        case GLXT_FRAMEBUFFER_INCOMPLETE: return "ERROR: Framebuffer is incomplete";
+        case GLXT_READBACK_STREAM_FULL: return "ERROR: Every readback buffer is still pending";
+        case GLXT_CAPTURE_THREAD_FAILURE: return "ERROR: Failed to start the capture writer thread";
+        case GLXT_INVALID_TRANSFORM_NODE: return "ERROR: Transform node is not valid";
+        case GLXT_TRANSFORM_THREAD_FAILURE: return "ERROR: Failed to start the transform worker threads";
+        case GLXT_UNIFORM_PROGRAM_NOT_BOUND: return "ERROR: Uniform set on a program that is not bound";
+        case GLXT_UNIFORM_DATA_TOO_SMALL: return "ERROR: Uniform data is smaller than its count of elements";
         default: return "Invalid error code detected";
     }
     return "Invalid error code detected";
 }
 
+static int _glxt_buffer_target_slot(uint32_t target)
+{
+    switch(target) {
+        case GL_ARRAY_BUFFER: return _GLXT_BUFFER_TARGET_ARRAY;
+        case GL_ELEMENT_ARRAY_BUFFER: return _GLXT_BUFFER_TARGET_ELEMENT_ARRAY;
+        case GL_UNIFORM_BUFFER: return _GLXT_BUFFER_TARGET_UNIFORM;
+        case GL_PIXEL_PACK_BUFFER: return _GLXT_BUFFER_TARGET_PIXEL_PACK;
+        case GL_PIXEL_UNPACK_BUFFER: return _GLXT_BUFFER_TARGET_PIXEL_UNPACK;
+        case GL_COPY_READ_BUFFER: return _GLXT_BUFFER_TARGET_COPY_READ;
+        case GL_COPY_WRITE_BUFFER: return _GLXT_BUFFER_TARGET_COPY_WRITE;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return _GLXT_BUFFER_TARGET_TRANSFORM_FEEDBACK;
+        default: return -1;
+    }
+}
+
+void glxt_invalidate_state(void)
+{
+    GLXT.state.shader_program = _GLXT_STATE_UNKNOWN;
+    GLXT.state.vertex_array = _GLXT_STATE_UNKNOWN;
+    for(size_t i = 0; i < _GLXT_BUFFER_TARGET_COUNT; ++i)
+        GLXT.state.buffers[i] = _GLXT_STATE_UNKNOWN;
+    GLXT.state.active_texture_unit = _GLXT_STATE_UNKNOWN;
+    for(size_t i = 0; i < GLXT_MAXIMUM_TEXTURE_UNITS; ++i)
+        GLXT.state.textures2d[i] = _GLXT_STATE_UNKNOWN;
+    GLXT.state.framebuffer = _GLXT_STATE_UNKNOWN;
+    GLXT.state.blend_known = false;
+    GLXT.state.depth_test_known = false;
+    GLXT.state.depth_mask_known = false;
+    GLXT.state.viewport_known = false;
+    GLXT.state.unpack_alignment_known = false;
+    GLXT.state.pack_alignment_known = false;
+}
+
+GLXTStateStats glxt_state_stats(void)
+{
+    return GLXT.state.stats;
+}
+
+void glxt_reset_state_stats(void)
+{
+    GLXT.state.stats.calls_issued = 0;
+    GLXT.state.stats.calls_elided = 0;
+}
+
+#if GLXT_PROFILER_ENABLED
+    #define _GLXT_COUNT(FIELD, N) (GLXT.counters.FIELD += (N))
+#else
+    #define _GLXT_COUNT(FIELD, N) ((void)0)
+#endif
+
+GLXTFrameCounters glxt_frame_counters(void)
+{
+    return GLXT.counters;
+}
+
+void glxt_reset_frame_counters(void)
+{
+    memset(&GLXT.counters, 0, sizeof(GLXT.counters));
+}
+
+#define _GLXT_SCRATCH_ALIGNMENT 16
+
+void* glxt_scratch_alloc(size_t size)
+{
+    size_t aligned = (size + _GLXT_SCRATCH_ALIGNMENT - 1) & ~(size_t)(_GLXT_SCRATCH_ALIGNMENT - 1);
+    if(GLXT.scratch.base == NULL && aligned <= GLXT_SCRATCH_SIZE) {
+        GLXT.scratch.base = malloc(GLXT_SCRATCH_SIZE);
+        if(GLXT.scratch.base != NULL) GLXT.scratch.stats.heap_allocations += 1;
+    }
+
+    GLXT.scratch.stats.allocations += 1;
+    if(GLXT.scratch.base != NULL && aligned <= GLXT_SCRATCH_SIZE - GLXT.scratch.offset) {
+        void* pointer = GLXT.scratch.base + GLXT.scratch.offset;
+        GLXT.scratch.offset += aligned;
+        GLXT.scratch.stats.bytes_in_use = GLXT.scratch.offset;
+        if(GLXT.scratch.offset > GLXT.scratch.stats.high_water)
+            GLXT.scratch.stats.high_water = GLXT.scratch.offset;
+        return pointer;
+    }
+
+    GLXT.scratch.stats.heap_allocations += 1;
+    void* pointer = malloc(size > 0 ? size : 1);
+    if(pointer == NULL) GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+    return pointer;
+}
+
+void glxt_scratch_free(void* pointer)
+{
+    if(pointer == NULL) return;
+    uintptr_t address = (uintptr_t)pointer, base = (uintptr_t)GLXT.scratch.base;
+    if(GLXT.scratch.base != NULL && address >= base && address < base + GLXT_SCRATCH_SIZE) {
+        GLXT.scratch.offset = address - base;
+        GLXT.scratch.stats.bytes_in_use = GLXT.scratch.offset;
+        return;
+    }
+    free(pointer);
+}
+
+GLXTAllocatorStats glxt_scratch_stats(void)
+{
+    return GLXT.scratch.stats;
+}
+
+void glxt_scratch_deinit(void)
+{
+    free(GLXT.scratch.base);
+    GLXT.scratch.base = NULL;
+    GLXT.scratch.offset = 0;
+    GLXT.scratch.stats.bytes_in_use = 0;
+}
+
+#define _GLXT_STATE_ELIDE(COND) do { \
+    if(COND) { GLXT.state.stats.calls_elided += 1; return; } \
+    GLXT.state.stats.calls_issued += 1; \
+} while(0)
+
+void glxt_bind_buffer(uint32_t target, uint32_t buffer)
+{
+    int slot = _glxt_buffer_target_slot(target);
+    if(slot < 0) {
+        GLXT.state.stats.calls_issued += 1;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    _GLXT_STATE_ELIDE(GLXT.state.buffers[slot] == buffer);
+    GLXT.state.buffers[slot] = buffer;
+    glBindBuffer(target, buffer);
+}
+
+static void _glxt_use_program(uint32_t shader_program)
+{
+    _GLXT_STATE_ELIDE(GLXT.state.shader_program == shader_program);
+    GLXT.state.shader_program = shader_program;
+    glUseProgram(shader_program);
+}
+
+static void _glxt_bind_vertex_array(uint32_t vao)
+{
+    _GLXT_STATE_ELIDE(GLXT.state.vertex_array == vao);
+    GLXT.state.vertex_array = vao;
+    // The element array binding belongs to the vertex array object
+    GLXT.state.buffers[_GLXT_BUFFER_TARGET_ELEMENT_ARRAY] = _GLXT_STATE_UNKNOWN;
+    glBindVertexArray(vao);
+}
+
+static void _glxt_active_texture(uint32_t unit)
+{
+    _GLXT_STATE_ELIDE(GLXT.state.active_texture_unit == unit);
+    GLXT.state.active_texture_unit = unit;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void glxt_bind_texture2d(uint32_t unit, uint32_t texture)
+{
+    if(unit >= GLXT_MAXIMUM_TEXTURE_UNITS) {
+        GLXT.state.stats.calls_issued += 2;
+        GLXT.state.active_texture_unit = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+    if(GLXT.state.textures2d[unit] == texture) {
+        GLXT.state.stats.calls_elided += 1;
+        return;
+    }
+    _glxt_active_texture(unit);
+    GLXT.state.stats.calls_issued += 1;
+    GLXT.state.textures2d[unit] = texture;
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void glxt_bind_framebuffer(uint32_t framebuffer)
+{
+    _GLXT_STATE_ELIDE(GLXT.state.framebuffer == framebuffer);
+    GLXT.state.framebuffer = framebuffer;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+static void _glxt_forget_buffer(uint32_t buffer)
+{
+    // Deleting a bound buffer reverts its bindings to 0
+    for(size_t i = 0; i < _GLXT_BUFFER_TARGET_COUNT; ++i)
+        if(GLXT.state.buffers[i] == buffer) GLXT.state.buffers[i] = 0;
+}
+
+static void _glxt_forget_texture2d(uint32_t texture)
+{
+    for(size_t i = 0; i < GLXT_MAXIMUM_TEXTURE_UNITS; ++i)
+        if(GLXT.state.textures2d[i] == texture) GLXT.state.textures2d[i] = 0;
+}
+
+void glxt_set_blend(bool enabled, uint32_t src_factor, uint32_t dst_factor)
+{
+    bool known = GLXT.state.blend_known;
+    if(known && GLXT.state.blend_enabled == enabled) {
+        GLXT.state.stats.calls_elided += 1;
+    } else {
+        GLXT.state.stats.calls_issued += 1;
+        if(enabled) glEnable(GL_BLEND);
+        else glDisable(GL_BLEND);
+    }
+    GLXT.state.blend_enabled = enabled;
+    GLXT.state.blend_known = true;
+    if(!enabled) return;
+
+    if(known && GLXT.state.blend_src == src_factor && GLXT.state.blend_dst == dst_factor) {
+        GLXT.state.stats.calls_elided += 1;
+        return;
+    }
+    GLXT.state.stats.calls_issued += 1;
+    GLXT.state.blend_src = src_factor;
+    GLXT.state.blend_dst = dst_factor;
+    glBlendFunc(src_factor, dst_factor);
+}
+
+void glxt_set_depth_test(bool enabled, uint32_t func)
+{
+    bool known = GLXT.state.depth_test_known;
+    if(known && GLXT.state.depth_test_enabled == enabled) {
+        GLXT.state.stats.calls_elided += 1;
+    } else {
+        GLXT.state.stats.calls_issued += 1;
+        if(enabled) glEnable(GL_DEPTH_TEST);
+        else glDisable(GL_DEPTH_TEST);
+    }
+    GLXT.state.depth_test_enabled = enabled;
+    GLXT.state.depth_test_known = true;
+    if(!enabled) return;
+
+    if(known && GLXT.state.depth_func == func) {
+        GLXT.state.stats.calls_elided += 1;
+        return;
+    }
+    GLXT.state.stats.calls_issued += 1;
+    GLXT.state.depth_func = func;
+    glDepthFunc(func);
+}
+
+void glxt_set_depth_mask(bool enabled)
+{
+    _GLXT_STATE_ELIDE(GLXT.state.depth_mask_known && GLXT.state.depth_mask == enabled);
+    GLXT.state.depth_mask = enabled;
+    GLXT.state.depth_mask_known = true;
+    glDepthMask(enabled);
+}
+
+void glxt_set_viewport(int x, int y, int width, int height)
+{
+    _GLXT_STATE_ELIDE(GLXT.state.viewport_known
+        && GLXT.state.viewport[0] == x && GLXT.state.viewport[1] == y
+        && GLXT.state.viewport[2] == width && GLXT.state.viewport[3] == height);
+    GLXT.state.viewport[0] = x;
+    GLXT.state.viewport[1] = y;
+    GLXT.state.viewport[2] = width;
+    GLXT.state.viewport[3] = height;
+    GLXT.state.viewport_known = true;
+    glViewport(x, y, width, height);
+}
+
+// Returns the previous alignment, so the caller can put back what the application had set
+static int _glxt_pixel_alignment(uint32_t pname, int alignment)
+{
+    bool* known = &GLXT.state.unpack_alignment_known;
+    int* current = &GLXT.state.unpack_alignment;
+    if(pname == GL_PACK_ALIGNMENT) {
+        known = &GLXT.state.pack_alignment_known;
+        current = &GLXT.state.pack_alignment;
+    }
+    if(!*known) {
+        glGetIntegerv(pname, current);
+        *known = true;
+    }
+
+    int previous = *current;
+    if(previous == alignment) {
+        GLXT.state.stats.calls_elided += 1;
+        return previous;
+    }
+    GLXT.state.stats.calls_issued += 1;
+    *current = alignment;
+    glPixelStorei(pname, alignment);
+    return previous;
+}
+
 uint32_t glxt_create_vertex_array(void)
 {
     uint32_t vao = 0;
@@ -148,17 +1028,18 @@ uint32_t glxt_create_vertex_array(void)
 
 void glxt_destroy_vertex_array(uint32_t vao)
 {
+    if(GLXT.state.vertex_array == vao) GLXT.state.vertex_array = 0;
     glDeleteVertexArrays(1, &vao);
 }
 
 void glxt_enable_vertex_array(uint32_t vao)
 {
-    glBindVertexArray(vao);
+    _glxt_bind_vertex_array(vao);
 }
 
 void glxt_disable_vertex_array(void)
 {
-    glBindVertexArray(0);
+    _glxt_bind_vertex_array(0);
 }
 
 void glxt_set_vertex_attrib(uint32_t index, int comp_count, int attr_type, 
@@ -168,47 +1049,90 @@ void glxt_set_vertex_attrib(uint32_t index, int comp_count, int attr_type,
     glVertexAttribPointer(index, comp_count, attr_type, normalized, vertex_size, attr_offset);
 }
 
+void glxt_set_vertex_attrib_divisor(uint32_t index, uint32_t divisor)
+{
+    glVertexAttribDivisor(index, divisor);
+}
+
+void glxt_set_instance_attrib(uint32_t index, int comp_count, int attr_type,
+    bool normalized, size_t instance_size, const void *attr_offset, uint32_t divisor)
+{
+    glxt_set_vertex_attrib(index, comp_count, attr_type, normalized, instance_size, attr_offset);
+    glVertexAttribDivisor(index, divisor);
+}
+
 void glxt_draw_vertex_array(int offset, int count)
 {
-    glDrawArrays(GL_TRIANGLES, offset, count);
+    glxt_draw_arrays(GL_TRIANGLES, offset, count);
 }
 
 void glxt_draw_vertex_array_elements(int offset, int count, const void* buffer)
 {
     glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const uint32_t*)buffer + offset);
+    _GLXT_COUNT(draw_calls, 1);
+    _GLXT_COUNT(vertices, count);
+}
+
+void glxt_draw_arrays(uint32_t mode, int first, int count)
+{
+    glDrawArrays(mode, first, count);
+    _GLXT_COUNT(draw_calls, 1);
+    _GLXT_COUNT(vertices, count);
+}
+
+void glxt_draw_arrays_instanced(uint32_t mode, int first, int count, int instances_count)
+{
+    glDrawArraysInstanced(mode, first, count, instances_count);
+    _GLXT_COUNT(draw_calls, 1);
+    _GLXT_COUNT(vertices, (size_t)count * instances_count);
+}
+
+void glxt_draw_elements(uint32_t mode, int count, uint32_t index_type, size_t offset)
+{
+    glDrawElements(mode, count, index_type, (const void*)(uintptr_t)offset);
+    _GLXT_COUNT(draw_calls, 1);
+    _GLXT_COUNT(vertices, count);
+}
+
+void glxt_draw_elements_instanced(uint32_t mode, int count, uint32_t index_type, size_t offset,
+    int instances_count)
+{
+    glDrawElementsInstanced(mode, count, index_type, (const void*)(uintptr_t)offset, instances_count);
+    _GLXT_COUNT(draw_calls, 1);
+    _GLXT_COUNT(vertices, (size_t)count * instances_count);
 }
 
 uint32_t glxt_create_vertex_buffer(size_t buffer_size, const void* buffer_data)
 {
     uint32_t vbo = 0;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glxt_bind_buffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, buffer_size, buffer_data, GL_DYNAMIC_DRAW);
-
-    DEBUG_DO(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    if(buffer_data != NULL) _GLXT_COUNT(bytes_uploaded, buffer_size);
     return vbo;
 }
 
 void glxt_update_vertex_buffer(uint32_t vbo, size_t buffer_size, const void* buffer_data, int offset)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glxt_bind_buffer(GL_ARRAY_BUFFER, vbo);
     glBufferSubData(GL_ARRAY_BUFFER, offset, buffer_size, buffer_data);
-    DEBUG_DO(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    _GLXT_COUNT(bytes_uploaded, buffer_size);
 }
 
 void glxt_destroy_vertex_buffer(uint32_t vbo)
 {
+    _glxt_forget_buffer(vbo);
     glDeleteBuffers(1, &vbo);
 }
 
 void glxt_enable_vertex_buffer(uint32_t vbo)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glxt_bind_buffer(GL_ARRAY_BUFFER, vbo);
 }
 
 void glxt_disable_vertex_buffer(void)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glxt_bind_buffer(GL_ARRAY_BUFFER, 0);
 }
 
 
@@ -216,37 +1140,258 @@ uint32_t glxt_create_index_buffer(size_t buffer_size, const void* buffer_data)
 {
     uint32_t ibo = 0;
     glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glxt_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffer_size, buffer_data, GL_DYNAMIC_DRAW);
-
-    DEBUG_DO(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    if(buffer_data != NULL) _GLXT_COUNT(bytes_uploaded, buffer_size);
     return ibo;
 }
 
 void glxt_update_index_buffer(uint32_t ibo, size_t buffer_size, const void* buffer_data, int offset)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glxt_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, buffer_size, buffer_data);
-
-    DEBUG_DO(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    _GLXT_COUNT(bytes_uploaded, buffer_size);
 }
 
 void glxt_destroy_index_buffer(uint32_t ibo)
 {
+    _glxt_forget_buffer(ibo);
     glDeleteBuffers(1, &ibo);
 }
 
 void glxt_enable_index_buffer(uint32_t ibo)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glxt_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 }
 
 void glxt_disable_index_buffer(void)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glxt_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-uint32_t glxt_create_shader_program(const char* vert_source, const char* frag_source)
+static uint32_t _glxt_hash_string(const char* str)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while(*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t _glxt_uniform_element_size(uint32_t type)
+{
+    switch(type) {
+        case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL: return 4;
+        case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 8;
+        case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 12;
+        case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: return 16;
+        case GL_FLOAT_MAT2: return 16;
+        case GL_FLOAT_MAT3: return 36;
+        case GL_FLOAT_MAT4: return 64;
+        case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2: return 24;
+        case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2: return 32;
+        case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3: return 48;
+        default: return 4; // samplers
+    }
+}
+
+static void _glxt_upload_uniform(uint32_t type, int location, int count, const void* data)
+{
+    switch(type) {
+        case GL_FLOAT: glUniform1fv(location, count, (const float*)data); break;
+        case GL_FLOAT_VEC2: glUniform2fv(location, count, (const float*)data); break;
+        case GL_FLOAT_VEC3: glUniform3fv(location, count, (const float*)data); break;
+        case GL_FLOAT_VEC4: glUniform4fv(location, count, (const float*)data); break;
+        case GL_INT: case GL_BOOL: glUniform1iv(location, count, (const int*)data); break;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(location, count, (const int*)data); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(location, count, (const int*)data); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(location, count, (const int*)data); break;
+        case GL_UNSIGNED_INT: glUniform1uiv(location, count, (const uint32_t*)data); break;
+        case GL_UNSIGNED_INT_VEC2: glUniform2uiv(location, count, (const uint32_t*)data); break;
+        case GL_UNSIGNED_INT_VEC3: glUniform3uiv(location, count, (const uint32_t*)data); break;
+        case GL_UNSIGNED_INT_VEC4: glUniform4uiv(location, count, (const uint32_t*)data); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT2x3: glUniformMatrix2x3fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT3x2: glUniformMatrix3x2fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT2x4: glUniformMatrix2x4fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT4x2: glUniformMatrix4x2fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT3x4: glUniformMatrix3x4fv(location, count, false, (const float*)data); break;
+        case GL_FLOAT_MAT4x3: glUniformMatrix4x3fv(location, count, false, (const float*)data); break;
+        default: glUniform1iv(location, count, (const int*)data); break; // samplers
+    }
+}
+
+static _GLXTProgramInfo* _glxt_find_program_info(uint32_t shader_program)
+{
+    if(shader_program == 0) return NULL;
+    if(GLXT.programs[GLXT.last_program_slot].shader_program == shader_program)
+        return &GLXT.programs[GLXT.last_program_slot];
+
+    for(size_t i = 0; i < GLXT_MAXIMUM_SHADER_PROGRAMS; ++i) {
+        if(GLXT.programs[i].shader_program == shader_program) {
+            GLXT.last_program_slot = i;
+            return &GLXT.programs[i];
+        }
+    }
+    return NULL;
+}
+
+static _GLXTUniformInfo* _glxt_find_uniform_info(_GLXTProgramInfo* program, const char* name, size_t* index)
+{
+    if(program == NULL || program->table_capacity == 0) return NULL;
+
+    uint32_t hash = _glxt_hash_string(name);
+    size_t mask = program->table_capacity - 1;
+    for(size_t i = hash & mask; program->table[i] != 0; i = (i + 1) & mask) {
+        _GLXTUniformInfo* info = &program->uniforms[program->table[i] - 1];
+        if(info->hash == hash && strcmp(info->name, name) == 0) {
+            if(index != NULL) *index = program->table[i] - 1;
+            return info;
+        }
+    }
+    return NULL;
+}
+
+// Returns true when the value is identical to the last one uploaded,
+// otherwise records it as the new cached value
+static bool _glxt_uniform_is_redundant(_GLXTProgramInfo* program, _GLXTUniformInfo* info,
+    const void* data, int count)
+{
+    if(count <= 0 || count > info->array_size) return false;
+
+    uint8_t* cached = program->values + info->value_offset;
+    size_t size = info->element_size * (size_t)count;
+    if(info->cached && memcmp(cached, data, size) == 0) {
+        GLXT.uniform_stats.uploads_elided += 1;
+        return true;
+    }
+    memcpy(cached, data, size);
+    // Only a full upload makes the whole cached array trustworthy
+    info->cached = info->cached || count == info->array_size;
+    GLXT.uniform_stats.uploads += 1;
+    return false;
+}
+
+static void _glxt_apply_uniform_block_bindings(uint32_t shader_program)
+{
+    for(size_t i = 0; i < GLXT.uniform_blocks_count; ++i) {
+        uint32_t index = glGetUniformBlockIndex(shader_program, GLXT.uniform_blocks[i].name);
+        if(index != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader_program, index, GLXT.uniform_blocks[i].binding);
+    }
+}
+
+static void _glxt_release_program_info(_GLXTProgramInfo* program)
+{
+    free(program->uniforms);
+    free(program->table);
+    free(program->values);
+    program->uniforms = NULL;
+    program->table = NULL;
+    program->values = NULL;
+    program->uniforms_count = 0;
+    program->table_capacity = 0;
+    program->shader_program = 0;
+}
+
+// Shared with the companion headers, which are implemented in the same file
+static inline bool _glxt_has_extension(const char* name)
+{
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(int i = 0; i < count; ++i) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if(extension != NULL && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static void _glxt_reflect_shader_program(uint32_t shader_program)
+{
+    _GLXTProgramInfo* program = NULL;
+    for(size_t i = 0; i < GLXT_MAXIMUM_SHADER_PROGRAMS; ++i) {
+        if(GLXT.programs[i].shader_program == 0) {
+            program = &GLXT.programs[i];
+            break;
+        }
+    }
+    // Not fatal: untracked programs fall back to glGetUniformLocation
+    if(program == NULL) {
+        GLXT.last_failure = GLXT_TOO_MANY_SHADER_PROGRAMS;
+        return;
+    }
+
+    int active_count = 0;
+    glGetProgramiv(shader_program, GL_ACTIVE_UNIFORMS, &active_count);
+
+    _GLXTUniformInfo* uniforms = calloc(active_count > 0 ? active_count : 1, sizeof(_GLXTUniformInfo));
+    if(uniforms == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return;
+    }
+
+    size_t uniforms_count = 0;
+    size_t values_size = 0;
+    for(int i = 0; i < active_count; ++i) {
+        _GLXTUniformInfo* info = &uniforms[uniforms_count];
+        int length = 0, size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(shader_program, i, GLXT_MAXIMUM_UNIFORM_NAME, &length, &size, &type, info->name);
+
+        // Members of uniform blocks have no location
+        info->location = glGetUniformLocation(shader_program, info->name);
+        if(info->location == -1) continue;
+
+        // Arrays are reported as "name[0]", look them up as "name"
+        if(length > 3 && strcmp(info->name + length - 3, "[0]") == 0)
+            info->name[length - 3] = '\0';
+
+        info->hash = _glxt_hash_string(info->name);
+        info->type = type;
+        info->array_size = size;
+        info->element_size = _glxt_uniform_element_size(type);
+        info->value_offset = values_size;
+        info->cached = false;
+        values_size += info->element_size * size;
+        uniforms_count += 1;
+    }
+
+    size_t table_capacity = 8;
+    while(table_capacity < uniforms_count * 2) table_capacity *= 2;
+
+    uint16_t* table = calloc(table_capacity, sizeof(uint16_t));
+    uint8_t* values = calloc(values_size > 0 ? values_size : 1, 1);
+    if(table == NULL || values == NULL) {
+        free(uniforms);
+        free(table);
+        free(values);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return;
+    }
+
+    for(size_t i = 0; i < uniforms_count; ++i) {
+        size_t slot = uniforms[i].hash & (table_capacity - 1);
+        while(table[slot] != 0) slot = (slot + 1) & (table_capacity - 1);
+        table[slot] = (uint16_t)(i + 1);
+    }
+
+    program->shader_program = shader_program;
+    program->generation = program->generation == 0xFF ? 1 : program->generation + 1;
+    program->uniforms = uniforms;
+    program->uniforms_count = uniforms_count;
+    program->table = table;
+    program->table_capacity = table_capacity;
+    program->values = values;
+
+    _glxt_apply_uniform_block_bindings(shader_program);
+}
+
+static uint32_t _glxt_compile_shader_program(const char* vert_source, const char* frag_source,
+    bool retrievable)
 {
     // Create and compile the vertex shader
     int is_compiled;
@@ -261,10 +1406,11 @@ uint32_t glxt_create_shader_program(const char* vert_source, const char* frag_so
         DEBUG_DO(do {
             int error_log_length = 0;
             glGetShaderiv(vert_shader, GL_INFO_LOG_LENGTH, &error_log_length);
-            char* err_msg = malloc(error_log_length * sizeof(char));
+            char* err_msg = glxt_scratch_alloc(error_log_length * sizeof(char));
+            if(err_msg == NULL) break;
             glGetShaderInfoLog(vert_shader, error_log_length, &error_log_length, err_msg);
             fprintf(stderr, "%s\n", err_msg);
-            free(err_msg);
+            glxt_scratch_free(err_msg);
         } while(0));
         glDeleteShader(vert_shader);
         return 0;
@@ -282,10 +1428,11 @@ uint32_t glxt_create_shader_program(const char* vert_source, const char* frag_so
         DEBUG_DO(do {
             int error_log_length = 0;
             glGetShaderiv(frag_shader, GL_INFO_LOG_LENGTH, &error_log_length);
-            char* err_msg = malloc(error_log_length * sizeof(char));
+            char* err_msg = glxt_scratch_alloc(error_log_length * sizeof(char));
+            if(err_msg == NULL) break;
             glGetShaderInfoLog(frag_shader, error_log_length, &error_log_length, err_msg);
             fprintf(stderr, "%s\n", err_msg);
-            free(err_msg);
+            glxt_scratch_free(err_msg);
         } while(0));
         glDeleteShader(vert_shader);
         glDeleteShader(frag_shader);
@@ -296,6 +1443,8 @@ uint32_t glxt_create_shader_program(const char* vert_source, const char* frag_so
     uint32_t shader_program = glCreateProgram();
     glAttachShader(shader_program, vert_shader);
     glAttachShader(shader_program, frag_shader);
+    if(retrievable)
+        glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(shader_program);
 
     int is_linked = 0;
@@ -305,113 +1454,1176 @@ uint32_t glxt_create_shader_program(const char* vert_source, const char* frag_so
         DEBUG_DO(do {
             int error_log_length = 0;
             glGetProgramiv(shader_program, GL_INFO_LOG_LENGTH, &error_log_length);
-            char* err_msg = malloc(error_log_length * sizeof(char));
+            char* err_msg = glxt_scratch_alloc(error_log_length * sizeof(char));
+            if(err_msg == NULL) break;
             glGetProgramInfoLog(shader_program, error_log_length, &error_log_length, err_msg);
             fprintf(stderr, "%s\n", err_msg);
-            free(err_msg);
+            glxt_scratch_free(err_msg);
         } while(0));
         glDeleteShader(vert_shader);
         glDeleteShader(frag_shader);
+        glDeleteProgram(shader_program);
         return 0;
     }
 
     glDeleteShader(vert_shader);
     glDeleteShader(frag_shader);
 
-    DEBUG_DO(_glxt_check_opengl_error());
-
     return shader_program;
 }
 
-void glxt_destroy_shader_program(uint32_t shader_program)
+#define _GLXT_PROGRAM_BINARY_MAGIC 0x42584C47u // "GLXB"
+#define _GLXT_PROGRAM_BINARY_VERSION 1u
+
+typedef struct _GLXTProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+} _GLXTProgramBinaryHeader;
+
+static uint64_t _glxt_hash64(uint64_t hash, const void* data, size_t size)
 {
-    glDeleteProgram(shader_program);
+    // FNV-1a, chainable by passing the previous hash back in
+    const uint8_t* bytes = (const uint8_t*)data;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
 }
 
-void glxt_enable_shader_program(uint32_t shader_program)
+static uint64_t _glxt_program_cache_key(const char* vert_source, const char* frag_source)
 {
-    glUseProgram(shader_program);
+    uint64_t key = GLXT.program_cache.driver_hash;
+    key = _glxt_hash64(key, vert_source, strlen(vert_source) + 1);
+    key = _glxt_hash64(key, frag_source, strlen(frag_source) + 1);
+    return key;
 }
 
-void glxt_disable_shader_program(uint32_t shader_program)
+// Room for the directory plus "/<16 hex digits>.glxb.tmp"
+#define _GLXT_PROGRAM_CACHE_PATH_SIZE (GLXT_MAXIMUM_PATH + 32)
+
+static void _glxt_program_cache_path(char* path, uint64_t key)
 {
-    glUseProgram(0);
+    snprintf(path, _GLXT_PROGRAM_CACHE_PATH_SIZE, "%s/%016llx.glxb",
+        GLXT.program_cache.directory, (unsigned long long)key);
 }
 
-void glxt_set_shader_uniform(uint32_t shader_program, const char* name, 
-    const void* data, int uniform_type, int count)
+static uint32_t _glxt_program_cache_load(uint64_t key)
 {
-    int location = -1;
-    location = glGetUniformLocation(shader_program, name);
-    if(location == -1)
-        GLXT.last_failure = GLXT_UNIFORM_LOCATION_NOT_FOUND;
+    char path[_GLXT_PROGRAM_CACHE_PATH_SIZE];
+    _glxt_program_cache_path(path, key);
 
-    switch(uniform_type)
-    {
-        case GLXT_SHADER_UNIFORM_FLOAT: glUniform1fv(location, count, (float*)data); break;
-        case GLXT_SHADER_UNIFORM_VEC2: glUniform2fv(location, count, (float*)data); break;
-        case GLXT_SHADER_UNIFORM_VEC3: glUniform3fv(location, count, (float*)data); break;
-        case GLXT_SHADER_UNIFORM_VEC4: glUniform4fv(location, count, (float*)data); break;
-        case GLXT_SHADER_UNIFORM_INT: glUniform1iv(location, count, (int*)data); break;
-        case GLXT_SHADER_UNIFORM_IVEC2: glUniform2iv(location, count, (int*)data); break;
-        case GLXT_SHADER_UNIFORM_IVEC3: glUniform3iv(location, count, (int*)data); break;
-        case GLXT_SHADER_UNIFORM_IVEC4: glUniform4iv(location, count, (int*)data); break;
-        case GLXT_SHADER_UNIFORM_SAMPLER2D: glUniform1iv(location, count, (int*)data); break;
-        default:
-            GLXT.last_failure = GLXT_UNKNOWN_UNIFORM_SHADER_TYPE;
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+        GLXT.program_cache.stats.misses += 1;
+        return 0;
     }
 
-    DEBUG_DO(_glxt_check_opengl_error());
+    _GLXTProgramBinaryHeader header = {0};
+    void* binary = NULL;
+    bool valid = fread(&header, sizeof(header), 1, f) == 1
+        && header.magic == _GLXT_PROGRAM_BINARY_MAGIC
+        && header.version == _GLXT_PROGRAM_BINARY_VERSION
+        && header.key == key && header.length > 0;
+    if(valid) {
+        binary = glxt_scratch_alloc(header.length);
+        valid = binary != NULL && fread(binary, header.length, 1, f) == 1;
+    }
+    fclose(f);
+
+    uint32_t shader_program = 0;
+    if(valid) {
+        shader_program = glCreateProgram();
+        glProgramBinary(shader_program, header.format, binary, header.length);
+        int is_linked = 0;
+        glGetProgramiv(shader_program, GL_LINK_STATUS, &is_linked);
+        if(is_linked == GL_FALSE) {
+            glDeleteProgram(shader_program);
+            shader_program = 0;
+        }
+    }
+    glxt_scratch_free(binary);
+
+    // Driver updates invalidate binaries, the entry is rewritten after compiling
+    if(shader_program == 0) {
+        GLXT.program_cache.stats.rejected += 1;
+        GLXT.program_cache.stats.misses += 1;
+        _glxt_check_opengl_error();
+        return 0;
+    }
+    GLXT.program_cache.stats.hits += 1;
+    return shader_program;
+}
+
+static void _glxt_program_cache_store(uint64_t key, uint32_t shader_program)
+{
+    int length = 0;
+    glGetProgramiv(shader_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) return;
+
+    void* binary = glxt_scratch_alloc(length);
+    if(binary == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return;
+    }
+
+    _GLXTProgramBinaryHeader header = {0};
+    header.magic = _GLXT_PROGRAM_BINARY_MAGIC;
+    header.version = _GLXT_PROGRAM_BINARY_VERSION;
+    header.key = key;
+    GLenum format = 0;
+    glGetProgramBinary(shader_program, length, &length, &format, binary);
+    header.format = format;
+    header.length = (uint32_t)length;
+
+    // Write to a temporary file first so a crash never leaves a torn entry
+    char path[_GLXT_PROGRAM_CACHE_PATH_SIZE];
+    char temp_path[_GLXT_PROGRAM_CACHE_PATH_SIZE];
+    _glxt_program_cache_path(path, key);
+    _glxt_program_cache_path(temp_path, key);
+    strcat(temp_path, ".tmp");
+
+    FILE* f = fopen(temp_path, "wb");
+    if(f == NULL) {
+        glxt_scratch_free(binary);
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1
+        && fwrite(binary, header.length, 1, f) == 1;
+    written = fclose(f) == 0 && written;
+    glxt_scratch_free(binary);
+
+#if defined(_WIN32)
+    // rename does not replace an existing file on Windows, a stale entry for the key has to go first
+    if(written) remove(path);
+#endif
+    if(written && rename(temp_path, path) == 0) {
+        GLXT.program_cache.stats.stores += 1;
+    } else {
+        remove(temp_path);
+    }
+}
+
+uint32_t glxt_create_shader_program(const char* vert_source, const char* frag_source)
+{
+    if(vert_source == NULL || frag_source == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    uint64_t key = 0;
+    uint32_t shader_program = 0;
+    if(GLXT.program_cache.enabled) {
+        key = _glxt_program_cache_key(vert_source, frag_source);
+        shader_program = _glxt_program_cache_load(key);
+    }
+
+    if(shader_program == 0) {
+        shader_program = _glxt_compile_shader_program(vert_source, frag_source,
+            GLXT.program_cache.enabled);
+        if(shader_program == 0) return 0;
+        if(GLXT.program_cache.enabled)
+            _glxt_program_cache_store(key, shader_program);
+    }
+
+    _glxt_reflect_shader_program(shader_program);
+
+    DEBUG_DO(_glxt_check_opengl_error());
+
+    return shader_program;
+}
+
+bool glxt_program_cache_init(const char* directory)
+{
+    if(directory == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    int formats_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_count);
+    if(formats_count <= 0) {
+        GLXT.last_failure = GLXT_PROGRAM_BINARY_UNSUPPORTED;
+        return false;
+    }
+
+    // Binaries are only valid for the exact driver that produced them
+    const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    uint64_t driver_hash = 14695981039346656037ull;
+    for(size_t i = 0; i < sizeof(driver_strings) / sizeof(driver_strings[0]); ++i) {
+        const char* str = (const char*)glGetString(driver_strings[i]);
+        if(str != NULL) driver_hash = _glxt_hash64(driver_hash, str, strlen(str) + 1);
+    }
+
+    snprintf(GLXT.program_cache.directory, GLXT_MAXIMUM_PATH, "%s", directory);
+    GLXT.program_cache.driver_hash = driver_hash;
+    GLXT.program_cache.enabled = true;
+    return true;
+}
+
+void glxt_program_cache_deinit(void)
+{
+    GLXT.program_cache.enabled = false;
+}
+
+size_t glxt_program_cache_prewarm(const GLXTShaderSources* sources, size_t count)
+{
+    if(sources == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    if(!GLXT.program_cache.enabled) return 0;
+
+    size_t stored = 0;
+    for(size_t i = 0; i < count; ++i) {
+        if(sources[i].vert_source == NULL || sources[i].frag_source == NULL) continue;
+
+        uint64_t key = _glxt_program_cache_key(sources[i].vert_source, sources[i].frag_source);
+        char path[_GLXT_PROGRAM_CACHE_PATH_SIZE];
+        _glxt_program_cache_path(path, key);
+        FILE* f = fopen(path, "rb");
+        if(f != NULL) {
+            fclose(f);
+            continue;
+        }
+
+        uint32_t shader_program = _glxt_compile_shader_program(
+            sources[i].vert_source, sources[i].frag_source, true);
+        if(shader_program == 0) continue;
+
+        size_t stores = GLXT.program_cache.stats.stores;
+        _glxt_program_cache_store(key, shader_program);
+        stored += GLXT.program_cache.stats.stores - stores;
+        glDeleteProgram(shader_program);
+    }
+    return stored;
+}
+
+GLXTProgramCacheStats glxt_program_cache_stats(void)
+{
+    return GLXT.program_cache.stats;
+}
+
+void glxt_destroy_shader_program(uint32_t shader_program)
+{
+    _GLXTProgramInfo* program = _glxt_find_program_info(shader_program);
+    if(program != NULL) _glxt_release_program_info(program);
+    // A deleted program stays current until replaced, stop trusting the shadow
+    if(GLXT.state.shader_program == shader_program)
+        GLXT.state.shader_program = _GLXT_STATE_UNKNOWN;
+    glDeleteProgram(shader_program);
+}
+
+void glxt_enable_shader_program(uint32_t shader_program)
+{
+    _glxt_use_program(shader_program);
+}
+
+void glxt_disable_shader_program(uint32_t shader_program)
+{
+    _glxt_use_program(0);
+}
+
+void glxt_set_shader_uniform(uint32_t shader_program, const char* name, 
+    const void* data, int uniform_type, int count)
+{
+    // Bound behind glxt's back the value goes up uncached, the cached one is stale after it
+    bool bound = GLXT.state.shader_program == shader_program;
+    _GLXTProgramInfo* program = _glxt_find_program_info(shader_program);
+    _GLXTUniformInfo* info = _glxt_find_uniform_info(program, name, NULL);
+    if(info != NULL && !bound) info->cached = false;
+
+    int location = -1;
+    if(info != NULL) location = info->location;
+    else location = glGetUniformLocation(shader_program, name);
+    if(location == -1)
+        GLXT.last_failure = GLXT_UNIFORM_LOCATION_NOT_FOUND;
+
+    // Only trust the cache when the caller's type has the reflected size
+    size_t element_size = 0;
+    switch(uniform_type) {
+        case GLXT_SHADER_UNIFORM_FLOAT: case GLXT_SHADER_UNIFORM_INT:
+        case GLXT_SHADER_UNIFORM_SAMPLER2D: element_size = 4; break;
+        case GLXT_SHADER_UNIFORM_VEC2: case GLXT_SHADER_UNIFORM_IVEC2: element_size = 8; break;
+        case GLXT_SHADER_UNIFORM_VEC3: case GLXT_SHADER_UNIFORM_IVEC3: element_size = 12; break;
+        case GLXT_SHADER_UNIFORM_VEC4: case GLXT_SHADER_UNIFORM_IVEC4: element_size = 16; break;
+    }
+    if(bound && info != NULL && element_size == info->element_size
+        && _glxt_uniform_is_redundant(program, info, data, count))
+        return;
+
+    switch(uniform_type)
+    {
+        case GLXT_SHADER_UNIFORM_FLOAT: glUniform1fv(location, count, (float*)data); break;
+        case GLXT_SHADER_UNIFORM_VEC2: glUniform2fv(location, count, (float*)data); break;
+        case GLXT_SHADER_UNIFORM_VEC3: glUniform3fv(location, count, (float*)data); break;
+        case GLXT_SHADER_UNIFORM_VEC4: glUniform4fv(location, count, (float*)data); break;
+        case GLXT_SHADER_UNIFORM_INT: glUniform1iv(location, count, (int*)data); break;
+        case GLXT_SHADER_UNIFORM_IVEC2: glUniform2iv(location, count, (int*)data); break;
+        case GLXT_SHADER_UNIFORM_IVEC3: glUniform3iv(location, count, (int*)data); break;
+        case GLXT_SHADER_UNIFORM_IVEC4: glUniform4iv(location, count, (int*)data); break;
+        case GLXT_SHADER_UNIFORM_SAMPLER2D: glUniform1iv(location, count, (int*)data); break;
+        default:
+            GLXT.last_failure = GLXT_UNKNOWN_UNIFORM_SHADER_TYPE;
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
 }
 
 void glxt_set_shader_uniform_mat4(uint32_t shader_program, const char* name, const void* data)
 {
-    int location = -1;
-    location = glGetUniformLocation(shader_program, name);
-    if(location == -1)
-        GLXT.last_failure = GLXT_UNIFORM_LOCATION_NOT_FOUND;
-    glUniformMatrix4fv(location, 1, false, (const float*)data);
-    
+    // Bound behind glxt's back the value goes up uncached, the cached one is stale after it
+    bool bound = GLXT.state.shader_program == shader_program;
+    _GLXTProgramInfo* program = _glxt_find_program_info(shader_program);
+    _GLXTUniformInfo* info = _glxt_find_uniform_info(program, name, NULL);
+    if(info != NULL && !bound) info->cached = false;
+
+    int location = -1;
+    if(info != NULL) location = info->location;
+    else location = glGetUniformLocation(shader_program, name);
+    if(location == -1)
+        GLXT.last_failure = GLXT_UNIFORM_LOCATION_NOT_FOUND;
+
+    if(bound && info != NULL && info->type == GL_FLOAT_MAT4 && _glxt_uniform_is_redundant(program, info, data, 1))
+        return;
+    glUniformMatrix4fv(location, 1, false, (const float*)data);
+    
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+GLXTUniform glxt_get_shader_uniform(uint32_t shader_program, const char* name)
+{
+    if(name == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    _GLXTProgramInfo* program = _glxt_find_program_info(shader_program);
+    size_t index = 0;
+    if(_glxt_find_uniform_info(program, name, &index) == NULL) {
+        GLXT.last_failure = GLXT_UNIFORM_LOCATION_NOT_FOUND;
+        return 0;
+    }
+
+    // [generation:8][program slot:8][uniform index:16], never 0 for a valid handle
+    size_t slot = program - GLXT.programs;
+    return ((uint32_t)program->generation << 24) | ((uint32_t)slot << 16) | (uint32_t)index;
+}
+
+void glxt_set_uniform(GLXTUniform uniform, const void* data, int count)
+{
+    size_t slot = (uniform >> 16) & 0xFF;
+    size_t index = uniform & 0xFFFF;
+    _GLXTProgramInfo* program = slot < GLXT_MAXIMUM_SHADER_PROGRAMS ? &GLXT.programs[slot] : NULL;
+    if(uniform == 0 || program == NULL || program->shader_program == 0
+        || program->generation != (uniform >> 24) || index >= program->uniforms_count) {
+        GLXT.last_failure = GLXT_INVALID_UNIFORM_HANDLE;
+        return;
+    }
+    if(data == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    // glUniform writes the bound program, caching it under another one would poison the cache
+    if(GLXT.state.shader_program != program->shader_program) {
+        GLXT.last_failure = GLXT_UNIFORM_PROGRAM_NOT_BOUND;
+        return;
+    }
+
+    _GLXTUniformInfo* info = &program->uniforms[index];
+    if(count > info->array_size) count = info->array_size;
+    if(_glxt_uniform_is_redundant(program, info, data, count)) return;
+
+    _glxt_upload_uniform(info->type, info->location, count, data);
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+/**
+ * Bytes glxt_set_uniform reads for count elements, false for an invalid
+ * handle. The recorders of deferred uniform sets check their payload
+ * against it.
+ */
+static inline bool _glxt_uniform_data_size(GLXTUniform uniform, int count, size_t* size)
+{
+    size_t slot = (uniform >> 16) & 0xFF;
+    size_t index = uniform & 0xFFFF;
+    _GLXTProgramInfo* program = slot < GLXT_MAXIMUM_SHADER_PROGRAMS ? &GLXT.programs[slot] : NULL;
+    if(uniform == 0 || program == NULL || program->shader_program == 0
+        || program->generation != (uniform >> 24) || index >= program->uniforms_count)
+        return false;
+
+    const _GLXTUniformInfo* info = &program->uniforms[index];
+    if(count > info->array_size) count = info->array_size;
+    *size = count > 0 ? (size_t)count * _glxt_uniform_element_size(info->type) : 0;
+    return true;
+}
+
+GLXTUniformStats glxt_uniform_stats(void)
+{
+    return GLXT.uniform_stats;
+}
+
+uint32_t glxt_create_uniform_buffer(size_t buffer_size, const void* buffer_data)
+{
+    uint32_t ubo = 0;
+    glGenBuffers(1, &ubo);
+    glxt_bind_buffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, buffer_size, buffer_data, GL_DYNAMIC_DRAW);
+    if(buffer_data != NULL) _GLXT_COUNT(bytes_uploaded, buffer_size);
+    return ubo;
+}
+
+void glxt_update_uniform_buffer(uint32_t ubo, size_t buffer_size, const void* buffer_data, int offset)
+{
+    glxt_bind_buffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, buffer_size, buffer_data);
+    _GLXT_COUNT(bytes_uploaded, buffer_size);
+}
+
+void glxt_destroy_uniform_buffer(uint32_t ubo)
+{
+    _glxt_forget_buffer(ubo);
+    glDeleteBuffers(1, &ubo);
+}
+
+void glxt_enable_uniform_buffer(uint32_t ubo, uint32_t binding)
+{
+    // Indexed binds are not shadowed but also rebind the generic target
+    GLXT.state.stats.calls_issued += 1;
+    GLXT.state.buffers[_GLXT_BUFFER_TARGET_UNIFORM] = ubo;
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+}
+
+bool glxt_register_uniform_block(const char* block_name, uint32_t binding)
+{
+    if(block_name == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    size_t i = 0;
+    for(; i < GLXT.uniform_blocks_count; ++i)
+        if(strcmp(GLXT.uniform_blocks[i].name, block_name) == 0) break;
+
+    if(i == GLXT.uniform_blocks_count) {
+        if(GLXT.uniform_blocks_count >= GLXT_MAXIMUM_UNIFORM_BLOCKS) {
+            GLXT.last_failure = GLXT_TOO_MANY_UNIFORM_BLOCKS;
+            return false;
+        }
+        snprintf(GLXT.uniform_blocks[i].name, GLXT_MAXIMUM_UNIFORM_NAME, "%s", block_name);
+        GLXT.uniform_blocks_count += 1;
+    }
+    GLXT.uniform_blocks[i].binding = binding;
+
+    // Programs linked later pick the binding up at reflection time
+    for(size_t j = 0; j < GLXT_MAXIMUM_SHADER_PROGRAMS; ++j) {
+        uint32_t shader_program = GLXT.programs[j].shader_program;
+        if(shader_program == 0) continue;
+        uint32_t index = glGetUniformBlockIndex(shader_program, block_name);
+        if(index != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader_program, index, binding);
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+bool glxt_bind_shader_uniform_block(uint32_t shader_program, const char* block_name, uint32_t binding)
+{
+    if(block_name == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    uint32_t index = glGetUniformBlockIndex(shader_program, block_name);
+    if(index == GL_INVALID_INDEX) {
+        GLXT.last_failure = GLXT_UNIFORM_BLOCK_NOT_FOUND;
+        return false;
+    }
+    glUniformBlockBinding(shader_program, index, binding);
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+static bool _glxt_comp_texture_formats(int comp, uint32_t* internal_format, uint32_t* format)
+{
+    switch(comp) {
+        case 1: *internal_format = GL_R8; *format = GL_RED; return true;
+        case 2: *internal_format = GL_RG8; *format = GL_RG; return true;
+        case 3: *internal_format = GL_RGB8; *format = GL_RGB; return true;
+        case 4: *internal_format = GL_RGBA8; *format = GL_RGBA; return true;
+        default: return false;
+    }
+}
+
+static size_t _glxt_pixel_size(uint32_t format, uint32_t type)
+{
+    size_t channels = 0;
+    switch(format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: channels = 1; break;
+        case GL_RG: case GL_RG_INTEGER: channels = 2; break;
+        case GL_RGB: case GL_RGB_INTEGER: channels = 3; break;
+        case GL_RGBA: case GL_RGBA_INTEGER: channels = 4; break;
+        default: return 0;
+    }
+    switch(type) {
+        case GL_UNSIGNED_BYTE: case GL_BYTE: return channels;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return channels * 2;
+        case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return channels * 4;
+        default: return 0;
+    }
+}
+
+static int _glxt_mip_levels(uint32_t width, uint32_t height)
+{
+    uint32_t size = width > height ? width : height;
+    int levels = 1;
+    while(size > 1) {
+        size >>= 1;
+        levels += 1;
+    }
+    return levels;
+}
+
+uint32_t glxt_create_texture2d(uint32_t width, uint32_t height, int comp, const uint8_t* data)
+{
+    GLXTTexture2DDesc desc = {0};
+    desc.width = width;
+    desc.height = height;
+    if(!_glxt_comp_texture_formats(comp, &desc.internal_format, &desc.format)) {
+        GLXT.last_failure = GLXT_INVALID_TEXTURE_FORMAT;
+        return 0;
+    }
+    desc.type = GL_UNSIGNED_BYTE;
+    return glxt_create_texture2d_from_desc(&desc, data);
+}
+
+uint32_t glxt_create_texture2d_from_desc(const GLXTTexture2DDesc* desc, const void* data)
+{
+    if(desc == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    if(desc->width == 0 || desc->height == 0 || desc->internal_format == 0
+        || _glxt_pixel_size(desc->format, desc->type) == 0) {
+        GLXT.last_failure = GLXT_INVALID_TEXTURE_FORMAT;
+        return 0;
+    }
+
+    uint32_t min_filter = desc->min_filter != 0 ? desc->min_filter
+        : (desc->mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    uint32_t mag_filter = desc->mag_filter != 0 ? desc->mag_filter : GL_LINEAR;
+    uint32_t wrap = desc->wrap != 0 ? desc->wrap : GL_REPEAT;
+    int levels = desc->mipmaps ? _glxt_mip_levels(desc->width, desc->height) : 1;
+
+    uint32_t texture = 0;
+    glGenTextures(1, &texture);
+    glxt_bind_texture2d(0, texture);
+    glTexStorage2D(GL_TEXTURE_2D, levels, desc->internal_format, desc->width, desc->height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+
+    if(data != NULL) {
+        // Client memory upload, make sure no unpack buffer hijacks the pointer
+        glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        int alignment = _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, desc->width, desc->height, desc->format, desc->type, data);
+        _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, alignment);
+        _GLXT_COUNT(bytes_uploaded, (size_t)desc->width * desc->height * _glxt_pixel_size(desc->format, desc->type));
+        if(desc->mipmaps) glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return texture;
+}
+
+void glxt_update_texture2d(uint32_t texture, int x, int y, uint32_t width, uint32_t height,
+    int comp, const uint8_t* data)
+{
+    uint32_t internal_format = 0, format = 0;
+    if(data == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    if(!_glxt_comp_texture_formats(comp, &internal_format, &format)) {
+        GLXT.last_failure = GLXT_INVALID_TEXTURE_FORMAT;
+        return;
+    }
+
+    glxt_bind_texture2d(0, texture);
+    glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    int alignment = _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, data);
+    _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, alignment);
+    _GLXT_COUNT(bytes_uploaded, (size_t)width * height * comp);
+
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+void glxt_generate_texture2d_mipmaps(uint32_t texture)
+{
+    glxt_bind_texture2d(0, texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void glxt_destroy_texture2d(uint32_t texture)
+{
+    _glxt_forget_texture2d(texture);
+    glDeleteTextures(1, &texture);
+}
+
+void glxt_enable_texture2d(uint32_t texture)
+{
+    glxt_bind_texture2d(0, texture);
+}
+
+void glxt_disable_texture2d(uint32_t texture)
+{
+    if(GLXT.state.textures2d[0] == texture)
+        glxt_bind_texture2d(0, 0);
+}
+
+bool glxt_create_texture_stream(GLXTTextureStream* stream, const GLXTTexture2DDesc* desc)
+{
+    if(stream == NULL || desc == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(stream, 0, sizeof(*stream));
+
+    stream->texture = glxt_create_texture2d_from_desc(desc, NULL);
+    if(stream->texture == 0) return false;
+
+    stream->width = desc->width;
+    stream->height = desc->height;
+    stream->format = desc->format;
+    stream->type = desc->type;
+    stream->pixel_size = _glxt_pixel_size(desc->format, desc->type);
+    stream->mipmaps = desc->mipmaps;
+
+    size_t size = (size_t)desc->width * desc->height * stream->pixel_size;
+    glGenBuffers(GLXT_TEXTURE_STREAM_BUFFERS, stream->buffers);
+    for(size_t i = 0; i < GLXT_TEXTURE_STREAM_BUFFERS; ++i) {
+        glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, stream->buffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    }
+    glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_destroy_texture_stream(GLXTTextureStream* stream)
+{
+    if(stream == NULL || stream->texture == 0) return;
+
+    if(stream->mapped) {
+        glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, stream->buffers[stream->buffer_index]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    for(size_t i = 0; i < GLXT_TEXTURE_STREAM_BUFFERS; ++i) {
+        if(stream->fences[i] != NULL) glDeleteSync((GLsync)stream->fences[i]);
+        _glxt_forget_buffer(stream->buffers[i]);
+    }
+    glDeleteBuffers(GLXT_TEXTURE_STREAM_BUFFERS, stream->buffers);
+    glxt_destroy_texture2d(stream->texture);
+    memset(stream, 0, sizeof(*stream));
+}
+
+void* glxt_begin_texture_stream_update(GLXTTextureStream* stream)
+{
+    if(stream == NULL || stream->texture == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+
+    size_t index = stream->buffer_index;
+    GLsync fence = (GLsync)stream->fences[index];
+    if(fence != NULL) {
+        if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            stream->stalls += 1;
+            while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        stream->fences[index] = NULL;
+    }
+
+    size_t size = (size_t)stream->width * stream->height * stream->pixel_size;
+    glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, stream->buffers[index]);
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    stream->mapped = dst != NULL;
+    DEBUG_DO(_glxt_check_opengl_error());
+    return dst;
+}
+
+// The region has to lie within the texture, the mapped buffer holds no more than the whole texture
+static bool _glxt_texture_stream_region_valid(const GLXTTextureStream* stream,
+    int x, int y, uint32_t width, uint32_t height)
+{
+    return x >= 0 && y >= 0 && (uint32_t)x <= stream->width && (uint32_t)y <= stream->height
+        && width <= stream->width - (uint32_t)x && height <= stream->height - (uint32_t)y;
+}
+
+void glxt_end_texture_stream_update(GLXTTextureStream* stream, int x, int y, uint32_t width, uint32_t height)
+{
+    if(stream == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    if(!stream->mapped) {
+        GLXT.last_failure = GLXT_TEXTURE_STREAM_NOT_MAPPED;
+        return;
+    }
+
+    size_t index = stream->buffer_index;
+    glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, stream->buffers[index]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    stream->mapped = false;
+    // The buffer is unmapped either way, a bad region only drops this update
+    if(!_glxt_texture_stream_region_valid(stream, x, y, width, height)) {
+        glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return;
+    }
+
+    // Pixels are tightly packed rows of the updated region, starting at offset 0
+    glxt_bind_texture2d(0, stream->texture);
+    int alignment = _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, stream->format, stream->type, (const void*)0);
+    _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, alignment);
+    _GLXT_COUNT(bytes_uploaded, (size_t)width * height * stream->pixel_size);
+    glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(stream->mipmaps) glGenerateMipmap(GL_TEXTURE_2D);
+
+    stream->fences[index] = (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stream->buffer_index = (index + 1) % GLXT_TEXTURE_STREAM_BUFFERS;
+    stream->uploads += 1;
+
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+void glxt_update_texture_stream(GLXTTextureStream* stream, int x, int y, uint32_t width, uint32_t height,
+    const void* pixels)
+{
+    if(stream == NULL || pixels == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    if(!_glxt_texture_stream_region_valid(stream, x, y, width, height)) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return;
+    }
+
+    void* dst = glxt_begin_texture_stream_update(stream);
+    if(dst == NULL) return;
+    memcpy(dst, pixels, (size_t)width * height * stream->pixel_size);
+    glxt_end_texture_stream_update(stream, x, y, width, height);
+}
+
+static bool _glxt_attach_render_target(GLXTRenderTarget* target)
+{
+    GLXTTexture2DDesc color = target->color;
+    color.width = target->width;
+    color.height = target->height;
+    target->color_texture = glxt_create_texture2d_from_desc(&color, NULL);
+    if(target->color_texture == 0) return false;
+
+    glxt_bind_framebuffer(target->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->color_texture, 0);
+    if(target->depth_format != 0) {
+        glBindRenderbuffer(GL_RENDERBUFFER, target->depth_renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, target->depth_format, target->width, target->height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        bool stencil = target->depth_format == GL_DEPTH24_STENCIL8 || target->depth_format == GL_DEPTH32F_STENCIL8;
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+            GL_RENDERBUFFER, target->depth_renderbuffer);
+    }
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        GLXT.last_failure = GLXT_FRAMEBUFFER_INCOMPLETE;
+        return false;
+    }
+    return true;
+}
+
+bool glxt_create_render_target(GLXTRenderTarget* target, const GLXTRenderTargetDesc* desc)
+{
+    if(target == NULL || desc == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(target, 0, sizeof(*target));
+    if(desc->width == 0 || desc->height == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+
+    target->width = desc->width;
+    target->height = desc->height;
+    target->color = desc->color;
+    if(target->color.internal_format == 0) {
+        target->color.internal_format = GL_RGBA8;
+        target->color.format = GL_RGBA;
+        target->color.type = GL_UNSIGNED_BYTE;
+    }
+    if(target->color.wrap == 0) target->color.wrap = GL_CLAMP_TO_EDGE;
+    target->depth_format = desc->depth_format;
+
+    uint32_t previous = GLXT.state.framebuffer;
+    glGenFramebuffers(1, &target->framebuffer);
+    if(target->depth_format != 0) glGenRenderbuffers(1, &target->depth_renderbuffer);
+    bool attached = _glxt_attach_render_target(target);
+    glxt_bind_framebuffer(previous == _GLXT_STATE_UNKNOWN ? 0 : previous);
+
+    if(!attached) {
+        glxt_destroy_render_target(target);
+        return false;
+    }
     DEBUG_DO(_glxt_check_opengl_error());
+    return true;
 }
 
-void glxt_read_file_data(FILE* f, char* writable)
+bool glxt_resize_render_target(GLXTRenderTarget* target, uint32_t width, uint32_t height)
 {
-    if(writable == NULL) {
+    if(target == NULL || target->framebuffer == 0) {
         GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(width == 0 || height == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+    if(target->width == width && target->height == height) return true;
+
+    glxt_destroy_texture2d(target->color_texture);
+    target->color_texture = 0;
+    target->width = width;
+    target->height = height;
+
+    uint32_t previous = GLXT.state.framebuffer;
+    bool attached = _glxt_attach_render_target(target);
+    glxt_bind_framebuffer(previous == _GLXT_STATE_UNKNOWN ? 0 : previous);
+    // A bound target keeps covering the whole framebuffer
+    if(previous == target->framebuffer) glxt_set_viewport(0, 0, width, height);
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return attached;
+}
+
+void glxt_destroy_render_target(GLXTRenderTarget* target)
+{
+    if(target == NULL || target->framebuffer == 0) return;
+
+    // Deleting the bound framebuffer reverts the binding to the default one
+    if(GLXT.state.framebuffer == target->framebuffer) GLXT.state.framebuffer = 0;
+    glDeleteFramebuffers(1, &target->framebuffer);
+    if(target->depth_renderbuffer != 0) glDeleteRenderbuffers(1, &target->depth_renderbuffer);
+    if(target->color_texture != 0) glxt_destroy_texture2d(target->color_texture);
+    memset(target, 0, sizeof(*target));
+}
+
+void glxt_bind_render_target(const GLXTRenderTarget* target)
+{
+    if(target == NULL) {
+        glxt_bind_framebuffer(0);
         return;
     }
+    glxt_bind_framebuffer(target->framebuffer);
+    glxt_set_viewport(0, 0, target->width, target->height);
+}
+
+bool glxt_create_readback_stream(GLXTReadbackStream* stream, uint32_t width, uint32_t height,
+    uint32_t format, uint32_t type)
+{
+    if(stream == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(stream, 0, sizeof(*stream));
+    if(width == 0 || height == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+    stream->pixel_size = _glxt_pixel_size(format, type);
+    if(stream->pixel_size == 0) {
+        GLXT.last_failure = GLXT_INVALID_TEXTURE_FORMAT;
+        return false;
+    }
+    stream->width = width;
+    stream->height = height;
+    stream->format = format;
+    stream->type = type;
+
+    size_t size = (size_t)width * height * stream->pixel_size;
+    glGenBuffers(GLXT_READBACK_STREAM_BUFFERS, stream->buffers);
+    for(size_t i = 0; i < GLXT_READBACK_STREAM_BUFFERS; ++i) {
+        glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, stream->buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    }
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
 
-    if(f == NULL) {
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_destroy_readback_stream(GLXTReadbackStream* stream)
+{
+    if(stream == NULL || stream->buffers[0] == 0) return;
+
+    if(stream->mapped) {
+        glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, stream->buffers[stream->head]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    for(size_t i = 0; i < GLXT_READBACK_STREAM_BUFFERS; ++i) {
+        if(stream->fences[i] != NULL) glDeleteSync((GLsync)stream->fences[i]);
+        _glxt_forget_buffer(stream->buffers[i]);
+    }
+    glDeleteBuffers(GLXT_READBACK_STREAM_BUFFERS, stream->buffers);
+    memset(stream, 0, sizeof(*stream));
+}
+
+bool glxt_queue_readback(GLXTReadbackStream* stream, int x, int y)
+{
+    if(stream == NULL || stream->buffers[0] == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(stream->pending == GLXT_READBACK_STREAM_BUFFERS) {
+        GLXT.last_failure = GLXT_READBACK_STREAM_FULL;
+        return false;
+    }
+
+    size_t index = (stream->head + stream->pending) % GLXT_READBACK_STREAM_BUFFERS;
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, stream->buffers[index]);
+    int alignment = _glxt_pixel_alignment(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, stream->width, stream->height, stream->format, stream->type, (void*)0);
+    _glxt_pixel_alignment(GL_PACK_ALIGNMENT, alignment);
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    stream->fences[index] = (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stream->frames[index] = stream->next_frame++;
+    stream->pending += 1;
+    stream->reads += 1;
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+const void* glxt_begin_readback(GLXTReadbackStream* stream, bool wait, uint64_t* frame)
+{
+    if(stream == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+    if(stream->pending == 0 || stream->mapped) return NULL;
+
+    size_t index = stream->head;
+    GLsync fence = (GLsync)stream->fences[index];
+    if(fence != NULL) {
+        // Flushing makes sure the fence gets signaled even if nobody else flushes
+        if(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+            if(!wait) return NULL;
+            stream->stalls += 1;
+            while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        stream->fences[index] = NULL;
+    }
+
+    size_t size = (size_t)stream->width * stream->height * stream->pixel_size;
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, stream->buffers[index]);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    stream->mapped = pixels != NULL;
+    if(frame != NULL) *frame = stream->frames[index];
+    DEBUG_DO(_glxt_check_opengl_error());
+    return pixels;
+}
+
+void glxt_end_readback(GLXTReadbackStream* stream)
+{
+    if(stream == NULL) {
         GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
         return;
     }
+    if(!stream->mapped) return;
+
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, stream->buffers[stream->head]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glxt_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    stream->mapped = false;
+    stream->head = (stream->head + 1) % GLXT_READBACK_STREAM_BUFFERS;
+    stream->pending -= 1;
+}
 
-    size_t i = 0;
-    char c;
-    while(!feof(f)) {
-        c = fgetc(f);
-        writable[i] = c;
-        ++i;
+bool glxt_create_instance_stream(GLXTInstanceStream* stream, size_t instance_size, size_t max_instances)
+{
+    if(stream == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(stream, 0, sizeof(*stream));
+    if(instance_size == 0 || max_instances == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
     }
 
-    fseek(f, 0, SEEK_SET);
+    stream->instance_size = instance_size;
+    stream->max_instances = max_instances;
+
+    glGenBuffers(GLXT_INSTANCE_STREAM_BUFFERS, stream->buffers);
+    for(size_t i = 0; i < GLXT_INSTANCE_STREAM_BUFFERS; ++i) {
+        glxt_bind_buffer(GL_ARRAY_BUFFER, stream->buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, instance_size * max_instances, NULL, GL_STREAM_DRAW);
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
 }
 
-void glxt_read_file_data_path(const char* file_path, char* writable)
+void glxt_destroy_instance_stream(GLXTInstanceStream* stream)
 {
-    if(writable == NULL) {
+    if(stream == NULL || stream->buffers[0] == 0) return;
+
+    if(stream->mapped) {
+        glxt_bind_buffer(GL_ARRAY_BUFFER, stream->buffers[stream->buffer_index]);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    for(size_t i = 0; i < GLXT_INSTANCE_STREAM_BUFFERS; ++i) {
+        if(stream->fences[i] != NULL) glDeleteSync((GLsync)stream->fences[i]);
+        _glxt_forget_buffer(stream->buffers[i]);
+    }
+    glDeleteBuffers(GLXT_INSTANCE_STREAM_BUFFERS, stream->buffers);
+    memset(stream, 0, sizeof(*stream));
+}
+
+bool glxt_add_instance_stream_attrib(GLXTInstanceStream* stream, uint32_t index, int comp_count,
+    int attr_type, bool normalized, size_t offset)
+{
+    if(stream == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(stream->attribs_count >= GLXT_INSTANCE_STREAM_MAXIMUM_ATTRIBS) {
+        GLXT.last_failure = GLXT_TOO_MANY_INSTANCE_ATTRIBS;
+        return false;
+    }
+
+    GLXTInstanceAttrib* attrib = &stream->attribs[stream->attribs_count++];
+    attrib->index = index;
+    attrib->comp_count = comp_count;
+    attrib->attr_type = attr_type;
+    attrib->normalized = normalized;
+    attrib->offset = offset;
+    return true;
+}
+
+void* glxt_begin_instance_stream_update(GLXTInstanceStream* stream)
+{
+    if(stream == NULL || stream->buffers[0] == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+
+    // Every draw reading the current buffer has been issued by now, fence
+    // them and move on. The buffer we move into was last drawn from
+    // GLXT_INSTANCE_STREAM_BUFFERS - 1 updates ago.
+    if(stream->written) {
+        stream->fences[stream->buffer_index] = (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        stream->buffer_index = (stream->buffer_index + 1) % GLXT_INSTANCE_STREAM_BUFFERS;
+        stream->written = false;
+    }
+
+    size_t index = stream->buffer_index;
+    GLsync fence = (GLsync)stream->fences[index];
+    if(fence != NULL) {
+        if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            stream->stalls += 1;
+            while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        stream->fences[index] = NULL;
+    }
+
+    glxt_bind_buffer(GL_ARRAY_BUFFER, stream->buffers[index]);
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, 0, stream->instance_size * stream->max_instances,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+    stream->mapped = dst != NULL;
+    DEBUG_DO(_glxt_check_opengl_error());
+    return dst;
+}
+
+void glxt_end_instance_stream_update(GLXTInstanceStream* stream, size_t instances_count)
+{
+    if(stream == NULL) {
         GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
         return;
     }
+    if(!stream->mapped) {
+        GLXT.last_failure = GLXT_INSTANCE_STREAM_NOT_MAPPED;
+        return;
+    }
 
-    FILE* f = fopen(file_path, "r");
-    if(f == NULL) {
-        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+    glxt_bind_buffer(GL_ARRAY_BUFFER, stream->buffers[stream->buffer_index]);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    stream->mapped = false;
+    stream->written = true;
+
+    if(instances_count > stream->max_instances) instances_count = stream->max_instances;
+    stream->instances_count = instances_count;
+    stream->uploads += 1;
+    _GLXT_COUNT(bytes_uploaded, instances_count * stream->instance_size);
+
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+void glxt_update_instance_stream(GLXTInstanceStream* stream, const void* instances, size_t instances_count)
+{
+    if(stream == NULL || instances == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    if(instances_count > stream->max_instances) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
         return;
     }
 
-    glxt_read_file_data(f, writable);
+    void* dst = glxt_begin_instance_stream_update(stream);
+    if(dst == NULL) return;
+    memcpy(dst, instances, instances_count * stream->instance_size);
+    glxt_end_instance_stream_update(stream, instances_count);
+}
+
+void glxt_enable_instance_stream(GLXTInstanceStream* stream)
+{
+    if(stream == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    // The vertex array captures the buffer, so the attributes are pointed
+    // again each time the stream moves to another buffer of the ring
+    glxt_bind_buffer(GL_ARRAY_BUFFER, stream->buffers[stream->buffer_index]);
+    for(size_t i = 0; i < stream->attribs_count; ++i) {
+        const GLXTInstanceAttrib* attrib = &stream->attribs[i];
+        glxt_set_instance_attrib(attrib->index, attrib->comp_count, attrib->attr_type, attrib->normalized,
+            stream->instance_size, (const void*)(uintptr_t)attrib->offset, 1);
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
 }
 
 size_t glxt_get_file_size(FILE* f)
@@ -434,14 +2646,414 @@ size_t glxt_get_file_size_path(const char* file_path)
         return 0;
     }
 
-    FILE* f = fopen(file_path, "r");
+    FILE* f = fopen(file_path, "rb");
     if(f == NULL) {
         GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
         return 0;
     }
 
-    return glxt_get_file_size(f);
+    size_t size = glxt_get_file_size(f);
+    fclose(f);
+    return size;
+}
+
+void glxt_read_file_data(FILE* f, char* writable)
+{
+    if(writable == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    if(f == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    // Writes exactly glxt_get_file_size(f) bytes, no terminator
+    size_t size = glxt_get_file_size(f);
+    if(fread(writable, 1, size, f) != size && ferror(f))
+        GLXT.last_failure = GLXT_FAILED_TO_READ_FILE;
+
+    fseek(f, 0, SEEK_SET);
+}
+
+void glxt_read_file_data_path(const char* file_path, char* writable)
+{
+    if(writable == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    FILE* f = fopen(file_path, "rb");
+    if(f == NULL) {
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return;
+    }
+
+    glxt_read_file_data(f, writable);
+    fclose(f);
+}
+
+// Reports failures through *failure instead of the global failure state,
+// so it can be used from threads other than the GL one
+static bool _glxt_load_file(const char* file_path, GLXTFileView* view, int* failure)
+{
+    if(file_path == NULL || view == NULL) {
+        *failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    view->data = NULL;
+    view->size = 0;
+    view->mapped = false;
+
+#if defined(_WIN32)
+    FILE* f = fopen(file_path, "rb");
+    if(f == NULL) {
+        *failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+    size_t size = glxt_get_file_size(f);
+    char* data = malloc(size + 1);
+    if(data == NULL) {
+        fclose(f);
+        *failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    size_t total = fread(data, 1, size, f);
+    fclose(f);
+#else
+    int fd = open(file_path, O_RDONLY);
+    if(fd < 0) {
+        *failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        *failure = GLXT_FAILED_TO_READ_FILE;
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+
+    // The kernel zero-fills the mapping past the end of the file up to the
+    // page boundary, which provides the terminator as long as the file does
+    // not end exactly on a page boundary
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    if(size >= GLXT_FILE_MMAP_THRESHOLD && size % page_size != 0) {
+        void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping != MAP_FAILED) {
+            close(fd);
+            view->data = (const char*)mapping;
+            view->size = size;
+            view->mapped = true;
+            return true;
+        }
+    }
+
+    char* data = malloc(size + 1);
+    if(data == NULL) {
+        close(fd);
+        *failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    size_t total = 0;
+    while(total < size) {
+        ssize_t n = read(fd, data + total, size - total);
+        if(n <= 0) break;
+        total += (size_t)n;
+    }
+    close(fd);
+#endif
+
+    if(total != size) {
+        free(data);
+        *failure = GLXT_FAILED_TO_READ_FILE;
+        return false;
+    }
+    data[size] = '\0';
+    view->data = data;
+    view->size = size;
+    return true;
+}
+
+bool glxt_load_file(const char* file_path, GLXTFileView* view)
+{
+    int failure = GLXT_NO_ERROR;
+    if(_glxt_load_file(file_path, view, &failure)) return true;
+    GLXT.last_failure = failure;
+    return false;
+}
+
+void glxt_release_file(GLXTFileView* view)
+{
+    if(view == NULL || view->data == NULL) return;
+
+#if !defined(_WIN32)
+    if(view->mapped) munmap((void*)view->data, view->size);
+    else free((void*)view->data);
+#else
+    free((void*)view->data);
+#endif
+
+    view->data = NULL;
+    view->size = 0;
+    view->mapped = false;
+}
+
+static const char* _glxt_batch_vert_source =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_pos;\n"
+    "layout(location = 1) in vec4 a_color;\n"
+    "layout(location = 2) in vec2 a_uv;\n"
+    "out vec4 v_color;\n"
+    "out vec2 v_uv;\n"
+    "void main() {\n"
+    "    v_color = a_color;\n"
+    "    v_uv = a_uv;\n"
+    "    gl_Position = vec4(a_pos, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* _glxt_batch_frag_source =
+    "#version 330 core\n"
+    "layout(location = 0) out vec4 o_color;\n"
+    "in vec4 v_color;\n"
+    "in vec2 v_uv;\n"
+    "uniform sampler2D u_texture;\n"
+    "void main() {\n"
+    "    o_color = v_color * texture(u_texture, v_uv);\n"
+    "}\n";
+
+bool glxt_batch_init(size_t max_vertices)
+{
+    if(GLXT.batch.initialized) return true;
+    if(max_vertices < 6) max_vertices = 6;
+
+    GLXT.batch.vertices = malloc(max_vertices * sizeof(GLXTBatchVertex));
+    if(GLXT.batch.vertices == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    if(GLXT.default_shader_program == 0) {
+        GLXT.default_shader_program = glxt_create_shader_program(
+            _glxt_batch_vert_source, _glxt_batch_frag_source);
+        if(GLXT.default_shader_program == 0) {
+            free(GLXT.batch.vertices);
+            GLXT.batch.vertices = NULL;
+            return false;
+        }
+        int unit = 0;
+        glxt_enable_shader_program(GLXT.default_shader_program);
+        glxt_set_shader_uniform(GLXT.default_shader_program, "u_texture",
+            (const void*)&unit, GLXT_SHADER_UNIFORM_SAMPLER2D, 1);
+    }
+
+    // 1x1 white texture so untextured primitives can share the textured path
+    const uint8_t white[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    GLXT.batch.white_texture = glxt_create_texture2d(1, 1, 4, white);
+
+    // One buffer holding every ring segment, so the VAO never has to be re-pointed
+    GLXT.batch.vao = glxt_create_vertex_array();
+    glxt_enable_vertex_array(GLXT.batch.vao);
+    GLXT.batch.vbo = glxt_create_vertex_buffer(
+        max_vertices * GLXT_BATCH_RING_SEGMENTS * sizeof(GLXTBatchVertex), NULL);
+    glxt_enable_vertex_buffer(GLXT.batch.vbo);
+    glxt_set_vertex_attrib(0, 2, GL_FLOAT, false, sizeof(GLXTBatchVertex),
+        (const void*)offsetof(GLXTBatchVertex, pos));
+    glxt_set_vertex_attrib(1, 4, GL_FLOAT, false, sizeof(GLXTBatchVertex),
+        (const void*)offsetof(GLXTBatchVertex, color));
+    glxt_set_vertex_attrib(2, 2, GL_FLOAT, false, sizeof(GLXTBatchVertex),
+        (const void*)offsetof(GLXTBatchVertex, uv));
+    glxt_disable_vertex_array();
+    glxt_disable_vertex_buffer();
+
+    GLXT.batch.capacity = max_vertices;
+    GLXT.batch.vertices_count = 0;
+    GLXT.batch.primitive = GLXT_BATCH_TRIANGLES;
+    GLXT.batch.shader_program = 0;
+    GLXT.batch.texture = 0;
+    GLXT.batch.segment = 0;
+    GLXT.batch.segment_cursor = 0;
+    for(size_t i = 0; i < GLXT_BATCH_RING_SEGMENTS; ++i)
+        GLXT.batch.fences[i] = NULL;
+    memset(&GLXT.batch.stats, 0, sizeof(GLXT.batch.stats));
+    GLXT.batch.initialized = true;
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_batch_deinit(void)
+{
+    if(!GLXT.batch.initialized) return;
+
+    for(size_t i = 0; i < GLXT_BATCH_RING_SEGMENTS; ++i) {
+        if(GLXT.batch.fences[i] != NULL) glDeleteSync(GLXT.batch.fences[i]);
+        GLXT.batch.fences[i] = NULL;
+    }
+
+    glxt_destroy_vertex_buffer(GLXT.batch.vbo);
+    glxt_destroy_vertex_array(GLXT.batch.vao);
+    glxt_destroy_texture2d(GLXT.batch.white_texture);
+    glxt_destroy_shader_program(GLXT.default_shader_program);
+    GLXT.default_shader_program = 0;
+
+    free(GLXT.batch.vertices);
+    GLXT.batch.vertices = NULL;
+    GLXT.batch.initialized = false;
+}
+
+void glxt_batch_begin(void)
+{
+    memset(&GLXT.batch.stats, 0, sizeof(GLXT.batch.stats));
+}
+
+void glxt_batch_end(void)
+{
+    glxt_batch_flush();
+}
+
+static void _glxt_batch_next_segment(void)
+{
+    // Fence everything submitted from the current segment, then move on.
+    // The segment we move into was last used GLXT_BATCH_RING_SEGMENTS - 1
+    // wraps ago, so its fence is normally signaled already.
+    GLXT.batch.fences[GLXT.batch.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    GLXT.batch.segment = (GLXT.batch.segment + 1) % GLXT_BATCH_RING_SEGMENTS;
+    GLXT.batch.segment_cursor = 0;
+
+    GLsync fence = GLXT.batch.fences[GLXT.batch.segment];
+    if(fence == NULL) return;
+
+    if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        GLXT.batch.stats.fence_waits += 1;
+        while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    GLXT.batch.fences[GLXT.batch.segment] = NULL;
+}
+
+void glxt_batch_flush(void)
+{
+    if(!GLXT.batch.initialized) {
+        GLXT.last_failure = GLXT_BATCH_NOT_INITIALIZED;
+        return;
+    }
+
+    size_t count = GLXT.batch.vertices_count;
+    if(count == 0) return;
+
+    if(GLXT.batch.segment_cursor + count > GLXT.batch.capacity)
+        _glxt_batch_next_segment();
+
+    size_t first = GLXT.batch.segment * GLXT.batch.capacity + GLXT.batch.segment_cursor;
+    size_t size = count * sizeof(GLXTBatchVertex);
+
+    // The range was never handed to the GPU since its fence was last waited,
+    // so it is safe to map it without synchronization.
+    glxt_bind_buffer(GL_ARRAY_BUFFER, GLXT.batch.vbo);
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, first * sizeof(GLXTBatchVertex), size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if(dst != NULL) {
+        memcpy(dst, GLXT.batch.vertices, size);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(GLXTBatchVertex), size, GLXT.batch.vertices);
+    }
+
+    uint32_t shader_program = GLXT.batch.shader_program != 0
+        ? GLXT.batch.shader_program : GLXT.default_shader_program;
+    uint32_t texture = GLXT.batch.texture != 0
+        ? GLXT.batch.texture : GLXT.batch.white_texture;
+
+    glxt_enable_vertex_array(GLXT.batch.vao);
+    glxt_enable_shader_program(shader_program);
+    glxt_bind_texture2d(0, texture);
+    glDrawArrays(GLXT.batch.primitive == GLXT_BATCH_LINES ? GL_LINES : GL_TRIANGLES,
+        (int)first, (int)count);
+    _GLXT_COUNT(draw_calls, 1);
+    _GLXT_COUNT(vertices, count);
+    _GLXT_COUNT(bytes_uploaded, size);
+
+    GLXT.batch.segment_cursor += count;
+    GLXT.batch.vertices_count = 0;
+    GLXT.batch.stats.draw_calls += 1;
+    GLXT.batch.stats.vertices += count;
+
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+void glxt_batch_set_material(uint32_t shader_program, uint32_t texture)
+{
+    if(GLXT.batch.shader_program == shader_program && GLXT.batch.texture == texture)
+        return;
+    if(GLXT.batch.vertices_count > 0) {
+        GLXT.batch.stats.flushes_on_state_change += 1;
+        glxt_batch_flush();
+    }
+    GLXT.batch.shader_program = shader_program;
+    GLXT.batch.texture = texture;
+}
+
+void glxt_batch_push_vertices(int primitive, const GLXTBatchVertex* vertices, size_t count)
+{
+    if(vertices == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    if(!GLXT.batch.initialized) {
+        GLXT.last_failure = GLXT_BATCH_NOT_INITIALIZED;
+        return;
+    }
+
+    if(primitive != GLXT.batch.primitive) {
+        if(GLXT.batch.vertices_count > 0) {
+            GLXT.batch.stats.flushes_on_state_change += 1;
+            glxt_batch_flush();
+        }
+        GLXT.batch.primitive = primitive;
+    }
+
+    // Keep whole primitives together when splitting across flushes
+    size_t unit = primitive == GLXT_BATCH_LINES ? 2 : 3;
+    size_t room = GLXT.batch.capacity - GLXT.batch.capacity % unit;
+
+    while(count > 0) {
+        if(GLXT.batch.vertices_count + unit > room) {
+            GLXT.batch.stats.flushes_on_capacity += 1;
+            glxt_batch_flush();
+        }
+        size_t n = room - GLXT.batch.vertices_count;
+        if(n > count) n = count;
+        memcpy(GLXT.batch.vertices + GLXT.batch.vertices_count, vertices, n * sizeof(GLXTBatchVertex));
+        GLXT.batch.vertices_count += n;
+        vertices += n;
+        count -= n;
+    }
+}
+
+void glxt_batch_push_triangle(GLXTBatchVertex a, GLXTBatchVertex b, GLXTBatchVertex c)
+{
+    const GLXTBatchVertex vertices[3] = { a, b, c };
+    glxt_batch_push_vertices(GLXT_BATCH_TRIANGLES, vertices, 3);
 }
 
+void glxt_batch_push_quad(GLXTBatchVertex a, GLXTBatchVertex b, GLXTBatchVertex c, GLXTBatchVertex d)
+{
+    const GLXTBatchVertex vertices[6] = { a, b, c, a, c, d };
+    glxt_batch_push_vertices(GLXT_BATCH_TRIANGLES, vertices, 6);
+}
+
+void glxt_batch_push_line(GLXTBatchVertex a, GLXTBatchVertex b)
+{
+    const GLXTBatchVertex vertices[2] = { a, b };
+    glxt_batch_push_vertices(GLXT_BATCH_LINES, vertices, 2);
+}
+
+GLXTBatchStats glxt_batch_stats(void)
+{
+    return GLXT.batch.stats;
+}
 
 #endif // GLXT_IMPLEMENTATION
\ No newline at end of file
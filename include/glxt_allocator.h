@@ -0,0 +1,342 @@
+/**
+ * glxt_allocator works like glxt: define GLXT_ALLOCATOR_IMPLEMENTATION in
+ * the file where glxt is implemented, after the glxt implementation.
+ *
+ * Allocators for transient and frequently created data, so steady state
+ * frames make no heap allocations. Every allocator reports
+ * GLXTAllocatorStats (see glxt_scratch_stats for the scratch memory glxt
+ * uses internally).
+ *
+ * Arena: a bump allocator released all at once by glxt_arena_reset.
+ * An allocation that does not fit comes from the heap and is counted;
+ * the next reset frees those and grows the block to the high water mark,
+ * so after a frame or two the arena stops touching the heap.
+ *
+ * Frame arena: GLXT_FRAME_ARENA_BUFFERS arenas used in turn, one per
+ * frame. glxt_frame_arena_swap, called after swapping buffers, moves to
+ * the next arena and resets it; data allocated in a frame stays valid
+ * for the following one, long enough for client memory the GPU still
+ * reads from.
+ *
+ *     void* instances = glxt_frame_arena_alloc(&arena, size, 16);
+ *     ...
+ *     glfwSwapBuffers(window);
+ *     glxt_frame_arena_swap(&arena);
+ *
+ * Pool: fixed size elements on a free list, taken from chunks of
+ * chunk_elements elements. Freed elements are reused before a new chunk
+ * is allocated, chunks go back to the heap in glxt_pool_deinit.
+ */
+#ifndef GLXT_ALLOCATOR_H
+#define GLXT_ALLOCATOR_H
+
+#include "glxt.h"
+
+#ifndef GLXT_FRAME_ARENA_BUFFERS
+    #define GLXT_FRAME_ARENA_BUFFERS 2
+#endif
+
+typedef struct _GLXTArenaOverflow _GLXTArenaOverflow;
+
+typedef struct GLXTArena {
+    uint8_t* base;
+    size_t size;
+    size_t offset;
+    // Bytes asked for since the reset, including the ones served by the heap
+    size_t requested;
+    _GLXTArenaOverflow* overflows;
+    GLXTAllocatorStats stats;
+} GLXTArena;
+
+typedef struct GLXTFrameArena {
+    GLXTArena arenas[GLXT_FRAME_ARENA_BUFFERS];
+    size_t current;
+} GLXTFrameArena;
+
+typedef struct _GLXTPoolChunk _GLXTPoolChunk;
+
+typedef struct GLXTPool {
+    size_t element_size;
+    size_t chunk_elements;
+    _GLXTPoolChunk* chunks;
+    void* free_list;
+    GLXTAllocatorStats stats;
+} GLXTPool;
+
+bool glxt_arena_init(GLXTArena* arena, size_t size);
+void glxt_arena_deinit(GLXTArena* arena);
+// alignment is a power of two, 0 means 16
+void* glxt_arena_alloc(GLXTArena* arena, size_t size, size_t alignment);
+void glxt_arena_reset(GLXTArena* arena);
+GLXTAllocatorStats glxt_arena_stats(const GLXTArena* arena);
+
+// size is per arena
+bool glxt_frame_arena_init(GLXTFrameArena* arena, size_t size);
+void glxt_frame_arena_deinit(GLXTFrameArena* arena);
+void* glxt_frame_arena_alloc(GLXTFrameArena* arena, size_t size, size_t alignment);
+void glxt_frame_arena_swap(GLXTFrameArena* arena);
+// Summed over the arenas, high_water is the largest frame
+GLXTAllocatorStats glxt_frame_arena_stats(const GLXTFrameArena* arena);
+
+bool glxt_pool_init(GLXTPool* pool, size_t element_size, size_t chunk_elements);
+void glxt_pool_deinit(GLXTPool* pool);
+void* glxt_pool_alloc(GLXTPool* pool);
+void glxt_pool_free(GLXTPool* pool, void* element);
+GLXTAllocatorStats glxt_pool_stats(const GLXTPool* pool);
+
+#endif // GLXT_ALLOCATOR_H
+
+#if defined(GLXT_ALLOCATOR_IMPLEMENTATION) && !defined(GLXT_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define GLXT_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#define _GLXT_ALLOCATOR_ALIGNMENT 16
+
+// Heap blocks handed out by a full arena, the header keeps the payload aligned to 16
+struct _GLXTArenaOverflow {
+    _GLXTArenaOverflow* next;
+    uint8_t padding[_GLXT_ALLOCATOR_ALIGNMENT - sizeof(void*)];
+};
+
+struct _GLXTPoolChunk {
+    _GLXTPoolChunk* next;
+    uint8_t padding[_GLXT_ALLOCATOR_ALIGNMENT - sizeof(void*)];
+};
+
+static size_t _glxt_align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool glxt_arena_init(GLXTArena* arena, size_t size)
+{
+    if(arena == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(arena, 0, sizeof(*arena));
+    if(size == 0) return true;
+
+    arena->base = malloc(size);
+    if(arena->base == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    arena->size = size;
+    arena->stats.heap_allocations = 1;
+    return true;
+}
+
+static void _glxt_arena_free_overflows(GLXTArena* arena)
+{
+    while(arena->overflows != NULL) {
+        _GLXTArenaOverflow* next = arena->overflows->next;
+        free(arena->overflows);
+        arena->overflows = next;
+    }
+}
+
+void glxt_arena_deinit(GLXTArena* arena)
+{
+    if(arena == NULL) return;
+    _glxt_arena_free_overflows(arena);
+    free(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void* glxt_arena_alloc(GLXTArena* arena, size_t size, size_t alignment)
+{
+    if(arena == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+    if(alignment == 0) alignment = _GLXT_ALLOCATOR_ALIGNMENT;
+    if((alignment & (alignment - 1)) != 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return NULL;
+    }
+
+    // Counts the worst case padding of large alignments, a block grown to the
+    // high water mark then fits the frame whatever address it lands at
+    arena->stats.allocations += 1;
+    arena->requested = _glxt_align_up(arena->requested, alignment) + size;
+    if(alignment > _GLXT_ALLOCATOR_ALIGNMENT) arena->requested += alignment - _GLXT_ALLOCATOR_ALIGNMENT;
+    if(arena->requested > arena->stats.high_water) arena->stats.high_water = arena->requested;
+
+    // The block itself is aligned to 16 by malloc, larger alignments are taken from the address
+    uintptr_t base = (uintptr_t)arena->base;
+    size_t offset = _glxt_align_up(base + arena->offset, alignment) - base;
+    if(arena->base != NULL && offset <= arena->size && size <= arena->size - offset) {
+        arena->offset = offset + size;
+        arena->stats.bytes_in_use = arena->requested;
+        return arena->base + offset;
+    }
+
+    size_t padding = alignment > _GLXT_ALLOCATOR_ALIGNMENT ? alignment : 0;
+    _GLXTArenaOverflow* overflow = malloc(sizeof(_GLXTArenaOverflow) + padding + size);
+    if(overflow == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return NULL;
+    }
+    overflow->next = arena->overflows;
+    arena->overflows = overflow;
+    arena->stats.heap_allocations += 1;
+    arena->stats.bytes_in_use = arena->requested;
+    return (void*)_glxt_align_up((uintptr_t)(overflow + 1), alignment);
+}
+
+void glxt_arena_reset(GLXTArena* arena)
+{
+    if(arena == NULL) return;
+
+    // The block was too small for this frame: grow it once to what the frame needed
+    if(arena->overflows != NULL) {
+        _glxt_arena_free_overflows(arena);
+        size_t size = arena->size > 0 ? arena->size : 4096;
+        while(size < arena->stats.high_water) size *= 2;
+        uint8_t* base = malloc(size);
+        if(base != NULL) {
+            free(arena->base);
+            arena->base = base;
+            arena->size = size;
+            arena->stats.heap_allocations += 1;
+        }
+    }
+    arena->offset = 0;
+    arena->requested = 0;
+    arena->stats.bytes_in_use = 0;
+}
+
+GLXTAllocatorStats glxt_arena_stats(const GLXTArena* arena)
+{
+    return arena->stats;
+}
+
+bool glxt_frame_arena_init(GLXTFrameArena* arena, size_t size)
+{
+    if(arena == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(arena, 0, sizeof(*arena));
+    for(size_t i = 0; i < GLXT_FRAME_ARENA_BUFFERS; ++i) {
+        if(!glxt_arena_init(&arena->arenas[i], size)) {
+            glxt_frame_arena_deinit(arena);
+            return false;
+        }
+    }
+    return true;
+}
+
+void glxt_frame_arena_deinit(GLXTFrameArena* arena)
+{
+    if(arena == NULL) return;
+    for(size_t i = 0; i < GLXT_FRAME_ARENA_BUFFERS; ++i) glxt_arena_deinit(&arena->arenas[i]);
+    arena->current = 0;
+}
+
+void* glxt_frame_arena_alloc(GLXTFrameArena* arena, size_t size, size_t alignment)
+{
+    if(arena == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+    return glxt_arena_alloc(&arena->arenas[arena->current], size, alignment);
+}
+
+void glxt_frame_arena_swap(GLXTFrameArena* arena)
+{
+    if(arena == NULL) return;
+    arena->current = (arena->current + 1) % GLXT_FRAME_ARENA_BUFFERS;
+    glxt_arena_reset(&arena->arenas[arena->current]);
+}
+
+GLXTAllocatorStats glxt_frame_arena_stats(const GLXTFrameArena* arena)
+{
+    GLXTAllocatorStats stats = {0};
+    for(size_t i = 0; i < GLXT_FRAME_ARENA_BUFFERS; ++i) {
+        const GLXTAllocatorStats* arena_stats = &arena->arenas[i].stats;
+        stats.allocations += arena_stats->allocations;
+        stats.bytes_in_use += arena_stats->bytes_in_use;
+        stats.heap_allocations += arena_stats->heap_allocations;
+        if(arena_stats->high_water > stats.high_water) stats.high_water = arena_stats->high_water;
+    }
+    return stats;
+}
+
+bool glxt_pool_init(GLXTPool* pool, size_t element_size, size_t chunk_elements)
+{
+    if(pool == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(element_size == 0 || chunk_elements == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+    memset(pool, 0, sizeof(*pool));
+    // Free elements hold the free list link, every element stays aligned to 16
+    if(element_size < sizeof(void*)) element_size = sizeof(void*);
+    pool->element_size = _glxt_align_up(element_size, _GLXT_ALLOCATOR_ALIGNMENT);
+    pool->chunk_elements = chunk_elements;
+    return true;
+}
+
+void glxt_pool_deinit(GLXTPool* pool)
+{
+    if(pool == NULL) return;
+    while(pool->chunks != NULL) {
+        _GLXTPoolChunk* next = pool->chunks->next;
+        free(pool->chunks);
+        pool->chunks = next;
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+void* glxt_pool_alloc(GLXTPool* pool)
+{
+    if(pool == NULL || pool->element_size == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+
+    if(pool->free_list == NULL) {
+        _GLXTPoolChunk* chunk = malloc(sizeof(_GLXTPoolChunk) + pool->element_size * pool->chunk_elements);
+        if(chunk == NULL) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return NULL;
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        pool->stats.heap_allocations += 1;
+
+        // Linked back to front so elements are handed out in address order
+        uint8_t* elements = (uint8_t*)(chunk + 1);
+        for(size_t i = pool->chunk_elements; i-- > 0;) {
+            void* element = elements + i * pool->element_size;
+            *(void**)element = pool->free_list;
+            pool->free_list = element;
+        }
+    }
+
+    void* element = pool->free_list;
+    pool->free_list = *(void**)element;
+    pool->stats.allocations += 1;
+    pool->stats.bytes_in_use += pool->element_size;
+    if(pool->stats.bytes_in_use > pool->stats.high_water) pool->stats.high_water = pool->stats.bytes_in_use;
+    return element;
+}
+
+void glxt_pool_free(GLXTPool* pool, void* element)
+{
+    if(pool == NULL || element == NULL) return;
+    *(void**)element = pool->free_list;
+    pool->free_list = element;
+    pool->stats.bytes_in_use -= pool->element_size;
+}
+
+GLXTAllocatorStats glxt_pool_stats(const GLXTPool* pool)
+{
+    return pool->stats;
+}
+
+#endif // GLXT_ALLOCATOR_IMPLEMENTATION
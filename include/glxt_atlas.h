@@ -0,0 +1,500 @@
+/**
+ * glxt_atlas works like glxt: define GLXT_ATLAS_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Texture atlases.
+ * Images are packed into a few large texture2d pages with a skyline
+ * (bottom-left) packer so sprites that share a page can share a batch.
+ * Insertion works at any time: the pixels are copied into the page's CPU
+ * copy and only the dirty region is uploaded by glxt_atlas_upload. A
+ * packed atlas can be saved and loaded back without repacking.
+ *
+ * Entries are identified by a non-zero id, 0 means the image did not fit.
+ */
+#ifndef GLXT_ATLAS_H
+#define GLXT_ATLAS_H
+
+#include "glxt.h"
+
+#ifndef GLXT_ATLAS_MAXIMUM_PAGES
+    #define GLXT_ATLAS_MAXIMUM_PAGES 8
+#endif
+
+typedef struct GLXTAtlasEntry {
+    uint32_t page;
+    uint32_t x, y;
+    uint32_t width, height;
+    float u0, v0, u1, v1;
+} GLXTAtlasEntry;
+
+typedef struct GLXTAtlasSkylineNode {
+    uint32_t x, y, width;
+} GLXTAtlasSkylineNode;
+
+typedef struct GLXTAtlasPage {
+    uint32_t texture;
+    uint8_t* pixels;
+    GLXTAtlasSkylineNode* skyline;
+    size_t skyline_count;
+    bool dirty;
+    uint32_t dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+} GLXTAtlasPage;
+
+typedef struct GLXTAtlasStats {
+    size_t entries;
+    size_t pages;
+    size_t pixels_used;
+    size_t uploads;
+    size_t pixels_uploaded;
+} GLXTAtlasStats;
+
+typedef struct GLXTAtlas {
+    uint32_t width, height;
+    int comp;
+    uint32_t padding;
+    GLXTAtlasPage pages[GLXT_ATLAS_MAXIMUM_PAGES];
+    size_t pages_count;
+    GLXTAtlasEntry* entries;
+    size_t entries_count;
+    size_t entries_capacity;
+    GLXTAtlasStats stats;
+} GLXTAtlas;
+
+/**
+ * Every page is width x height with comp 8 bit channels. padding pixels
+ * are kept free around each image to avoid bleeding when filtering.
+ */
+bool glxt_atlas_init(GLXTAtlas* atlas, uint32_t width, uint32_t height, int comp, uint32_t padding);
+void glxt_atlas_deinit(GLXTAtlas* atlas);
+uint32_t glxt_atlas_add(GLXTAtlas* atlas, uint32_t width, uint32_t height, const uint8_t* pixels);
+const GLXTAtlasEntry* glxt_atlas_get(const GLXTAtlas* atlas, uint32_t id);
+uint32_t glxt_atlas_texture(const GLXTAtlas* atlas, uint32_t page);
+void glxt_atlas_upload(GLXTAtlas* atlas);
+bool glxt_atlas_save(const GLXTAtlas* atlas, const char* path);
+bool glxt_atlas_load(GLXTAtlas* atlas, const char* path);
+GLXTAtlasStats glxt_atlas_stats(const GLXTAtlas* atlas);
+
+#endif // GLXT_ATLAS_H
+
+#if defined(GLXT_ATLAS_IMPLEMENTATION) && !defined(GLXT_ATLAS_IMPLEMENTATION_INCLUDED)
+#define GLXT_ATLAS_IMPLEMENTATION_INCLUDED
+
+#define _GLXT_ATLAS_MAGIC 0x534C5447 // "GTLS"
+#define _GLXT_ATLAS_VERSION 1
+
+typedef struct _GLXTAtlasFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t comp;
+    uint32_t padding;
+    uint32_t pages_count;
+    uint32_t entries_count;
+} _GLXTAtlasFileHeader;
+
+static bool _glxt_atlas_add_page(GLXTAtlas* atlas)
+{
+    if(atlas->pages_count >= GLXT_ATLAS_MAXIMUM_PAGES) {
+        GLXT.last_failure = GLXT_ATLAS_FULL;
+        return false;
+    }
+
+    GLXTAtlasPage* page = &atlas->pages[atlas->pages_count];
+    memset(page, 0, sizeof(*page));
+    page->pixels = calloc((size_t)atlas->width * atlas->height, atlas->comp);
+    // One node per column at most, plus one while an insertion is trimmed
+    page->skyline = malloc(sizeof(GLXTAtlasSkylineNode) * (atlas->width + 1));
+    if(page->pixels == NULL || page->skyline == NULL) {
+        free(page->pixels);
+        free(page->skyline);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    page->texture = glxt_create_texture2d(atlas->width, atlas->height, atlas->comp, NULL);
+    if(page->texture == 0) {
+        free(page->pixels);
+        free(page->skyline);
+        return false;
+    }
+    page->skyline[0] = (GLXTAtlasSkylineNode){ 0, 0, atlas->width };
+    page->skyline_count = 1;
+
+    atlas->pages_count += 1;
+    atlas->stats.pages = atlas->pages_count;
+    return true;
+}
+
+bool glxt_atlas_init(GLXTAtlas* atlas, uint32_t width, uint32_t height, int comp, uint32_t padding)
+{
+    if(atlas == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(atlas, 0, sizeof(*atlas));
+    if(width == 0 || height == 0 || comp < 1 || comp > 4) {
+        GLXT.last_failure = GLXT_INVALID_TEXTURE_FORMAT;
+        return false;
+    }
+
+    atlas->width = width;
+    atlas->height = height;
+    atlas->comp = comp;
+    atlas->padding = padding;
+    return _glxt_atlas_add_page(atlas);
+}
+
+void glxt_atlas_deinit(GLXTAtlas* atlas)
+{
+    if(atlas == NULL) return;
+    for(size_t i = 0; i < atlas->pages_count; ++i) {
+        GLXTAtlasPage* page = &atlas->pages[i];
+        glxt_destroy_texture2d(page->texture);
+        free(page->pixels);
+        free(page->skyline);
+    }
+    free(atlas->entries);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+/**
+ * Returns the lowest y the rectangle can sit at when its left edge is on
+ * node index, or false when it would leave the page.
+ */
+static bool _glxt_atlas_skyline_fit(const GLXTAtlas* atlas, const GLXTAtlasPage* page,
+    size_t index, uint32_t width, uint32_t height, uint32_t* y)
+{
+    uint32_t x = page->skyline[index].x;
+    if(x + width > atlas->width) return false;
+
+    uint32_t top = 0;
+    uint32_t remaining = width;
+    for(size_t i = index; remaining > 0; ++i) {
+        if(i >= page->skyline_count) return false;
+        if(page->skyline[i].y > top) top = page->skyline[i].y;
+        if(top + height > atlas->height) return false;
+        remaining = page->skyline[i].width >= remaining ? 0 : remaining - page->skyline[i].width;
+    }
+    *y = top;
+    return true;
+}
+
+static void _glxt_atlas_skyline_insert(GLXTAtlasPage* page, size_t index,
+    uint32_t x, uint32_t y, uint32_t width)
+{
+    memmove(&page->skyline[index + 1], &page->skyline[index],
+        sizeof(GLXTAtlasSkylineNode) * (page->skyline_count - index));
+    page->skyline[index] = (GLXTAtlasSkylineNode){ x, y, width };
+    page->skyline_count += 1;
+
+    // Trim or drop the nodes now covered by the new one
+    for(size_t i = index + 1; i < page->skyline_count; ) {
+        GLXTAtlasSkylineNode* previous = &page->skyline[i - 1];
+        GLXTAtlasSkylineNode* node = &page->skyline[i];
+        uint32_t previous_end = previous->x + previous->width;
+        if(node->x >= previous_end) break;
+
+        uint32_t shrink = previous_end - node->x;
+        if(node->width > shrink) {
+            node->x += shrink;
+            node->width -= shrink;
+            break;
+        }
+        memmove(node, node + 1, sizeof(GLXTAtlasSkylineNode) * (page->skyline_count - i - 1));
+        page->skyline_count -= 1;
+    }
+
+    // Merge neighbours at the same height
+    for(size_t i = 0; i + 1 < page->skyline_count; ) {
+        if(page->skyline[i].y == page->skyline[i + 1].y) {
+            page->skyline[i].width += page->skyline[i + 1].width;
+            memmove(&page->skyline[i + 1], &page->skyline[i + 2],
+                sizeof(GLXTAtlasSkylineNode) * (page->skyline_count - i - 2));
+            page->skyline_count -= 1;
+        } else {
+            ++i;
+        }
+    }
+}
+
+static bool _glxt_atlas_pack(GLXTAtlas* atlas, GLXTAtlasPage* page,
+    uint32_t width, uint32_t height, uint32_t* x, uint32_t* y)
+{
+    size_t best_index = SIZE_MAX;
+    uint32_t best_top = UINT32_MAX;
+    uint32_t best_width = UINT32_MAX;
+    for(size_t i = 0; i < page->skyline_count; ++i) {
+        uint32_t top = 0;
+        if(!_glxt_atlas_skyline_fit(atlas, page, i, width, height, &top)) continue;
+        // Bottom-left rule, ties go to the narrowest node to limit waste
+        if(top + height < best_top || (top + height == best_top && page->skyline[i].width < best_width)) {
+            best_index = i;
+            best_top = top + height;
+            best_width = page->skyline[i].width;
+        }
+    }
+    if(best_index == SIZE_MAX) return false;
+
+    *x = page->skyline[best_index].x;
+    *y = best_top - height;
+    _glxt_atlas_skyline_insert(page, best_index, *x, best_top, width);
+    return true;
+}
+
+static void _glxt_atlas_mark_dirty(GLXTAtlasPage* page, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    if(!page->dirty) {
+        page->dirty = true;
+        page->dirty_x0 = x0;
+        page->dirty_y0 = y0;
+        page->dirty_x1 = x1;
+        page->dirty_y1 = y1;
+        return;
+    }
+    if(x0 < page->dirty_x0) page->dirty_x0 = x0;
+    if(y0 < page->dirty_y0) page->dirty_y0 = y0;
+    if(x1 > page->dirty_x1) page->dirty_x1 = x1;
+    if(y1 > page->dirty_y1) page->dirty_y1 = y1;
+}
+
+uint32_t glxt_atlas_add(GLXTAtlas* atlas, uint32_t width, uint32_t height, const uint8_t* pixels)
+{
+    if(atlas == NULL || pixels == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    uint32_t padded_width = width + atlas->padding * 2;
+    uint32_t padded_height = height + atlas->padding * 2;
+    if(width == 0 || height == 0 || padded_width > atlas->width || padded_height > atlas->height) {
+        GLXT.last_failure = GLXT_ATLAS_FULL;
+        return 0;
+    }
+
+    if(atlas->entries_count >= atlas->entries_capacity) {
+        size_t capacity = atlas->entries_capacity == 0 ? 64 : atlas->entries_capacity * 2;
+        GLXTAtlasEntry* entries = realloc(atlas->entries, sizeof(GLXTAtlasEntry) * capacity);
+        if(entries == NULL) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return 0;
+        }
+        atlas->entries = entries;
+        atlas->entries_capacity = capacity;
+    }
+
+    // Older pages are tried first so they fill up before new ones are used
+    uint32_t x = 0, y = 0;
+    size_t page_index = 0;
+    while(!_glxt_atlas_pack(atlas, &atlas->pages[page_index], padded_width, padded_height, &x, &y)) {
+        page_index += 1;
+        if(page_index >= atlas->pages_count && !_glxt_atlas_add_page(atlas))
+            return 0;
+    }
+    x += atlas->padding;
+    y += atlas->padding;
+
+    GLXTAtlasPage* page = &atlas->pages[page_index];
+    size_t row_size = (size_t)width * atlas->comp;
+    for(uint32_t row = 0; row < height; ++row) {
+        memcpy(&page->pixels[((size_t)(y + row) * atlas->width + x) * atlas->comp],
+            &pixels[row * row_size], row_size);
+    }
+    _glxt_atlas_mark_dirty(page, x, y, x + width, y + height);
+
+    GLXTAtlasEntry* entry = &atlas->entries[atlas->entries_count++];
+    entry->page = (uint32_t)page_index;
+    entry->x = x;
+    entry->y = y;
+    entry->width = width;
+    entry->height = height;
+    entry->u0 = (float)x / atlas->width;
+    entry->v0 = (float)y / atlas->height;
+    entry->u1 = (float)(x + width) / atlas->width;
+    entry->v1 = (float)(y + height) / atlas->height;
+
+    atlas->stats.entries = atlas->entries_count;
+    atlas->stats.pixels_used += (size_t)width * height;
+    return (uint32_t)atlas->entries_count;
+}
+
+const GLXTAtlasEntry* glxt_atlas_get(const GLXTAtlas* atlas, uint32_t id)
+{
+    if(atlas == NULL || id == 0 || id > atlas->entries_count) return NULL;
+    return &atlas->entries[id - 1];
+}
+
+uint32_t glxt_atlas_texture(const GLXTAtlas* atlas, uint32_t page)
+{
+    if(atlas == NULL || page >= atlas->pages_count) return 0;
+    return atlas->pages[page].texture;
+}
+
+void glxt_atlas_upload(GLXTAtlas* atlas)
+{
+    if(atlas == NULL) return;
+
+    uint32_t internal_format = 0, format = 0;
+    _glxt_comp_texture_formats(atlas->comp, &internal_format, &format);
+    for(size_t i = 0; i < atlas->pages_count; ++i) {
+        GLXTAtlasPage* page = &atlas->pages[i];
+        if(!page->dirty) continue;
+
+        uint32_t width = page->dirty_x1 - page->dirty_x0;
+        uint32_t height = page->dirty_y1 - page->dirty_y0;
+        const uint8_t* origin = &page->pixels[((size_t)page->dirty_y0 * atlas->width + page->dirty_x0) * atlas->comp];
+
+        // Upload straight out of the page copy, the row length skips the rest of each row
+        glxt_bind_texture2d(0, page->texture);
+        glxt_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        int alignment = _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, atlas->width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, page->dirty_x0, page->dirty_y0, width, height,
+            format, GL_UNSIGNED_BYTE, origin);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        _glxt_pixel_alignment(GL_UNPACK_ALIGNMENT, alignment);
+        _GLXT_COUNT(bytes_uploaded, (size_t)width * height * atlas->comp);
+
+        page->dirty = false;
+        atlas->stats.uploads += 1;
+        atlas->stats.pixels_uploaded += (size_t)width * height;
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+/**
+ * Layout: header, entries, then per page its skyline count, skyline nodes
+ * and pixels. The file is written to a temporary path and renamed.
+ */
+bool glxt_atlas_save(const GLXTAtlas* atlas, const char* path)
+{
+    if(atlas == NULL || path == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    char temp_path[GLXT_MAXIMUM_PATH];
+    if(snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) {
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+    FILE* f = fopen(temp_path, "wb");
+    if(f == NULL) {
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+
+    _GLXTAtlasFileHeader header = {0};
+    header.magic = _GLXT_ATLAS_MAGIC;
+    header.version = _GLXT_ATLAS_VERSION;
+    header.width = atlas->width;
+    header.height = atlas->height;
+    header.comp = (uint32_t)atlas->comp;
+    header.padding = atlas->padding;
+    header.pages_count = (uint32_t)atlas->pages_count;
+    header.entries_count = (uint32_t)atlas->entries_count;
+
+    size_t page_size = (size_t)atlas->width * atlas->height * atlas->comp;
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1
+        && fwrite(atlas->entries, sizeof(GLXTAtlasEntry), atlas->entries_count, f) == atlas->entries_count;
+    for(size_t i = 0; written && i < atlas->pages_count; ++i) {
+        const GLXTAtlasPage* page = &atlas->pages[i];
+        uint32_t skyline_count = (uint32_t)page->skyline_count;
+        written = fwrite(&skyline_count, sizeof(skyline_count), 1, f) == 1
+            && fwrite(page->skyline, sizeof(GLXTAtlasSkylineNode), skyline_count, f) == skyline_count
+            && fwrite(page->pixels, page_size, 1, f) == 1;
+    }
+    written = fclose(f) == 0 && written;
+
+    if(!written || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        GLXT.last_failure = GLXT_FAILED_TO_WRITE_FILE;
+        return false;
+    }
+    return true;
+}
+
+static bool _glxt_atlas_read(const GLXTFileView* view, size_t* offset, void* dst, size_t size)
+{
+    if(size > view->size - *offset) return false;
+    memcpy(dst, view->data + *offset, size);
+    *offset += size;
+    return true;
+}
+
+/**
+ * Replaces the content of an initialized atlas or initializes a zeroed
+ * one. Every page is uploaded on the next glxt_atlas_upload. A file with
+ * a bad header leaves the atlas untouched, a truncated or corrupt body
+ * leaves it deinitialized.
+ */
+bool glxt_atlas_load(GLXTAtlas* atlas, const char* path)
+{
+    if(atlas == NULL || path == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    GLXTFileView view = {0};
+    if(!glxt_load_file(path, &view)) return false;
+
+    size_t offset = 0;
+    _GLXTAtlasFileHeader header = {0};
+    bool valid = _glxt_atlas_read(&view, &offset, &header, sizeof(header))
+        && header.magic == _GLXT_ATLAS_MAGIC
+        && header.version == _GLXT_ATLAS_VERSION
+        && header.pages_count > 0 && header.pages_count <= GLXT_ATLAS_MAXIMUM_PAGES
+        && header.entries_count <= (view.size - offset) / sizeof(GLXTAtlasEntry);
+
+    bool replaced = valid;
+    if(valid) {
+        glxt_atlas_deinit(atlas);
+        valid = glxt_atlas_init(atlas, header.width, header.height, (int)header.comp, header.padding);
+    }
+    while(valid && atlas->pages_count < header.pages_count)
+        valid = _glxt_atlas_add_page(atlas);
+
+    if(valid && header.entries_count > 0) {
+        atlas->entries = malloc(sizeof(GLXTAtlasEntry) * header.entries_count);
+        atlas->entries_capacity = header.entries_count;
+        valid = atlas->entries != NULL
+            && _glxt_atlas_read(&view, &offset, atlas->entries, sizeof(GLXTAtlasEntry) * header.entries_count);
+        atlas->entries_count = valid ? header.entries_count : 0;
+    }
+
+    size_t page_size = (size_t)atlas->width * atlas->height * atlas->comp;
+    for(size_t i = 0; valid && i < atlas->pages_count; ++i) {
+        GLXTAtlasPage* page = &atlas->pages[i];
+        uint32_t skyline_count = 0;
+        valid = _glxt_atlas_read(&view, &offset, &skyline_count, sizeof(skyline_count))
+            && skyline_count > 0 && skyline_count <= atlas->width
+            && _glxt_atlas_read(&view, &offset, page->skyline, sizeof(GLXTAtlasSkylineNode) * skyline_count)
+            && _glxt_atlas_read(&view, &offset, page->pixels, page_size);
+        page->skyline_count = skyline_count;
+        _glxt_atlas_mark_dirty(page, 0, 0, atlas->width, atlas->height);
+    }
+    for(size_t i = 0; valid && i < atlas->entries_count; ++i) {
+        const GLXTAtlasEntry* entry = &atlas->entries[i];
+        valid = entry->page < atlas->pages_count
+            && entry->x + entry->width <= atlas->width
+            && entry->y + entry->height <= atlas->height;
+        atlas->stats.pixels_used += (size_t)entry->width * entry->height;
+    }
+    glxt_release_file(&view);
+
+    if(!valid) {
+        if(replaced) glxt_atlas_deinit(atlas);
+        GLXT.last_failure = GLXT_ATLAS_INVALID_FILE;
+        return false;
+    }
+    atlas->stats.entries = atlas->entries_count;
+    return true;
+}
+
+GLXTAtlasStats glxt_atlas_stats(const GLXTAtlas* atlas)
+{
+    GLXTAtlasStats stats = {0};
+    if(atlas != NULL) stats = atlas->stats;
+    return stats;
+}
+
+#endif // GLXT_ATLAS_IMPLEMENTATION
@@ -0,0 +1,599 @@
+/**
+ * glxt_buffer_pool works like glxt: define GLXT_BUFFER_POOL_IMPLEMENTATION
+ * in the file where glxt is implemented, after the glxt and glxt_mesh
+ * implementations.
+ *
+ * Buffer pools.
+ * A pool carves vertex and index ranges for many meshes out of one vertex
+ * buffer and one index buffer that share a single vertex array, so drawing
+ * different meshes of the pool needs no rebinding. Every mesh of a pool
+ * has the same vertex layout. Create a static pool (GL_STATIC_DRAW) for
+ * geometry written once and a dynamic pool (GL_DYNAMIC_DRAW) for geometry
+ * rewritten often.
+ *
+ * Ranges are kept in first-fit free lists. Indices are stored as 32-bit
+ * values already offset by the mesh's first vertex, so the draw functions
+ * only need the index offset. Defragmentation compacts both buffers and
+ * happens on glxt_buffer_pool_defragment or when an allocation does not
+ * fit in any free range even though enough space is free in total.
+ * Allocations are handles, look up the current range with
+ * glxt_buffer_pool_range after a defragmentation. A handle carries the
+ * generation of its slot, so a freed handle stays invalid once the slot
+ * is reused.
+ */
+#ifndef GLXT_BUFFER_POOL_H
+#define GLXT_BUFFER_POOL_H
+
+#include "glxt.h"
+#include "glxt_mesh.h"
+
+typedef uint32_t GLXTBufferAllocation;
+
+typedef struct GLXTBufferPoolDesc {
+    size_t vertex_size;
+    size_t max_vertices;
+    size_t max_indices;
+    bool dynamic;
+    const GLXTMeshAttrib* attribs;
+    size_t attribs_count;
+} GLXTBufferPoolDesc;
+
+typedef struct GLXTBufferRange {
+    uint32_t first_vertex;
+    uint32_t vertices_count;
+    uint32_t first_index;
+    uint32_t indices_count;
+} GLXTBufferRange;
+
+typedef struct GLXTBufferPoolStats {
+    size_t allocations;
+    size_t vertices_used;
+    size_t indices_used;
+    size_t largest_free_vertices;
+    size_t largest_free_indices;
+    size_t defragmentations;
+    size_t bytes_moved;
+} GLXTBufferPoolStats;
+
+typedef struct _GLXTBufferPoolBlock {
+    size_t offset;
+    size_t size;
+} _GLXTBufferPoolBlock;
+
+typedef struct _GLXTBufferPoolSpace {
+    _GLXTBufferPoolBlock* free_blocks;
+    size_t free_count;
+    size_t free_capacity;
+    size_t capacity;
+    size_t used;
+} _GLXTBufferPoolSpace;
+
+typedef struct _GLXTBufferPoolEntry {
+    bool used;
+    uint8_t generation;
+    GLXTBufferRange range;
+} _GLXTBufferPoolEntry;
+
+typedef struct GLXTBufferPool {
+    uint32_t vao;
+    uint32_t vbo;
+    uint32_t ibo;
+    size_t vertex_size;
+    uint32_t usage;
+    GLXTMeshAttrib attribs[GLXT_MESH_FILE_MAXIMUM_ATTRIBS];
+    size_t attribs_count;
+    _GLXTBufferPoolSpace vertices;
+    _GLXTBufferPoolSpace indices;
+    _GLXTBufferPoolEntry* entries;
+    size_t entries_count;
+    size_t entries_capacity;
+    GLXTBufferPoolStats stats;
+} GLXTBufferPool;
+
+bool glxt_buffer_pool_init(GLXTBufferPool* pool, const GLXTBufferPoolDesc* desc);
+void glxt_buffer_pool_deinit(GLXTBufferPool* pool);
+
+// Returns 0 when the pool is full, indices_count may be 0 for array draws
+GLXTBufferAllocation glxt_buffer_pool_alloc(GLXTBufferPool* pool, size_t vertices_count, size_t indices_count);
+void glxt_buffer_pool_free(GLXTBufferPool* pool, GLXTBufferAllocation allocation);
+/**
+ * Writes the whole allocation. indices are relative to the mesh's first
+ * vertex and of index_type (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or
+ * GL_UNSIGNED_INT), they may be NULL when the allocation has none.
+ */
+bool glxt_buffer_pool_write(GLXTBufferPool* pool, GLXTBufferAllocation allocation,
+    const void* vertices, const void* indices, uint32_t index_type);
+GLXTBufferAllocation glxt_buffer_pool_add(GLXTBufferPool* pool, const void* vertices, size_t vertices_count,
+    const void* indices, uint32_t index_type, size_t indices_count);
+GLXTBufferAllocation glxt_buffer_pool_add_mesh(GLXTBufferPool* pool, const GLXTMesh* mesh);
+GLXTBufferRange glxt_buffer_pool_range(const GLXTBufferPool* pool, GLXTBufferAllocation allocation);
+bool glxt_buffer_pool_defragment(GLXTBufferPool* pool);
+
+void glxt_buffer_pool_enable(GLXTBufferPool* pool);
+// Draws with the pool enabled, indexed when the allocation has indices
+void glxt_buffer_pool_draw(const GLXTBufferPool* pool, GLXTBufferAllocation allocation, uint32_t mode);
+void glxt_buffer_pool_draw_instanced(const GLXTBufferPool* pool, GLXTBufferAllocation allocation,
+    uint32_t mode, int instances_count);
+GLXTBufferPoolStats glxt_buffer_pool_stats(const GLXTBufferPool* pool);
+
+#endif // GLXT_BUFFER_POOL_H
+
+#if defined(GLXT_BUFFER_POOL_IMPLEMENTATION) && !defined(GLXT_BUFFER_POOL_IMPLEMENTATION_INCLUDED)
+#define GLXT_BUFFER_POOL_IMPLEMENTATION_INCLUDED
+
+static bool _glxt_buffer_pool_space_init(_GLXTBufferPoolSpace* space, size_t capacity)
+{
+    memset(space, 0, sizeof(*space));
+    space->capacity = capacity;
+    if(capacity == 0) return true;
+
+    space->free_blocks = malloc(sizeof(_GLXTBufferPoolBlock) * 16);
+    if(space->free_blocks == NULL) return false;
+    space->free_capacity = 16;
+    space->free_blocks[0].offset = 0;
+    space->free_blocks[0].size = capacity;
+    space->free_count = 1;
+    return true;
+}
+
+static void _glxt_buffer_pool_space_reset(_GLXTBufferPoolSpace* space, size_t used)
+{
+    // Everything packed at the front, one free block after it
+    space->used = used;
+    space->free_count = 0;
+    if(used < space->capacity) {
+        space->free_blocks[0].offset = used;
+        space->free_blocks[0].size = space->capacity - used;
+        space->free_count = 1;
+    }
+}
+
+static bool _glxt_buffer_pool_space_alloc(_GLXTBufferPoolSpace* space, size_t size, size_t* offset)
+{
+    if(size == 0) {
+        *offset = 0;
+        return true;
+    }
+    for(size_t i = 0; i < space->free_count; ++i) {
+        _GLXTBufferPoolBlock* block = &space->free_blocks[i];
+        if(block->size < size) continue;
+
+        *offset = block->offset;
+        block->offset += size;
+        block->size -= size;
+        if(block->size == 0) {
+            memmove(block, block + 1, sizeof(*block) * (space->free_count - i - 1));
+            space->free_count -= 1;
+        }
+        space->used += size;
+        return true;
+    }
+    return false;
+}
+
+static bool _glxt_buffer_pool_space_free(_GLXTBufferPoolSpace* space, size_t offset, size_t size)
+{
+    if(size == 0) return true;
+
+    // Free blocks are sorted by offset, merge with the neighbours
+    size_t i = 0;
+    while(i < space->free_count && space->free_blocks[i].offset < offset) i += 1;
+
+    bool merge_previous = i > 0
+        && space->free_blocks[i - 1].offset + space->free_blocks[i - 1].size == offset;
+    bool merge_next = i < space->free_count && offset + size == space->free_blocks[i].offset;
+
+    space->used -= size;
+    if(merge_previous && merge_next) {
+        space->free_blocks[i - 1].size += size + space->free_blocks[i].size;
+        memmove(&space->free_blocks[i], &space->free_blocks[i + 1],
+            sizeof(_GLXTBufferPoolBlock) * (space->free_count - i - 1));
+        space->free_count -= 1;
+        return true;
+    }
+    if(merge_previous) {
+        space->free_blocks[i - 1].size += size;
+        return true;
+    }
+    if(merge_next) {
+        space->free_blocks[i].offset = offset;
+        space->free_blocks[i].size += size;
+        return true;
+    }
+
+    if(space->free_count == space->free_capacity) {
+        size_t capacity = space->free_capacity * 2;
+        _GLXTBufferPoolBlock* blocks = realloc(space->free_blocks, sizeof(_GLXTBufferPoolBlock) * capacity);
+        if(blocks == NULL) {
+            // The range leaks until the next defragmentation rebuilds the list
+            return false;
+        }
+        space->free_blocks = blocks;
+        space->free_capacity = capacity;
+    }
+    memmove(&space->free_blocks[i + 1], &space->free_blocks[i],
+        sizeof(_GLXTBufferPoolBlock) * (space->free_count - i));
+    space->free_blocks[i].offset = offset;
+    space->free_blocks[i].size = size;
+    space->free_count += 1;
+    return true;
+}
+
+static size_t _glxt_buffer_pool_space_largest(const _GLXTBufferPoolSpace* space)
+{
+    size_t largest = 0;
+    for(size_t i = 0; i < space->free_count; ++i)
+        if(space->free_blocks[i].size > largest) largest = space->free_blocks[i].size;
+    return largest;
+}
+
+static void _glxt_buffer_pool_setup_vertex_array(GLXTBufferPool* pool)
+{
+    glxt_enable_vertex_array(pool->vao);
+    glxt_bind_buffer(GL_ARRAY_BUFFER, pool->vbo);
+    for(size_t i = 0; i < pool->attribs_count; ++i) {
+        const GLXTMeshAttrib* attrib = &pool->attribs[i];
+        glxt_set_vertex_attrib(attrib->index, (int)attrib->comp_count, (int)attrib->attr_type,
+            attrib->normalized != 0, pool->vertex_size, (const void*)(uintptr_t)attrib->offset);
+    }
+    glxt_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, pool->ibo);
+}
+
+bool glxt_buffer_pool_init(GLXTBufferPool* pool, const GLXTBufferPoolDesc* desc)
+{
+    if(pool == NULL || desc == NULL || (desc->attribs == NULL && desc->attribs_count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(pool, 0, sizeof(*pool));
+    if(desc->vertex_size == 0 || desc->max_vertices == 0 || desc->max_vertices > UINT32_MAX
+        || desc->max_indices > UINT32_MAX || desc->attribs_count > GLXT_MESH_FILE_MAXIMUM_ATTRIBS) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+
+    pool->vertex_size = desc->vertex_size;
+    pool->usage = desc->dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+    pool->attribs_count = desc->attribs_count;
+    if(desc->attribs_count > 0)
+        memcpy(pool->attribs, desc->attribs, sizeof(GLXTMeshAttrib) * desc->attribs_count);
+
+    if(!_glxt_buffer_pool_space_init(&pool->vertices, desc->max_vertices)
+        || !_glxt_buffer_pool_space_init(&pool->indices, desc->max_indices)) {
+        free(pool->vertices.free_blocks);
+        free(pool->indices.free_blocks);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    pool->vao = glxt_create_vertex_array();
+    glGenBuffers(1, &pool->vbo);
+    glxt_bind_buffer(GL_ARRAY_BUFFER, pool->vbo);
+    glBufferData(GL_ARRAY_BUFFER, desc->vertex_size * desc->max_vertices, NULL, pool->usage);
+    if(desc->max_indices > 0) {
+        glGenBuffers(1, &pool->ibo);
+        glxt_bind_buffer(GL_ARRAY_BUFFER, pool->ibo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * desc->max_indices, NULL, pool->usage);
+    }
+    _glxt_buffer_pool_setup_vertex_array(pool);
+    glxt_disable_vertex_array();
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_buffer_pool_deinit(GLXTBufferPool* pool)
+{
+    if(pool == NULL || pool->vao == 0) return;
+
+    glxt_destroy_vertex_array(pool->vao);
+    glxt_destroy_vertex_buffer(pool->vbo);
+    if(pool->ibo != 0) glxt_destroy_index_buffer(pool->ibo);
+    free(pool->vertices.free_blocks);
+    free(pool->indices.free_blocks);
+    free(pool->entries);
+    memset(pool, 0, sizeof(*pool));
+}
+
+#define _GLXT_BUFFER_POOL_MAXIMUM_ENTRIES 0xFFFFFF
+
+// [generation:8][entry slot + 1:24], never 0 for a valid handle
+static GLXTBufferAllocation _glxt_buffer_pool_handle(const GLXTBufferPool* pool, size_t slot)
+{
+    return ((uint32_t)pool->entries[slot].generation << 24) | (uint32_t)(slot + 1);
+}
+
+static _GLXTBufferPoolEntry* _glxt_buffer_pool_entry(const GLXTBufferPool* pool, GLXTBufferAllocation allocation)
+{
+    size_t slot = allocation & _GLXT_BUFFER_POOL_MAXIMUM_ENTRIES;
+    if(pool == NULL || slot == 0 || slot > pool->entries_count) return NULL;
+    _GLXTBufferPoolEntry* entry = &pool->entries[slot - 1];
+    return entry->used && entry->generation == (allocation >> 24) ? entry : NULL;
+}
+
+// Slot of an unused entry, entries_count when there is none left
+static size_t _glxt_buffer_pool_new_entry(GLXTBufferPool* pool)
+{
+    for(size_t i = 0; i < pool->entries_count; ++i)
+        if(!pool->entries[i].used) return i;
+
+    if(pool->entries_count == _GLXT_BUFFER_POOL_MAXIMUM_ENTRIES) return pool->entries_count;
+    if(pool->entries_count == pool->entries_capacity) {
+        size_t capacity = pool->entries_capacity == 0 ? 64 : pool->entries_capacity * 2;
+        _GLXTBufferPoolEntry* entries = realloc(pool->entries, sizeof(_GLXTBufferPoolEntry) * capacity);
+        if(entries == NULL) return pool->entries_count;
+        pool->entries = entries;
+        pool->entries_capacity = capacity;
+    }
+    pool->entries[pool->entries_count].used = false;
+    pool->entries[pool->entries_count].generation = 1;
+    pool->entries_count += 1;
+    return pool->entries_count - 1;
+}
+
+GLXTBufferAllocation glxt_buffer_pool_alloc(GLXTBufferPool* pool, size_t vertices_count, size_t indices_count)
+{
+    if(pool == NULL || pool->vao == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    if(vertices_count == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return 0;
+    }
+    if(vertices_count > pool->vertices.capacity - pool->vertices.used
+        || indices_count > pool->indices.capacity - pool->indices.used) {
+        GLXT.last_failure = GLXT_BUFFER_POOL_FULL;
+        return 0;
+    }
+
+    // Enough space in total, compact when it is too fragmented to fit
+    if(_glxt_buffer_pool_space_largest(&pool->vertices) < vertices_count
+        || (indices_count > 0 && _glxt_buffer_pool_space_largest(&pool->indices) < indices_count)) {
+        if(!glxt_buffer_pool_defragment(pool)) return 0;
+    }
+
+    size_t slot = _glxt_buffer_pool_new_entry(pool);
+    if(slot == pool->entries_count) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return 0;
+    }
+
+    size_t first_vertex = 0, first_index = 0;
+    _glxt_buffer_pool_space_alloc(&pool->vertices, vertices_count, &first_vertex);
+    _glxt_buffer_pool_space_alloc(&pool->indices, indices_count, &first_index);
+
+    _GLXTBufferPoolEntry* entry = &pool->entries[slot];
+    entry->used = true;
+    entry->range.first_vertex = (uint32_t)first_vertex;
+    entry->range.vertices_count = (uint32_t)vertices_count;
+    entry->range.first_index = (uint32_t)first_index;
+    entry->range.indices_count = (uint32_t)indices_count;
+    pool->stats.allocations += 1;
+    return _glxt_buffer_pool_handle(pool, slot);
+}
+
+void glxt_buffer_pool_free(GLXTBufferPool* pool, GLXTBufferAllocation allocation)
+{
+    _GLXTBufferPoolEntry* entry = _glxt_buffer_pool_entry(pool, allocation);
+    if(entry == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    _glxt_buffer_pool_space_free(&pool->vertices, entry->range.first_vertex, entry->range.vertices_count);
+    _glxt_buffer_pool_space_free(&pool->indices, entry->range.first_index, entry->range.indices_count);
+    entry->used = false;
+    entry->generation = entry->generation == 0xFF ? 1 : entry->generation + 1;
+    pool->stats.allocations -= 1;
+}
+
+bool glxt_buffer_pool_write(GLXTBufferPool* pool, GLXTBufferAllocation allocation,
+    const void* vertices, const void* indices, uint32_t index_type)
+{
+    _GLXTBufferPoolEntry* entry = _glxt_buffer_pool_entry(pool, allocation);
+    if(entry == NULL || vertices == NULL || (indices == NULL && entry->range.indices_count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    const GLXTBufferRange* range = &entry->range;
+
+    glxt_bind_buffer(GL_ARRAY_BUFFER, pool->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(range->first_vertex * pool->vertex_size),
+        range->vertices_count * pool->vertex_size, vertices);
+    _GLXT_COUNT(bytes_uploaded, range->vertices_count * pool->vertex_size);
+
+    if(range->indices_count > 0) {
+        uint32_t* rebased = glxt_scratch_alloc(sizeof(uint32_t) * range->indices_count);
+        if(rebased == NULL) return false;
+        for(size_t i = 0; i < range->indices_count; ++i) {
+            uint32_t index = 0;
+            switch(index_type) {
+                case GL_UNSIGNED_BYTE: index = ((const uint8_t*)indices)[i]; break;
+                case GL_UNSIGNED_SHORT: index = ((const uint16_t*)indices)[i]; break;
+                default: index = ((const uint32_t*)indices)[i]; break;
+            }
+            rebased[i] = range->first_vertex + index;
+        }
+        // Bound on the copy target so the element binding of the current
+        // vertex array is left alone
+        glxt_bind_buffer(GL_COPY_WRITE_BUFFER, pool->ibo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(range->first_index * sizeof(uint32_t)),
+            range->indices_count * sizeof(uint32_t), rebased);
+        _GLXT_COUNT(bytes_uploaded, range->indices_count * sizeof(uint32_t));
+        glxt_scratch_free(rebased);
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+GLXTBufferAllocation glxt_buffer_pool_add(GLXTBufferPool* pool, const void* vertices, size_t vertices_count,
+    const void* indices, uint32_t index_type, size_t indices_count)
+{
+    GLXTBufferAllocation allocation = glxt_buffer_pool_alloc(pool, vertices_count, indices_count);
+    if(allocation == 0) return 0;
+    if(!glxt_buffer_pool_write(pool, allocation, vertices, indices, index_type)) {
+        glxt_buffer_pool_free(pool, allocation);
+        return 0;
+    }
+    return allocation;
+}
+
+GLXTBufferAllocation glxt_buffer_pool_add_mesh(GLXTBufferPool* pool, const GLXTMesh* mesh)
+{
+    if(pool == NULL || mesh == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    if(mesh->vertex_size != pool->vertex_size) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return 0;
+    }
+    return glxt_buffer_pool_add(pool, mesh->vertices, mesh->vertices_count,
+        mesh->indices, mesh->index_type, mesh->indices_count);
+}
+
+GLXTBufferRange glxt_buffer_pool_range(const GLXTBufferPool* pool, GLXTBufferAllocation allocation)
+{
+    GLXTBufferRange range = {0};
+    const _GLXTBufferPoolEntry* entry = _glxt_buffer_pool_entry(pool, allocation);
+    if(entry != NULL) range = entry->range;
+    return range;
+}
+
+/**
+ * Live ranges are copied GPU side, in allocation order, to the front of
+ * fresh buffers. Indices have to be rebased to the new first vertex, so
+ * the old index buffer is read back, which waits for the GPU.
+ */
+bool glxt_buffer_pool_defragment(GLXTBufferPool* pool)
+{
+    if(pool == NULL || pool->vao == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    uint32_t* indices = NULL;
+    if(pool->indices.used > 0) {
+        indices = glxt_scratch_alloc(sizeof(uint32_t) * pool->indices.used);
+        if(indices == NULL) return false;
+    }
+
+    uint32_t vbo = 0;
+    glGenBuffers(1, &vbo);
+    glxt_bind_buffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, pool->vertex_size * pool->vertices.capacity, NULL, pool->usage);
+    glxt_bind_buffer(GL_COPY_READ_BUFFER, pool->vbo);
+
+    const uint32_t* old_indices = NULL;
+    if(indices != NULL) {
+        glxt_bind_buffer(GL_ARRAY_BUFFER, pool->ibo);
+        old_indices = glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(uint32_t) * pool->indices.capacity,
+            GL_MAP_READ_BIT);
+        if(old_indices == NULL) {
+            glxt_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+            _glxt_forget_buffer(vbo);
+            glDeleteBuffers(1, &vbo);
+            glxt_scratch_free(indices);
+            DEBUG_DO(_glxt_check_opengl_error());
+            return false;
+        }
+    }
+
+    size_t vertex_cursor = 0, index_cursor = 0;
+    for(size_t i = 0; i < pool->entries_count; ++i) {
+        _GLXTBufferPoolEntry* entry = &pool->entries[i];
+        if(!entry->used) continue;
+        GLXTBufferRange* range = &entry->range;
+
+        size_t size = range->vertices_count * pool->vertex_size;
+        if(range->first_vertex != vertex_cursor) pool->stats.bytes_moved += size;
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            (GLintptr)(range->first_vertex * pool->vertex_size),
+            (GLintptr)(vertex_cursor * pool->vertex_size), (GLsizeiptr)size);
+
+        for(size_t k = 0; k < range->indices_count; ++k) {
+            uint32_t index = old_indices[range->first_index + k];
+            indices[index_cursor + k] = index - range->first_vertex + (uint32_t)vertex_cursor;
+        }
+        if(range->first_index != index_cursor) pool->stats.bytes_moved += range->indices_count * sizeof(uint32_t);
+
+        range->first_vertex = (uint32_t)vertex_cursor;
+        range->first_index = range->indices_count > 0 ? (uint32_t)index_cursor : 0;
+        vertex_cursor += range->vertices_count;
+        index_cursor += range->indices_count;
+    }
+
+    if(old_indices != NULL) {
+        glxt_bind_buffer(GL_ARRAY_BUFFER, pool->ibo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(uint32_t) * index_cursor, indices);
+    }
+    glxt_scratch_free(indices);
+
+    // Only the vertex buffer was replaced, the index buffer was rewritten in place
+    glxt_destroy_vertex_buffer(pool->vbo);
+    pool->vbo = vbo;
+    _glxt_buffer_pool_setup_vertex_array(pool);
+
+    _glxt_buffer_pool_space_reset(&pool->vertices, vertex_cursor);
+    _glxt_buffer_pool_space_reset(&pool->indices, index_cursor);
+    pool->stats.defragmentations += 1;
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_buffer_pool_enable(GLXTBufferPool* pool)
+{
+    if(pool == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    glxt_enable_vertex_array(pool->vao);
+}
+
+void glxt_buffer_pool_draw(const GLXTBufferPool* pool, GLXTBufferAllocation allocation, uint32_t mode)
+{
+    glxt_buffer_pool_draw_instanced(pool, allocation, mode, 0);
+}
+
+// An instances_count of 0 draws without instancing
+void glxt_buffer_pool_draw_instanced(const GLXTBufferPool* pool, GLXTBufferAllocation allocation,
+    uint32_t mode, int instances_count)
+{
+    const _GLXTBufferPoolEntry* entry = _glxt_buffer_pool_entry(pool, allocation);
+    if(entry == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    const GLXTBufferRange* range = &entry->range;
+
+    if(range->indices_count > 0) {
+        size_t offset = range->first_index * sizeof(uint32_t);
+        if(instances_count > 0)
+            glxt_draw_elements_instanced(mode, (int)range->indices_count, GL_UNSIGNED_INT, offset, instances_count);
+        else
+            glxt_draw_elements(mode, (int)range->indices_count, GL_UNSIGNED_INT, offset);
+    } else {
+        if(instances_count > 0)
+            glxt_draw_arrays_instanced(mode, (int)range->first_vertex, (int)range->vertices_count, instances_count);
+        else
+            glxt_draw_arrays(mode, (int)range->first_vertex, (int)range->vertices_count);
+    }
+}
+
+GLXTBufferPoolStats glxt_buffer_pool_stats(const GLXTBufferPool* pool)
+{
+    GLXTBufferPoolStats stats = {0};
+    if(pool == NULL) return stats;
+    stats = pool->stats;
+    stats.vertices_used = pool->vertices.used;
+    stats.indices_used = pool->indices.used;
+    stats.largest_free_vertices = _glxt_buffer_pool_space_largest(&pool->vertices);
+    stats.largest_free_indices = _glxt_buffer_pool_space_largest(&pool->indices);
+    return stats;
+}
+
+#endif // GLXT_BUFFER_POOL_IMPLEMENTATION
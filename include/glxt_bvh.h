@@ -0,0 +1,702 @@
+/**
+ * glxt_bvh works like glxt: define GLXT_BVH_IMPLEMENTATION in the file
+ * where glxt is implemented, after the glxt implementation.
+ *
+ * Bounding volume hierarchy over axis aligned boxes, for frustum culling
+ * and picking. The build splits nodes with the surface area heuristic
+ * evaluated over GLXT_BVH_BINS centroid bins per axis. Moving boxes are
+ * handled by glxt_bvh_refit, which recomputes every node's bounds
+ * bottom-up without changing the tree; the tree degrades as boxes drift
+ * away from where they were at build time, rebuild when refits stop
+ * paying off.
+ *
+ * Nodes are stored depth first with both children of a node next to each
+ * other, children always after their parent. The boxes are copied in leaf
+ * order, queries never touch the caller's array and return the caller's
+ * box indices.
+ *
+ * Frusta come from a view projection matrix, mat4_dot(view, projection)
+ * in llama.h order, with OpenGL clip space. Planes point inwards.
+ *
+ *     GLXTFrustum frustum = glxt_frustum_from_matrix(view_projection);
+ *     size_t visible = glxt_bvh_cull(&bvh, &frustum, indices, capacity);
+ *
+ *     GLXTRay ray = glxt_ray_from_cursor(x, y, width, height, mat4_inverse(view_projection));
+ *     GLXTRayHit hit;
+ *     if(glxt_bvh_raycast(&bvh, &ray, LLAMA_INFINITY, NULL, NULL, &hit)) pick(hit.index);
+ *
+ * Include glfwe.h before glxt_bvh.h to get GLXTBVHPicker, which follows
+ * the cursor through glfwe events and casts a ray on every left click:
+ *
+ *     GLXTBVHPicker picker = { .width = width, .height = height };
+ *     while(glfwe_poll_events(&event)) {
+ *         picker.inverse_view_projection = mat4_inverse(view_projection);
+ *         if(glxt_bvh_pick_event(&bvh, &picker, &event, NULL, NULL, &hit)) pick(hit.index);
+ *     }
+ */
+#ifndef GLXT_BVH_H
+#define GLXT_BVH_H
+
+#include "glxt.h"
+#include <llama.h>
+
+#ifndef GLXT_BVH_BINS
+    #define GLXT_BVH_BINS 16
+#endif
+
+#ifndef GLXT_BVH_MAXIMUM_LEAF_BOXES
+    #define GLXT_BVH_MAXIMUM_LEAF_BOXES 4
+#endif
+
+// Cost of visiting a node, in box tests
+#ifndef GLXT_BVH_TRAVERSAL_COST
+    #define GLXT_BVH_TRAVERSAL_COST 1.0f
+#endif
+
+// Traversals hold at most depth + 1 nodes, the build stops splitting below this depth
+#define GLXT_BVH_STACK_SIZE 64
+
+typedef struct GLXTAABB {
+    vec3_t min;
+    vec3_t max;
+} GLXTAABB;
+
+// xyz is the inward normal, w the distance, a point p is inside when dot(xyz, p) + w >= 0
+typedef struct GLXTFrustum {
+    vec4_t planes[6];
+} GLXTFrustum;
+
+typedef struct GLXTRay {
+    vec3_t origin;
+    // Normalized
+    vec3_t direction;
+} GLXTRay;
+
+typedef struct GLXTRayHit {
+    uint32_t index;
+    float distance;
+} GLXTRayHit;
+
+/**
+ * Exact test for picking against the real geometry of box `index`.
+ * Returns the distance along the ray, or a negative value on a miss.
+ */
+typedef float (*GLXTRayIntersect)(const GLXTRay* ray, uint32_t index, void* user_data);
+
+// Inner nodes have count == 0 and their children at first and first + 1,
+// leaves own boxes[first .. first + count)
+typedef struct GLXTBVHNode {
+    GLXTAABB bounds;
+    uint32_t first;
+    uint32_t count;
+} GLXTBVHNode;
+
+typedef struct GLXTBVH {
+    GLXTBVHNode* nodes;
+    size_t nodes_count;
+    size_t nodes_capacity;
+    // In leaf order, indices[i] is the caller's index of boxes[i]
+    GLXTAABB* boxes;
+    uint32_t* indices;
+    size_t count;
+    size_t capacity;
+    uint32_t depth;
+} GLXTBVH;
+
+void glxt_bvh_init(GLXTBVH* bvh);
+void glxt_bvh_deinit(GLXTBVH* bvh);
+// Rebuilds from scratch, storage is reused when the count does not grow
+bool glxt_bvh_build(GLXTBVH* bvh, const GLXTAABB* boxes, size_t count);
+// boxes holds the same count of boxes as the build, in the caller's order
+void glxt_bvh_refit(GLXTBVH* bvh, const GLXTAABB* boxes);
+
+GLXTFrustum glxt_frustum_from_matrix(mat4_t view_projection);
+bool glxt_frustum_test_aabb(const GLXTFrustum* frustum, const GLXTAABB* box);
+// Writes 1 or 0 per box to visible, returns how many boxes are visible
+size_t glxt_frustum_cull_aabbs(const GLXTFrustum* frustum, const GLXTAABB* boxes, size_t count, uint8_t* visible);
+/**
+ * Writes the caller's indices of the visible boxes, up to capacity of them,
+ * and returns how many are visible, which can be more than capacity.
+ */
+size_t glxt_bvh_cull(const GLXTBVH* bvh, const GLXTFrustum* frustum, uint32_t* visible, size_t capacity);
+
+// Cursor coordinates as GLFW reports them, pixels from the top left of the window
+GLXTRay glxt_ray_from_cursor(double x, double y, int width, int height, mat4_t inverse_view_projection);
+// Nearest hit within max_distance, intersect may be NULL to pick by box only
+bool glxt_bvh_raycast(const GLXTBVH* bvh, const GLXTRay* ray, float max_distance,
+    GLXTRayIntersect intersect, void* user_data, GLXTRayHit* hit);
+
+#if defined(GLFWE_H)
+// width and height are the window size, kept up to date by resize events
+typedef struct GLXTBVHPicker {
+    int width;
+    int height;
+    mat4_t inverse_view_projection;
+    int cursor_x;
+    int cursor_y;
+    bool cursor_outside;
+} GLXTBVHPicker;
+
+// Feed every polled event, true when it is a left click over the window that hits
+bool glxt_bvh_pick_event(const GLXTBVH* bvh, GLXTBVHPicker* picker, const GLFWEEvent* event,
+    GLXTRayIntersect intersect, void* user_data, GLXTRayHit* hit);
+#endif
+
+#endif // GLXT_BVH_H
+
+#if defined(GLXT_BVH_IMPLEMENTATION) && !defined(GLXT_BVH_IMPLEMENTATION_INCLUDED)
+#define GLXT_BVH_IMPLEMENTATION_INCLUDED
+
+static inline GLXTAABB _glxt_aabb_empty(void)
+{
+    GLXTAABB box = {
+        .min = vec3(LLAMA_INFINITY, LLAMA_INFINITY, LLAMA_INFINITY),
+        .max = vec3(-LLAMA_INFINITY, -LLAMA_INFINITY, -LLAMA_INFINITY),
+    };
+    return box;
+}
+
+static inline void _glxt_aabb_grow(GLXTAABB* box, const GLXTAABB* other)
+{
+    for(int axis = 0; axis < 3; ++axis) {
+        float low = other->min.elements[axis], high = other->max.elements[axis];
+        box->min.elements[axis] = low < box->min.elements[axis] ? low : box->min.elements[axis];
+        box->max.elements[axis] = high > box->max.elements[axis] ? high : box->max.elements[axis];
+    }
+}
+
+static inline void _glxt_aabb_grow_point(GLXTAABB* box, vec3_t point)
+{
+    for(int axis = 0; axis < 3; ++axis) {
+        float value = point.elements[axis];
+        box->min.elements[axis] = value < box->min.elements[axis] ? value : box->min.elements[axis];
+        box->max.elements[axis] = value > box->max.elements[axis] ? value : box->max.elements[axis];
+    }
+}
+
+static inline float _glxt_aabb_half_area(const GLXTAABB* box)
+{
+    float x = box->max.x - box->min.x, y = box->max.y - box->min.y, z = box->max.z - box->min.z;
+    if(x < 0.0f || y < 0.0f || z < 0.0f) return 0.0f;
+    return x * y + y * z + z * x;
+}
+
+static inline vec3_t _glxt_aabb_center(const GLXTAABB* box)
+{
+    return vec3((box->min.x + box->max.x) * 0.5f, (box->min.y + box->max.y) * 0.5f,
+        (box->min.z + box->max.z) * 0.5f);
+}
+
+void glxt_bvh_init(GLXTBVH* bvh)
+{
+    if(bvh == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+void glxt_bvh_deinit(GLXTBVH* bvh)
+{
+    if(bvh == NULL) return;
+    free(bvh->nodes);
+    free(bvh->boxes);
+    free(bvh->indices);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+typedef struct _GLXTBVHBin {
+    GLXTAABB bounds;
+    uint32_t count;
+} _GLXTBVHBin;
+
+/**
+ * Picks the cheapest split of boxes[first .. first + count), binning the
+ * box centers of all three axes in one pass. A side costs its box count
+ * times its half surface area, a split adds GLXT_BVH_TRAVERSAL_COST times
+ * the node's area for visiting it. Returns the cost, LLAMA_INFINITY when
+ * every center is in the same place.
+ */
+static float _glxt_bvh_find_split(const GLXTBVH* bvh, const vec3_t* centers, const GLXTBVHNode* node,
+    const GLXTAABB* center_bounds, int* split_axis, float* split_position)
+{
+    _GLXTBVHBin bins[3][GLXT_BVH_BINS];
+    float scale[3];
+    for(int axis = 0; axis < 3; ++axis) {
+        float extent = center_bounds->max.elements[axis] - center_bounds->min.elements[axis];
+        scale[axis] = extent > 0.0f ? GLXT_BVH_BINS / extent : 0.0f;
+        for(int b = 0; b < GLXT_BVH_BINS; ++b) {
+            bins[axis][b].bounds = _glxt_aabb_empty();
+            bins[axis][b].count = 0;
+        }
+    }
+    for(uint32_t i = node->first; i < node->first + node->count; ++i) {
+        for(int axis = 0; axis < 3; ++axis) {
+            int b = (int)((centers[i].elements[axis] - center_bounds->min.elements[axis]) * scale[axis]);
+            if(b > GLXT_BVH_BINS - 1) b = GLXT_BVH_BINS - 1;
+            bins[axis][b].count += 1;
+            _glxt_aabb_grow(&bins[axis][b].bounds, &bvh->boxes[i]);
+        }
+    }
+
+    float best_cost = LLAMA_INFINITY;
+    for(int axis = 0; axis < 3; ++axis) {
+        if(scale[axis] == 0.0f) continue;
+        // Sweep from both ends, split b puts bins [0, b] on the left
+        float left_area[GLXT_BVH_BINS - 1], right_area[GLXT_BVH_BINS - 1];
+        uint32_t left_count[GLXT_BVH_BINS - 1], right_count[GLXT_BVH_BINS - 1];
+        GLXTAABB left = _glxt_aabb_empty(), right = _glxt_aabb_empty();
+        uint32_t left_sum = 0, right_sum = 0;
+        for(int b = 0; b < GLXT_BVH_BINS - 1; ++b) {
+            left_sum += bins[axis][b].count;
+            _glxt_aabb_grow(&left, &bins[axis][b].bounds);
+            left_count[b] = left_sum;
+            left_area[b] = _glxt_aabb_half_area(&left);
+
+            right_sum += bins[axis][GLXT_BVH_BINS - 1 - b].count;
+            _glxt_aabb_grow(&right, &bins[axis][GLXT_BVH_BINS - 1 - b].bounds);
+            right_count[GLXT_BVH_BINS - 2 - b] = right_sum;
+            right_area[GLXT_BVH_BINS - 2 - b] = _glxt_aabb_half_area(&right);
+        }
+        for(int b = 0; b < GLXT_BVH_BINS - 1; ++b) {
+            if(left_count[b] == 0 || right_count[b] == 0) continue;
+            float cost = (float)left_count[b] * left_area[b] + (float)right_count[b] * right_area[b];
+            if(cost < best_cost) {
+                best_cost = cost;
+                *split_axis = axis;
+                *split_position = center_bounds->min.elements[axis] + (float)(b + 1) / scale[axis];
+            }
+        }
+    }
+    if(best_cost == LLAMA_INFINITY) return best_cost;
+    return best_cost + GLXT_BVH_TRAVERSAL_COST * _glxt_aabb_half_area(&node->bounds);
+}
+
+static bool _glxt_bvh_reserve(GLXTBVH* bvh, size_t count)
+{
+    // A binary tree with at least one box per leaf has at most 2n - 1 nodes
+    size_t nodes_capacity = count > 0 ? count * 2 - 1 : 1;
+    if(nodes_capacity > bvh->nodes_capacity) {
+        GLXTBVHNode* nodes = realloc(bvh->nodes, sizeof(GLXTBVHNode) * nodes_capacity);
+        if(nodes == NULL) return false;
+        bvh->nodes = nodes;
+        bvh->nodes_capacity = nodes_capacity;
+    }
+    if(count > bvh->capacity) {
+        GLXTAABB* boxes = realloc(bvh->boxes, sizeof(GLXTAABB) * count);
+        if(boxes == NULL) return false;
+        bvh->boxes = boxes;
+        uint32_t* indices = realloc(bvh->indices, sizeof(uint32_t) * count);
+        if(indices == NULL) return false;
+        bvh->indices = indices;
+        bvh->capacity = count;
+    }
+    return true;
+}
+
+bool glxt_bvh_build(GLXTBVH* bvh, const GLXTAABB* boxes, size_t count)
+{
+    if(bvh == NULL || (boxes == NULL && count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(count > UINT32_MAX / 2) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+    vec3_t* centers = malloc(sizeof(vec3_t) * (count > 0 ? count : 1));
+    if(centers == NULL || !_glxt_bvh_reserve(bvh, count)) {
+        free(centers);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    GLXTBVHNode* root = &bvh->nodes[0];
+    root->bounds = _glxt_aabb_empty();
+    root->first = 0;
+    root->count = (uint32_t)count;
+    for(size_t i = 0; i < count; ++i) {
+        bvh->boxes[i] = boxes[i];
+        bvh->indices[i] = (uint32_t)i;
+        centers[i] = _glxt_aabb_center(&boxes[i]);
+        _glxt_aabb_grow(&root->bounds, &boxes[i]);
+    }
+    bvh->count = count;
+    bvh->nodes_count = 1;
+    bvh->depth = 1;
+
+    // Each pending node carries the bounds of its box centers, the bins span them
+    struct { uint32_t node; uint32_t depth; GLXTAABB centers; } stack[GLXT_BVH_STACK_SIZE];
+    size_t stack_count = 0;
+    if(count > 0) {
+        stack[0].node = 0;
+        stack[0].depth = 1;
+        stack[0].centers = _glxt_aabb_empty();
+        for(size_t i = 0; i < count; ++i) _glxt_aabb_grow_point(&stack[0].centers, centers[i]);
+        stack_count = 1;
+    }
+    while(stack_count > 0) {
+        stack_count -= 1;
+        GLXTBVHNode* node = &bvh->nodes[stack[stack_count].node];
+        uint32_t depth = stack[stack_count].depth;
+        GLXTAABB center_bounds = stack[stack_count].centers;
+        if(depth > bvh->depth) bvh->depth = depth;
+        if(node->count <= 1) continue;
+        // Past the stack depth the node stays a leaf, whatever it holds
+        if(depth + 1 >= GLXT_BVH_STACK_SIZE) continue;
+
+        int axis = 0;
+        float position = 0.0f;
+        float split_cost = _glxt_bvh_find_split(bvh, centers, node, &center_bounds, &axis, &position);
+        float leaf_cost = (float)node->count * _glxt_aabb_half_area(&node->bounds);
+        if(node->count <= GLXT_BVH_MAXIMUM_LEAF_BOXES && split_cost >= leaf_cost) continue;
+
+        uint32_t first = node->first, last = node->first + node->count;
+        uint32_t middle = first;
+        if(split_cost < LLAMA_INFINITY) {
+            // Partition boxes, indices and centers in place
+            uint32_t end = last;
+            while(middle < end) {
+                if(centers[middle].elements[axis] < position) {
+                    middle += 1;
+                } else {
+                    end -= 1;
+                    GLXTAABB box = bvh->boxes[middle];
+                    bvh->boxes[middle] = bvh->boxes[end];
+                    bvh->boxes[end] = box;
+                    uint32_t index = bvh->indices[middle];
+                    bvh->indices[middle] = bvh->indices[end];
+                    bvh->indices[end] = index;
+                    vec3_t center = centers[middle];
+                    centers[middle] = centers[end];
+                    centers[end] = center;
+                }
+            }
+        }
+        // Too many boxes without a useful split, e.g. identical centers: halve them
+        if(middle == first || middle == last) middle = first + (last - first) / 2;
+
+        uint32_t left = (uint32_t)bvh->nodes_count;
+        bvh->nodes_count += 2;
+        GLXTBVHNode* children = &bvh->nodes[left];
+        children[0].first = first;
+        children[0].count = middle - first;
+        children[1].first = middle;
+        children[1].count = last - middle;
+        node->first = left;
+        node->count = 0;
+        for(int c = 0; c < 2; ++c) {
+            stack[stack_count].node = left + (uint32_t)c;
+            stack[stack_count].depth = depth + 1;
+            stack[stack_count].centers = _glxt_aabb_empty();
+            children[c].bounds = _glxt_aabb_empty();
+            for(uint32_t i = children[c].first; i < children[c].first + children[c].count; ++i) {
+                _glxt_aabb_grow(&children[c].bounds, &bvh->boxes[i]);
+                _glxt_aabb_grow_point(&stack[stack_count].centers, centers[i]);
+            }
+            stack_count += 1;
+        }
+    }
+
+    free(centers);
+    return true;
+}
+
+void glxt_bvh_refit(GLXTBVH* bvh, const GLXTAABB* boxes)
+{
+    if(bvh == NULL || (boxes == NULL && bvh->count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    if(bvh->count == 0) return;
+    for(size_t i = 0; i < bvh->count; ++i) bvh->boxes[i] = boxes[bvh->indices[i]];
+
+    // Children come after their parent, walking backwards visits them first
+    for(size_t n = bvh->nodes_count; n-- > 0;) {
+        GLXTBVHNode* node = &bvh->nodes[n];
+        if(node->count > 0) {
+            node->bounds = bvh->boxes[node->first];
+            for(uint32_t i = node->first + 1; i < node->first + node->count; ++i)
+                _glxt_aabb_grow(&node->bounds, &bvh->boxes[i]);
+        } else {
+            node->bounds = bvh->nodes[node->first].bounds;
+            _glxt_aabb_grow(&node->bounds, &bvh->nodes[node->first + 1].bounds);
+        }
+    }
+}
+
+// Gribb and Hartmann: each plane is the last row of the matrix plus or minus another row
+GLXTFrustum glxt_frustum_from_matrix(mat4_t view_projection)
+{
+    const float* m = view_projection.elements;
+    vec4_t rows[4];
+    for(int r = 0; r < 4; ++r) rows[r] = vec4(m[r], m[4 + r], m[8 + r], m[12 + r]);
+
+    GLXTFrustum frustum;
+    for(int p = 0; p < 6; ++p) {
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        const vec4_t* row = &rows[p / 2];
+        vec4_t plane = vec4(rows[3].x + sign * row->x, rows[3].y + sign * row->y,
+            rows[3].z + sign * row->z, rows[3].w + sign * row->w);
+        float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if(length > 0.0f) {
+            plane.x /= length;
+            plane.y /= length;
+            plane.z /= length;
+            plane.w /= length;
+        }
+        frustum.planes[p] = plane;
+    }
+    return frustum;
+}
+
+/**
+ * Center and extent form of the box against one plane: d is the signed
+ * distance of the center, r how far the box reaches along the normal.
+ * Outside when d + r < 0, fully inside when d - r >= 0.
+ */
+static inline void _glxt_plane_box(const vec4_t* plane, const GLXTAABB* box, float* d, float* r)
+{
+    float cx = (box->min.x + box->max.x) * 0.5f, ex = (box->max.x - box->min.x) * 0.5f;
+    float cy = (box->min.y + box->max.y) * 0.5f, ey = (box->max.y - box->min.y) * 0.5f;
+    float cz = (box->min.z + box->max.z) * 0.5f, ez = (box->max.z - box->min.z) * 0.5f;
+    *d = plane->x * cx + plane->y * cy + plane->z * cz + plane->w;
+    *r = fabsf(plane->x) * ex + fabsf(plane->y) * ey + fabsf(plane->z) * ez;
+}
+
+bool glxt_frustum_test_aabb(const GLXTFrustum* frustum, const GLXTAABB* box)
+{
+    for(int p = 0; p < 6; ++p) {
+        float d, r;
+        _glxt_plane_box(&frustum->planes[p], box, &d, &r);
+        if(d + r < 0.0f) return false;
+    }
+    return true;
+}
+
+// Branch free over the planes so the compiler can keep it in vector registers
+size_t glxt_frustum_cull_aabbs(const GLXTFrustum* frustum, const GLXTAABB* boxes, size_t count, uint8_t* visible)
+{
+    if(frustum == NULL || (count > 0 && (boxes == NULL || visible == NULL))) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    float nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+    for(int p = 0; p < 6; ++p) {
+        nx[p] = frustum->planes[p].x;
+        ny[p] = frustum->planes[p].y;
+        nz[p] = frustum->planes[p].z;
+        nw[p] = frustum->planes[p].w;
+        ax[p] = fabsf(nx[p]);
+        ay[p] = fabsf(ny[p]);
+        az[p] = fabsf(nz[p]);
+    }
+
+    size_t visible_count = 0;
+    for(size_t i = 0; i < count; ++i) {
+        const GLXTAABB* box = &boxes[i];
+        float cx = box->min.x + box->max.x, ex = box->max.x - box->min.x;
+        float cy = box->min.y + box->max.y, ey = box->max.y - box->min.y;
+        float cz = box->min.z + box->max.z, ez = box->max.z - box->min.z;
+        // Doubled center and extent, compared against the doubled distance
+        int inside = 1;
+        for(int p = 0; p < 6; ++p) {
+            float d = nx[p] * cx + ny[p] * cy + nz[p] * cz + 2.0f * nw[p];
+            float r = ax[p] * ex + ay[p] * ey + az[p] * ez;
+            inside &= d + r >= 0.0f;
+        }
+        visible[i] = (uint8_t)inside;
+        visible_count += (size_t)inside;
+    }
+    return visible_count;
+}
+
+/**
+ * Each node carries the mask of planes its parent still crosses. Planes a
+ * node is fully inside of are dropped for its subtree; once none are
+ * left, the whole subtree is visible and is emitted without tests.
+ */
+size_t glxt_bvh_cull(const GLXTBVH* bvh, const GLXTFrustum* frustum, uint32_t* visible, size_t capacity)
+{
+    if(bvh == NULL || frustum == NULL || (visible == NULL && capacity > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    if(bvh->count == 0) return 0;
+
+    struct { uint32_t node; uint32_t mask; } stack[GLXT_BVH_STACK_SIZE];
+    size_t stack_count = 0;
+    size_t visible_count = 0;
+    stack[stack_count].node = 0;
+    stack[stack_count++].mask = 0x3F;
+    while(stack_count > 0) {
+        stack_count -= 1;
+        const GLXTBVHNode* node = &bvh->nodes[stack[stack_count].node];
+        uint32_t mask = stack[stack_count].mask;
+
+        bool outside = false;
+        for(int p = 0; p < 6 && mask != 0; ++p) {
+            if(!(mask & (1u << p))) continue;
+            float d, r;
+            _glxt_plane_box(&frustum->planes[p], &node->bounds, &d, &r);
+            if(d + r < 0.0f) {
+                outside = true;
+                break;
+            }
+            if(d - r >= 0.0f) mask &= ~(1u << p);
+        }
+        if(outside) continue;
+
+        if(node->count > 0) {
+            for(uint32_t i = node->first; i < node->first + node->count; ++i) {
+                if(mask != 0 && node->count > 1) {
+                    bool box_visible = true;
+                    for(int p = 0; p < 6 && box_visible; ++p) {
+                        if(!(mask & (1u << p))) continue;
+                        float d, r;
+                        _glxt_plane_box(&frustum->planes[p], &bvh->boxes[i], &d, &r);
+                        box_visible = d + r >= 0.0f;
+                    }
+                    if(!box_visible) continue;
+                }
+                if(visible_count < capacity) visible[visible_count] = bvh->indices[i];
+                visible_count += 1;
+            }
+            continue;
+        }
+        stack[stack_count].node = node->first;
+        stack[stack_count++].mask = mask;
+        stack[stack_count].node = node->first + 1;
+        stack[stack_count++].mask = mask;
+    }
+    return visible_count;
+}
+
+GLXTRay glxt_ray_from_cursor(double x, double y, int width, int height, mat4_t inverse_view_projection)
+{
+    // GLFW puts the origin at the top left, normalized device coordinates at the bottom left
+    float ndc_x = width > 0 ? (float)(2.0 * x / width - 1.0) : 0.0f;
+    float ndc_y = height > 0 ? (float)(1.0 - 2.0 * y / height) : 0.0f;
+    const float* m = inverse_view_projection.elements;
+    vec3_t points[2];
+    for(int i = 0; i < 2; ++i) {
+        float z = i == 0 ? -1.0f : 1.0f;
+        float w = m[3] * ndc_x + m[7] * ndc_y + m[11] * z + m[15];
+        if(w == 0.0f) w = LLAMA_FLOAT_EPSILON;
+        points[i] = vec3((m[0] * ndc_x + m[4] * ndc_y + m[8] * z + m[12]) / w,
+            (m[1] * ndc_x + m[5] * ndc_y + m[9] * z + m[13]) / w,
+            (m[2] * ndc_x + m[6] * ndc_y + m[10] * z + m[14]) / w);
+    }
+
+    GLXTRay ray;
+    ray.origin = points[0];
+    ray.direction = vec3_normalized(vec3(points[1].x - points[0].x, points[1].y - points[0].y,
+        points[1].z - points[0].z));
+    return ray;
+}
+
+// Slab test, returns the entry distance or LLAMA_INFINITY on a miss
+static inline float _glxt_ray_box(vec3_t origin, vec3_t inverse_direction, const GLXTAABB* box, float max_distance)
+{
+    float near = 0.0f, far = max_distance;
+    for(int axis = 0; axis < 3; ++axis) {
+        float t0 = (box->min.elements[axis] - origin.elements[axis]) * inverse_direction.elements[axis];
+        float t1 = (box->max.elements[axis] - origin.elements[axis]) * inverse_direction.elements[axis];
+        if(t0 > t1) {
+            float t = t0;
+            t0 = t1;
+            t1 = t;
+        }
+        // Written so a NaN from 0 * infinity leaves the bound alone
+        near = t0 > near ? t0 : near;
+        far = t1 < far ? t1 : far;
+    }
+    return near <= far ? near : LLAMA_INFINITY;
+}
+
+bool glxt_bvh_raycast(const GLXTBVH* bvh, const GLXTRay* ray, float max_distance,
+    GLXTRayIntersect intersect, void* user_data, GLXTRayHit* hit)
+{
+    if(bvh == NULL || ray == NULL || hit == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(bvh->count == 0) return false;
+
+    vec3_t inverse_direction = vec3(1.0f / ray->direction.x, 1.0f / ray->direction.y, 1.0f / ray->direction.z);
+    float nearest = max_distance;
+    bool found = false;
+
+    uint32_t stack[GLXT_BVH_STACK_SIZE];
+    size_t stack_count = 0;
+    if(_glxt_ray_box(ray->origin, inverse_direction, &bvh->nodes[0].bounds, nearest) < LLAMA_INFINITY)
+        stack[stack_count++] = 0;
+    while(stack_count > 0) {
+        const GLXTBVHNode* node = &bvh->nodes[stack[--stack_count]];
+        if(node->count > 0) {
+            for(uint32_t i = node->first; i < node->first + node->count; ++i) {
+                float distance = _glxt_ray_box(ray->origin, inverse_direction, &bvh->boxes[i], nearest);
+                if(distance == LLAMA_INFINITY) continue;
+                if(intersect != NULL) {
+                    distance = intersect(ray, bvh->indices[i], user_data);
+                    if(distance < 0.0f || distance > nearest) continue;
+                }
+                nearest = distance;
+                hit->index = bvh->indices[i];
+                hit->distance = distance;
+                found = true;
+            }
+            continue;
+        }
+
+        // Nearest child on top of the stack, it is likely to shrink nearest for the other one
+        float distances[2];
+        for(int c = 0; c < 2; ++c)
+            distances[c] = _glxt_ray_box(ray->origin, inverse_direction, &bvh->nodes[node->first + c].bounds, nearest);
+        int close = distances[1] < distances[0] ? 1 : 0;
+        if(distances[1 - close] < LLAMA_INFINITY) stack[stack_count++] = node->first + 1 - close;
+        if(distances[close] < LLAMA_INFINITY) stack[stack_count++] = node->first + close;
+    }
+    return found;
+}
+
+#if defined(GLFWE_H)
+bool glxt_bvh_pick_event(const GLXTBVH* bvh, GLXTBVHPicker* picker, const GLFWEEvent* event,
+    GLXTRayIntersect intersect, void* user_data, GLXTRayHit* hit)
+{
+    if(picker == NULL || event == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    switch(event->type) {
+    case GLFWE_EVENT_CURSOR_MOVED:
+        picker->cursor_x = event->mouse.x;
+        picker->cursor_y = event->mouse.y;
+        picker->cursor_outside = false;
+        return false;
+    case GLFWE_EVENT_CURSOR_ENTER_WINDOW:
+        picker->cursor_outside = false;
+        return false;
+    case GLFWE_EVENT_CURSOR_LEAVE_WINDOW:
+        picker->cursor_outside = true;
+        return false;
+    case GLFWE_EVENT_WINDOW_RESIZED:
+        picker->width = event->window.w;
+        picker->height = event->window.h;
+        return false;
+    case GLFWE_EVENT_MOUSE_KEY_LEFT_DOWN:
+        break;
+    default:
+        return false;
+    }
+
+    if(picker->cursor_outside || picker->width <= 0 || picker->height <= 0) return false;
+    // glfwe truncates the cursor to whole pixels, cast through the pixel center
+    GLXTRay ray = glxt_ray_from_cursor((double)picker->cursor_x + 0.5, (double)picker->cursor_y + 0.5,
+        picker->width, picker->height, picker->inverse_view_projection);
+    return glxt_bvh_raycast(bvh, &ray, LLAMA_INFINITY, intersect, user_data, hit);
+}
+#endif
+
+#endif // GLXT_BVH_IMPLEMENTATION
@@ -0,0 +1,376 @@
+/**
+ * glxt_capture works like glxt: define GLXT_CAPTURE_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Frame capture.
+ * Records rendered frames to a file without stalling the pipeline.
+ * glxt_capture_frame queues an asynchronous readback of the bound
+ * framebuffer (a glxt readback stream) and hands every frame that has
+ * arrived to a writer thread, which converts and writes it out, so the GL
+ * thread only pays for a copy out of the mapped pixel buffer. Call it
+ * after rendering and before swapping when capturing the default
+ * framebuffer. Works the same on a headless null platform/OSMesa context.
+ *
+ * Formats:
+ *   GLXT_CAPTURE_RAW  tightly packed top-down RGBA8 frames, e.g.
+ *                     ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r FPS -i file
+ *   GLXT_CAPTURE_Y4M  YUV4MPEG2 stream, 4:2:0 BT.601 limited range, which
+ *                     most video tools read directly
+ *
+ * When the writer falls behind, glxt_capture_frame waits for it (a writer
+ * stall) unless drop_when_busy is set, then the frame is dropped instead.
+ * The glxt_capture_* functions must be called from the GL thread.
+ */
+#ifndef GLXT_CAPTURE_H
+#define GLXT_CAPTURE_H
+
+#include "glxt.h"
+
+#ifndef GLXT_CAPTURE_DEFAULT_QUEUE
+    #define GLXT_CAPTURE_DEFAULT_QUEUE 8
+#endif
+
+typedef enum GLXTCaptureFormat {
+    GLXT_CAPTURE_RAW = 0,
+    GLXT_CAPTURE_Y4M,
+} GLXTCaptureFormat;
+
+typedef struct GLXTCaptureDesc {
+    const char* path;
+    GLXTCaptureFormat format;
+    uint32_t width, height;
+    // Frame rate of the Y4M header, 0 means 60
+    uint32_t fps;
+    // Frames buffered for the writer, 0 means GLXT_CAPTURE_DEFAULT_QUEUE
+    size_t queue_frames;
+    bool drop_when_busy;
+} GLXTCaptureDesc;
+
+typedef struct GLXTCaptureStats {
+    size_t frames_captured;
+    size_t frames_written;
+    size_t frames_dropped;
+    size_t readback_stalls;
+    size_t writer_stalls;
+    size_t bytes_written;
+    bool write_failed;
+} GLXTCaptureStats;
+
+bool glxt_capture_begin(const GLXTCaptureDesc* desc);
+void glxt_capture_frame(void);
+// Writes out every pending frame, then closes the file
+void glxt_capture_end(void);
+bool glxt_capture_active(void);
+GLXTCaptureStats glxt_capture_stats(void);
+
+#endif // GLXT_CAPTURE_H
+
+#if defined(GLXT_CAPTURE_IMPLEMENTATION) && !defined(GLXT_CAPTURE_IMPLEMENTATION_INCLUDED)
+#define GLXT_CAPTURE_IMPLEMENTATION_INCLUDED
+
+#include "glxt_thread.h"
+
+static struct {
+    bool active;
+    GLXTCaptureFormat format;
+    uint32_t width, height;
+    bool drop_when_busy;
+    GLXTReadbackStream readback;
+    FILE* file;
+    _GLXTThread writer;
+
+    // GL thread -> writer, a ring of frame buffers. The GL thread fills the
+    // slot after the last queued one, the writer owns the queued ones.
+    _GLXTMutex mutex;
+    _GLXTCondition queued;
+    _GLXTCondition released;
+    uint8_t** frames;
+    size_t frames_capacity;
+    size_t frames_head;
+    size_t frames_count;
+    bool quit;
+
+    // Only touched by the writer thread
+    uint8_t* converted;
+
+    GLXTCaptureStats stats;
+} GLXT_CAPTURE = {0};
+
+static size_t _glxt_capture_frame_size(void)
+{
+    return (size_t)GLXT_CAPTURE.width * GLXT_CAPTURE.height * 4;
+}
+
+static size_t _glxt_capture_y4m_size(void)
+{
+    size_t chroma_width = (GLXT_CAPTURE.width + 1) / 2, chroma_height = (GLXT_CAPTURE.height + 1) / 2;
+    return (size_t)GLXT_CAPTURE.width * GLXT_CAPTURE.height + chroma_width * chroma_height * 2;
+}
+
+// Bottom-up RGBA8 to top-down 4:2:0 planes, each chroma sample averages a 2x2 block
+static void _glxt_capture_convert_y4m(const uint8_t* rgba, uint8_t* yuv)
+{
+    uint32_t width = GLXT_CAPTURE.width, height = GLXT_CAPTURE.height;
+    uint32_t chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    uint8_t* plane_y = yuv;
+    uint8_t* plane_u = yuv + (size_t)width * height;
+    uint8_t* plane_v = plane_u + (size_t)chroma_width * chroma_height;
+
+    for(uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = rgba + (size_t)(height - 1 - y) * width * 4;
+        uint8_t* out = plane_y + (size_t)y * width;
+        for(uint32_t x = 0; x < width; ++x) {
+            int r = row[x * 4 + 0], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            out[x] = (uint8_t)(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+        }
+    }
+
+    for(uint32_t cy = 0; cy < chroma_height; ++cy) {
+        uint32_t y0 = cy * 2, y1 = y0 + 1 < height ? y0 + 1 : y0;
+        const uint8_t* row0 = rgba + (size_t)(height - 1 - y0) * width * 4;
+        const uint8_t* row1 = rgba + (size_t)(height - 1 - y1) * width * 4;
+        for(uint32_t cx = 0; cx < chroma_width; ++cx) {
+            uint32_t x0 = cx * 2, x1 = x0 + 1 < width ? x0 + 1 : x0;
+            int r = row0[x0 * 4 + 0] + row0[x1 * 4 + 0] + row1[x0 * 4 + 0] + row1[x1 * 4 + 0];
+            int g = row0[x0 * 4 + 1] + row0[x1 * 4 + 1] + row1[x0 * 4 + 1] + row1[x1 * 4 + 1];
+            int b = row0[x0 * 4 + 2] + row0[x1 * 4 + 2] + row1[x0 * 4 + 2] + row1[x1 * 4 + 2];
+            // Sums of four samples, the extra factor of 4 goes into the shift
+            size_t index = (size_t)cy * chroma_width + cx;
+            plane_u[index] = (uint8_t)(128 + ((-38 * r - 74 * g + 112 * b + 512) >> 10));
+            plane_v[index] = (uint8_t)(128 + ((112 * r - 94 * g - 18 * b + 512) >> 10));
+        }
+    }
+}
+
+static size_t _glxt_capture_write(const uint8_t* rgba)
+{
+    FILE* file = GLXT_CAPTURE.file;
+    if(GLXT_CAPTURE.format == GLXT_CAPTURE_Y4M) {
+        size_t size = _glxt_capture_y4m_size();
+        _glxt_capture_convert_y4m(rgba, GLXT_CAPTURE.converted);
+        if(fwrite("FRAME\n", 1, 6, file) != 6 || fwrite(GLXT_CAPTURE.converted, 1, size, file) != size) return 0;
+        return size + 6;
+    }
+
+    size_t row_size = (size_t)GLXT_CAPTURE.width * 4;
+    for(uint32_t y = GLXT_CAPTURE.height; y-- > 0;) {
+        if(fwrite(rgba + y * row_size, 1, row_size, file) != row_size) return 0;
+    }
+    return row_size * GLXT_CAPTURE.height;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _glxt_capture_writer(LPVOID arg)
+#else
+static void* _glxt_capture_writer(void* arg)
+#endif
+{
+    (void)arg;
+    for(;;) {
+        _glxt_mutex_lock(&GLXT_CAPTURE.mutex);
+        while(GLXT_CAPTURE.frames_count == 0 && !GLXT_CAPTURE.quit)
+            _glxt_condition_wait(&GLXT_CAPTURE.queued, &GLXT_CAPTURE.mutex);
+        // Quitting only once the queue is empty, so every captured frame gets written
+        if(GLXT_CAPTURE.frames_count == 0) {
+            _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+            break;
+        }
+        const uint8_t* frame = GLXT_CAPTURE.frames[GLXT_CAPTURE.frames_head];
+        bool failed = GLXT_CAPTURE.stats.write_failed;
+        _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+
+        size_t written = failed ? 0 : _glxt_capture_write(frame);
+
+        _glxt_mutex_lock(&GLXT_CAPTURE.mutex);
+        if(written == 0) {
+            GLXT_CAPTURE.stats.write_failed = true;
+            GLXT_CAPTURE.stats.frames_dropped += 1;
+        } else {
+            GLXT_CAPTURE.stats.frames_written += 1;
+            GLXT_CAPTURE.stats.bytes_written += written;
+        }
+        GLXT_CAPTURE.frames_head = (GLXT_CAPTURE.frames_head + 1) % GLXT_CAPTURE.frames_capacity;
+        GLXT_CAPTURE.frames_count -= 1;
+        _glxt_condition_signal(&GLXT_CAPTURE.released);
+        _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+    }
+    return 0;
+}
+
+static void _glxt_capture_push(const void* pixels)
+{
+    _glxt_mutex_lock(&GLXT_CAPTURE.mutex);
+    if(GLXT_CAPTURE.frames_count == GLXT_CAPTURE.frames_capacity) {
+        if(GLXT_CAPTURE.drop_when_busy) {
+            GLXT_CAPTURE.stats.frames_dropped += 1;
+            _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+            return;
+        }
+        GLXT_CAPTURE.stats.writer_stalls += 1;
+        while(GLXT_CAPTURE.frames_count == GLXT_CAPTURE.frames_capacity)
+            _glxt_condition_wait(&GLXT_CAPTURE.released, &GLXT_CAPTURE.mutex);
+    }
+    size_t slot = (GLXT_CAPTURE.frames_head + GLXT_CAPTURE.frames_count) % GLXT_CAPTURE.frames_capacity;
+    _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+
+    // The slot is not visible to the writer until it is counted
+    memcpy(GLXT_CAPTURE.frames[slot], pixels, _glxt_capture_frame_size());
+
+    _glxt_mutex_lock(&GLXT_CAPTURE.mutex);
+    GLXT_CAPTURE.frames_count += 1;
+    _glxt_condition_signal(&GLXT_CAPTURE.queued);
+    _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+}
+
+static bool _glxt_capture_take(bool wait)
+{
+    const void* pixels = glxt_begin_readback(&GLXT_CAPTURE.readback, wait, NULL);
+    if(pixels == NULL) return false;
+    _glxt_capture_push(pixels);
+    glxt_end_readback(&GLXT_CAPTURE.readback);
+    return true;
+}
+
+static void _glxt_capture_release(void)
+{
+    if(GLXT_CAPTURE.frames != NULL) {
+        for(size_t i = 0; i < GLXT_CAPTURE.frames_capacity; ++i) free(GLXT_CAPTURE.frames[i]);
+        free(GLXT_CAPTURE.frames);
+    }
+    free(GLXT_CAPTURE.converted);
+    if(GLXT_CAPTURE.file != NULL) fclose(GLXT_CAPTURE.file);
+    glxt_destroy_readback_stream(&GLXT_CAPTURE.readback);
+    GLXT_CAPTURE.frames = NULL;
+    GLXT_CAPTURE.converted = NULL;
+    GLXT_CAPTURE.file = NULL;
+}
+
+bool glxt_capture_begin(const GLXTCaptureDesc* desc)
+{
+    if(desc == NULL || desc->path == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(GLXT_CAPTURE.active) glxt_capture_end();
+    memset(&GLXT_CAPTURE, 0, sizeof(GLXT_CAPTURE));
+    if(desc->width == 0 || desc->height == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+
+    GLXT_CAPTURE.format = desc->format;
+    GLXT_CAPTURE.width = desc->width;
+    GLXT_CAPTURE.height = desc->height;
+    GLXT_CAPTURE.drop_when_busy = desc->drop_when_busy;
+    GLXT_CAPTURE.frames_capacity = desc->queue_frames != 0 ? desc->queue_frames : GLXT_CAPTURE_DEFAULT_QUEUE;
+
+    if(!glxt_create_readback_stream(&GLXT_CAPTURE.readback, desc->width, desc->height, GL_RGBA, GL_UNSIGNED_BYTE))
+        return false;
+
+    GLXT_CAPTURE.frames = calloc(GLXT_CAPTURE.frames_capacity, sizeof(uint8_t*));
+    bool allocated = GLXT_CAPTURE.frames != NULL;
+    for(size_t i = 0; allocated && i < GLXT_CAPTURE.frames_capacity; ++i) {
+        GLXT_CAPTURE.frames[i] = malloc(_glxt_capture_frame_size());
+        allocated = GLXT_CAPTURE.frames[i] != NULL;
+    }
+    if(allocated && desc->format == GLXT_CAPTURE_Y4M) {
+        GLXT_CAPTURE.converted = malloc(_glxt_capture_y4m_size());
+        allocated = GLXT_CAPTURE.converted != NULL;
+    }
+    if(!allocated) {
+        _glxt_capture_release();
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    GLXT_CAPTURE.file = fopen(desc->path, "wb");
+    if(GLXT_CAPTURE.file == NULL) {
+        _glxt_capture_release();
+        GLXT.last_failure = GLXT_FAILED_TO_WRITE_FILE;
+        return false;
+    }
+    if(desc->format == GLXT_CAPTURE_Y4M) {
+        // C420jpeg: chroma sited between the luma samples, as the 2x2 averages are
+        fprintf(GLXT_CAPTURE.file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n",
+            desc->width, desc->height, desc->fps != 0 ? desc->fps : 60);
+    }
+
+    _glxt_mutex_init(&GLXT_CAPTURE.mutex);
+    _glxt_condition_init(&GLXT_CAPTURE.queued);
+    _glxt_condition_init(&GLXT_CAPTURE.released);
+#if defined(_WIN32)
+    GLXT_CAPTURE.writer = CreateThread(NULL, 0, _glxt_capture_writer, NULL, 0, NULL);
+    bool created = GLXT_CAPTURE.writer != NULL;
+#else
+    bool created = pthread_create(&GLXT_CAPTURE.writer, NULL, _glxt_capture_writer, NULL) == 0;
+#endif
+    if(!created) {
+        _glxt_condition_destroy(&GLXT_CAPTURE.released);
+        _glxt_condition_destroy(&GLXT_CAPTURE.queued);
+        _glxt_mutex_destroy(&GLXT_CAPTURE.mutex);
+        _glxt_capture_release();
+        GLXT.last_failure = GLXT_CAPTURE_THREAD_FAILURE;
+        return false;
+    }
+
+    GLXT_CAPTURE.active = true;
+    return true;
+}
+
+void glxt_capture_frame(void)
+{
+    if(!GLXT_CAPTURE.active) return;
+
+    // Hand over whatever has arrived, only waiting when every buffer is taken
+    while(_glxt_capture_take(false));
+    if(GLXT_CAPTURE.readback.pending == GLXT_READBACK_STREAM_BUFFERS) _glxt_capture_take(true);
+
+    if(glxt_queue_readback(&GLXT_CAPTURE.readback, 0, 0)) GLXT_CAPTURE.stats.frames_captured += 1;
+}
+
+void glxt_capture_end(void)
+{
+    if(!GLXT_CAPTURE.active) return;
+
+    while(GLXT_CAPTURE.readback.pending > 0 && _glxt_capture_take(true));
+
+    _glxt_mutex_lock(&GLXT_CAPTURE.mutex);
+    GLXT_CAPTURE.quit = true;
+    _glxt_condition_signal(&GLXT_CAPTURE.queued);
+    _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+#if defined(_WIN32)
+    WaitForSingleObject(GLXT_CAPTURE.writer, INFINITE);
+    CloseHandle(GLXT_CAPTURE.writer);
+#else
+    pthread_join(GLXT_CAPTURE.writer, NULL);
+#endif
+
+    GLXT_CAPTURE.stats.readback_stalls = GLXT_CAPTURE.readback.stalls;
+    _glxt_condition_destroy(&GLXT_CAPTURE.released);
+    _glxt_condition_destroy(&GLXT_CAPTURE.queued);
+    _glxt_mutex_destroy(&GLXT_CAPTURE.mutex);
+    if(GLXT_CAPTURE.file != NULL && fclose(GLXT_CAPTURE.file) != 0) GLXT_CAPTURE.stats.write_failed = true;
+    GLXT_CAPTURE.file = NULL;
+    _glxt_capture_release();
+    GLXT_CAPTURE.active = false;
+
+    if(GLXT_CAPTURE.stats.write_failed) GLXT.last_failure = GLXT_FAILED_TO_WRITE_FILE;
+}
+
+bool glxt_capture_active(void)
+{
+    return GLXT_CAPTURE.active;
+}
+
+GLXTCaptureStats glxt_capture_stats(void)
+{
+    if(!GLXT_CAPTURE.active) return GLXT_CAPTURE.stats;
+
+    _glxt_mutex_lock(&GLXT_CAPTURE.mutex);
+    GLXTCaptureStats stats = GLXT_CAPTURE.stats;
+    _glxt_mutex_unlock(&GLXT_CAPTURE.mutex);
+    stats.readback_stalls = GLXT_CAPTURE.readback.stalls;
+    return stats;
+}
+
+#endif // GLXT_CAPTURE_IMPLEMENTATION
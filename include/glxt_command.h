@@ -0,0 +1,354 @@
+/**
+ * glxt_command works like glxt: define GLXT_COMMAND_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Command lists.
+ * A command list is a growable arena of compact POD commands (bind
+ * program, set uniform, bind buffers and textures, update buffers, draw).
+ * Recording never touches GL or glxt state, so any thread can record into
+ * its own list, e.g. one list per worker building draws for its share of
+ * the scene. glxt_submit_command_lists then replays the lists on the GL
+ * thread, in array order and each list in recording order, through the
+ * glxt state shadow so redundant binds are still elided.
+ *
+ * A list must only be recorded by one thread at a time and must not be
+ * recorded while it is being submitted. Recording functions return false
+ * when the arena could not grow or an argument was NULL; such a list is
+ * marked failed and skipped on submit.
+ */
+#ifndef GLXT_COMMAND_H
+#define GLXT_COMMAND_H
+
+#include "glxt.h"
+
+#ifndef GLXT_COMMAND_LIST_INITIAL_CAPACITY
+    #define GLXT_COMMAND_LIST_INITIAL_CAPACITY 4096
+#endif
+
+typedef struct GLXTCommandList {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    size_t commands_count;
+    bool failed;
+} GLXTCommandList;
+
+typedef struct GLXTCommandStats {
+    size_t lists_submitted;
+    size_t lists_skipped;
+    size_t commands_replayed;
+} GLXTCommandStats;
+
+void glxt_command_list_init(GLXTCommandList* list);
+void glxt_command_list_deinit(GLXTCommandList* list);
+void glxt_command_list_reset(GLXTCommandList* list);
+
+bool glxt_command_use_program(GLXTCommandList* list, uint32_t shader_program);
+/**
+ * size is the number of bytes read from data, count the number of array
+ * elements as for glxt_set_uniform. The list fails when size is smaller
+ * than count elements of the uniform's type, replay would read past data.
+ */
+bool glxt_command_set_uniform(GLXTCommandList* list, GLXTUniform uniform, const void* data, int count, size_t size);
+bool glxt_command_bind_vertex_array(GLXTCommandList* list, uint32_t vao);
+bool glxt_command_bind_buffer(GLXTCommandList* list, uint32_t target, uint32_t buffer);
+bool glxt_command_bind_texture2d(GLXTCommandList* list, uint32_t unit, uint32_t texture);
+bool glxt_command_update_buffer(GLXTCommandList* list, uint32_t target, uint32_t buffer,
+    size_t offset, size_t size, const void* data);
+bool glxt_command_draw_arrays(GLXTCommandList* list, uint32_t mode, int first, int count);
+bool glxt_command_draw_elements(GLXTCommandList* list, uint32_t mode, int count, uint32_t type, size_t offset);
+bool glxt_command_draw_arrays_instanced(GLXTCommandList* list, uint32_t mode, int first, int count,
+    int instances_count);
+bool glxt_command_draw_elements_instanced(GLXTCommandList* list, uint32_t mode, int count, uint32_t type,
+    size_t offset, int instances_count);
+
+void glxt_submit_command_lists(const GLXTCommandList* lists, size_t lists_count);
+GLXTCommandStats glxt_command_stats(void);
+
+#endif // GLXT_COMMAND_H
+
+#if defined(GLXT_COMMAND_IMPLEMENTATION) && !defined(GLXT_COMMAND_IMPLEMENTATION_INCLUDED)
+#define GLXT_COMMAND_IMPLEMENTATION_INCLUDED
+
+enum {
+    _GLXT_COMMAND_USE_PROGRAM = 1,
+    _GLXT_COMMAND_SET_UNIFORM,
+    _GLXT_COMMAND_BIND_VERTEX_ARRAY,
+    _GLXT_COMMAND_BIND_BUFFER,
+    _GLXT_COMMAND_BIND_TEXTURE2D,
+    _GLXT_COMMAND_UPDATE_BUFFER,
+    _GLXT_COMMAND_DRAW_ARRAYS,
+    _GLXT_COMMAND_DRAW_ELEMENTS,
+};
+
+// Every command starts with this header, size covers the header, the
+// command and its inline payload, rounded up to keep 8 byte alignment
+typedef struct _GLXTCommandHeader {
+    uint32_t type;
+    uint32_t size;
+} _GLXTCommandHeader;
+
+typedef struct _GLXTCommandBind {
+    uint32_t target;
+    uint32_t object;
+} _GLXTCommandBind;
+
+typedef struct _GLXTCommandSetUniform {
+    GLXTUniform uniform;
+    int count;
+} _GLXTCommandSetUniform;
+
+typedef struct _GLXTCommandUpdateBuffer {
+    uint32_t target;
+    uint32_t buffer;
+    uint64_t offset;
+    uint64_t size;
+} _GLXTCommandUpdateBuffer;
+
+typedef struct _GLXTCommandDraw {
+    uint32_t mode;
+    uint32_t type;
+    int first;
+    int count;
+    int instances_count;
+    uint64_t offset;
+} _GLXTCommandDraw;
+
+static struct {
+    GLXTCommandStats stats;
+} GLXT_COMMAND = {0};
+
+void glxt_command_list_init(GLXTCommandList* list)
+{
+    memset(list, 0, sizeof(*list));
+}
+
+void glxt_command_list_deinit(GLXTCommandList* list)
+{
+    free(list->data);
+    memset(list, 0, sizeof(*list));
+}
+
+void glxt_command_list_reset(GLXTCommandList* list)
+{
+    list->size = 0;
+    list->commands_count = 0;
+    list->failed = false;
+}
+
+static void* _glxt_command_push(GLXTCommandList* list, uint32_t type, size_t command_size, size_t payload_size)
+{
+    size_t size = (sizeof(_GLXTCommandHeader) + command_size + payload_size + 7) & ~(size_t)7;
+    if(list->failed || size > UINT32_MAX) {
+        list->failed = true;
+        return NULL;
+    }
+
+    if(list->size + size > list->capacity) {
+        size_t capacity = list->capacity == 0 ? GLXT_COMMAND_LIST_INITIAL_CAPACITY : list->capacity;
+        while(capacity < list->size + size) capacity *= 2;
+        uint8_t* data = realloc(list->data, capacity);
+        if(data == NULL) {
+            list->failed = true;
+            return NULL;
+        }
+        list->data = data;
+        list->capacity = capacity;
+    }
+
+    _GLXTCommandHeader* header = (_GLXTCommandHeader*)(list->data + list->size);
+    header->type = type;
+    header->size = (uint32_t)size;
+    list->size += size;
+    list->commands_count += 1;
+    return header + 1;
+}
+
+static bool _glxt_command_bind(GLXTCommandList* list, uint32_t type, uint32_t target, uint32_t object)
+{
+    _GLXTCommandBind* command = _glxt_command_push(list, type, sizeof(*command), 0);
+    if(command == NULL) return false;
+    command->target = target;
+    command->object = object;
+    return true;
+}
+
+bool glxt_command_use_program(GLXTCommandList* list, uint32_t shader_program)
+{
+    return _glxt_command_bind(list, _GLXT_COMMAND_USE_PROGRAM, 0, shader_program);
+}
+
+bool glxt_command_set_uniform(GLXTCommandList* list, GLXTUniform uniform, const void* data, int count, size_t size)
+{
+    if(data == NULL) {
+        list->failed = true;
+        return false;
+    }
+    size_t needed = 0;
+    if(!_glxt_uniform_data_size(uniform, count, &needed)) {
+        GLXT.last_failure = GLXT_INVALID_UNIFORM_HANDLE;
+        list->failed = true;
+        return false;
+    }
+    if(size < needed) {
+        GLXT.last_failure = GLXT_UNIFORM_DATA_TOO_SMALL;
+        list->failed = true;
+        return false;
+    }
+    _GLXTCommandSetUniform* command = _glxt_command_push(list, _GLXT_COMMAND_SET_UNIFORM, sizeof(*command), size);
+    if(command == NULL) return false;
+    command->uniform = uniform;
+    command->count = count;
+    memcpy(command + 1, data, size);
+    return true;
+}
+
+bool glxt_command_bind_vertex_array(GLXTCommandList* list, uint32_t vao)
+{
+    return _glxt_command_bind(list, _GLXT_COMMAND_BIND_VERTEX_ARRAY, 0, vao);
+}
+
+bool glxt_command_bind_buffer(GLXTCommandList* list, uint32_t target, uint32_t buffer)
+{
+    return _glxt_command_bind(list, _GLXT_COMMAND_BIND_BUFFER, target, buffer);
+}
+
+bool glxt_command_bind_texture2d(GLXTCommandList* list, uint32_t unit, uint32_t texture)
+{
+    return _glxt_command_bind(list, _GLXT_COMMAND_BIND_TEXTURE2D, unit, texture);
+}
+
+bool glxt_command_update_buffer(GLXTCommandList* list, uint32_t target, uint32_t buffer,
+    size_t offset, size_t size, const void* data)
+{
+    if(data == NULL) {
+        list->failed = true;
+        return false;
+    }
+    _GLXTCommandUpdateBuffer* command = _glxt_command_push(list, _GLXT_COMMAND_UPDATE_BUFFER, sizeof(*command), size);
+    if(command == NULL) return false;
+    command->target = target;
+    command->buffer = buffer;
+    command->offset = offset;
+    command->size = size;
+    memcpy(command + 1, data, size);
+    return true;
+}
+
+bool glxt_command_draw_arrays(GLXTCommandList* list, uint32_t mode, int first, int count)
+{
+    return glxt_command_draw_arrays_instanced(list, mode, first, count, 0);
+}
+
+bool glxt_command_draw_elements(GLXTCommandList* list, uint32_t mode, int count, uint32_t type, size_t offset)
+{
+    return glxt_command_draw_elements_instanced(list, mode, count, type, offset, 0);
+}
+
+// An instances_count of 0 records a plain, non instanced draw
+bool glxt_command_draw_arrays_instanced(GLXTCommandList* list, uint32_t mode, int first, int count,
+    int instances_count)
+{
+    _GLXTCommandDraw* command = _glxt_command_push(list, _GLXT_COMMAND_DRAW_ARRAYS, sizeof(*command), 0);
+    if(command == NULL) return false;
+    memset(command, 0, sizeof(*command));
+    command->mode = mode;
+    command->first = first;
+    command->count = count;
+    command->instances_count = instances_count;
+    return true;
+}
+
+bool glxt_command_draw_elements_instanced(GLXTCommandList* list, uint32_t mode, int count, uint32_t type,
+    size_t offset, int instances_count)
+{
+    _GLXTCommandDraw* command = _glxt_command_push(list, _GLXT_COMMAND_DRAW_ELEMENTS, sizeof(*command), 0);
+    if(command == NULL) return false;
+    memset(command, 0, sizeof(*command));
+    command->mode = mode;
+    command->type = type;
+    command->count = count;
+    command->offset = offset;
+    command->instances_count = instances_count;
+    return true;
+}
+
+static void _glxt_command_replay(const GLXTCommandList* list)
+{
+    const uint8_t* cursor = list->data;
+    const uint8_t* end = list->data + list->size;
+    while(cursor < end) {
+        const _GLXTCommandHeader* header = (const _GLXTCommandHeader*)cursor;
+        const void* command = header + 1;
+        switch(header->type) {
+            case _GLXT_COMMAND_USE_PROGRAM: {
+                glxt_enable_shader_program(((const _GLXTCommandBind*)command)->object);
+            } break;
+            case _GLXT_COMMAND_SET_UNIFORM: {
+                const _GLXTCommandSetUniform* set = command;
+                glxt_set_uniform(set->uniform, set + 1, set->count);
+            } break;
+            case _GLXT_COMMAND_BIND_VERTEX_ARRAY: {
+                glxt_enable_vertex_array(((const _GLXTCommandBind*)command)->object);
+            } break;
+            case _GLXT_COMMAND_BIND_BUFFER: {
+                const _GLXTCommandBind* bind = command;
+                glxt_bind_buffer(bind->target, bind->object);
+            } break;
+            case _GLXT_COMMAND_BIND_TEXTURE2D: {
+                const _GLXTCommandBind* bind = command;
+                glxt_bind_texture2d(bind->target, bind->object);
+            } break;
+            case _GLXT_COMMAND_UPDATE_BUFFER: {
+                const _GLXTCommandUpdateBuffer* update = command;
+                glxt_bind_buffer(update->target, update->buffer);
+                glBufferSubData(update->target, (GLintptr)update->offset, (GLsizeiptr)update->size, update + 1);
+                _GLXT_COUNT(bytes_uploaded, update->size);
+            } break;
+            case _GLXT_COMMAND_DRAW_ARRAYS: {
+                const _GLXTCommandDraw* draw = command;
+                if(draw->instances_count > 0)
+                    glxt_draw_arrays_instanced(draw->mode, draw->first, draw->count, draw->instances_count);
+                else
+                    glxt_draw_arrays(draw->mode, draw->first, draw->count);
+            } break;
+            case _GLXT_COMMAND_DRAW_ELEMENTS: {
+                const _GLXTCommandDraw* draw = command;
+                if(draw->instances_count > 0)
+                    glxt_draw_elements_instanced(draw->mode, draw->count, draw->type, draw->offset,
+                        draw->instances_count);
+                else
+                    glxt_draw_elements(draw->mode, draw->count, draw->type, draw->offset);
+            } break;
+        }
+        cursor += header->size;
+    }
+    GLXT_COMMAND.stats.commands_replayed += list->commands_count;
+}
+
+void glxt_submit_command_lists(const GLXTCommandList* lists, size_t lists_count)
+{
+    if(lists == NULL && lists_count > 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    for(size_t i = 0; i < lists_count; ++i) {
+        if(lists[i].failed) {
+            GLXT.last_failure = GLXT_COMMAND_LIST_INCOMPLETE;
+            GLXT_COMMAND.stats.lists_skipped += 1;
+            continue;
+        }
+        _glxt_command_replay(&lists[i]);
+        GLXT_COMMAND.stats.lists_submitted += 1;
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+GLXTCommandStats glxt_command_stats(void)
+{
+    return GLXT_COMMAND.stats;
+}
+
+#endif // GLXT_COMMAND_IMPLEMENTATION
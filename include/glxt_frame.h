@@ -0,0 +1,296 @@
+/**
+ * glxt_frame works like glxt: define GLXT_FRAME_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Frame loop.
+ * Runs the simulation at a fixed timestep independent of the frame rate
+ * and tells the renderer how far it is between the last two steps, so
+ * motion can be interpolated. Frames are paced to target_fps by sleeping
+ * until shortly before the deadline and spinning for the rest, which keeps
+ * the CPU mostly idle without oversleeping. A target_fps of 0 leaves the
+ * pacing to the swap interval.
+ *
+ *     int steps = glxt_frame_loop_begin(&loop);   // right after polling input
+ *     while(steps-- > 0) simulate(loop.step_seconds);
+ *     render(glxt_frame_loop_alpha(&loop));
+ *     glfwSwapBuffers(window);
+ *     glxt_frame_loop_end(&loop);
+ *
+ * Latency is measured from glxt_frame_loop_begin (or the last
+ * glxt_frame_loop_mark_input) to glxt_frame_loop_end, after the swap.
+ * With finish set, glFinish runs first so the GPU work is included.
+ * Statistics cover the last GLXT_FRAME_LOOP_HISTORY frames.
+ *
+ * Timing uses GLXT_FRAME_TIMER (glfwGetTimerValue by default) and the swap
+ * interval is set with glfwSwapInterval, so a context must be current when
+ * the loop is initialized.
+ *
+ * On Windows Sleep wakes on the scheduler tick, 15.6 ms by default, which
+ * is coarser than the spin margin. The loop raises the timer resolution to
+ * 1 ms (timeBeginPeriod, link winmm) until glxt_frame_loop_deinit.
+ */
+#ifndef GLXT_FRAME_H
+#define GLXT_FRAME_H
+
+#include "glxt.h"
+
+#ifndef GLXT_FRAME_LOOP_HISTORY
+    #define GLXT_FRAME_LOOP_HISTORY 240
+#endif
+
+typedef struct GLXTFrameLoopDesc {
+    double simulation_hz;
+    double target_fps;
+    // Negative leaves the swap interval alone
+    int swap_interval;
+    int max_steps_per_frame;
+    // How long before the deadline sleeping stops and spinning starts
+    double spin_seconds;
+    bool finish;
+} GLXTFrameLoopDesc;
+
+typedef struct GLXTFrameLoopStats {
+    size_t frames;
+    size_t simulation_steps;
+    size_t dropped_steps;
+    double fps;
+    double frame_ms_mean;
+    double frame_ms_p50;
+    double frame_ms_p99;
+    double frame_ms_max;
+    double latency_ms_mean;
+    double latency_ms_p99;
+    double latency_ms_max;
+    // Time spent waiting for the deadline, per frame on average
+    double sleep_ms_mean;
+    double spin_ms_mean;
+} GLXTFrameLoopStats;
+
+typedef struct GLXTFrameLoop {
+    GLXTFrameLoopDesc desc;
+    double step_seconds;
+    double accumulator;
+    double frequency;
+    uint64_t frame_start;
+    uint64_t input_time;
+    uint64_t next_deadline;
+    bool started;
+    double frame_seconds[GLXT_FRAME_LOOP_HISTORY];
+    double latency_seconds[GLXT_FRAME_LOOP_HISTORY];
+    size_t history_count;
+    size_t history_index;
+    size_t frames;
+    size_t simulation_steps;
+    size_t dropped_steps;
+    double sleep_seconds;
+    double spin_seconds;
+    bool timer_period;
+} GLXTFrameLoop;
+
+// desc may be NULL, zero fields take defaults: 60 Hz simulation, 5 steps per frame, 2 ms spin
+void glxt_frame_loop_init(GLXTFrameLoop* loop, const GLXTFrameLoopDesc* desc);
+void glxt_frame_loop_deinit(GLXTFrameLoop* loop);
+void glxt_frame_loop_set_target_fps(GLXTFrameLoop* loop, double target_fps);
+void glxt_frame_loop_set_swap_interval(GLXTFrameLoop* loop, int swap_interval);
+// Returns the number of fixed steps to simulate this frame
+int glxt_frame_loop_begin(GLXTFrameLoop* loop);
+void glxt_frame_loop_mark_input(GLXTFrameLoop* loop);
+// Between 0 and 1, how far the current time is past the last simulated step
+float glxt_frame_loop_alpha(const GLXTFrameLoop* loop);
+void glxt_frame_loop_end(GLXTFrameLoop* loop);
+GLXTFrameLoopStats glxt_frame_loop_stats(const GLXTFrameLoop* loop);
+
+#endif // GLXT_FRAME_H
+
+#if defined(GLXT_FRAME_IMPLEMENTATION) && !defined(GLXT_FRAME_IMPLEMENTATION_INCLUDED)
+#define GLXT_FRAME_IMPLEMENTATION_INCLUDED
+
+#include <GLFW/glfw3.h>
+
+#ifndef GLXT_FRAME_TIMER
+    #define GLXT_FRAME_TIMER() glfwGetTimerValue()
+    #define GLXT_FRAME_TIMER_FREQUENCY() glfwGetTimerFrequency()
+#endif
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <mmsystem.h>
+    #if defined(_MSC_VER)
+        #pragma comment(lib, "winmm.lib")
+    #endif
+#else
+    #include <time.h>
+#endif
+
+// Frames longer than this are simulated as if they were, so a stall
+// (breakpoint, window drag) does not trigger a burst of catch up steps
+#define _GLXT_FRAME_MAXIMUM_DELTA 0.25
+
+static void _glxt_frame_sleep(double seconds)
+{
+#if defined(_WIN32)
+    Sleep((DWORD)(seconds * 1000.0));
+#else
+    struct timespec duration;
+    duration.tv_sec = (time_t)seconds;
+    duration.tv_nsec = (long)((seconds - (double)duration.tv_sec) * 1e9);
+    nanosleep(&duration, NULL);
+#endif
+}
+
+void glxt_frame_loop_init(GLXTFrameLoop* loop, const GLXTFrameLoopDesc* desc)
+{
+    if(loop == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    memset(loop, 0, sizeof(*loop));
+    if(desc != NULL) loop->desc = *desc;
+    else loop->desc.swap_interval = -1;
+
+    if(loop->desc.simulation_hz <= 0.0) loop->desc.simulation_hz = 60.0;
+    if(loop->desc.max_steps_per_frame <= 0) loop->desc.max_steps_per_frame = 5;
+    if(loop->desc.spin_seconds <= 0.0) loop->desc.spin_seconds = 0.002;
+    loop->step_seconds = 1.0 / loop->desc.simulation_hz;
+    loop->frequency = (double)GLXT_FRAME_TIMER_FREQUENCY();
+
+    if(loop->desc.swap_interval >= 0) glfwSwapInterval(loop->desc.swap_interval);
+#if defined(_WIN32)
+    loop->timer_period = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+}
+
+void glxt_frame_loop_deinit(GLXTFrameLoop* loop)
+{
+    if(loop == NULL) return;
+#if defined(_WIN32)
+    if(loop->timer_period) timeEndPeriod(1);
+#endif
+    loop->timer_period = false;
+}
+
+void glxt_frame_loop_set_target_fps(GLXTFrameLoop* loop, double target_fps)
+{
+    loop->desc.target_fps = target_fps > 0.0 ? target_fps : 0.0;
+    loop->next_deadline = 0;
+}
+
+void glxt_frame_loop_set_swap_interval(GLXTFrameLoop* loop, int swap_interval)
+{
+    loop->desc.swap_interval = swap_interval;
+    if(swap_interval >= 0) glfwSwapInterval(swap_interval);
+}
+
+int glxt_frame_loop_begin(GLXTFrameLoop* loop)
+{
+    uint64_t now = GLXT_FRAME_TIMER();
+    loop->input_time = now;
+    if(!loop->started) {
+        // The first frame renders the initial state
+        loop->started = true;
+        loop->frame_start = now;
+        return 0;
+    }
+
+    double delta = (double)(now - loop->frame_start) / loop->frequency;
+    loop->frame_start = now;
+    if(delta > _GLXT_FRAME_MAXIMUM_DELTA) delta = _GLXT_FRAME_MAXIMUM_DELTA;
+    loop->accumulator += delta;
+
+    int steps = (int)(loop->accumulator / loop->step_seconds);
+    loop->accumulator -= steps * loop->step_seconds;
+    if(steps > loop->desc.max_steps_per_frame) {
+        loop->dropped_steps += (size_t)(steps - loop->desc.max_steps_per_frame);
+        steps = loop->desc.max_steps_per_frame;
+    }
+    loop->simulation_steps += (size_t)steps;
+    return steps;
+}
+
+void glxt_frame_loop_mark_input(GLXTFrameLoop* loop)
+{
+    loop->input_time = GLXT_FRAME_TIMER();
+}
+
+float glxt_frame_loop_alpha(const GLXTFrameLoop* loop)
+{
+    float alpha = (float)(loop->accumulator / loop->step_seconds);
+    return alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+}
+
+void glxt_frame_loop_end(GLXTFrameLoop* loop)
+{
+    if(loop->desc.finish) glFinish();
+
+    uint64_t now = GLXT_FRAME_TIMER();
+    size_t index = loop->history_index;
+    loop->latency_seconds[index] = (double)(now - loop->input_time) / loop->frequency;
+
+    if(loop->desc.target_fps > 0.0) {
+        uint64_t period = (uint64_t)(loop->frequency / loop->desc.target_fps);
+        // Deadlines advance by whole periods so pacing does not drift,
+        // a frame that overran starts a new schedule instead of rushing
+        if(loop->next_deadline == 0 || now > loop->next_deadline + period)
+            loop->next_deadline = now + period;
+        else
+            loop->next_deadline += period;
+
+        double remaining = (double)(int64_t)(loop->next_deadline - now) / loop->frequency;
+        if(remaining > loop->desc.spin_seconds) {
+            _glxt_frame_sleep(remaining - loop->desc.spin_seconds);
+            uint64_t woke = GLXT_FRAME_TIMER();
+            loop->sleep_seconds += (double)(woke - now) / loop->frequency;
+            now = woke;
+        }
+        uint64_t spin_start = now;
+        while(now < loop->next_deadline) now = GLXT_FRAME_TIMER();
+        loop->spin_seconds += (double)(now - spin_start) / loop->frequency;
+    }
+
+    loop->frame_seconds[index] = (double)(now - loop->frame_start) / loop->frequency;
+    loop->history_index = (index + 1) % GLXT_FRAME_LOOP_HISTORY;
+    if(loop->history_count < GLXT_FRAME_LOOP_HISTORY) loop->history_count += 1;
+    loop->frames += 1;
+}
+
+static int _glxt_frame_compare(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void _glxt_frame_summary(const double* history, size_t count,
+    double* mean, double* p50, double* p99, double* max)
+{
+    double sorted[GLXT_FRAME_LOOP_HISTORY];
+    double total = 0.0;
+    memcpy(sorted, history, sizeof(double) * count);
+    qsort(sorted, count, sizeof(double), _glxt_frame_compare);
+    for(size_t i = 0; i < count; ++i) total += sorted[i];
+
+    *mean = total / count * 1000.0;
+    if(p50 != NULL) *p50 = sorted[(count - 1) / 2] * 1000.0;
+    *p99 = sorted[(size_t)((count - 1) * 0.99 + 0.5)] * 1000.0;
+    *max = sorted[count - 1] * 1000.0;
+}
+
+GLXTFrameLoopStats glxt_frame_loop_stats(const GLXTFrameLoop* loop)
+{
+    GLXTFrameLoopStats stats = {0};
+    if(loop == NULL || loop->history_count == 0) return stats;
+
+    stats.frames = loop->frames;
+    stats.simulation_steps = loop->simulation_steps;
+    stats.dropped_steps = loop->dropped_steps;
+    _glxt_frame_summary(loop->frame_seconds, loop->history_count,
+        &stats.frame_ms_mean, &stats.frame_ms_p50, &stats.frame_ms_p99, &stats.frame_ms_max);
+    _glxt_frame_summary(loop->latency_seconds, loop->history_count,
+        &stats.latency_ms_mean, NULL, &stats.latency_ms_p99, &stats.latency_ms_max);
+    stats.fps = stats.frame_ms_mean > 0.0 ? 1000.0 / stats.frame_ms_mean : 0.0;
+    stats.sleep_ms_mean = loop->sleep_seconds * 1000.0 / loop->frames;
+    stats.spin_ms_mean = loop->spin_seconds * 1000.0 / loop->frames;
+    return stats;
+}
+
+#endif // GLXT_FRAME_IMPLEMENTATION
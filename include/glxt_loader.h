@@ -0,0 +1,442 @@
+/**
+ * glxt_loader works like glxt: define GLXT_LOADER_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Asynchronous asset loading.
+ * File I/O and decoding run on worker threads. Finished jobs are pushed
+ * onto a lock-free queue and picked up by glxt_loader_pump on the thread
+ * that owns the GL context, which performs the GPU upload and calls the
+ * job's done callback. glxt_loader_pump stops after the given time budget
+ * so streaming never takes a whole frame.
+ *
+ * The glxt_loader_* functions must be called from the GL thread.
+ * Decode callbacks run on worker threads and must not touch GL or glxt.
+ */
+#ifndef GLXT_LOADER_H
+#define GLXT_LOADER_H
+
+#include "glxt.h"
+
+#ifndef GLXT_LOADER_MAXIMUM_JOBS
+    #define GLXT_LOADER_MAXIMUM_JOBS 256
+#endif
+
+#ifndef GLXT_LOADER_MAXIMUM_WORKERS
+    #define GLXT_LOADER_MAXIMUM_WORKERS 16
+#endif
+
+enum {
+    GLXT_LOAD_RAW = 0,
+    GLXT_LOAD_SHADER_PROGRAM,
+    GLXT_LOAD_VERTEX_BUFFER,
+    GLXT_LOAD_INDEX_BUFFER,
+    GLXT_LOAD_TEXTURE2D,
+};
+
+/**
+ * files[i] is the content of paths[i]. A decode callback may replace
+ * data/size with its own output; set owns_data when data was malloc'd
+ * so the loader frees it.
+ */
+typedef struct GLXTLoadPayload {
+    GLXTFileView files[2];
+    void* data;
+    size_t size;
+    bool owns_data;
+    uint32_t width, height;
+    int comp;
+} GLXTLoadPayload;
+
+typedef struct GLXTLoadResult {
+    bool ok;
+    int failure;
+    uint32_t handle;
+} GLXTLoadResult;
+
+typedef bool (*GLXTLoadDecodeProc)(GLXTLoadPayload* payload, void* user_data);
+typedef uint32_t (*GLXTLoadUploadProc)(const GLXTLoadPayload* payload, void* user_data);
+typedef void (*GLXTLoadDoneProc)(const GLXTLoadResult* result, const GLXTLoadPayload* payload, void* user_data);
+
+/**
+ * kind selects the default upload: shader programs use paths[0] and
+ * paths[1] as vertex and fragment source, buffers upload data/size and
+ * textures upload width x height pixels of comp channels from data (the
+ * decode callback is expected to fill those in).
+ * upload overrides the default and must return a non-zero handle on
+ * success. GLXT_LOAD_RAW has no default upload, done receives the bytes.
+ */
+typedef struct GLXTLoadRequest {
+    int kind;
+    const char* paths[2];
+    GLXTLoadDecodeProc decode;
+    GLXTLoadUploadProc upload;
+    GLXTLoadDoneProc done;
+    void* user_data;
+} GLXTLoadRequest;
+
+typedef struct GLXTLoaderStats {
+    size_t submitted;
+    size_t uploaded;
+    size_t failed;
+    size_t deferred_pumps;
+} GLXTLoaderStats;
+
+bool glxt_loader_init(size_t workers_count);
+void glxt_loader_deinit(void);
+bool glxt_loader_submit(const GLXTLoadRequest* request);
+size_t glxt_loader_pump(double budget_seconds);
+size_t glxt_loader_pending(void);
+GLXTLoaderStats glxt_loader_stats(void);
+
+#endif // GLXT_LOADER_H
+
+#if defined(GLXT_LOADER_IMPLEMENTATION) && !defined(GLXT_LOADER_IMPLEMENTATION_INCLUDED)
+#define GLXT_LOADER_IMPLEMENTATION_INCLUDED
+
+#include <stdatomic.h>
+
+#include "glxt_thread.h"
+
+#if !defined(_WIN32)
+    #include <time.h>
+#endif
+
+#if (GLXT_LOADER_MAXIMUM_JOBS & (GLXT_LOADER_MAXIMUM_JOBS - 1)) != 0
+    #error "GLXT_LOADER_MAXIMUM_JOBS must be a power of two"
+#endif
+
+typedef struct _GLXTLoadJob {
+    GLXTLoadRequest request;
+    GLXTLoadPayload payload;
+    int failure;
+} _GLXTLoadJob;
+
+static struct {
+    bool initialized;
+    _GLXTThread workers[GLXT_LOADER_MAXIMUM_WORKERS];
+    size_t workers_count;
+
+    // Only touched by the GL thread
+    _GLXTLoadJob jobs[GLXT_LOADER_MAXIMUM_JOBS];
+    uint32_t free_jobs[GLXT_LOADER_MAXIMUM_JOBS];
+    size_t free_jobs_count;
+    GLXTLoaderStats stats;
+
+    // GL thread -> workers, workers sleep on it so it is lock based
+    _GLXTMutex mutex;
+    _GLXTCondition condition;
+    uint32_t pending[GLXT_LOADER_MAXIMUM_JOBS];
+    size_t pending_head;
+    size_t pending_count;
+    bool quit;
+
+    // Workers -> GL thread, bounded multi-producer single-consumer ring.
+    // Each cell carries a sequence number telling producers and the
+    // consumer whose turn it is (Vyukov's bounded queue).
+    struct {
+        atomic_size_t sequence;
+        uint32_t job;
+    } completed[GLXT_LOADER_MAXIMUM_JOBS];
+    atomic_size_t completed_tail;
+    size_t completed_head;
+} GLXT_LOADER = {0};
+
+#if defined(_WIN32)
+static double _glxt_loader_now(void)
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+static double _glxt_loader_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#endif
+
+static void _glxt_loader_push_completed(uint32_t job)
+{
+    size_t tail = atomic_load_explicit(&GLXT_LOADER.completed_tail, memory_order_relaxed);
+    for(;;) {
+        size_t index = tail & (GLXT_LOADER_MAXIMUM_JOBS - 1);
+        size_t sequence = atomic_load_explicit(&GLXT_LOADER.completed[index].sequence, memory_order_acquire);
+        // The ring holds as many cells as there are jobs, so it never fills up
+        if(sequence == tail) {
+            if(atomic_compare_exchange_weak_explicit(&GLXT_LOADER.completed_tail, &tail, tail + 1,
+                memory_order_relaxed, memory_order_relaxed)) {
+                GLXT_LOADER.completed[index].job = job;
+                atomic_store_explicit(&GLXT_LOADER.completed[index].sequence, tail + 1, memory_order_release);
+                return;
+            }
+        } else {
+            tail = atomic_load_explicit(&GLXT_LOADER.completed_tail, memory_order_relaxed);
+        }
+    }
+}
+
+static bool _glxt_loader_has_completed(void)
+{
+    size_t head = GLXT_LOADER.completed_head;
+    size_t index = head & (GLXT_LOADER_MAXIMUM_JOBS - 1);
+    return atomic_load_explicit(&GLXT_LOADER.completed[index].sequence, memory_order_acquire) == head + 1;
+}
+
+static bool _glxt_loader_pop_completed(uint32_t* job)
+{
+    size_t head = GLXT_LOADER.completed_head;
+    size_t index = head & (GLXT_LOADER_MAXIMUM_JOBS - 1);
+    size_t sequence = atomic_load_explicit(&GLXT_LOADER.completed[index].sequence, memory_order_acquire);
+    if(sequence != head + 1) return false;
+
+    *job = GLXT_LOADER.completed[index].job;
+    atomic_store_explicit(&GLXT_LOADER.completed[index].sequence,
+        head + GLXT_LOADER_MAXIMUM_JOBS, memory_order_release);
+    GLXT_LOADER.completed_head = head + 1;
+    return true;
+}
+
+static void _glxt_loader_run_job(_GLXTLoadJob* job)
+{
+    job->failure = GLXT_NO_ERROR;
+    for(size_t i = 0; i < 2; ++i) {
+        if(job->request.paths[i] == NULL) continue;
+        if(!_glxt_load_file(job->request.paths[i], &job->payload.files[i], &job->failure))
+            return;
+    }
+
+    job->payload.data = (void*)job->payload.files[0].data;
+    job->payload.size = job->payload.files[0].size;
+    job->payload.owns_data = false;
+
+    if(job->request.decode != NULL && !job->request.decode(&job->payload, job->request.user_data))
+        job->failure = GLXT_LOADER_DECODE_FAILURE;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _glxt_loader_worker(LPVOID arg)
+#else
+static void* _glxt_loader_worker(void* arg)
+#endif
+{
+    (void)arg;
+    for(;;) {
+        _glxt_mutex_lock(&GLXT_LOADER.mutex);
+        while(GLXT_LOADER.pending_count == 0 && !GLXT_LOADER.quit)
+            _glxt_condition_wait(&GLXT_LOADER.condition, &GLXT_LOADER.mutex);
+        if(GLXT_LOADER.quit) {
+            _glxt_mutex_unlock(&GLXT_LOADER.mutex);
+            break;
+        }
+        uint32_t job = GLXT_LOADER.pending[GLXT_LOADER.pending_head];
+        GLXT_LOADER.pending_head = (GLXT_LOADER.pending_head + 1) % GLXT_LOADER_MAXIMUM_JOBS;
+        GLXT_LOADER.pending_count -= 1;
+        _glxt_mutex_unlock(&GLXT_LOADER.mutex);
+
+        _glxt_loader_run_job(&GLXT_LOADER.jobs[job]);
+        _glxt_loader_push_completed(job);
+    }
+    return 0;
+}
+
+static void _glxt_loader_release_job(uint32_t job)
+{
+    GLXTLoadPayload* payload = &GLXT_LOADER.jobs[job].payload;
+    if(payload->owns_data) free(payload->data);
+    glxt_release_file(&payload->files[0]);
+    glxt_release_file(&payload->files[1]);
+    memset(payload, 0, sizeof(*payload));
+    GLXT_LOADER.free_jobs[GLXT_LOADER.free_jobs_count++] = job;
+}
+
+bool glxt_loader_init(size_t workers_count)
+{
+    if(GLXT_LOADER.initialized) return true;
+    if(workers_count == 0) workers_count = 1;
+    if(workers_count > GLXT_LOADER_MAXIMUM_WORKERS) workers_count = GLXT_LOADER_MAXIMUM_WORKERS;
+
+    GLXT_LOADER.free_jobs_count = GLXT_LOADER_MAXIMUM_JOBS;
+    for(size_t i = 0; i < GLXT_LOADER_MAXIMUM_JOBS; ++i) {
+        GLXT_LOADER.free_jobs[i] = (uint32_t)(GLXT_LOADER_MAXIMUM_JOBS - 1 - i);
+        atomic_init(&GLXT_LOADER.completed[i].sequence, i);
+    }
+    atomic_init(&GLXT_LOADER.completed_tail, 0);
+    GLXT_LOADER.completed_head = 0;
+    GLXT_LOADER.pending_head = 0;
+    GLXT_LOADER.pending_count = 0;
+    GLXT_LOADER.quit = false;
+    memset(&GLXT_LOADER.stats, 0, sizeof(GLXT_LOADER.stats));
+
+    _glxt_mutex_init(&GLXT_LOADER.mutex);
+    _glxt_condition_init(&GLXT_LOADER.condition);
+
+    GLXT_LOADER.workers_count = 0;
+    for(size_t i = 0; i < workers_count; ++i) {
+#if defined(_WIN32)
+        GLXT_LOADER.workers[i] = CreateThread(NULL, 0, _glxt_loader_worker, NULL, 0, NULL);
+        bool created = GLXT_LOADER.workers[i] != NULL;
+#else
+        bool created = pthread_create(&GLXT_LOADER.workers[i], NULL, _glxt_loader_worker, NULL) == 0;
+#endif
+        if(!created) break;
+        GLXT_LOADER.workers_count += 1;
+    }
+
+    GLXT_LOADER.initialized = true;
+    if(GLXT_LOADER.workers_count == 0) {
+        glxt_loader_deinit();
+        GLXT.last_failure = GLXT_LOADER_THREAD_FAILURE;
+        return false;
+    }
+    return true;
+}
+
+void glxt_loader_deinit(void)
+{
+    if(!GLXT_LOADER.initialized) return;
+
+    _glxt_mutex_lock(&GLXT_LOADER.mutex);
+    GLXT_LOADER.quit = true;
+    _glxt_condition_broadcast(&GLXT_LOADER.condition);
+    _glxt_mutex_unlock(&GLXT_LOADER.mutex);
+
+    for(size_t i = 0; i < GLXT_LOADER.workers_count; ++i) {
+#if defined(_WIN32)
+        WaitForSingleObject(GLXT_LOADER.workers[i], INFINITE);
+        CloseHandle(GLXT_LOADER.workers[i]);
+#else
+        pthread_join(GLXT_LOADER.workers[i], NULL);
+#endif
+    }
+
+    // Jobs that finished loading but were never uploaded
+    uint32_t job = 0;
+    while(_glxt_loader_pop_completed(&job))
+        _glxt_loader_release_job(job);
+    for(size_t i = 0; i < GLXT_LOADER.pending_count; ++i) {
+        job = GLXT_LOADER.pending[(GLXT_LOADER.pending_head + i) % GLXT_LOADER_MAXIMUM_JOBS];
+        _glxt_loader_release_job(job);
+    }
+
+    _glxt_condition_destroy(&GLXT_LOADER.condition);
+    _glxt_mutex_destroy(&GLXT_LOADER.mutex);
+    GLXT_LOADER.workers_count = 0;
+    GLXT_LOADER.initialized = false;
+}
+
+bool glxt_loader_submit(const GLXTLoadRequest* request)
+{
+    if(request == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(!GLXT_LOADER.initialized) {
+        GLXT.last_failure = GLXT_LOADER_NOT_INITIALIZED;
+        return false;
+    }
+    if(GLXT_LOADER.free_jobs_count == 0) {
+        GLXT.last_failure = GLXT_LOADER_QUEUE_FULL;
+        return false;
+    }
+
+    uint32_t job = GLXT_LOADER.free_jobs[--GLXT_LOADER.free_jobs_count];
+    GLXT_LOADER.jobs[job].request = *request;
+    memset(&GLXT_LOADER.jobs[job].payload, 0, sizeof(GLXTLoadPayload));
+    GLXT_LOADER.jobs[job].failure = GLXT_NO_ERROR;
+
+    _glxt_mutex_lock(&GLXT_LOADER.mutex);
+    size_t tail = (GLXT_LOADER.pending_head + GLXT_LOADER.pending_count) % GLXT_LOADER_MAXIMUM_JOBS;
+    GLXT_LOADER.pending[tail] = job;
+    GLXT_LOADER.pending_count += 1;
+    _glxt_condition_signal(&GLXT_LOADER.condition);
+    _glxt_mutex_unlock(&GLXT_LOADER.mutex);
+
+    GLXT_LOADER.stats.submitted += 1;
+    return true;
+}
+
+// failure is the upload's own, an older failure still pending in GLXT is kept but not reported
+static uint32_t _glxt_loader_upload(const _GLXTLoadJob* job, int* failure)
+{
+    const GLXTLoadPayload* payload = &job->payload;
+    int previous_failure = GLXT.last_failure;
+    GLXT.last_failure = GLXT_NO_ERROR;
+
+    uint32_t handle = 0;
+    if(job->request.upload != NULL) {
+        handle = job->request.upload(payload, job->request.user_data);
+    } else {
+        switch(job->request.kind) {
+            case GLXT_LOAD_SHADER_PROGRAM:
+                handle = glxt_create_shader_program(payload->files[0].data, payload->files[1].data);
+                break;
+            case GLXT_LOAD_VERTEX_BUFFER:
+                handle = glxt_create_vertex_buffer(payload->size, payload->data);
+                break;
+            case GLXT_LOAD_INDEX_BUFFER:
+                handle = glxt_create_index_buffer(payload->size, payload->data);
+                break;
+            case GLXT_LOAD_TEXTURE2D:
+                handle = glxt_create_texture2d(payload->width, payload->height, payload->comp,
+                    (const uint8_t*)payload->data);
+                break;
+        }
+    }
+
+    *failure = GLXT_NO_ERROR;
+    if(handle == 0) *failure = glxt_has_failure() ? GLXT.last_failure : GLXT_LOADER_UPLOAD_FAILURE;
+    if(!glxt_has_failure()) GLXT.last_failure = previous_failure;
+    return handle;
+}
+
+size_t glxt_loader_pump(double budget_seconds)
+{
+    if(!GLXT_LOADER.initialized) return 0;
+
+    double deadline = _glxt_loader_now() + budget_seconds;
+    size_t processed = 0;
+    uint32_t job = 0;
+
+    // Always make progress on at least one job, even with a zero budget
+    while(_glxt_loader_pop_completed(&job)) {
+        _GLXTLoadJob* current = &GLXT_LOADER.jobs[job];
+        GLXTLoadResult result = {0};
+        result.failure = current->failure;
+
+        bool has_upload = current->request.upload != NULL || current->request.kind != GLXT_LOAD_RAW;
+        if(result.failure == GLXT_NO_ERROR && has_upload) {
+            result.handle = _glxt_loader_upload(current, &result.failure);
+        }
+        if(result.failure != GLXT_NO_ERROR) GLXT.last_failure = result.failure;
+        result.ok = result.failure == GLXT_NO_ERROR;
+
+        if(result.ok) GLXT_LOADER.stats.uploaded += 1;
+        else GLXT_LOADER.stats.failed += 1;
+
+        if(current->request.done != NULL)
+            current->request.done(&result, &current->payload, current->request.user_data);
+        _glxt_loader_release_job(job);
+        processed += 1;
+
+        if(_glxt_loader_now() >= deadline) {
+            if(_glxt_loader_has_completed()) GLXT_LOADER.stats.deferred_pumps += 1;
+            break;
+        }
+    }
+    return processed;
+}
+
+size_t glxt_loader_pending(void)
+{
+    return GLXT_LOADER_MAXIMUM_JOBS - GLXT_LOADER.free_jobs_count;
+}
+
+GLXTLoaderStats glxt_loader_stats(void)
+{
+    return GLXT_LOADER.stats;
+}
+
+#endif // GLXT_LOADER_IMPLEMENTATION
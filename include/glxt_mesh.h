@@ -0,0 +1,688 @@
+/**
+ * glxt_mesh works like glxt: define GLXT_MESH_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Mesh optimization.
+ * CPU side utilities that turn triangle lists into indexed meshes that
+ * are cheap for the GPU to draw:
+ *  - welding: identical vertices (compared byte for byte, so zero any
+ *    padding) are merged and referenced by index
+ *  - vertex cache order: triangles are reordered with Tipsify so recently
+ *    transformed vertices get reused by the post-transform cache
+ *  - vertex fetch order: vertices are reordered by first use so fetching
+ *    them walks memory linearly
+ *  - index type: GL_UNSIGNED_SHORT indices when every vertex fits, else
+ *    GL_UNSIGNED_INT
+ *
+ * ACMR (average cache miss ratio) is the number of vertices transformed
+ * per triangle with a FIFO cache of GLXT_MESH_CACHE_SIZE entries: 3.0 is
+ * the worst, around 0.6 is typical of a well ordered grid.
+ *
+ * A built mesh is drawn with
+ *     glxt_draw_elements(GL_TRIANGLES, mesh.indices_count, mesh.index_type, 0);
+ */
+#ifndef GLXT_MESH_H
+#define GLXT_MESH_H
+
+#include "glxt.h"
+
+#ifndef GLXT_MESH_CACHE_SIZE
+    #define GLXT_MESH_CACHE_SIZE 16
+#endif
+
+typedef struct GLXTMesh {
+    void* vertices;
+    size_t vertex_size;
+    size_t vertices_count;
+    void* indices;
+    uint32_t index_type;
+    size_t index_size;
+    size_t indices_count;
+} GLXTMesh;
+
+typedef struct GLXTMeshStats {
+    size_t vertices_before;
+    size_t vertices_after;
+    float acmr_before;
+    float acmr_after;
+} GLXTMeshStats;
+
+/**
+ * Build an optimized mesh from vertices of vertex_size bytes. indices may
+ * be NULL, vertices are then a plain triangle list. stats may be NULL.
+ * Release the mesh with glxt_mesh_free.
+ */
+bool glxt_mesh_build(GLXTMesh* mesh, const void* vertices, size_t vertex_size, size_t vertices_count,
+    const uint32_t* indices, size_t indices_count, GLXTMeshStats* stats);
+void glxt_mesh_free(GLXTMesh* mesh);
+
+/**
+ * The building blocks of glxt_mesh_build, usable on their own.
+ *
+ * glxt_mesh_weld writes the unique vertices (at most vertices_count) and
+ * one index per input vertex, it returns the unique vertices count.
+ * glxt_mesh_optimize_vertex_cache writes the reordered triangles to dst,
+ * which must not alias indices.
+ * glxt_mesh_optimize_vertex_fetch writes the used vertices in first use
+ * order and remaps indices in place, it returns the used vertices count.
+ */
+size_t glxt_mesh_weld(const void* vertices, size_t vertex_size, size_t vertices_count,
+    void* unique_vertices, uint32_t* indices);
+bool glxt_mesh_optimize_vertex_cache(uint32_t* dst, const uint32_t* indices, size_t indices_count,
+    size_t vertices_count);
+size_t glxt_mesh_optimize_vertex_fetch(void* dst_vertices, uint32_t* indices, size_t indices_count,
+    const void* vertices, size_t vertex_size, size_t vertices_count);
+float glxt_mesh_acmr(const uint32_t* indices, size_t indices_count, size_t vertices_count, size_t cache_size);
+
+uint32_t glxt_mesh_index_type(size_t vertices_count);
+size_t glxt_mesh_index_size(uint32_t index_type);
+// Writes indices as index_type into dst, returns the number of bytes written
+size_t glxt_mesh_pack_indices(void* dst, const uint32_t* indices, size_t indices_count, uint32_t index_type);
+
+/**
+ * Binary mesh files.
+ * A versioned container laid out so it can be memory mapped and uploaded
+ * without parsing: a fixed header describing the vertex layout, then the
+ * vertex and index blobs, each starting on a GLXT_MESH_FILE_ALIGNMENT
+ * byte boundary. glxt_mesh_file_open validates the header and points
+ * into the file view, glxt_mesh_file_upload hands those pointers straight
+ * to glxt_create_vertex_buffer and glxt_create_index_buffer.
+ * Files are little endian and written by glxt_mesh_save or the obj2mesh
+ * tool.
+ */
+#ifndef GLXT_MESH_FILE_MAXIMUM_ATTRIBS
+    #define GLXT_MESH_FILE_MAXIMUM_ATTRIBS 8
+#endif
+
+#define GLXT_MESH_FILE_ALIGNMENT 64
+
+typedef struct GLXTMeshAttrib {
+    uint32_t index;
+    uint32_t comp_count;
+    uint32_t attr_type;
+    uint32_t normalized;
+    uint32_t offset;
+} GLXTMeshAttrib;
+
+typedef struct GLXTMeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_size;
+    uint32_t index_type;
+    uint64_t vertices_count;
+    uint64_t indices_count;
+    uint64_t vertices_offset;
+    uint64_t indices_offset;
+    float bounds_min[3];
+    float bounds_max[3];
+    uint32_t attribs_count;
+    uint32_t reserved;
+    GLXTMeshAttrib attribs[GLXT_MESH_FILE_MAXIMUM_ATTRIBS];
+} GLXTMeshFileHeader;
+
+typedef struct GLXTMeshFile {
+    GLXTFileView view;
+    const GLXTMeshFileHeader* header;
+    const void* vertices;
+    const void* indices;
+} GLXTMeshFile;
+
+typedef struct GLXTMeshBuffers {
+    uint32_t vao;
+    uint32_t vbo;
+    uint32_t ibo;
+    uint32_t index_type;
+    int indices_count;
+} GLXTMeshBuffers;
+
+// bounds_min/bounds_max come from the first attribute, when it has 3 floats
+bool glxt_mesh_save(const GLXTMesh* mesh, const GLXTMeshAttrib* attribs, size_t attribs_count, const char* path);
+bool glxt_mesh_file_open(GLXTMeshFile* file, const char* path);
+void glxt_mesh_file_close(GLXTMeshFile* file);
+bool glxt_mesh_file_upload(const GLXTMeshFile* file, GLXTMeshBuffers* buffers);
+void glxt_mesh_buffers_destroy(GLXTMeshBuffers* buffers);
+
+#endif // GLXT_MESH_H
+
+#if defined(GLXT_MESH_IMPLEMENTATION) && !defined(GLXT_MESH_IMPLEMENTATION_INCLUDED)
+#define GLXT_MESH_IMPLEMENTATION_INCLUDED
+
+#include <math.h>
+
+#define _GLXT_MESH_EMPTY_SLOT UINT32_MAX
+
+static uint32_t _glxt_mesh_hash(const uint8_t* data, size_t size)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t glxt_mesh_weld(const void* vertices, size_t vertex_size, size_t vertices_count,
+    void* unique_vertices, uint32_t* indices)
+{
+    if(vertices == NULL || unique_vertices == NULL || indices == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    // Open addressing, at most half full so probes stay short
+    size_t table_size = 1;
+    while(table_size < vertices_count * 2) table_size *= 2;
+    uint32_t* table = malloc(sizeof(uint32_t) * table_size);
+    if(table == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return 0;
+    }
+    memset(table, 0xFF, sizeof(uint32_t) * table_size);
+
+    const uint8_t* src = vertices;
+    uint8_t* dst = unique_vertices;
+    size_t unique_count = 0;
+    for(size_t i = 0; i < vertices_count; ++i) {
+        const uint8_t* vertex = src + i * vertex_size;
+        size_t slot = _glxt_mesh_hash(vertex, vertex_size) & (table_size - 1);
+        while(table[slot] != _GLXT_MESH_EMPTY_SLOT &&
+            memcmp(dst + (size_t)table[slot] * vertex_size, vertex, vertex_size) != 0)
+            slot = (slot + 1) & (table_size - 1);
+
+        if(table[slot] == _GLXT_MESH_EMPTY_SLOT) {
+            memcpy(dst + unique_count * vertex_size, vertex, vertex_size);
+            table[slot] = (uint32_t)unique_count++;
+        }
+        indices[i] = table[slot];
+    }
+
+    free(table);
+    return unique_count;
+}
+
+float glxt_mesh_acmr(const uint32_t* indices, size_t indices_count, size_t vertices_count, size_t cache_size)
+{
+    if(indices == NULL || indices_count < 3) return 0.0f;
+
+    // FIFO cache: a vertex is cached while fewer than cache_size misses
+    // happened since it was loaded
+    size_t* loaded_at = malloc(sizeof(size_t) * vertices_count);
+    if(loaded_at == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return 0.0f;
+    }
+    for(size_t i = 0; i < vertices_count; ++i) loaded_at[i] = SIZE_MAX;
+
+    size_t misses = 0;
+    for(size_t i = 0; i < indices_count; ++i) {
+        uint32_t v = indices[i];
+        if(loaded_at[v] == SIZE_MAX || misses - loaded_at[v] >= cache_size) {
+            loaded_at[v] = misses;
+            misses += 1;
+        }
+    }
+
+    free(loaded_at);
+    return (float)misses / (float)(indices_count / 3);
+}
+
+// Tipsify, from Sander, Nehab and Barczak, "Fast Triangle Reordering for
+// Vertex Locality and Reduced Overdraw". Fans around one vertex at a time
+// and picks the next fanning vertex among the ones just emitted that will
+// still be in the cache, falling back to a dead-end stack.
+bool glxt_mesh_optimize_vertex_cache(uint32_t* dst, const uint32_t* indices, size_t indices_count,
+    size_t vertices_count)
+{
+    if(dst == NULL || indices == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(indices_count == 0 || vertices_count == 0) return true;
+
+    const size_t cache_size = GLXT_MESH_CACHE_SIZE;
+    size_t triangles_count = indices_count / 3;
+
+    uint32_t* offsets = calloc(vertices_count + 1, sizeof(uint32_t));
+    uint32_t* live = calloc(vertices_count, sizeof(uint32_t));
+    uint32_t* adjacency = malloc(sizeof(uint32_t) * triangles_count * 3);
+    size_t* cache_time = calloc(vertices_count, sizeof(size_t));
+    uint32_t* dead_end = malloc(sizeof(uint32_t) * triangles_count * 3);
+    bool* emitted = calloc(triangles_count, sizeof(bool));
+    if(offsets == NULL || live == NULL || adjacency == NULL || cache_time == NULL ||
+        dead_end == NULL || emitted == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        free(offsets); free(live); free(adjacency); free(cache_time); free(dead_end); free(emitted);
+        return false;
+    }
+
+    // Vertex to triangles adjacency as offsets into one array
+    for(size_t i = 0; i < triangles_count * 3; ++i) live[indices[i]] += 1;
+    for(size_t v = 0; v < vertices_count; ++v) offsets[v + 1] = offsets[v] + live[v];
+    for(size_t i = 0; i < triangles_count * 3; ++i) {
+        uint32_t v = indices[i];
+        adjacency[offsets[v + 1] - live[v]] = (uint32_t)(i / 3);
+        live[v] -= 1;
+    }
+    for(size_t i = 0; i < triangles_count * 3; ++i) live[indices[i]] += 1;
+
+    size_t timestamp = cache_size + 1;
+    size_t dead_end_top = 0;
+    size_t cursor = 0;
+    size_t written = 0;
+    int64_t fanning = 0;
+
+    while(fanning >= 0) {
+        size_t candidates_begin = dead_end_top;
+
+        for(uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+            uint32_t triangle = adjacency[a];
+            if(emitted[triangle]) continue;
+            emitted[triangle] = true;
+
+            for(size_t k = 0; k < 3; ++k) {
+                uint32_t v = indices[triangle * 3 + k];
+                dst[written++] = v;
+                dead_end[dead_end_top++] = v;
+                live[v] -= 1;
+                if(timestamp - cache_time[v] > cache_size) {
+                    cache_time[v] = timestamp;
+                    timestamp += 1;
+                }
+            }
+        }
+
+        // Prefer the candidate with the most triangles left that will
+        // still be cached once they are emitted
+        int64_t best = -1;
+        int64_t best_priority = -1;
+        for(size_t i = candidates_begin; i < dead_end_top; ++i) {
+            uint32_t v = dead_end[i];
+            if(live[v] == 0) continue;
+            int64_t priority = 0;
+            if(timestamp - cache_time[v] + 2 * live[v] <= cache_size)
+                priority = (int64_t)(timestamp - cache_time[v]);
+            if(priority > best_priority) {
+                best_priority = priority;
+                best = v;
+            }
+        }
+
+        if(best < 0) {
+            while(dead_end_top > 0) {
+                uint32_t v = dead_end[--dead_end_top];
+                if(live[v] > 0) {
+                    best = v;
+                    break;
+                }
+            }
+        }
+        if(best < 0) {
+            while(cursor < vertices_count && live[cursor] == 0) cursor += 1;
+            if(cursor < vertices_count) best = (int64_t)cursor;
+        }
+        fanning = best;
+    }
+
+    free(offsets); free(live); free(adjacency); free(cache_time); free(dead_end); free(emitted);
+    return true;
+}
+
+size_t glxt_mesh_optimize_vertex_fetch(void* dst_vertices, uint32_t* indices, size_t indices_count,
+    const void* vertices, size_t vertex_size, size_t vertices_count)
+{
+    if(dst_vertices == NULL || indices == NULL || vertices == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    uint32_t* remap = malloc(sizeof(uint32_t) * vertices_count);
+    if(remap == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return 0;
+    }
+    memset(remap, 0xFF, sizeof(uint32_t) * vertices_count);
+
+    const uint8_t* src = vertices;
+    uint8_t* dst = dst_vertices;
+    size_t used_count = 0;
+    for(size_t i = 0; i < indices_count; ++i) {
+        uint32_t v = indices[i];
+        if(remap[v] == _GLXT_MESH_EMPTY_SLOT) {
+            memcpy(dst + used_count * vertex_size, src + (size_t)v * vertex_size, vertex_size);
+            remap[v] = (uint32_t)used_count++;
+        }
+        indices[i] = remap[v];
+    }
+
+    free(remap);
+    return used_count;
+}
+
+uint32_t glxt_mesh_index_type(size_t vertices_count)
+{
+    return vertices_count <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t glxt_mesh_index_size(uint32_t index_type)
+{
+    switch(index_type) {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        default: return 4;
+    }
+}
+
+size_t glxt_mesh_pack_indices(void* dst, const uint32_t* indices, size_t indices_count, uint32_t index_type)
+{
+    if(dst == NULL || indices == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    switch(index_type) {
+        case GL_UNSIGNED_BYTE: {
+            uint8_t* out = dst;
+            for(size_t i = 0; i < indices_count; ++i) out[i] = (uint8_t)indices[i];
+        } break;
+        case GL_UNSIGNED_SHORT: {
+            uint16_t* out = dst;
+            for(size_t i = 0; i < indices_count; ++i) out[i] = (uint16_t)indices[i];
+        } break;
+        default: {
+            memcpy(dst, indices, sizeof(uint32_t) * indices_count);
+        } break;
+    }
+    return indices_count * glxt_mesh_index_size(index_type);
+}
+
+bool glxt_mesh_build(GLXTMesh* mesh, const void* vertices, size_t vertex_size, size_t vertices_count,
+    const uint32_t* indices, size_t indices_count, GLXTMeshStats* stats)
+{
+    if(mesh == NULL || vertices == NULL || vertex_size == 0) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(mesh, 0, sizeof(*mesh));
+    if(indices == NULL) indices_count = vertices_count;
+    indices_count -= indices_count % 3;
+    if(vertices_count == 0 || indices_count == 0) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+
+    uint8_t* welded = malloc(vertex_size * vertices_count);
+    uint32_t* weld_remap = malloc(sizeof(uint32_t) * vertices_count);
+    uint32_t* welded_indices = malloc(sizeof(uint32_t) * indices_count);
+    uint32_t* ordered_indices = malloc(sizeof(uint32_t) * indices_count);
+    mesh->vertices = malloc(vertex_size * vertices_count);
+    if(welded == NULL || weld_remap == NULL || welded_indices == NULL ||
+        ordered_indices == NULL || mesh->vertices == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        goto failure;
+    }
+
+    size_t welded_count = glxt_mesh_weld(vertices, vertex_size, vertices_count, welded, weld_remap);
+    if(welded_count == 0) goto failure;
+    for(size_t i = 0; i < indices_count; ++i) {
+        uint32_t index = indices != NULL ? indices[i] : (uint32_t)i;
+        if(index >= vertices_count) {
+            GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+            goto failure;
+        }
+        welded_indices[i] = weld_remap[index];
+    }
+
+    if(stats != NULL) {
+        stats->vertices_before = vertices_count;
+        if(indices != NULL) {
+            stats->acmr_before = glxt_mesh_acmr(indices, indices_count, vertices_count, GLXT_MESH_CACHE_SIZE);
+        } else {
+            // An unindexed list transforms every vertex of every triangle
+            stats->acmr_before = indices_count > 0 ? 3.0f : 0.0f;
+        }
+    }
+
+    if(!glxt_mesh_optimize_vertex_cache(ordered_indices, welded_indices, indices_count, welded_count))
+        goto failure;
+    mesh->vertices_count = glxt_mesh_optimize_vertex_fetch(mesh->vertices, ordered_indices, indices_count,
+        welded, vertex_size, welded_count);
+
+    mesh->vertex_size = vertex_size;
+    mesh->indices_count = indices_count;
+    mesh->index_type = glxt_mesh_index_type(mesh->vertices_count);
+    mesh->index_size = glxt_mesh_index_size(mesh->index_type);
+    if(mesh->index_type == GL_UNSIGNED_INT) {
+        // Already in the right format, hand the array over
+        mesh->indices = ordered_indices;
+        ordered_indices = NULL;
+    } else {
+        mesh->indices = malloc(mesh->index_size * indices_count);
+        if(mesh->indices == NULL) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            goto failure;
+        }
+        glxt_mesh_pack_indices(mesh->indices, ordered_indices, indices_count, mesh->index_type);
+    }
+
+    if(stats != NULL) {
+        stats->vertices_after = mesh->vertices_count;
+        stats->acmr_after = glxt_mesh_acmr(ordered_indices != NULL ? ordered_indices : mesh->indices,
+            indices_count, mesh->vertices_count, GLXT_MESH_CACHE_SIZE);
+    }
+
+    free(welded);
+    free(weld_remap);
+    free(welded_indices);
+    free(ordered_indices);
+    return true;
+
+failure:
+    free(welded);
+    free(weld_remap);
+    free(welded_indices);
+    free(ordered_indices);
+    glxt_mesh_free(mesh);
+    return false;
+}
+
+void glxt_mesh_free(GLXTMesh* mesh)
+{
+    if(mesh == NULL) return;
+    free(mesh->vertices);
+    free(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+#define _GLXT_MESH_FILE_MAGIC 0x534D5847 // "GXMS"
+#define _GLXT_MESH_FILE_VERSION 1
+
+static size_t _glxt_mesh_align(size_t offset)
+{
+    return (offset + GLXT_MESH_FILE_ALIGNMENT - 1) & ~(size_t)(GLXT_MESH_FILE_ALIGNMENT - 1);
+}
+
+static bool _glxt_mesh_write_padded(FILE* f, const void* data, size_t size, size_t* offset)
+{
+    static const uint8_t zeros[GLXT_MESH_FILE_ALIGNMENT] = {0};
+    size_t padding = _glxt_mesh_align(*offset) - *offset;
+    if(padding > 0 && fwrite(zeros, padding, 1, f) != 1) return false;
+    if(size > 0 && fwrite(data, size, 1, f) != 1) return false;
+    *offset += padding + size;
+    return true;
+}
+
+bool glxt_mesh_save(const GLXTMesh* mesh, const GLXTMeshAttrib* attribs, size_t attribs_count, const char* path)
+{
+    if(mesh == NULL || path == NULL || (attribs == NULL && attribs_count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(attribs_count > GLXT_MESH_FILE_MAXIMUM_ATTRIBS) {
+        GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+        return false;
+    }
+
+    GLXTMeshFileHeader header = {0};
+    header.magic = _GLXT_MESH_FILE_MAGIC;
+    header.version = _GLXT_MESH_FILE_VERSION;
+    header.vertex_size = (uint32_t)mesh->vertex_size;
+    header.index_type = mesh->index_type;
+    header.vertices_count = mesh->vertices_count;
+    header.indices_count = mesh->indices_count;
+    header.attribs_count = (uint32_t)attribs_count;
+    if(attribs_count > 0) memcpy(header.attribs, attribs, sizeof(GLXTMeshAttrib) * attribs_count);
+
+    size_t vertices_size = mesh->vertex_size * mesh->vertices_count;
+    size_t indices_size = glxt_mesh_index_size(mesh->index_type) * mesh->indices_count;
+    header.vertices_offset = _glxt_mesh_align(sizeof(header));
+    header.indices_offset = _glxt_mesh_align(header.vertices_offset + vertices_size);
+
+    if(attribs_count > 0 && attribs[0].comp_count == 3 && attribs[0].attr_type == GL_FLOAT) {
+        for(size_t k = 0; k < 3; ++k) {
+            header.bounds_min[k] = mesh->vertices_count > 0 ? INFINITY : 0.0f;
+            header.bounds_max[k] = mesh->vertices_count > 0 ? -INFINITY : 0.0f;
+        }
+        for(size_t i = 0; i < mesh->vertices_count; ++i) {
+            float position[3];
+            memcpy(position, (const uint8_t*)mesh->vertices + i * mesh->vertex_size + attribs[0].offset,
+                sizeof(position));
+            for(size_t k = 0; k < 3; ++k) {
+                if(position[k] < header.bounds_min[k]) header.bounds_min[k] = position[k];
+                if(position[k] > header.bounds_max[k]) header.bounds_max[k] = position[k];
+            }
+        }
+    }
+
+    char temp_path[GLXT_MAXIMUM_PATH];
+    if(snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) {
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+    FILE* f = fopen(temp_path, "wb");
+    if(f == NULL) {
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+
+    size_t offset = 0;
+    bool written = _glxt_mesh_write_padded(f, &header, sizeof(header), &offset)
+        && _glxt_mesh_write_padded(f, mesh->vertices, vertices_size, &offset)
+        && _glxt_mesh_write_padded(f, mesh->indices, indices_size, &offset);
+    written = fclose(f) == 0 && written;
+
+    if(!written || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        GLXT.last_failure = GLXT_FAILED_TO_WRITE_FILE;
+        return false;
+    }
+    return true;
+}
+
+// Bytes per component of a vertex attribute type, 0 for types a mesh file may not use
+static size_t _glxt_mesh_attrib_type_size(uint32_t attr_type)
+{
+    switch(attr_type) {
+        case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+        case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: return 2;
+        case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+bool glxt_mesh_file_open(GLXTMeshFile* file, const char* path)
+{
+    if(file == NULL || path == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(file, 0, sizeof(*file));
+    if(!glxt_load_file(path, &file->view)) return false;
+
+    // Every size is checked against the file before anything points into it
+    const GLXTMeshFileHeader* header = (const GLXTMeshFileHeader*)file->view.data;
+    size_t file_size = file->view.size;
+    size_t index_size = 0;
+    bool valid = file_size >= sizeof(GLXTMeshFileHeader)
+        && header->magic == _GLXT_MESH_FILE_MAGIC
+        && header->version == _GLXT_MESH_FILE_VERSION
+        && header->attribs_count <= GLXT_MESH_FILE_MAXIMUM_ATTRIBS
+        && header->vertex_size > 0;
+    // glxt_mesh_index_size maps unknown types to 4, the type goes straight to glDrawElements
+    if(valid) {
+        valid = header->index_type == GL_UNSIGNED_BYTE || header->index_type == GL_UNSIGNED_SHORT
+            || header->index_type == GL_UNSIGNED_INT;
+    }
+    if(valid) {
+        index_size = glxt_mesh_index_size(header->index_type);
+        valid = header->vertices_offset % GLXT_MESH_FILE_ALIGNMENT == 0
+            && header->indices_offset % GLXT_MESH_FILE_ALIGNMENT == 0
+            && header->vertices_offset <= file_size
+            && header->indices_offset <= file_size
+            && header->vertices_count <= (file_size - header->vertices_offset) / header->vertex_size
+            && header->indices_count <= (file_size - header->indices_offset) / index_size;
+    }
+    for(uint32_t i = 0; valid && i < header->attribs_count; ++i) {
+        const GLXTMeshAttrib* attrib = &header->attribs[i];
+        size_t component_size = _glxt_mesh_attrib_type_size(attrib->attr_type);
+        valid = component_size != 0 && attrib->comp_count >= 1 && attrib->comp_count <= 4
+            && (uint64_t)attrib->offset + attrib->comp_count * component_size <= header->vertex_size;
+    }
+
+    if(!valid) {
+        glxt_release_file(&file->view);
+        GLXT.last_failure = GLXT_MESH_INVALID_FILE;
+        return false;
+    }
+
+    file->header = header;
+    file->vertices = file->view.data + header->vertices_offset;
+    file->indices = file->view.data + header->indices_offset;
+    return true;
+}
+
+void glxt_mesh_file_close(GLXTMeshFile* file)
+{
+    if(file == NULL) return;
+    glxt_release_file(&file->view);
+    memset(file, 0, sizeof(*file));
+}
+
+bool glxt_mesh_file_upload(const GLXTMeshFile* file, GLXTMeshBuffers* buffers)
+{
+    if(file == NULL || file->header == NULL || buffers == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    const GLXTMeshFileHeader* header = file->header;
+    memset(buffers, 0, sizeof(*buffers));
+
+    buffers->vao = glxt_create_vertex_array();
+    glxt_enable_vertex_array(buffers->vao);
+    buffers->vbo = glxt_create_vertex_buffer(header->vertex_size * header->vertices_count, file->vertices);
+    buffers->ibo = glxt_create_index_buffer(glxt_mesh_index_size(header->index_type) * header->indices_count,
+        file->indices);
+    for(uint32_t i = 0; i < header->attribs_count; ++i) {
+        const GLXTMeshAttrib* attrib = &header->attribs[i];
+        glxt_set_vertex_attrib(attrib->index, (int)attrib->comp_count, (int)attrib->attr_type,
+            attrib->normalized != 0, header->vertex_size, (const void*)(uintptr_t)attrib->offset);
+    }
+    glxt_disable_vertex_array();
+
+    buffers->index_type = header->index_type;
+    buffers->indices_count = (int)header->indices_count;
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return buffers->vao != 0 && buffers->vbo != 0 && buffers->ibo != 0;
+}
+
+void glxt_mesh_buffers_destroy(GLXTMeshBuffers* buffers)
+{
+    if(buffers == NULL) return;
+    if(buffers->ibo != 0) glxt_destroy_index_buffer(buffers->ibo);
+    if(buffers->vbo != 0) glxt_destroy_vertex_buffer(buffers->vbo);
+    if(buffers->vao != 0) glxt_destroy_vertex_array(buffers->vao);
+    memset(buffers, 0, sizeof(*buffers));
+}
+
+#endif // GLXT_MESH_IMPLEMENTATION
@@ -0,0 +1,409 @@
+/**
+ * glxt_profiler works like glxt: define GLXT_PROFILER_IMPLEMENTATION in
+ * the file where glxt is implemented, after the glxt implementation.
+ * GLXT_PROFILER_ENABLED must have the same value everywhere glxt.h is
+ * included, when it is 0 (the default) every GLXT_PROFILE_* macro
+ * expands to nothing and no profiler code is compiled.
+ *
+ * Frame profiling.
+ * CPU scopes nest and are timed with GLXT_PROFILER_TIMER (glfwGetTimerValue
+ * by default). GPU scopes use GL_TIME_ELAPSED queries when the context
+ * supports timer queries (GL 3.3 or GL_EXT_disjoint_timer_query); they are
+ * kept in a ring of GLXT_PROFILER_GPU_FRAMES frames and read back that many
+ * frames later, results that are still not available are dropped instead
+ * of stalling. GPU scopes do not nest. Every frame also records the glxt
+ * frame counters. Everything can be exported as a Chrome trace
+ * (chrome://tracing or ui.perfetto.dev).
+ *
+ * Scope names are stored by pointer, pass string literals.
+ * The profiler must be used from the GL thread only.
+ */
+#ifndef GLXT_PROFILER_H
+#define GLXT_PROFILER_H
+
+#include "glxt.h"
+
+#if GLXT_PROFILER_ENABLED
+
+#ifndef GLXT_PROFILER_MAXIMUM_EVENTS
+    #define GLXT_PROFILER_MAXIMUM_EVENTS 65536
+#endif
+
+#ifndef GLXT_PROFILER_MAXIMUM_FRAMES
+    #define GLXT_PROFILER_MAXIMUM_FRAMES 1024
+#endif
+
+#ifndef GLXT_PROFILER_MAXIMUM_DEPTH
+    #define GLXT_PROFILER_MAXIMUM_DEPTH 32
+#endif
+
+#ifndef GLXT_PROFILER_GPU_FRAMES
+    #define GLXT_PROFILER_GPU_FRAMES 4
+#endif
+
+#ifndef GLXT_PROFILER_MAXIMUM_GPU_SCOPES
+    #define GLXT_PROFILER_MAXIMUM_GPU_SCOPES 16
+#endif
+
+typedef struct GLXTProfilerFrameStats {
+    size_t frame;
+    double cpu_seconds;
+    GLXTFrameCounters counters;
+    // Sum of the GPU scopes of frame gpu_frame, GLXT_PROFILER_GPU_FRAMES behind
+    size_t gpu_frame;
+    double gpu_seconds;
+    size_t gpu_results_dropped;
+    size_t gpu_scopes_skipped;
+} GLXTProfilerFrameStats;
+
+bool glxt_profiler_init(void);
+void glxt_profiler_deinit(void);
+void glxt_profiler_frame_begin(void);
+void glxt_profiler_frame_end(void);
+void glxt_profiler_begin(const char* name);
+void glxt_profiler_end(void);
+void glxt_profiler_gpu_begin(const char* name);
+void glxt_profiler_gpu_end(void);
+bool glxt_profiler_gpu_available(void);
+GLXTProfilerFrameStats glxt_profiler_frame_stats(void);
+bool glxt_profiler_export_chrome_trace(const char* path);
+
+#define GLXT_PROFILER_INIT() glxt_profiler_init()
+#define GLXT_PROFILER_DEINIT() glxt_profiler_deinit()
+#define GLXT_PROFILER_EXPORT(PATH) glxt_profiler_export_chrome_trace(PATH)
+#define GLXT_PROFILE_FRAME_BEGIN() glxt_profiler_frame_begin()
+#define GLXT_PROFILE_FRAME_END() glxt_profiler_frame_end()
+#define GLXT_PROFILE_BEGIN(NAME) glxt_profiler_begin(NAME)
+#define GLXT_PROFILE_END() glxt_profiler_end()
+#define GLXT_PROFILE_GPU_BEGIN(NAME) glxt_profiler_gpu_begin(NAME)
+#define GLXT_PROFILE_GPU_END() glxt_profiler_gpu_end()
+
+#else
+
+#define GLXT_PROFILER_INIT() ((void)0)
+#define GLXT_PROFILER_DEINIT() ((void)0)
+#define GLXT_PROFILER_EXPORT(PATH) ((void)0)
+#define GLXT_PROFILE_FRAME_BEGIN() ((void)0)
+#define GLXT_PROFILE_FRAME_END() ((void)0)
+#define GLXT_PROFILE_BEGIN(NAME) ((void)0)
+#define GLXT_PROFILE_END() ((void)0)
+#define GLXT_PROFILE_GPU_BEGIN(NAME) ((void)0)
+#define GLXT_PROFILE_GPU_END() ((void)0)
+
+#endif // GLXT_PROFILER_ENABLED
+
+#endif // GLXT_PROFILER_H
+
+#if GLXT_PROFILER_ENABLED && defined(GLXT_PROFILER_IMPLEMENTATION) && !defined(GLXT_PROFILER_IMPLEMENTATION_INCLUDED)
+#define GLXT_PROFILER_IMPLEMENTATION_INCLUDED
+
+#ifndef GLXT_PROFILER_TIMER
+    #include <GLFW/glfw3.h>
+    #define GLXT_PROFILER_TIMER() glfwGetTimerValue()
+    #define GLXT_PROFILER_TIMER_FREQUENCY() glfwGetTimerFrequency()
+#endif
+
+#ifndef GL_TIME_ELAPSED_EXT
+    #define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+
+#ifndef GL_GPU_DISJOINT_EXT
+    #define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+typedef struct _GLXTProfilerEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t depth;
+    bool gpu;
+} _GLXTProfilerEvent;
+
+typedef struct _GLXTProfilerFrame {
+    uint64_t start;
+    uint64_t end;
+    GLXTFrameCounters counters;
+} _GLXTProfilerFrame;
+
+static struct {
+    bool initialized;
+    uint64_t origin;
+    uint64_t frequency;
+
+    _GLXTProfilerEvent events[GLXT_PROFILER_MAXIMUM_EVENTS];
+    size_t events_count;
+    _GLXTProfilerFrame frames[GLXT_PROFILER_MAXIMUM_FRAMES];
+    size_t frames_count;
+
+    struct {
+        const char* name;
+        uint64_t start;
+    } stack[GLXT_PROFILER_MAXIMUM_DEPTH];
+    size_t depth;
+    uint64_t frame_start;
+
+    bool gpu_available;
+    bool gpu_disjoint_ext;
+    bool gpu_active;
+    struct {
+        uint32_t queries[GLXT_PROFILER_MAXIMUM_GPU_SCOPES];
+        const char* names[GLXT_PROFILER_MAXIMUM_GPU_SCOPES];
+        uint64_t starts[GLXT_PROFILER_MAXIMUM_GPU_SCOPES];
+        size_t count;
+        size_t frame;
+    } gpu_frames[GLXT_PROFILER_GPU_FRAMES];
+
+    GLXTProfilerFrameStats stats;
+} GLXT_PROFILER = {0};
+
+static uint64_t _glxt_profiler_now(void)
+{
+    return (uint64_t)GLXT_PROFILER_TIMER();
+}
+
+// Events live in a ring, the oldest ones are overwritten when it is full
+static void _glxt_profiler_push_event(const char* name, uint64_t start, uint64_t end, uint32_t depth, bool gpu)
+{
+    _GLXTProfilerEvent* event = &GLXT_PROFILER.events[GLXT_PROFILER.events_count % GLXT_PROFILER_MAXIMUM_EVENTS];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    event->depth = depth;
+    event->gpu = gpu;
+    GLXT_PROFILER.events_count += 1;
+}
+
+bool glxt_profiler_init(void)
+{
+    memset(&GLXT_PROFILER, 0, sizeof(GLXT_PROFILER));
+    GLXT_PROFILER.frequency = (uint64_t)GLXT_PROFILER_TIMER_FREQUENCY();
+    GLXT_PROFILER.origin = _glxt_profiler_now();
+
+    // Timer queries are core since desktop GL 3.3, GLES needs the extension
+    const char* version = (const char*)glGetString(GL_VERSION);
+    bool is_gles = version != NULL && strncmp(version, "OpenGL ES", 9) == 0;
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if(is_gles) {
+        GLXT_PROFILER.gpu_disjoint_ext = _glxt_has_extension("GL_EXT_disjoint_timer_query");
+        GLXT_PROFILER.gpu_available = GLXT_PROFILER.gpu_disjoint_ext;
+    } else {
+        GLXT_PROFILER.gpu_available = major > 3 || (major == 3 && minor >= 3)
+            || _glxt_has_extension("GL_ARB_timer_query");
+    }
+    // Drain errors from the version queries on contexts that lack them
+    while(glGetError() != GL_NO_ERROR);
+
+    if(GLXT_PROFILER.gpu_available) {
+        for(size_t i = 0; i < GLXT_PROFILER_GPU_FRAMES; ++i)
+            glGenQueries(GLXT_PROFILER_MAXIMUM_GPU_SCOPES, GLXT_PROFILER.gpu_frames[i].queries);
+    }
+
+    GLXT_PROFILER.initialized = true;
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_profiler_deinit(void)
+{
+    if(!GLXT_PROFILER.initialized) return;
+    if(GLXT_PROFILER.gpu_active) glEndQuery(GL_TIME_ELAPSED_EXT);
+    if(GLXT_PROFILER.gpu_available) {
+        for(size_t i = 0; i < GLXT_PROFILER_GPU_FRAMES; ++i)
+            glDeleteQueries(GLXT_PROFILER_MAXIMUM_GPU_SCOPES, GLXT_PROFILER.gpu_frames[i].queries);
+    }
+    GLXT_PROFILER.initialized = false;
+}
+
+static void _glxt_profiler_resolve_gpu_frame(size_t slot, bool disjoint)
+{
+    GLXTProfilerFrameStats* stats = &GLXT_PROFILER.stats;
+    size_t count = GLXT_PROFILER.gpu_frames[slot].count;
+    if(count == 0) return;
+
+    bool available = !disjoint;
+    for(size_t i = 0; available && i < count; ++i) {
+        uint32_t ready = 0;
+        glGetQueryObjectuiv(GLXT_PROFILER.gpu_frames[slot].queries[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+        available = ready != 0;
+    }
+    if(!available) {
+        stats->gpu_results_dropped += count;
+        return;
+    }
+
+    // 32 bit results cover scopes up to ~4 seconds, plenty for a frame
+    double total = 0.0;
+    for(size_t i = 0; i < count; ++i) {
+        uint32_t nanoseconds = 0;
+        glGetQueryObjectuiv(GLXT_PROFILER.gpu_frames[slot].queries[i], GL_QUERY_RESULT, &nanoseconds);
+        uint64_t start = GLXT_PROFILER.gpu_frames[slot].starts[i];
+        uint64_t duration = (uint64_t)((double)nanoseconds * 1e-9 * GLXT_PROFILER.frequency);
+        _glxt_profiler_push_event(GLXT_PROFILER.gpu_frames[slot].names[i], start, start + duration, 0, true);
+        total += nanoseconds * 1e-9;
+    }
+    stats->gpu_frame = GLXT_PROFILER.gpu_frames[slot].frame;
+    stats->gpu_seconds = total;
+}
+
+void glxt_profiler_frame_begin(void)
+{
+    if(!GLXT_PROFILER.initialized) return;
+
+    GLXT_PROFILER.frame_start = _glxt_profiler_now();
+    GLXT_PROFILER.depth = 0;
+    glxt_reset_frame_counters();
+
+    if(GLXT_PROFILER.gpu_available) {
+        // A disjoint event (frequency change, context loss) invalidates everything in flight
+        int disjoint = 0;
+        if(GLXT_PROFILER.gpu_disjoint_ext) glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+        size_t slot = GLXT_PROFILER.stats.frame % GLXT_PROFILER_GPU_FRAMES;
+        _glxt_profiler_resolve_gpu_frame(slot, disjoint != 0);
+        GLXT_PROFILER.gpu_frames[slot].count = 0;
+        GLXT_PROFILER.gpu_frames[slot].frame = GLXT_PROFILER.stats.frame;
+    }
+}
+
+void glxt_profiler_frame_end(void)
+{
+    if(!GLXT_PROFILER.initialized) return;
+    if(GLXT_PROFILER.gpu_active) glxt_profiler_gpu_end();
+    while(GLXT_PROFILER.depth > 0) glxt_profiler_end();
+
+    uint64_t end = _glxt_profiler_now();
+    _GLXTProfilerFrame* frame = &GLXT_PROFILER.frames[GLXT_PROFILER.frames_count % GLXT_PROFILER_MAXIMUM_FRAMES];
+    frame->start = GLXT_PROFILER.frame_start;
+    frame->end = end;
+    frame->counters = glxt_frame_counters();
+    GLXT_PROFILER.frames_count += 1;
+    _glxt_profiler_push_event("frame", GLXT_PROFILER.frame_start, end, 0, false);
+
+    GLXT_PROFILER.stats.cpu_seconds = (double)(end - GLXT_PROFILER.frame_start) / GLXT_PROFILER.frequency;
+    GLXT_PROFILER.stats.counters = frame->counters;
+    GLXT_PROFILER.stats.frame += 1;
+}
+
+void glxt_profiler_begin(const char* name)
+{
+    if(GLXT_PROFILER.depth >= GLXT_PROFILER_MAXIMUM_DEPTH) {
+        // Still counted so the matching end pops the right scope
+        GLXT_PROFILER.depth += 1;
+        return;
+    }
+    GLXT_PROFILER.stack[GLXT_PROFILER.depth].name = name;
+    GLXT_PROFILER.stack[GLXT_PROFILER.depth].start = _glxt_profiler_now();
+    GLXT_PROFILER.depth += 1;
+}
+
+void glxt_profiler_end(void)
+{
+    if(GLXT_PROFILER.depth == 0) return;
+    GLXT_PROFILER.depth -= 1;
+    if(GLXT_PROFILER.depth >= GLXT_PROFILER_MAXIMUM_DEPTH) return;
+
+    size_t depth = GLXT_PROFILER.depth;
+    _glxt_profiler_push_event(GLXT_PROFILER.stack[depth].name, GLXT_PROFILER.stack[depth].start,
+        _glxt_profiler_now(), (uint32_t)depth + 1, false);
+}
+
+void glxt_profiler_gpu_begin(const char* name)
+{
+    size_t slot = GLXT_PROFILER.stats.frame % GLXT_PROFILER_GPU_FRAMES;
+    if(!GLXT_PROFILER.gpu_available || GLXT_PROFILER.gpu_active
+        || GLXT_PROFILER.gpu_frames[slot].count >= GLXT_PROFILER_MAXIMUM_GPU_SCOPES) {
+        GLXT_PROFILER.stats.gpu_scopes_skipped += 1;
+        return;
+    }
+
+    size_t index = GLXT_PROFILER.gpu_frames[slot].count++;
+    GLXT_PROFILER.gpu_frames[slot].names[index] = name;
+    GLXT_PROFILER.gpu_frames[slot].starts[index] = _glxt_profiler_now();
+    glBeginQuery(GL_TIME_ELAPSED_EXT, GLXT_PROFILER.gpu_frames[slot].queries[index]);
+    GLXT_PROFILER.gpu_active = true;
+}
+
+void glxt_profiler_gpu_end(void)
+{
+    if(!GLXT_PROFILER.gpu_active) return;
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    GLXT_PROFILER.gpu_active = false;
+}
+
+bool glxt_profiler_gpu_available(void)
+{
+    return GLXT_PROFILER.gpu_available;
+}
+
+GLXTProfilerFrameStats glxt_profiler_frame_stats(void)
+{
+    return GLXT_PROFILER.stats;
+}
+
+static double _glxt_profiler_microseconds(uint64_t ticks)
+{
+    return (double)(ticks - GLXT_PROFILER.origin) * 1e6 / GLXT_PROFILER.frequency;
+}
+
+static void _glxt_profiler_write_name(FILE* f, const char* name)
+{
+    fputc('"', f);
+    for(const char* c = name; *c != '\0'; ++c) {
+        if(*c == '"' || *c == '\\') fputc('\\', f);
+        if((unsigned char)*c >= 0x20) fputc(*c, f);
+    }
+    fputc('"', f);
+}
+
+/**
+ * CPU scopes go to thread 1, GPU scopes to thread 2 (placed at the CPU
+ * time their query began) and the frame counters become counter tracks.
+ */
+bool glxt_profiler_export_chrome_trace(const char* path)
+{
+    if(path == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) {
+        GLXT.last_failure = GLXT_FAILED_TO_OPEN_FILE;
+        return false;
+    }
+
+    fputs("{\"traceEvents\":[\n", f);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n", f);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}", f);
+
+    size_t events_count = GLXT_PROFILER.events_count < GLXT_PROFILER_MAXIMUM_EVENTS
+        ? GLXT_PROFILER.events_count : GLXT_PROFILER_MAXIMUM_EVENTS;
+    for(size_t i = GLXT_PROFILER.events_count - events_count; i < GLXT_PROFILER.events_count; ++i) {
+        const _GLXTProfilerEvent* event = &GLXT_PROFILER.events[i % GLXT_PROFILER_MAXIMUM_EVENTS];
+        fputs(",\n{\"name\":", f);
+        _glxt_profiler_write_name(f, event->name);
+        fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            event->gpu ? 2 : 1, _glxt_profiler_microseconds(event->start),
+            (double)(event->end - event->start) * 1e6 / GLXT_PROFILER.frequency);
+    }
+
+    size_t frames_count = GLXT_PROFILER.frames_count < GLXT_PROFILER_MAXIMUM_FRAMES
+        ? GLXT_PROFILER.frames_count : GLXT_PROFILER_MAXIMUM_FRAMES;
+    for(size_t i = GLXT_PROFILER.frames_count - frames_count; i < GLXT_PROFILER.frames_count; ++i) {
+        const _GLXTProfilerFrame* frame = &GLXT_PROFILER.frames[i % GLXT_PROFILER_MAXIMUM_FRAMES];
+        fprintf(f, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+            "\"args\":{\"draw_calls\":%zu,\"vertices\":%zu,\"bytes_uploaded\":%zu}}",
+            _glxt_profiler_microseconds(frame->start), frame->counters.draw_calls,
+            frame->counters.vertices, frame->counters.bytes_uploaded);
+    }
+    fputs("\n]}\n", f);
+
+    if(fclose(f) != 0) {
+        GLXT.last_failure = GLXT_FAILED_TO_WRITE_FILE;
+        return false;
+    }
+    return true;
+}
+
+#endif // GLXT_PROFILER_IMPLEMENTATION
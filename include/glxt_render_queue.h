@@ -0,0 +1,371 @@
+/**
+ * glxt_render_queue works like glxt: define GLXT_RENDER_QUEUE_IMPLEMENTATION
+ * in the file where glxt is implemented, after the glxt implementation.
+ *
+ * Render queue.
+ * Draws are pushed in any order with their state (program, vertex array,
+ * texture, per draw uniforms) and a few sort fields, and drawn on flush in
+ * the order of a packed 64 bit key, sorted with a radix sort:
+ *
+ *   opaque       layer:4 | 0 | program:12 | texture:12 | material:12 | depth:23
+ *   translucent  layer:4 | 1 | ~depth:23  | program:12 | texture:12 | material:12
+ *
+ * Within a layer, opaque draws come first, grouped by state and front to
+ * back inside a group so early depth testing rejects more; translucent
+ * draws follow back to front, which blending needs. Program and texture
+ * names only contribute their low 12 bits, colliding names sort together
+ * but are still bound correctly. material is any id the application uses
+ * for draws sharing uniforms; sorted together, the glxt uniform cache
+ * elides the repeated uploads. depth is the view depth mapped to [0, 1].
+ *
+ * Translucent draws are blended with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+ * without writing depth. Flushing leaves blending off and depth writes on.
+ */
+#ifndef GLXT_RENDER_QUEUE_H
+#define GLXT_RENDER_QUEUE_H
+
+#include "glxt.h"
+
+#define GLXT_RENDER_QUEUE_LAYERS 16
+
+typedef struct GLXTRenderUniform {
+    GLXTUniform uniform;
+    const void* data;
+    int count;
+    // Bytes copied from data, at least count elements of the uniform's type
+    size_t size;
+} GLXTRenderUniform;
+
+typedef struct GLXTRenderDraw {
+    uint32_t layer;
+    bool translucent;
+    uint32_t material;
+    float depth;
+
+    uint32_t shader_program;
+    uint32_t vao;
+    // Bound to unit 0, 0 leaves the unit alone
+    uint32_t texture;
+
+    uint32_t mode;
+    // 0 draws arrays from first, otherwise elements from the byte offset
+    uint32_t index_type;
+    int first;
+    int count;
+    size_t offset;
+    // 0 is not instanced
+    int instances_count;
+} GLXTRenderDraw;
+
+/**
+ * State changes the queued draws cause in the order they were pushed and
+ * in sorted order, counted when the value differs from the previous draw,
+ * plus what the glxt state shadow actually issued during the flush.
+ */
+typedef struct GLXTRenderQueueStats {
+    size_t draws;
+    size_t program_changes_submitted;
+    size_t program_changes_sorted;
+    size_t texture_changes_submitted;
+    size_t texture_changes_sorted;
+    size_t vertex_array_changes_submitted;
+    size_t vertex_array_changes_sorted;
+    size_t material_changes_submitted;
+    size_t material_changes_sorted;
+    size_t state_calls;
+    size_t state_calls_elided;
+} GLXTRenderQueueStats;
+
+typedef struct _GLXTRenderItem {
+    GLXTRenderDraw draw;
+    size_t uniforms_offset;
+    size_t uniforms_count;
+} _GLXTRenderItem;
+
+typedef struct _GLXTRenderSortEntry {
+    uint64_t key;
+    uint32_t item;
+} _GLXTRenderSortEntry;
+
+typedef struct GLXTRenderQueue {
+    _GLXTRenderItem* items;
+    size_t items_count;
+    size_t items_capacity;
+    _GLXTRenderSortEntry* entries;
+    _GLXTRenderSortEntry* scratch;
+    // Uniform values, copied when pushed
+    uint8_t* data;
+    size_t data_size;
+    size_t data_capacity;
+    GLXTRenderQueueStats stats;
+} GLXTRenderQueue;
+
+void glxt_render_queue_init(GLXTRenderQueue* queue);
+void glxt_render_queue_deinit(GLXTRenderQueue* queue);
+void glxt_render_queue_reset(GLXTRenderQueue* queue);
+uint64_t glxt_render_key(const GLXTRenderDraw* draw);
+bool glxt_render_queue_push(GLXTRenderQueue* queue, const GLXTRenderDraw* draw,
+    const GLXTRenderUniform* uniforms, size_t uniforms_count);
+// Sorts, draws and empties the queue
+void glxt_render_queue_flush(GLXTRenderQueue* queue);
+// Of the last flush
+GLXTRenderQueueStats glxt_render_queue_stats(const GLXTRenderQueue* queue);
+
+#endif // GLXT_RENDER_QUEUE_H
+
+#if defined(GLXT_RENDER_QUEUE_IMPLEMENTATION) && !defined(GLXT_RENDER_QUEUE_IMPLEMENTATION_INCLUDED)
+#define GLXT_RENDER_QUEUE_IMPLEMENTATION_INCLUDED
+
+// Uniform values are stored after this header, padded to 8 bytes
+typedef struct _GLXTRenderUniformHeader {
+    GLXTUniform uniform;
+    int count;
+    uint32_t size;
+    uint32_t padding;
+} _GLXTRenderUniformHeader;
+
+void glxt_render_queue_init(GLXTRenderQueue* queue)
+{
+    memset(queue, 0, sizeof(*queue));
+}
+
+void glxt_render_queue_deinit(GLXTRenderQueue* queue)
+{
+    free(queue->items);
+    free(queue->entries);
+    free(queue->scratch);
+    free(queue->data);
+    memset(queue, 0, sizeof(*queue));
+}
+
+void glxt_render_queue_reset(GLXTRenderQueue* queue)
+{
+    queue->items_count = 0;
+    queue->data_size = 0;
+}
+
+uint64_t glxt_render_key(const GLXTRenderDraw* draw)
+{
+    float depth = draw->depth < 0.0f ? 0.0f : (draw->depth > 1.0f ? 1.0f : draw->depth);
+    uint64_t layer = draw->layer < GLXT_RENDER_QUEUE_LAYERS ? draw->layer : GLXT_RENDER_QUEUE_LAYERS - 1;
+    uint64_t depth_bits = (uint64_t)(depth * (float)0x7FFFFF) & 0x7FFFFF;
+    uint64_t program = draw->shader_program & 0xFFF;
+    uint64_t texture = draw->texture & 0xFFF;
+    uint64_t material = draw->material & 0xFFF;
+
+    uint64_t key = layer << 60;
+    if(draw->translucent) {
+        key |= (uint64_t)1 << 59;
+        key |= (0x7FFFFF - depth_bits) << 36;
+        key |= program << 24 | texture << 12 | material;
+    } else {
+        key |= program << 47 | texture << 35 | material << 23 | depth_bits;
+    }
+    return key;
+}
+
+static bool _glxt_render_queue_reserve(GLXTRenderQueue* queue, size_t data_size)
+{
+    if(queue->items_count == queue->items_capacity) {
+        size_t capacity = queue->items_capacity == 0 ? 256 : queue->items_capacity * 2;
+        _GLXTRenderItem* items = realloc(queue->items, sizeof(_GLXTRenderItem) * capacity);
+        if(items == NULL) return false;
+        queue->items = items;
+        _GLXTRenderSortEntry* entries = realloc(queue->entries, sizeof(_GLXTRenderSortEntry) * capacity);
+        if(entries == NULL) return false;
+        queue->entries = entries;
+        _GLXTRenderSortEntry* scratch = realloc(queue->scratch, sizeof(_GLXTRenderSortEntry) * capacity);
+        if(scratch == NULL) return false;
+        queue->scratch = scratch;
+        queue->items_capacity = capacity;
+    }
+    if(queue->data_size + data_size > queue->data_capacity) {
+        size_t capacity = queue->data_capacity == 0 ? 4096 : queue->data_capacity;
+        while(capacity < queue->data_size + data_size) capacity *= 2;
+        uint8_t* data = realloc(queue->data, capacity);
+        if(data == NULL) return false;
+        queue->data = data;
+        queue->data_capacity = capacity;
+    }
+    return true;
+}
+
+bool glxt_render_queue_push(GLXTRenderQueue* queue, const GLXTRenderDraw* draw,
+    const GLXTRenderUniform* uniforms, size_t uniforms_count)
+{
+    if(queue == NULL || draw == NULL || (uniforms == NULL && uniforms_count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+
+    size_t data_size = 0;
+    for(size_t i = 0; i < uniforms_count; ++i) {
+        if(uniforms[i].data == NULL) {
+            GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+            return false;
+        }
+        // The flush reads count elements, a shorter payload would read into the next one
+        size_t needed = 0;
+        if(!_glxt_uniform_data_size(uniforms[i].uniform, uniforms[i].count, &needed)) {
+            GLXT.last_failure = GLXT_INVALID_UNIFORM_HANDLE;
+            return false;
+        }
+        if(uniforms[i].size < needed) {
+            GLXT.last_failure = GLXT_UNIFORM_DATA_TOO_SMALL;
+            return false;
+        }
+        data_size += (sizeof(_GLXTRenderUniformHeader) + uniforms[i].size + 7) & ~(size_t)7;
+    }
+    if(queue->items_count >= UINT32_MAX || !_glxt_render_queue_reserve(queue, data_size)) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    _GLXTRenderItem* item = &queue->items[queue->items_count];
+    item->draw = *draw;
+    item->uniforms_offset = queue->data_size;
+    item->uniforms_count = uniforms_count;
+    for(size_t i = 0; i < uniforms_count; ++i) {
+        _GLXTRenderUniformHeader* header = (_GLXTRenderUniformHeader*)(queue->data + queue->data_size);
+        header->uniform = uniforms[i].uniform;
+        header->count = uniforms[i].count;
+        header->size = (uint32_t)uniforms[i].size;
+        header->padding = 0;
+        memcpy(header + 1, uniforms[i].data, uniforms[i].size);
+        queue->data_size += (sizeof(_GLXTRenderUniformHeader) + uniforms[i].size + 7) & ~(size_t)7;
+    }
+
+    queue->entries[queue->items_count].key = glxt_render_key(draw);
+    queue->entries[queue->items_count].item = (uint32_t)queue->items_count;
+    queue->items_count += 1;
+    return true;
+}
+
+/**
+ * Least significant digit first, 8 bits per pass, so it is stable and
+ * equal keys keep their push order. All histograms come from one read of
+ * the keys, passes where every key has the same digit are skipped.
+ */
+static _GLXTRenderSortEntry* _glxt_render_queue_sort(GLXTRenderQueue* queue)
+{
+    size_t count = queue->items_count;
+    size_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for(size_t i = 0; i < count; ++i) {
+        uint64_t key = queue->entries[i].key;
+        for(size_t pass = 0; pass < 8; ++pass)
+            histograms[pass][(key >> (pass * 8)) & 0xFF] += 1;
+    }
+
+    _GLXTRenderSortEntry* source = queue->entries;
+    _GLXTRenderSortEntry* destination = queue->scratch;
+    for(size_t pass = 0; pass < 8; ++pass) {
+        size_t* histogram = histograms[pass];
+        if(histogram[(source[0].key >> (pass * 8)) & 0xFF] == count) continue;
+
+        size_t offset = 0;
+        for(size_t digit = 0; digit < 256; ++digit) {
+            size_t digit_count = histogram[digit];
+            histogram[digit] = offset;
+            offset += digit_count;
+        }
+        for(size_t i = 0; i < count; ++i)
+            destination[histogram[(source[i].key >> (pass * 8)) & 0xFF]++] = source[i];
+
+        _GLXTRenderSortEntry* swap = source;
+        source = destination;
+        destination = swap;
+    }
+    return source;
+}
+
+static void _glxt_render_queue_count_changes(const GLXTRenderDraw* previous, const GLXTRenderDraw* draw,
+    size_t* programs, size_t* textures, size_t* vertex_arrays, size_t* materials)
+{
+    if(previous == NULL || previous->shader_program != draw->shader_program) *programs += 1;
+    if(draw->texture != 0 && (previous == NULL || previous->texture != draw->texture)) *textures += 1;
+    if(previous == NULL || previous->vao != draw->vao) *vertex_arrays += 1;
+    if(previous == NULL || previous->material != draw->material) *materials += 1;
+}
+
+static void _glxt_render_queue_draw(const GLXTRenderQueue* queue, const _GLXTRenderItem* item)
+{
+    const GLXTRenderDraw* draw = &item->draw;
+    glxt_enable_shader_program(draw->shader_program);
+    glxt_enable_vertex_array(draw->vao);
+    if(draw->texture != 0) glxt_bind_texture2d(0, draw->texture);
+
+    const uint8_t* cursor = queue->data + item->uniforms_offset;
+    for(size_t i = 0; i < item->uniforms_count; ++i) {
+        const _GLXTRenderUniformHeader* header = (const _GLXTRenderUniformHeader*)cursor;
+        glxt_set_uniform(header->uniform, header + 1, header->count);
+        cursor += (sizeof(_GLXTRenderUniformHeader) + header->size + 7) & ~(size_t)7;
+    }
+
+    if(draw->index_type == 0) {
+        if(draw->instances_count > 0)
+            glxt_draw_arrays_instanced(draw->mode, draw->first, draw->count, draw->instances_count);
+        else
+            glxt_draw_arrays(draw->mode, draw->first, draw->count);
+    } else {
+        if(draw->instances_count > 0)
+            glxt_draw_elements_instanced(draw->mode, draw->count, draw->index_type, draw->offset,
+                draw->instances_count);
+        else
+            glxt_draw_elements(draw->mode, draw->count, draw->index_type, draw->offset);
+    }
+}
+
+void glxt_render_queue_flush(GLXTRenderQueue* queue)
+{
+    if(queue == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    GLXTRenderQueueStats stats = {0};
+    stats.draws = queue->items_count;
+    if(queue->items_count == 0) {
+        queue->stats = stats;
+        return;
+    }
+
+    for(size_t i = 0; i < queue->items_count; ++i) {
+        _glxt_render_queue_count_changes(i > 0 ? &queue->items[i - 1].draw : NULL, &queue->items[i].draw,
+            &stats.program_changes_submitted, &stats.texture_changes_submitted,
+            &stats.vertex_array_changes_submitted, &stats.material_changes_submitted);
+    }
+
+    const _GLXTRenderSortEntry* sorted = _glxt_render_queue_sort(queue);
+    GLXTStateStats state_before = glxt_state_stats();
+    const GLXTRenderDraw* previous = NULL;
+    for(size_t i = 0; i < queue->items_count; ++i) {
+        const _GLXTRenderItem* item = &queue->items[sorted[i].item];
+        if(previous == NULL || previous->translucent != item->draw.translucent) {
+            glxt_set_blend(item->draw.translucent, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glxt_set_depth_mask(!item->draw.translucent);
+        }
+        _glxt_render_queue_count_changes(previous, &item->draw,
+            &stats.program_changes_sorted, &stats.texture_changes_sorted,
+            &stats.vertex_array_changes_sorted, &stats.material_changes_sorted);
+        _glxt_render_queue_draw(queue, item);
+        previous = &item->draw;
+    }
+    if(previous->translucent) {
+        glxt_set_blend(false, 0, 0);
+        glxt_set_depth_mask(true);
+    }
+    GLXTStateStats state_after = glxt_state_stats();
+    stats.state_calls = state_after.calls_issued - state_before.calls_issued;
+    stats.state_calls_elided = state_after.calls_elided - state_before.calls_elided;
+
+    queue->stats = stats;
+    glxt_render_queue_reset(queue);
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+GLXTRenderQueueStats glxt_render_queue_stats(const GLXTRenderQueue* queue)
+{
+    return queue->stats;
+}
+
+#endif // GLXT_RENDER_QUEUE_IMPLEMENTATION
@@ -0,0 +1,431 @@
+/**
+ * glxt_shader works like glxt: define GLXT_SHADER_IMPLEMENTATION in the
+ * file where glxt is implemented, after the glxt implementation.
+ *
+ * Shader batches.
+ * glxt_shader_batch_add issues every compile and the link of a program
+ * right away without asking for their status, so the driver can compile
+ * the whole set in parallel while the application keeps rendering.
+ * glxt_shader_batch_poll then finishes the programs that are done: with
+ * GL_KHR_parallel_shader_compile (or the ARB variant) it asks for
+ * GL_COMPLETION_STATUS_KHR, which never blocks; without it, reading the
+ * link status blocks, so at most GLXT_SHADER_BATCH_BLOCKING_PER_POLL
+ * programs are finished per poll. Finished programs are reflected and go
+ * through the program binary cache exactly like glxt_create_shader_program.
+ * Ready programs belong to the caller, glxt_shader_batch_deinit only
+ * deletes the ones that never completed.
+ *
+ * Shader preprocessing.
+ * glxt_shader_preprocess expands #include "name" lines from an in-memory
+ * table and inserts #define lines right after #version, so permutations of
+ * one source are built without touching the file system. The returned
+ * string is allocated with malloc.
+ */
+#ifndef GLXT_SHADER_H
+#define GLXT_SHADER_H
+
+#include "glxt.h"
+
+#ifndef GLXT_SHADER_BATCH_BLOCKING_PER_POLL
+    #define GLXT_SHADER_BATCH_BLOCKING_PER_POLL 1
+#endif
+
+#ifndef GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH
+    #define GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH 16
+#endif
+
+typedef enum GLXTShaderStatus {
+    GLXT_SHADER_PENDING = 0,
+    GLXT_SHADER_READY,
+    GLXT_SHADER_FAILED,
+} GLXTShaderStatus;
+
+typedef struct _GLXTShaderBatchEntry {
+    GLXTShaderStatus status;
+    uint32_t shader_program;
+    uint32_t vert_shader;
+    uint32_t frag_shader;
+    uint64_t cache_key;
+    int failure;
+} _GLXTShaderBatchEntry;
+
+typedef struct GLXTShaderBatch {
+    _GLXTShaderBatchEntry* entries;
+    size_t entries_count;
+    size_t entries_capacity;
+    size_t pending;
+    size_t ready;
+    size_t failed;
+    bool parallel;
+} GLXTShaderBatch;
+
+typedef struct GLXTShaderDefine {
+    const char* name;
+    // NULL defines the name without a value
+    const char* value;
+} GLXTShaderDefine;
+
+typedef struct GLXTShaderInclude {
+    const char* name;
+    const char* source;
+} GLXTShaderInclude;
+
+void glxt_shader_batch_init(GLXTShaderBatch* batch);
+void glxt_shader_batch_deinit(GLXTShaderBatch* batch);
+// Returns an id for the program, 0 on failure
+size_t glxt_shader_batch_add(GLXTShaderBatch* batch, const char* vert_source, const char* frag_source);
+// Returns the number of programs still pending
+size_t glxt_shader_batch_poll(GLXTShaderBatch* batch);
+void glxt_shader_batch_wait(GLXTShaderBatch* batch);
+GLXTShaderStatus glxt_shader_batch_status(const GLXTShaderBatch* batch, size_t id);
+// 0 until the program is ready
+uint32_t glxt_shader_batch_program(const GLXTShaderBatch* batch, size_t id);
+
+char* glxt_shader_preprocess(const char* source, const GLXTShaderDefine* defines, size_t defines_count,
+    const GLXTShaderInclude* includes, size_t includes_count);
+
+#endif // GLXT_SHADER_H
+
+#if defined(GLXT_SHADER_IMPLEMENTATION) && !defined(GLXT_SHADER_IMPLEMENTATION_INCLUDED)
+#define GLXT_SHADER_IMPLEMENTATION_INCLUDED
+
+#ifndef GL_COMPLETION_STATUS_KHR
+    #define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+void glxt_shader_batch_init(GLXTShaderBatch* batch)
+{
+    if(batch == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    memset(batch, 0, sizeof(*batch));
+    batch->parallel = _glxt_has_extension("GL_KHR_parallel_shader_compile")
+        || _glxt_has_extension("GL_ARB_parallel_shader_compile");
+}
+
+static void _glxt_shader_batch_delete(_GLXTShaderBatchEntry* entry)
+{
+    if(entry->vert_shader != 0) glDeleteShader(entry->vert_shader);
+    if(entry->frag_shader != 0) glDeleteShader(entry->frag_shader);
+    entry->vert_shader = 0;
+    entry->frag_shader = 0;
+}
+
+void glxt_shader_batch_deinit(GLXTShaderBatch* batch)
+{
+    if(batch == NULL) return;
+    for(size_t i = 0; i < batch->entries_count; ++i) {
+        _GLXTShaderBatchEntry* entry = &batch->entries[i];
+        if(entry->status != GLXT_SHADER_PENDING) continue;
+        _glxt_shader_batch_delete(entry);
+        glDeleteProgram(entry->shader_program);
+    }
+    free(batch->entries);
+    memset(batch, 0, sizeof(*batch));
+}
+
+size_t glxt_shader_batch_add(GLXTShaderBatch* batch, const char* vert_source, const char* frag_source)
+{
+    if(batch == NULL || vert_source == NULL || frag_source == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    if(batch->entries_count == batch->entries_capacity) {
+        size_t capacity = batch->entries_capacity == 0 ? 16 : batch->entries_capacity * 2;
+        _GLXTShaderBatchEntry* entries = realloc(batch->entries, sizeof(_GLXTShaderBatchEntry) * capacity);
+        if(entries == NULL) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return 0;
+        }
+        batch->entries = entries;
+        batch->entries_capacity = capacity;
+    }
+    _GLXTShaderBatchEntry* entry = &batch->entries[batch->entries_count];
+    memset(entry, 0, sizeof(*entry));
+    batch->entries_count += 1;
+    size_t id = batch->entries_count;
+
+    if(GLXT.program_cache.enabled) {
+        entry->cache_key = _glxt_program_cache_key(vert_source, frag_source);
+        uint32_t shader_program = _glxt_program_cache_load(entry->cache_key);
+        if(shader_program != 0) {
+            _glxt_reflect_shader_program(shader_program);
+            entry->shader_program = shader_program;
+            entry->status = GLXT_SHADER_READY;
+            batch->ready += 1;
+            return id;
+        }
+    }
+
+    // No status query in between, each call only queues work for the driver
+    entry->vert_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(entry->vert_shader, 1, &vert_source, NULL);
+    glCompileShader(entry->vert_shader);
+    entry->frag_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(entry->frag_shader, 1, &frag_source, NULL);
+    glCompileShader(entry->frag_shader);
+
+    entry->shader_program = glCreateProgram();
+    glAttachShader(entry->shader_program, entry->vert_shader);
+    glAttachShader(entry->shader_program, entry->frag_shader);
+    if(GLXT.program_cache.enabled)
+        glProgramParameteri(entry->shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(entry->shader_program);
+
+    entry->status = GLXT_SHADER_PENDING;
+    batch->pending += 1;
+    DEBUG_DO(_glxt_check_opengl_error());
+    return id;
+}
+
+static void _glxt_shader_batch_log(uint32_t object, bool is_program)
+{
+    int length = 0;
+    if(is_program) glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+    else glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+    if(length <= 0) return;
+
+    char* message = glxt_scratch_alloc(length);
+    if(message == NULL) return;
+    if(is_program) glGetProgramInfoLog(object, length, &length, message);
+    else glGetShaderInfoLog(object, length, &length, message);
+    fprintf(stderr, "%s\n", message);
+    glxt_scratch_free(message);
+}
+
+static void _glxt_shader_batch_finish(GLXTShaderBatch* batch, _GLXTShaderBatchEntry* entry)
+{
+    int is_linked = 0;
+    glGetProgramiv(entry->shader_program, GL_LINK_STATUS, &is_linked);
+    batch->pending -= 1;
+
+    if(is_linked == GL_FALSE) {
+        // Only now is it worth asking which stage went wrong
+        int vert_compiled = 0, frag_compiled = 0;
+        glGetShaderiv(entry->vert_shader, GL_COMPILE_STATUS, &vert_compiled);
+        glGetShaderiv(entry->frag_shader, GL_COMPILE_STATUS, &frag_compiled);
+        if(vert_compiled == GL_FALSE) {
+            entry->failure = GLXT_VERTEX_SHADER_COMPILATION_FAILURE;
+            DEBUG_DO(_glxt_shader_batch_log(entry->vert_shader, false));
+        } else if(frag_compiled == GL_FALSE) {
+            entry->failure = GLXT_FRAGMENT_SHADER_COMPILATION_FAILURE;
+            DEBUG_DO(_glxt_shader_batch_log(entry->frag_shader, false));
+        } else {
+            entry->failure = GLXT_SHADER_PROGRAM_LINKING_FAILURE;
+            DEBUG_DO(_glxt_shader_batch_log(entry->shader_program, true));
+        }
+        GLXT.last_failure = entry->failure;
+        _glxt_shader_batch_delete(entry);
+        glDeleteProgram(entry->shader_program);
+        entry->shader_program = 0;
+        entry->status = GLXT_SHADER_FAILED;
+        batch->failed += 1;
+        return;
+    }
+
+    _glxt_shader_batch_delete(entry);
+    if(GLXT.program_cache.enabled) _glxt_program_cache_store(entry->cache_key, entry->shader_program);
+    _glxt_reflect_shader_program(entry->shader_program);
+    entry->status = GLXT_SHADER_READY;
+    batch->ready += 1;
+}
+
+size_t glxt_shader_batch_poll(GLXTShaderBatch* batch)
+{
+    if(batch == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+
+    size_t blocking = 0;
+    for(size_t i = 0; i < batch->entries_count && batch->pending > 0; ++i) {
+        _GLXTShaderBatchEntry* entry = &batch->entries[i];
+        if(entry->status != GLXT_SHADER_PENDING) continue;
+
+        if(batch->parallel) {
+            int completed = 0;
+            glGetProgramiv(entry->shader_program, GL_COMPLETION_STATUS_KHR, &completed);
+            if(completed == GL_FALSE) continue;
+        } else {
+            if(blocking == GLXT_SHADER_BATCH_BLOCKING_PER_POLL) break;
+            blocking += 1;
+        }
+        _glxt_shader_batch_finish(batch, entry);
+    }
+
+    DEBUG_DO(_glxt_check_opengl_error());
+    return batch->pending;
+}
+
+void glxt_shader_batch_wait(GLXTShaderBatch* batch)
+{
+    if(batch == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    for(size_t i = 0; i < batch->entries_count && batch->pending > 0; ++i) {
+        if(batch->entries[i].status == GLXT_SHADER_PENDING)
+            _glxt_shader_batch_finish(batch, &batch->entries[i]);
+    }
+}
+
+GLXTShaderStatus glxt_shader_batch_status(const GLXTShaderBatch* batch, size_t id)
+{
+    if(batch == NULL || id == 0 || id > batch->entries_count) return GLXT_SHADER_FAILED;
+    return batch->entries[id - 1].status;
+}
+
+uint32_t glxt_shader_batch_program(const GLXTShaderBatch* batch, size_t id)
+{
+    if(glxt_shader_batch_status(batch, id) != GLXT_SHADER_READY) return 0;
+    return batch->entries[id - 1].shader_program;
+}
+
+typedef struct _GLXTShaderString {
+    char* data;
+    size_t size;
+    size_t capacity;
+} _GLXTShaderString;
+
+static bool _glxt_shader_append(_GLXTShaderString* string, const char* data, size_t size)
+{
+    if(string->size + size + 1 > string->capacity) {
+        size_t capacity = string->capacity == 0 ? 1024 : string->capacity;
+        while(capacity < string->size + size + 1) capacity *= 2;
+        char* new_data = realloc(string->data, capacity);
+        if(new_data == NULL) return false;
+        string->data = new_data;
+        string->capacity = capacity;
+    }
+    memcpy(string->data + string->size, data, size);
+    string->size += size;
+    string->data[string->size] = '\0';
+    return true;
+}
+
+static bool _glxt_shader_append_defines(_GLXTShaderString* string,
+    const GLXTShaderDefine* defines, size_t defines_count)
+{
+    for(size_t i = 0; i < defines_count; ++i) {
+        bool appended = _glxt_shader_append(string, "#define ", 8)
+            && _glxt_shader_append(string, defines[i].name, strlen(defines[i].name));
+        if(appended && defines[i].value != NULL) {
+            appended = _glxt_shader_append(string, " ", 1)
+                && _glxt_shader_append(string, defines[i].value, strlen(defines[i].value));
+        }
+        if(!appended || !_glxt_shader_append(string, "\n", 1)) return false;
+    }
+    return true;
+}
+
+// Returns the name of an #include line, or NULL when the line is something else
+static const char* _glxt_shader_include_name(const char* line, const char* end, size_t* name_length)
+{
+    while(line < end && (*line == ' ' || *line == '\t')) line += 1;
+    if(line == end || *line != '#') return NULL;
+    line += 1;
+    while(line < end && (*line == ' ' || *line == '\t')) line += 1;
+    if((size_t)(end - line) < 7 || strncmp(line, "include", 7) != 0) return NULL;
+    line += 7;
+    while(line < end && (*line == ' ' || *line == '\t')) line += 1;
+    if(line == end || (*line != '"' && *line != '<')) return NULL;
+
+    char closing = *line == '"' ? '"' : '>';
+    const char* name = ++line;
+    while(line < end && *line != closing) line += 1;
+    if(line == end) return NULL;
+    *name_length = (size_t)(line - name);
+    return name;
+}
+
+static bool _glxt_shader_is_version(const char* line, const char* end)
+{
+    while(line < end && (*line == ' ' || *line == '\t')) line += 1;
+    return (size_t)(end - line) >= 8 && strncmp(line, "#version", 8) == 0;
+}
+
+static bool _glxt_shader_expand(_GLXTShaderString* string, const char* source, size_t depth,
+    const GLXTShaderDefine* defines, size_t defines_count,
+    const GLXTShaderInclude* includes, size_t includes_count)
+{
+    if(depth > GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH) {
+        GLXT.last_failure = GLXT_SHADER_INCLUDE_TOO_DEEP;
+        return false;
+    }
+
+    // Defines go after #version, which must stay first, or at the very top
+    bool defines_pending = depth == 0 && defines_count > 0;
+    if(defines_pending) {
+        const char* first = source;
+        while(*first == '\n' || *first == '\r' || *first == ' ' || *first == '\t') first += 1;
+        const char* first_end = first;
+        while(*first_end != '\0' && *first_end != '\n') first_end += 1;
+        if(!_glxt_shader_is_version(first, first_end)) {
+            if(!_glxt_shader_append_defines(string, defines, defines_count)) goto out_of_memory;
+            defines_pending = false;
+        }
+    }
+
+    for(const char* line = source; *line != '\0';) {
+        const char* end = line;
+        while(*end != '\0' && *end != '\n') end += 1;
+        const char* next = *end == '\n' ? end + 1 : end;
+
+        size_t name_length = 0;
+        const char* name = _glxt_shader_include_name(line, end, &name_length);
+        if(name != NULL) {
+            const GLXTShaderInclude* include = NULL;
+            for(size_t i = 0; i < includes_count; ++i) {
+                if(strlen(includes[i].name) == name_length && strncmp(includes[i].name, name, name_length) == 0) {
+                    include = &includes[i];
+                    break;
+                }
+            }
+            if(include == NULL) {
+                GLXT.last_failure = GLXT_SHADER_INCLUDE_NOT_FOUND;
+                DEBUG_DO(fprintf(stderr, "shader include not found: %.*s\n", (int)name_length, name));
+                return false;
+            }
+            if(!_glxt_shader_expand(string, include->source, depth + 1, NULL, 0, includes, includes_count))
+                return false;
+            if(string->size > 0 && string->data[string->size - 1] != '\n'
+                && !_glxt_shader_append(string, "\n", 1))
+                goto out_of_memory;
+        } else {
+            if(!_glxt_shader_append(string, line, (size_t)(next - line))) goto out_of_memory;
+            if(defines_pending && _glxt_shader_is_version(line, end)) {
+                if(*end == '\0' && !_glxt_shader_append(string, "\n", 1)) goto out_of_memory;
+                if(!_glxt_shader_append_defines(string, defines, defines_count)) goto out_of_memory;
+                defines_pending = false;
+            }
+        }
+        line = next;
+    }
+    return true;
+
+out_of_memory:
+    GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+    return false;
+}
+
+char* glxt_shader_preprocess(const char* source, const GLXTShaderDefine* defines, size_t defines_count,
+    const GLXTShaderInclude* includes, size_t includes_count)
+{
+    if(source == NULL || (defines == NULL && defines_count > 0) || (includes == NULL && includes_count > 0)) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return NULL;
+    }
+
+    _GLXTShaderString string = {0};
+    if(!_glxt_shader_append(&string, "", 0)
+        || !_glxt_shader_expand(&string, source, 0, defines, defines_count, includes, includes_count)) {
+        if(string.data == NULL) GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        free(string.data);
+        return NULL;
+    }
+    return string.data;
+}
+
+#endif // GLXT_SHADER_IMPLEMENTATION
@@ -0,0 +1,849 @@
+/**
+ * glxt_text works like glxt: define GLXT_TEXT_IMPLEMENTATION in the file
+ * where glxt is implemented, after the glxt and glxt_atlas implementations.
+ *
+ * Cached glyphs and batched text.
+ * A font rasterizes each glyph once, the first time it is shaped, into a
+ * single channel glxt_atlas, either as coverage or as a signed distance
+ * field which stays sharp at any scale. Glyphs come from a rasterizer
+ * callback (stb_truetype or any other library fits in a few lines), a
+ * font without one uses the built-in 8x8 ASCII font.
+ *
+ * A text renderer is immediate mode: every frame, glxt_text_begin, one
+ * glxt_text_add per string and glxt_text_draw. Every glyph of the frame
+ * is one instance of a single quad, so text is one instanced draw per
+ * atlas page and font kind. Runs are cached by content and position in
+ * the frame: a run equal to the one added at the same place last frame,
+ * after only equal runs, is neither shaped nor uploaded again, so static
+ * labels cost a hash of their string. Add changing text last to keep the
+ * static text in front of it cached.
+ *
+ * Text is positioned in window pixels, origin at the top left and y down
+ * like GLFW cursor coordinates, from the top left of the first line.
+ */
+#ifndef GLXT_TEXT_H
+#define GLXT_TEXT_H
+
+#include "glxt.h"
+#include "glxt_atlas.h"
+
+#ifndef GLXT_TEXT_ATLAS_SIZE
+    #define GLXT_TEXT_ATLAS_SIZE 1024
+#endif
+
+// The built-in font is upscaled by this much before its distance field is computed
+#ifndef GLXT_TEXT_BUILTIN_SDF_SCALE
+    #define GLXT_TEXT_BUILTIN_SDF_SCALE 4
+#endif
+
+#define GLXT_TEXT_BUILTIN_SIZE 8
+
+typedef struct GLXTGlyphBitmap {
+    uint32_t width, height;
+    // Offset from the pen on the baseline to the top left of the bitmap, y down
+    float bearing_x, bearing_y;
+    float advance;
+    // width * height coverage bytes, top row first, NULL for blank glyphs
+    const uint8_t* pixels;
+} GLXTGlyphBitmap;
+
+/**
+ * Fills glyph for codepoint at the font's pixel_size, the pixels must stay
+ * valid until the next call. Returning false leaves the codepoint blank.
+ */
+typedef bool (*GLXTGlyphRasterizer)(uint32_t codepoint, GLXTGlyphBitmap* glyph, void* user_data);
+
+typedef struct GLXTFontDesc {
+    // NULL uses the built-in font, which sets the metrics itself
+    GLXTGlyphRasterizer rasterize;
+    void* user_data;
+    // Size glyphs are rasterized at and line metrics at that size, in pixels
+    float pixel_size;
+    float ascent;
+    float line_height;
+    bool sdf;
+    // Distance encoded on each side of the outline in atlas pixels, 0 takes 4
+    uint32_t sdf_spread;
+    // Atlas page size, 0 takes GLXT_TEXT_ATLAS_SIZE
+    uint32_t atlas_size;
+} GLXTFontDesc;
+
+typedef struct GLXTGlyph {
+    uint32_t page;
+    // Quad relative to the pen on the baseline in font pixels, empty when blank
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+    float advance;
+} GLXTGlyph;
+
+typedef struct GLXTFont {
+    GLXTFontDesc desc;
+    GLXTAtlas atlas;
+    // Open addressing on codepoint + 1, 0 is a free slot
+    uint32_t* keys;
+    GLXTGlyph* glyphs;
+    size_t glyphs_count;
+    size_t glyphs_capacity;
+    uint32_t builtin_scale;
+    uint8_t builtin_pixels[GLXT_TEXT_BUILTIN_SIZE * GLXT_TEXT_BUILTIN_SIZE
+        * GLXT_TEXT_BUILTIN_SDF_SCALE * GLXT_TEXT_BUILTIN_SDF_SCALE];
+} GLXTFont;
+
+bool glxt_font_init(GLXTFont* font, const GLXTFontDesc* desc);
+void glxt_font_deinit(GLXTFont* font);
+// Rasterizes the glyph on first use, NULL when it does not fit the atlas
+const GLXTGlyph* glxt_font_glyph(GLXTFont* font, uint32_t codepoint);
+// Width of the longest line and height of all lines of UTF-8 text at size pixels
+void glxt_font_measure(GLXTFont* font, const char* text, float size, float* width, float* height);
+
+typedef struct GLXTTextInstance {
+    float rect[4];
+    float uv[4];
+    uint8_t color[4];
+} GLXTTextInstance;
+
+typedef struct GLXTTextStats {
+    size_t runs;
+    size_t runs_cached;
+    size_t glyphs;
+    size_t glyphs_shaped;
+    size_t instances_uploaded;
+    size_t draw_calls;
+} GLXTTextStats;
+
+typedef struct _GLXTTextRun {
+    uint64_t hash;
+    size_t first;
+    size_t count;
+} _GLXTTextRun;
+
+typedef struct _GLXTTextDraw {
+    uint32_t texture;
+    bool sdf;
+    size_t first;
+    size_t count;
+} _GLXTTextDraw;
+
+typedef struct GLXTTextRenderer {
+    uint32_t programs[2];
+    GLXTUniform screen_uniforms[2];
+    uint32_t vao;
+    uint32_t vbo;
+    size_t vbo_capacity;
+
+    GLXTTextInstance* instances;
+    size_t instances_count;
+    size_t instances_capacity;
+    _GLXTTextRun* runs;
+    size_t runs_count;
+    size_t runs_capacity;
+    size_t previous_runs_count;
+    _GLXTTextDraw* draws;
+    size_t draws_count;
+    size_t draws_capacity;
+    // Instances from here on differ from the vertex buffer, SIZE_MAX when none
+    size_t first_changed;
+    bool shaping;
+    // First instance the vertex array's attributes point at
+    size_t attribs_first;
+
+    GLXTTextStats stats;
+} GLXTTextRenderer;
+
+bool glxt_text_renderer_init(GLXTTextRenderer* renderer);
+void glxt_text_renderer_deinit(GLXTTextRenderer* renderer);
+void glxt_text_begin(GLXTTextRenderer* renderer);
+// color is straight alpha RGBA, size is the line height in pixels
+void glxt_text_add(GLXTTextRenderer* renderer, GLXTFont* font, const char* text,
+    float x, float y, float size, const float color[4]);
+/**
+ * Uploads what changed and draws every run added since glxt_text_begin
+ * over a width x height viewport, blended and without depth testing.
+ * Leaves blending off.
+ */
+void glxt_text_draw(GLXTTextRenderer* renderer, uint32_t width, uint32_t height);
+// Counts of the last frame
+GLXTTextStats glxt_text_stats(const GLXTTextRenderer* renderer);
+
+#endif // GLXT_TEXT_H
+
+#if defined(GLXT_TEXT_IMPLEMENTATION) && !defined(GLXT_TEXT_IMPLEMENTATION_INCLUDED)
+#define GLXT_TEXT_IMPLEMENTATION_INCLUDED
+
+#include <math.h>
+
+#define _GLXT_TEXT_BUILTIN_FIRST 0x20
+#define _GLXT_TEXT_BUILTIN_LAST 0x7E
+
+// Public domain font8x8_basic, one byte per row, least significant bit leftmost
+static const uint8_t _glxt_text_builtin_font[][GLXT_TEXT_BUILTIN_SIZE] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 }, // '!'
+    { 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '"'
+    { 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 }, // '#'
+    { 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 }, // '$'
+    { 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 }, // '%'
+    { 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 }, // '&'
+    { 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '''
+    { 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 }, // '('
+    { 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 }, // ')'
+    { 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 }, // '*'
+    { 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 }, // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ','
+    { 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 }, // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // '.'
+    { 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 }, // '/'
+    { 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 }, // '0'
+    { 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 }, // '1'
+    { 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 }, // '2'
+    { 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 }, // '3'
+    { 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 }, // '4'
+    { 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 }, // '5'
+    { 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 }, // '6'
+    { 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 }, // '7'
+    { 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 }, // '8'
+    { 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 }, // '9'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // ':'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ';'
+    { 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 }, // '<'
+    { 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 }, // '='
+    { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, // '>'
+    { 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 }, // '?'
+    { 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 }, // '@'
+    { 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 }, // 'A'
+    { 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 }, // 'B'
+    { 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 }, // 'C'
+    { 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 }, // 'D'
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 }, // 'E'
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 }, // 'F'
+    { 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 }, // 'G'
+    { 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 }, // 'H'
+    { 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // 'I'
+    { 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 }, // 'J'
+    { 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 }, // 'K'
+    { 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 }, // 'L'
+    { 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 }, // 'M'
+    { 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 }, // 'N'
+    { 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 }, // 'O'
+    { 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 }, // 'P'
+    { 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 }, // 'Q'
+    { 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 }, // 'R'
+    { 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 }, // 'S'
+    { 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // 'T'
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 }, // 'U'
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // 'V'
+    { 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 }, // 'W'
+    { 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 }, // 'X'
+    { 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 }, // 'Y'
+    { 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 }, // 'Z'
+    { 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 }, // '['
+    { 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 }, // '\'
+    { 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 }, // ']'
+    { 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 }, // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }, // '_'
+    { 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '`'
+    { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // 'a'
+    { 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 }, // 'b'
+    { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // 'c'
+    { 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 }, // 'd'
+    { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // 'e'
+    { 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 }, // 'f'
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // 'g'
+    { 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 }, // 'h'
+    { 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // 'i'
+    { 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E }, // 'j'
+    { 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 }, // 'k'
+    { 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // 'l'
+    { 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 }, // 'm'
+    { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // 'n'
+    { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // 'o'
+    { 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F }, // 'p'
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 }, // 'q'
+    { 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 }, // 'r'
+    { 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 }, // 's'
+    { 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 }, // 't'
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 }, // 'u'
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // 'v'
+    { 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 }, // 'w'
+    { 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 }, // 'x'
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // 'y'
+    { 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 }, // 'z'
+    { 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 }, // '{'
+    { 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 }, // '|'
+    { 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 }, // '}'
+    { 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '~'
+};
+
+static bool _glxt_text_builtin_glyph(uint32_t codepoint, GLXTGlyphBitmap* glyph, void* user_data)
+{
+    GLXTFont* font = user_data;
+    if(codepoint < _GLXT_TEXT_BUILTIN_FIRST || codepoint > _GLXT_TEXT_BUILTIN_LAST) return false;
+
+    uint32_t scale = font->builtin_scale;
+    uint32_t size = GLXT_TEXT_BUILTIN_SIZE * scale;
+    const uint8_t* rows = _glxt_text_builtin_font[codepoint - _GLXT_TEXT_BUILTIN_FIRST];
+    for(uint32_t y = 0; y < size; ++y) {
+        for(uint32_t x = 0; x < size; ++x)
+            font->builtin_pixels[y * size + x] = ((rows[y / scale] >> (x / scale)) & 1) ? 0xFF : 0x00;
+    }
+
+    glyph->width = size;
+    glyph->height = size;
+    // The cell's bottom row is the descender
+    glyph->bearing_x = 0.0f;
+    glyph->bearing_y = -(float)(size - scale);
+    glyph->advance = (float)size;
+    glyph->pixels = codepoint == ' ' ? NULL : font->builtin_pixels;
+    return true;
+}
+
+/**
+ * Distance to the nearest texel on the other side of the outline, searched
+ * within spread and mapped to [0, 255] with the outline at 128. Brute
+ * force, but it only runs once per glyph.
+ */
+static void _glxt_text_distance_field(const uint8_t* coverage, uint32_t width, uint32_t height,
+    uint32_t spread, uint8_t* field)
+{
+    int field_width = (int)(width + spread * 2);
+    int field_height = (int)(height + spread * 2);
+    int s = (int)spread;
+    for(int y = 0; y < field_height; ++y) {
+        for(int x = 0; x < field_width; ++x) {
+            int cx = x - s, cy = y - s;
+            bool inside = cx >= 0 && cy >= 0 && cx < (int)width && cy < (int)height
+                && coverage[cy * width + cx] >= 128;
+            int nearest = (s + 1) * (s + 1);
+            for(int dy = -s; dy <= s; ++dy) {
+                int sy = cy + dy;
+                for(int dx = -s; dx <= s; ++dx) {
+                    int sx = cx + dx;
+                    bool other = sx >= 0 && sy >= 0 && sx < (int)width && sy < (int)height
+                        && coverage[sy * width + sx] >= 128;
+                    int distance = dx * dx + dy * dy;
+                    if(other != inside && distance < nearest) nearest = distance;
+                }
+            }
+            // The outline lies half way between the two texel centres
+            float distance = sqrtf((float)nearest) - 0.5f;
+            if(distance > (float)s) distance = (float)s;
+            float value = 0.5f + (inside ? distance : -distance) * 0.5f / (float)s;
+            field[y * field_width + x] = (uint8_t)(value * 255.0f + 0.5f);
+        }
+    }
+}
+
+static bool _glxt_font_grow(GLXTFont* font)
+{
+    size_t capacity = font->glyphs_capacity * 2;
+    uint32_t* keys = calloc(capacity, sizeof(uint32_t));
+    GLXTGlyph* glyphs = malloc(sizeof(GLXTGlyph) * capacity);
+    if(keys == NULL || glyphs == NULL) {
+        free(keys);
+        free(glyphs);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    for(size_t i = 0; i < font->glyphs_capacity; ++i) {
+        if(font->keys[i] == 0) continue;
+        size_t slot = (font->keys[i] * 2654435761u) & (capacity - 1);
+        while(keys[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        keys[slot] = font->keys[i];
+        glyphs[slot] = font->glyphs[i];
+    }
+    free(font->keys);
+    free(font->glyphs);
+    font->keys = keys;
+    font->glyphs = glyphs;
+    font->glyphs_capacity = capacity;
+    return true;
+}
+
+bool glxt_font_init(GLXTFont* font, const GLXTFontDesc* desc)
+{
+    if(font == NULL || desc == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(font, 0, sizeof(*font));
+    font->desc = *desc;
+    if(font->desc.sdf_spread == 0) font->desc.sdf_spread = 4;
+    if(font->desc.atlas_size == 0) font->desc.atlas_size = GLXT_TEXT_ATLAS_SIZE;
+    if(font->desc.rasterize == NULL) {
+        font->builtin_scale = desc->sdf ? GLXT_TEXT_BUILTIN_SDF_SCALE : 1;
+        font->desc.rasterize = _glxt_text_builtin_glyph;
+        font->desc.user_data = font;
+        font->desc.pixel_size = (float)(GLXT_TEXT_BUILTIN_SIZE * font->builtin_scale);
+        font->desc.ascent = (float)((GLXT_TEXT_BUILTIN_SIZE - 1) * font->builtin_scale);
+        font->desc.line_height = font->desc.pixel_size;
+    }
+    if(font->desc.pixel_size <= 0.0f) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    if(font->desc.line_height <= 0.0f) font->desc.line_height = font->desc.pixel_size;
+
+    // The distance field already holds the spread as a border
+    uint32_t padding = font->desc.sdf ? 0 : 1;
+    if(!glxt_atlas_init(&font->atlas, font->desc.atlas_size, font->desc.atlas_size, 1, padding))
+        return false;
+
+    font->glyphs_capacity = 128;
+    font->keys = calloc(font->glyphs_capacity, sizeof(uint32_t));
+    font->glyphs = malloc(sizeof(GLXTGlyph) * font->glyphs_capacity);
+    if(font->keys == NULL || font->glyphs == NULL) {
+        glxt_font_deinit(font);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    return true;
+}
+
+void glxt_font_deinit(GLXTFont* font)
+{
+    if(font == NULL) return;
+    glxt_atlas_deinit(&font->atlas);
+    free(font->keys);
+    free(font->glyphs);
+    font->keys = NULL;
+    font->glyphs = NULL;
+    font->glyphs_count = 0;
+    font->glyphs_capacity = 0;
+}
+
+static bool _glxt_font_rasterize(GLXTFont* font, uint32_t codepoint, GLXTGlyph* glyph)
+{
+    memset(glyph, 0, sizeof(*glyph));
+    GLXTGlyphBitmap bitmap = { 0 };
+    if(!font->desc.rasterize(codepoint, &bitmap, font->desc.user_data)) return true;
+    glyph->advance = bitmap.advance;
+    if(bitmap.pixels == NULL || bitmap.width == 0 || bitmap.height == 0) return true;
+
+    const uint8_t* pixels = bitmap.pixels;
+    uint32_t width = bitmap.width, height = bitmap.height;
+    float border = 0.0f;
+    uint8_t* field = NULL;
+    if(font->desc.sdf) {
+        uint32_t spread = font->desc.sdf_spread;
+        width += spread * 2;
+        height += spread * 2;
+        field = glxt_scratch_alloc((size_t)width * height);
+        if(field == NULL) return false;
+        _glxt_text_distance_field(bitmap.pixels, bitmap.width, bitmap.height, spread, field);
+        pixels = field;
+        border = (float)spread;
+    }
+
+    uint32_t id = glxt_atlas_add(&font->atlas, width, height, pixels);
+    if(field != NULL) glxt_scratch_free(field);
+    if(id == 0) return false;
+
+    const GLXTAtlasEntry* entry = glxt_atlas_get(&font->atlas, id);
+    glyph->page = entry->page;
+    glyph->x0 = bitmap.bearing_x - border;
+    glyph->y0 = bitmap.bearing_y - border;
+    glyph->x1 = glyph->x0 + (float)width;
+    glyph->y1 = glyph->y0 + (float)height;
+    glyph->u0 = entry->u0;
+    glyph->v0 = entry->v0;
+    glyph->u1 = entry->u1;
+    glyph->v1 = entry->v1;
+    return true;
+}
+
+const GLXTGlyph* glxt_font_glyph(GLXTFont* font, uint32_t codepoint)
+{
+    uint32_t key = codepoint + 1;
+    size_t mask = font->glyphs_capacity - 1;
+    size_t slot = (key * 2654435761u) & mask;
+    while(font->keys[slot] != 0) {
+        if(font->keys[slot] == key) return &font->glyphs[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    GLXTGlyph glyph;
+    if(!_glxt_font_rasterize(font, codepoint, &glyph)) return NULL;
+
+    // Kept at most half full so probes stay short
+    if((font->glyphs_count + 1) * 2 > font->glyphs_capacity) {
+        if(!_glxt_font_grow(font)) return NULL;
+        mask = font->glyphs_capacity - 1;
+        slot = (key * 2654435761u) & mask;
+        while(font->keys[slot] != 0) slot = (slot + 1) & mask;
+    }
+    font->keys[slot] = key;
+    font->glyphs[slot] = glyph;
+    font->glyphs_count += 1;
+    return &font->glyphs[slot];
+}
+
+// Decodes one UTF-8 sequence, malformed bytes decode to U+FFFD one at a time
+static uint32_t _glxt_text_decode(const char** text)
+{
+    const uint8_t* s = (const uint8_t*)*text;
+    uint32_t codepoint = s[0];
+    size_t length = 1;
+    if(s[0] >= 0xF0 && s[0] < 0xF8) {
+        codepoint = s[0] & 0x07;
+        length = 4;
+    } else if(s[0] >= 0xE0) {
+        codepoint = s[0] & 0x0F;
+        length = 3;
+    } else if(s[0] >= 0xC0) {
+        codepoint = s[0] & 0x1F;
+        length = 2;
+    } else if(s[0] >= 0x80) {
+        length = 0;
+    }
+
+    for(size_t i = 1; i < length; ++i) {
+        if((s[i] & 0xC0) != 0x80) {
+            length = 0;
+            break;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+    if(length == 0 || s[0] >= 0xF8) {
+        *text += 1;
+        return 0xFFFD;
+    }
+    *text += length;
+    return codepoint;
+}
+
+void glxt_font_measure(GLXTFont* font, const char* text, float size, float* width, float* height)
+{
+    float scale = size / font->desc.pixel_size;
+    float line = 0.0f, widest = 0.0f;
+    size_t lines = 1;
+    while(*text != '\0') {
+        uint32_t codepoint = _glxt_text_decode(&text);
+        if(codepoint == '\n') {
+            lines += 1;
+            line = 0.0f;
+            continue;
+        }
+        const GLXTGlyph* glyph = glxt_font_glyph(font, codepoint);
+        if(glyph != NULL) line += glyph->advance * scale;
+        if(line > widest) widest = line;
+    }
+    if(width != NULL) *width = widest;
+    if(height != NULL) *height = (float)lines * font->desc.line_height * scale;
+}
+
+static const char* _glxt_text_vert_source =
+    "#version 330 core\n"
+    "layout(location = 0) in vec4 i_rect;\n"
+    "layout(location = 1) in vec4 i_uv;\n"
+    "layout(location = 2) in vec4 i_color;\n"
+    "uniform vec2 u_screen;\n"
+    "out vec2 v_uv;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    vec2 position = i_rect.xy + corner * i_rect.zw;\n"
+    "    gl_Position = vec4(position.x / u_screen.x * 2.0 - 1.0, 1.0 - position.y / u_screen.y * 2.0, 0.0, 1.0);\n"
+    "    v_uv = mix(i_uv.xy, i_uv.zw, corner);\n"
+    "    v_color = i_color;\n"
+    "}\n";
+
+static const char* _glxt_text_frag_source =
+    "#version 330 core\n"
+    "layout(location = 0) out vec4 o_color;\n"
+    "in vec2 v_uv;\n"
+    "in vec4 v_color;\n"
+    "uniform sampler2D u_atlas;\n"
+    "void main() {\n"
+    "    o_color = vec4(v_color.rgb, v_color.a * texture(u_atlas, v_uv).r);\n"
+    "}\n";
+
+static const char* _glxt_text_sdf_frag_source =
+    "#version 330 core\n"
+    "layout(location = 0) out vec4 o_color;\n"
+    "in vec2 v_uv;\n"
+    "in vec4 v_color;\n"
+    "uniform sampler2D u_atlas;\n"
+    "void main() {\n"
+    "    float distance = texture(u_atlas, v_uv).r;\n"
+    "    float edge = max(fwidth(distance), 1e-4);\n"
+    "    o_color = vec4(v_color.rgb, v_color.a * smoothstep(0.5 - edge, 0.5 + edge, distance));\n"
+    "}\n";
+
+// Base instances are not in GL 3.3, so a draw not starting at 0 moves the attributes to its first glyph
+static void _glxt_text_set_attribs(GLXTTextRenderer* renderer, size_t first)
+{
+    size_t offset = first * sizeof(GLXTTextInstance);
+    glxt_enable_vertex_buffer(renderer->vbo);
+    glxt_set_instance_attrib(0, 4, GL_FLOAT, false, sizeof(GLXTTextInstance),
+        (const void*)(offset + offsetof(GLXTTextInstance, rect)), 1);
+    glxt_set_instance_attrib(1, 4, GL_FLOAT, false, sizeof(GLXTTextInstance),
+        (const void*)(offset + offsetof(GLXTTextInstance, uv)), 1);
+    glxt_set_instance_attrib(2, 4, GL_UNSIGNED_BYTE, true, sizeof(GLXTTextInstance),
+        (const void*)(offset + offsetof(GLXTTextInstance, color)), 1);
+    glxt_disable_vertex_buffer();
+    renderer->attribs_first = first;
+}
+
+bool glxt_text_renderer_init(GLXTTextRenderer* renderer)
+{
+    if(renderer == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(renderer, 0, sizeof(*renderer));
+    renderer->first_changed = SIZE_MAX;
+
+    const char* frag_sources[2] = { _glxt_text_frag_source, _glxt_text_sdf_frag_source };
+    for(size_t i = 0; i < 2; ++i) {
+        renderer->programs[i] = glxt_create_shader_program(_glxt_text_vert_source, frag_sources[i]);
+        if(renderer->programs[i] == 0) {
+            glxt_text_renderer_deinit(renderer);
+            return false;
+        }
+        int unit = 0;
+        glxt_enable_shader_program(renderer->programs[i]);
+        glxt_set_shader_uniform(renderer->programs[i], "u_atlas", (const void*)&unit,
+            GLXT_SHADER_UNIFORM_SAMPLER2D, 1);
+        renderer->screen_uniforms[i] = glxt_get_shader_uniform(renderer->programs[i], "u_screen");
+    }
+
+    renderer->vbo_capacity = 1024;
+    renderer->vao = glxt_create_vertex_array();
+    renderer->vbo = glxt_create_vertex_buffer(renderer->vbo_capacity * sizeof(GLXTTextInstance), NULL);
+    glxt_enable_vertex_array(renderer->vao);
+    _glxt_text_set_attribs(renderer, 0);
+    glxt_disable_vertex_array();
+    DEBUG_DO(_glxt_check_opengl_error());
+    return true;
+}
+
+void glxt_text_renderer_deinit(GLXTTextRenderer* renderer)
+{
+    if(renderer == NULL) return;
+    for(size_t i = 0; i < 2; ++i) {
+        if(renderer->programs[i] != 0) glxt_destroy_shader_program(renderer->programs[i]);
+    }
+    if(renderer->vbo != 0) glxt_destroy_vertex_buffer(renderer->vbo);
+    if(renderer->vao != 0) glxt_destroy_vertex_array(renderer->vao);
+    free(renderer->instances);
+    free(renderer->runs);
+    free(renderer->draws);
+    memset(renderer, 0, sizeof(*renderer));
+}
+
+void glxt_text_begin(GLXTTextRenderer* renderer)
+{
+    renderer->previous_runs_count = renderer->runs_count;
+    renderer->runs_count = 0;
+    renderer->instances_count = 0;
+    renderer->shaping = false;
+    memset(&renderer->stats, 0, sizeof(renderer->stats));
+}
+
+static uint64_t _glxt_text_hash(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = data;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Drops the draws past the instances kept from last frame
+static void _glxt_text_truncate_draws(GLXTTextRenderer* renderer, size_t instances_count)
+{
+    while(renderer->draws_count > 0 && renderer->draws[renderer->draws_count - 1].first >= instances_count)
+        renderer->draws_count -= 1;
+    if(renderer->draws_count > 0) {
+        _GLXTTextDraw* last = &renderer->draws[renderer->draws_count - 1];
+        if(last->first + last->count > instances_count) last->count = instances_count - last->first;
+    }
+}
+
+static bool _glxt_text_reserve(GLXTTextRenderer* renderer, size_t instances_count)
+{
+    if(instances_count <= renderer->instances_capacity) return true;
+    size_t capacity = renderer->instances_capacity == 0 ? 1024 : renderer->instances_capacity;
+    while(capacity < instances_count) capacity *= 2;
+    GLXTTextInstance* instances = realloc(renderer->instances, sizeof(GLXTTextInstance) * capacity);
+    if(instances == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    renderer->instances = instances;
+    renderer->instances_capacity = capacity;
+    return true;
+}
+
+static bool _glxt_text_push_draw(GLXTTextRenderer* renderer, uint32_t texture, bool sdf, size_t first)
+{
+    if(renderer->draws_count > 0) {
+        _GLXTTextDraw* last = &renderer->draws[renderer->draws_count - 1];
+        if(last->texture == texture && last->sdf == sdf) return true;
+    }
+    if(renderer->draws_count >= renderer->draws_capacity) {
+        size_t capacity = renderer->draws_capacity == 0 ? 16 : renderer->draws_capacity * 2;
+        _GLXTTextDraw* draws = realloc(renderer->draws, sizeof(_GLXTTextDraw) * capacity);
+        if(draws == NULL) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return false;
+        }
+        renderer->draws = draws;
+        renderer->draws_capacity = capacity;
+    }
+    renderer->draws[renderer->draws_count++] = (_GLXTTextDraw){ texture, sdf, first, 0 };
+    return true;
+}
+
+void glxt_text_add(GLXTTextRenderer* renderer, GLXTFont* font, const char* text,
+    float x, float y, float size, const float color[4])
+{
+    if(renderer == NULL || font == NULL || text == NULL || color == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+
+    uint8_t rgba[4];
+    for(size_t i = 0; i < 4; ++i) {
+        float c = color[i] < 0.0f ? 0.0f : (color[i] > 1.0f ? 1.0f : color[i]);
+        rgba[i] = (uint8_t)(c * 255.0f + 0.5f);
+    }
+    size_t length = strlen(text);
+    uint64_t hash = _glxt_text_hash(0xCBF29CE484222325ull, text, length);
+    hash = _glxt_text_hash(hash, &font, sizeof(font));
+    float placement[3] = { x, y, size };
+    hash = _glxt_text_hash(hash, placement, sizeof(placement));
+    hash = _glxt_text_hash(hash, rgba, sizeof(rgba));
+
+    if(renderer->runs_count >= renderer->runs_capacity) {
+        size_t capacity = renderer->runs_capacity == 0 ? 64 : renderer->runs_capacity * 2;
+        _GLXTTextRun* runs = realloc(renderer->runs, sizeof(_GLXTTextRun) * capacity);
+        if(runs == NULL) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return;
+        }
+        renderer->runs = runs;
+        renderer->runs_capacity = capacity;
+    }
+
+    _GLXTTextRun* run = &renderer->runs[renderer->runs_count];
+    renderer->stats.runs += 1;
+    if(!renderer->shaping && renderer->runs_count < renderer->previous_runs_count && run->hash == hash) {
+        // Every run before matched too, so its instances and draws are still in place
+        renderer->runs_count += 1;
+        renderer->instances_count += run->count;
+        renderer->stats.runs_cached += 1;
+        renderer->stats.glyphs += run->count;
+        return;
+    }
+
+    if(!renderer->shaping) {
+        renderer->shaping = true;
+        _glxt_text_truncate_draws(renderer, renderer->instances_count);
+        if(renderer->instances_count < renderer->first_changed)
+            renderer->first_changed = renderer->instances_count;
+    }
+    // At most one instance per byte
+    if(!_glxt_text_reserve(renderer, renderer->instances_count + length)) return;
+
+    run->hash = hash;
+    run->first = renderer->instances_count;
+    run->count = 0;
+    renderer->runs_count += 1;
+
+    float scale = size / font->desc.pixel_size;
+    float pen_x = x;
+    float baseline = y + font->desc.ascent * scale;
+    const char* cursor = text;
+    while(*cursor != '\0') {
+        uint32_t codepoint = _glxt_text_decode(&cursor);
+        if(codepoint == '\n') {
+            pen_x = x;
+            baseline += font->desc.line_height * scale;
+            continue;
+        }
+        const GLXTGlyph* glyph = glxt_font_glyph(font, codepoint);
+        if(glyph == NULL) continue;
+        if(glyph->x1 > glyph->x0) {
+            uint32_t texture = glxt_atlas_texture(&font->atlas, glyph->page);
+            size_t index = run->first + run->count;
+            if(!_glxt_text_push_draw(renderer, texture, font->desc.sdf, index)) break;
+            GLXTTextInstance* instance = &renderer->instances[index];
+            instance->rect[0] = pen_x + glyph->x0 * scale;
+            instance->rect[1] = baseline + glyph->y0 * scale;
+            instance->rect[2] = (glyph->x1 - glyph->x0) * scale;
+            instance->rect[3] = (glyph->y1 - glyph->y0) * scale;
+            instance->uv[0] = glyph->u0;
+            instance->uv[1] = glyph->v0;
+            instance->uv[2] = glyph->u1;
+            instance->uv[3] = glyph->v1;
+            memcpy(instance->color, rgba, sizeof(rgba));
+            renderer->draws[renderer->draws_count - 1].count += 1;
+            run->count += 1;
+        }
+        pen_x += glyph->advance * scale;
+    }
+
+    renderer->instances_count += run->count;
+    renderer->stats.glyphs += run->count;
+    renderer->stats.glyphs_shaped += run->count;
+    // Only pages that got new glyphs are uploaded
+    glxt_atlas_upload(&font->atlas);
+}
+
+void glxt_text_draw(GLXTTextRenderer* renderer, uint32_t width, uint32_t height)
+{
+    if(renderer == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    // Fewer runs than last frame leave stale draws behind
+    if(!renderer->shaping) _glxt_text_truncate_draws(renderer, renderer->instances_count);
+
+    if(renderer->instances_count > renderer->vbo_capacity) {
+        size_t capacity = renderer->vbo_capacity;
+        while(capacity < renderer->instances_count) capacity *= 2;
+        glxt_destroy_vertex_buffer(renderer->vbo);
+        renderer->vbo = glxt_create_vertex_buffer(capacity * sizeof(GLXTTextInstance), NULL);
+        renderer->vbo_capacity = capacity;
+        glxt_enable_vertex_array(renderer->vao);
+        _glxt_text_set_attribs(renderer, renderer->attribs_first);
+        glxt_disable_vertex_array();
+        renderer->first_changed = 0;
+    }
+    if(renderer->first_changed < renderer->instances_count) {
+        size_t count = renderer->instances_count - renderer->first_changed;
+        glxt_update_vertex_buffer(renderer->vbo, count * sizeof(GLXTTextInstance),
+            renderer->instances + renderer->first_changed,
+            (int)(renderer->first_changed * sizeof(GLXTTextInstance)));
+        renderer->stats.instances_uploaded = count;
+    }
+    renderer->first_changed = SIZE_MAX;
+    if(renderer->draws_count == 0) return;
+
+    float screen[2] = { (float)width, (float)height };
+    glxt_set_blend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glxt_set_depth_test(false, GL_LESS);
+    glxt_enable_vertex_array(renderer->vao);
+    for(size_t i = 0; i < renderer->draws_count; ++i) {
+        const _GLXTTextDraw* draw = &renderer->draws[i];
+        if(draw->count == 0) continue;
+        glxt_enable_shader_program(renderer->programs[draw->sdf]);
+        glxt_set_uniform(renderer->screen_uniforms[draw->sdf], screen, 1);
+        glxt_bind_texture2d(0, draw->texture);
+        if(draw->first != renderer->attribs_first) _glxt_text_set_attribs(renderer, draw->first);
+        glxt_draw_arrays_instanced(GL_TRIANGLE_STRIP, 0, 4, (int)draw->count);
+        renderer->stats.draw_calls += 1;
+    }
+    glxt_disable_vertex_array();
+    glxt_set_blend(false, GL_ONE, GL_ZERO);
+    DEBUG_DO(_glxt_check_opengl_error());
+}
+
+GLXTTextStats glxt_text_stats(const GLXTTextRenderer* renderer)
+{
+    return renderer->stats;
+}
+
+#endif // GLXT_TEXT_IMPLEMENTATION
@@ -0,0 +1,42 @@
+/**
+ * Thread primitives shared by the glxt implementations that run worker
+ * threads (glxt_loader, glxt_capture, glxt_transform). Internal, included by their
+ * implementation sections only.
+ */
+#ifndef GLXT_THREAD_H
+#define GLXT_THREAD_H
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    typedef HANDLE _GLXTThread;
+    typedef CRITICAL_SECTION _GLXTMutex;
+    typedef CONDITION_VARIABLE _GLXTCondition;
+
+static inline void _glxt_mutex_init(_GLXTMutex* m) { InitializeCriticalSection(m); }
+static inline void _glxt_mutex_destroy(_GLXTMutex* m) { DeleteCriticalSection(m); }
+static inline void _glxt_mutex_lock(_GLXTMutex* m) { EnterCriticalSection(m); }
+static inline void _glxt_mutex_unlock(_GLXTMutex* m) { LeaveCriticalSection(m); }
+static inline void _glxt_condition_init(_GLXTCondition* c) { InitializeConditionVariable(c); }
+static inline void _glxt_condition_destroy(_GLXTCondition* c) { (void)c; }
+static inline void _glxt_condition_wait(_GLXTCondition* c, _GLXTMutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+static inline void _glxt_condition_signal(_GLXTCondition* c) { WakeConditionVariable(c); }
+static inline void _glxt_condition_broadcast(_GLXTCondition* c) { WakeAllConditionVariable(c); }
+#else
+    #include <pthread.h>
+    typedef pthread_t _GLXTThread;
+    typedef pthread_mutex_t _GLXTMutex;
+    typedef pthread_cond_t _GLXTCondition;
+
+static inline void _glxt_mutex_init(_GLXTMutex* m) { pthread_mutex_init(m, NULL); }
+static inline void _glxt_mutex_destroy(_GLXTMutex* m) { pthread_mutex_destroy(m); }
+static inline void _glxt_mutex_lock(_GLXTMutex* m) { pthread_mutex_lock(m); }
+static inline void _glxt_mutex_unlock(_GLXTMutex* m) { pthread_mutex_unlock(m); }
+static inline void _glxt_condition_init(_GLXTCondition* c) { pthread_cond_init(c, NULL); }
+static inline void _glxt_condition_destroy(_GLXTCondition* c) { pthread_cond_destroy(c); }
+static inline void _glxt_condition_wait(_GLXTCondition* c, _GLXTMutex* m) { pthread_cond_wait(c, m); }
+static inline void _glxt_condition_signal(_GLXTCondition* c) { pthread_cond_signal(c); }
+static inline void _glxt_condition_broadcast(_GLXTCondition* c) { pthread_cond_broadcast(c); }
+#endif
+
+#endif // GLXT_THREAD_H
@@ -0,0 +1,714 @@
+/**
+ * glxt_transform works like glxt: define GLXT_TRANSFORM_IMPLEMENTATION in
+ * the file where glxt is implemented, after the glxt implementation.
+ *
+ * Transform hierarchy.
+ * Nodes hold a local position, euler rotation (radians, as
+ * mat4_euler_xyz) and scale, with one array per component, and a parent.
+ * Storage is kept in level order, every node after its parent and each
+ * depth in one contiguous range, so glxt_transform_update computes world
+ * matrices in a single forward pass:
+ *
+ *     world = mat4_dot(local, parent world)    // parent * local
+ *     local = translation * rotation * scale
+ *
+ * Only nodes whose local transform changed, or whose parent's world
+ * matrix did, are recomputed, and the pass starts at the first dirty
+ * node. An update with nothing dirty returns immediately, so static
+ * scenes cost nothing. Local matrices are cached, a node that only moved
+ * with its parent does not rebuild its rotation.
+ *
+ * Reparenting, destroying or creating a node under a shallower parent
+ * than the last level breaks the order; the next update restores it with
+ * a stable counting sort by depth. Handles stay valid across the sort,
+ * indices and world matrix pointers do not.
+ *
+ * With workers_count > 0, levels of at least GLXT_TRANSFORM_PARALLEL_MINIMUM
+ * dirty candidates are split between the worker threads and the caller.
+ */
+#ifndef GLXT_TRANSFORM_H
+#define GLXT_TRANSFORM_H
+
+#include "glxt.h"
+#include <llama.h>
+
+#ifndef GLXT_TRANSFORM_PARALLEL_MINIMUM
+    #define GLXT_TRANSFORM_PARALLEL_MINIMUM 4096
+#endif
+
+#ifndef GLXT_TRANSFORM_MAXIMUM_WORKERS
+    #define GLXT_TRANSFORM_MAXIMUM_WORKERS 16
+#endif
+
+// 0 is never a valid node, it is used as "no parent"
+typedef uint32_t GLXTTransformNode;
+
+typedef struct GLXTTransformStats {
+    size_t nodes;
+    size_t levels;
+    // Of the last update
+    size_t updated;
+    size_t visited;
+    size_t sorts;
+} GLXTTransformStats;
+
+typedef struct _GLXTTransformWorkers _GLXTTransformWorkers;
+
+typedef struct GLXTTransformHierarchy {
+    // Per node, in level order
+    vec3_t* positions;
+    vec3_t* rotations;
+    vec3_t* scales;
+    int32_t* parents;
+    uint32_t* depths;
+    uint8_t* flags;
+    GLXTTransformNode* nodes;
+    mat4_t* locals;
+    mat4_t* worlds;
+    size_t count;
+    size_t capacity;
+
+    // Per handle
+    uint32_t* indices;
+    uint32_t* free_handles;
+    size_t free_handles_count;
+    size_t handles_count;
+    size_t handles_capacity;
+
+    // levels[d] is the first index of depth d, levels[levels_count] == count
+    size_t* levels;
+    size_t levels_count;
+    size_t levels_capacity;
+
+    // Reused by every sort, sized for the largest per node array
+    void* scratch;
+    size_t scratch_size;
+
+    size_t first_dirty;
+    bool dirty;
+    bool needs_sort;
+    GLXTTransformStats stats;
+    _GLXTTransformWorkers* workers;
+} GLXTTransformHierarchy;
+
+bool glxt_transform_hierarchy_init(GLXTTransformHierarchy* hierarchy, size_t capacity, size_t workers_count);
+void glxt_transform_hierarchy_deinit(GLXTTransformHierarchy* hierarchy);
+
+// parent may be 0 for a root, the new node has an identity transform
+GLXTTransformNode glxt_transform_create(GLXTTransformHierarchy* hierarchy, GLXTTransformNode parent);
+// Destroys the node and its whole subtree
+void glxt_transform_destroy(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node);
+bool glxt_transform_set_parent(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, GLXTTransformNode parent);
+void glxt_transform_set_local(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node,
+    vec3_t position, vec3_t rotation, vec3_t scale);
+void glxt_transform_set_position(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, vec3_t position);
+void glxt_transform_set_rotation(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, vec3_t rotation);
+void glxt_transform_set_scale(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, vec3_t scale);
+
+void glxt_transform_update(GLXTTransformHierarchy* hierarchy);
+// Valid until the next update or create, NULL for an invalid node
+const mat4_t* glxt_transform_world(const GLXTTransformHierarchy* hierarchy, GLXTTransformNode node);
+GLXTTransformStats glxt_transform_stats(const GLXTTransformHierarchy* hierarchy);
+
+#endif // GLXT_TRANSFORM_H
+
+#if defined(GLXT_TRANSFORM_IMPLEMENTATION) && !defined(GLXT_TRANSFORM_IMPLEMENTATION_INCLUDED)
+#define GLXT_TRANSFORM_IMPLEMENTATION_INCLUDED
+
+#include "glxt_thread.h"
+
+enum {
+    _GLXT_TRANSFORM_LOCAL_DIRTY = 1,
+    _GLXT_TRANSFORM_WORLD_CHANGED = 2,
+};
+
+#define _GLXT_TRANSFORM_DEAD UINT32_MAX
+
+typedef struct _GLXTTransformJob {
+    _GLXTTransformWorkers* workers;
+    GLXTTransformHierarchy* hierarchy;
+    size_t begin, end;
+    size_t updated;
+} _GLXTTransformJob;
+
+struct _GLXTTransformWorkers {
+    _GLXTThread threads[GLXT_TRANSFORM_MAXIMUM_WORKERS];
+    size_t count;
+    _GLXTMutex mutex;
+    _GLXTCondition start;
+    _GLXTCondition done;
+    // Workers run jobs[1..count], the caller runs jobs[0]
+    _GLXTTransformJob jobs[GLXT_TRANSFORM_MAXIMUM_WORKERS + 1];
+    uint64_t generation;
+    size_t remaining;
+    bool quit;
+};
+
+static bool _glxt_transform_valid(const GLXTTransformHierarchy* hierarchy, GLXTTransformNode node)
+{
+    return node != 0 && node <= hierarchy->handles_count && hierarchy->indices[node - 1] != _GLXT_TRANSFORM_DEAD;
+}
+
+/**
+ * Translation * rotation * scale. The rotation is mat4_euler_xyz expanded
+ * by hand, it builds three matrices and multiplies them twice otherwise,
+ * and the scale goes into the rotation columns.
+ */
+static mat4_t _glxt_transform_local(vec3_t position, vec3_t rotation, vec3_t scale)
+{
+    float cx = cosf(rotation.x), sx = sinf(rotation.x);
+    float cy = cosf(rotation.y), sy = sinf(rotation.y);
+    float cz = cosf(rotation.z), sz = sinf(rotation.z);
+    mat4_t local;
+    local.elements[0] = cy * cz * scale.x;
+    local.elements[1] = cy * sz * scale.x;
+    local.elements[2] = -sy * scale.x;
+    local.elements[3] = 0.0f;
+    local.elements[4] = (sx * sy * cz - cx * sz) * scale.y;
+    local.elements[5] = (sx * sy * sz + cx * cz) * scale.y;
+    local.elements[6] = sx * cy * scale.y;
+    local.elements[7] = 0.0f;
+    local.elements[8] = (cx * sy * cz + sx * sz) * scale.z;
+    local.elements[9] = (cx * sy * sz - sx * cz) * scale.z;
+    local.elements[10] = cx * cy * scale.z;
+    local.elements[11] = 0.0f;
+    local.elements[12] = position.x;
+    local.elements[13] = position.y;
+    local.elements[14] = position.z;
+    local.elements[15] = 1.0f;
+    return local;
+}
+
+static size_t _glxt_transform_update_range(GLXTTransformHierarchy* hierarchy, size_t begin, size_t end)
+{
+    size_t updated = 0;
+    uint8_t* flags = hierarchy->flags;
+    const int32_t* parents = hierarchy->parents;
+    for(size_t i = begin; i < end; ++i) {
+        int32_t parent = parents[i];
+        bool parent_changed = parent >= 0 && (flags[parent] & _GLXT_TRANSFORM_WORLD_CHANGED);
+        if(!(flags[i] & _GLXT_TRANSFORM_LOCAL_DIRTY) && !parent_changed) continue;
+
+        if(flags[i] & _GLXT_TRANSFORM_LOCAL_DIRTY)
+            hierarchy->locals[i] = _glxt_transform_local(hierarchy->positions[i], hierarchy->rotations[i],
+                hierarchy->scales[i]);
+        hierarchy->worlds[i] = parent >= 0 ? mat4_dot(hierarchy->locals[i], hierarchy->worlds[parent])
+            : hierarchy->locals[i];
+        // Only children read this flag and they live in the next level, so
+        // setting it while other threads work on this level is safe
+        flags[i] |= _GLXT_TRANSFORM_WORLD_CHANGED;
+        updated += 1;
+    }
+    return updated;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _glxt_transform_worker(LPVOID arg)
+#else
+static void* _glxt_transform_worker(void* arg)
+#endif
+{
+    _GLXTTransformJob* job = arg;
+    _GLXTTransformWorkers* workers = job->workers;
+    // Workers start at generation 0, a batch posted before they run is not missed
+    uint64_t generation = 0;
+
+    for(;;) {
+        _glxt_mutex_lock(&workers->mutex);
+        while(workers->generation == generation && !workers->quit)
+            _glxt_condition_wait(&workers->start, &workers->mutex);
+        if(workers->quit) {
+            _glxt_mutex_unlock(&workers->mutex);
+            break;
+        }
+        generation = workers->generation;
+        _glxt_mutex_unlock(&workers->mutex);
+
+        job->updated = _glxt_transform_update_range(job->hierarchy, job->begin, job->end);
+
+        _glxt_mutex_lock(&workers->mutex);
+        workers->remaining -= 1;
+        if(workers->remaining == 0) _glxt_condition_signal(&workers->done);
+        _glxt_mutex_unlock(&workers->mutex);
+    }
+    return 0;
+}
+
+static void _glxt_transform_stop_workers(_GLXTTransformWorkers* workers)
+{
+    _glxt_mutex_lock(&workers->mutex);
+    workers->quit = true;
+    _glxt_condition_broadcast(&workers->start);
+    _glxt_mutex_unlock(&workers->mutex);
+    for(size_t i = 0; i < workers->count; ++i) {
+#if defined(_WIN32)
+        WaitForSingleObject(workers->threads[i], INFINITE);
+        CloseHandle(workers->threads[i]);
+#else
+        pthread_join(workers->threads[i], NULL);
+#endif
+    }
+    _glxt_condition_destroy(&workers->done);
+    _glxt_condition_destroy(&workers->start);
+    _glxt_mutex_destroy(&workers->mutex);
+    free(workers);
+}
+
+static _GLXTTransformWorkers* _glxt_transform_start_workers(size_t workers_count)
+{
+    _GLXTTransformWorkers* workers = calloc(1, sizeof(_GLXTTransformWorkers));
+    if(workers == NULL) return NULL;
+    _glxt_mutex_init(&workers->mutex);
+    _glxt_condition_init(&workers->start);
+    _glxt_condition_init(&workers->done);
+
+    for(size_t i = 0; i < workers_count; ++i) {
+        _GLXTTransformJob* job = &workers->jobs[i + 1];
+        job->workers = workers;
+#if defined(_WIN32)
+        workers->threads[i] = CreateThread(NULL, 0, _glxt_transform_worker, job, 0, NULL);
+        if(workers->threads[i] == NULL) break;
+#else
+        if(pthread_create(&workers->threads[i], NULL, _glxt_transform_worker, job) != 0) break;
+#endif
+        workers->count += 1;
+    }
+    if(workers->count == 0) {
+        _glxt_transform_stop_workers(workers);
+        return NULL;
+    }
+    return workers;
+}
+
+static size_t _glxt_transform_update_parallel(GLXTTransformHierarchy* hierarchy, size_t begin, size_t end)
+{
+    _GLXTTransformWorkers* workers = hierarchy->workers;
+    size_t chunks = workers->count + 1;
+    size_t chunk_size = (end - begin + chunks - 1) / chunks;
+    for(size_t i = 0; i < chunks; ++i) {
+        size_t chunk_begin = begin + i * chunk_size;
+        size_t chunk_end = chunk_begin + chunk_size;
+        if(chunk_begin > end) chunk_begin = end;
+        if(chunk_end > end) chunk_end = end;
+        workers->jobs[i].hierarchy = hierarchy;
+        workers->jobs[i].begin = chunk_begin;
+        workers->jobs[i].end = chunk_end;
+        workers->jobs[i].updated = 0;
+    }
+
+    _glxt_mutex_lock(&workers->mutex);
+    workers->remaining = workers->count;
+    workers->generation += 1;
+    _glxt_condition_broadcast(&workers->start);
+    _glxt_mutex_unlock(&workers->mutex);
+
+    size_t updated = _glxt_transform_update_range(hierarchy, workers->jobs[0].begin, workers->jobs[0].end);
+
+    _glxt_mutex_lock(&workers->mutex);
+    while(workers->remaining > 0) _glxt_condition_wait(&workers->done, &workers->mutex);
+    _glxt_mutex_unlock(&workers->mutex);
+    for(size_t i = 1; i < chunks; ++i) updated += workers->jobs[i].updated;
+    return updated;
+}
+
+static bool _glxt_transform_grow(void** array, size_t element_size, size_t capacity)
+{
+    void* grown = realloc(*array, element_size * capacity);
+    if(grown == NULL) return false;
+    *array = grown;
+    return true;
+}
+
+static bool _glxt_transform_reserve_nodes(GLXTTransformHierarchy* hierarchy, size_t capacity)
+{
+    if(capacity <= hierarchy->capacity) return true;
+    if(!_glxt_transform_grow((void**)&hierarchy->positions, sizeof(vec3_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->rotations, sizeof(vec3_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->scales, sizeof(vec3_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->parents, sizeof(int32_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->depths, sizeof(uint32_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->flags, sizeof(uint8_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->nodes, sizeof(GLXTTransformNode), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->locals, sizeof(mat4_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->worlds, sizeof(mat4_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->indices, sizeof(uint32_t), capacity)
+        || !_glxt_transform_grow((void**)&hierarchy->free_handles, sizeof(uint32_t), capacity)) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    hierarchy->capacity = capacity;
+    hierarchy->handles_capacity = capacity;
+    return true;
+}
+
+bool glxt_transform_hierarchy_init(GLXTTransformHierarchy* hierarchy, size_t capacity, size_t workers_count)
+{
+    if(hierarchy == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return false;
+    }
+    memset(hierarchy, 0, sizeof(*hierarchy));
+    if(!_glxt_transform_reserve_nodes(hierarchy, capacity != 0 ? capacity : 256)) {
+        glxt_transform_hierarchy_deinit(hierarchy);
+        return false;
+    }
+
+    if(workers_count > GLXT_TRANSFORM_MAXIMUM_WORKERS) workers_count = GLXT_TRANSFORM_MAXIMUM_WORKERS;
+    if(workers_count > 0) {
+        hierarchy->workers = _glxt_transform_start_workers(workers_count);
+        if(hierarchy->workers == NULL) {
+            glxt_transform_hierarchy_deinit(hierarchy);
+            GLXT.last_failure = GLXT_TRANSFORM_THREAD_FAILURE;
+            return false;
+        }
+    }
+    return true;
+}
+
+void glxt_transform_hierarchy_deinit(GLXTTransformHierarchy* hierarchy)
+{
+    if(hierarchy == NULL) return;
+    if(hierarchy->workers != NULL) _glxt_transform_stop_workers(hierarchy->workers);
+    free(hierarchy->positions);
+    free(hierarchy->rotations);
+    free(hierarchy->scales);
+    free(hierarchy->parents);
+    free(hierarchy->depths);
+    free(hierarchy->flags);
+    free(hierarchy->nodes);
+    free(hierarchy->locals);
+    free(hierarchy->worlds);
+    free(hierarchy->indices);
+    free(hierarchy->free_handles);
+    free(hierarchy->levels);
+    free(hierarchy->scratch);
+    memset(hierarchy, 0, sizeof(*hierarchy));
+}
+
+static void _glxt_transform_mark_dirty(GLXTTransformHierarchy* hierarchy, size_t index)
+{
+    hierarchy->flags[index] |= _GLXT_TRANSFORM_LOCAL_DIRTY;
+    if(!hierarchy->dirty || index < hierarchy->first_dirty) hierarchy->first_dirty = index;
+    hierarchy->dirty = true;
+}
+
+GLXTTransformNode glxt_transform_create(GLXTTransformHierarchy* hierarchy, GLXTTransformNode parent)
+{
+    if(hierarchy == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return 0;
+    }
+    if(parent != 0 && !_glxt_transform_valid(hierarchy, parent)) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return 0;
+    }
+    if(hierarchy->count == hierarchy->capacity
+        && !_glxt_transform_reserve_nodes(hierarchy, hierarchy->capacity * 2))
+        return 0;
+    if(hierarchy->count >= INT32_MAX) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return 0;
+    }
+
+    GLXTTransformNode node = 0;
+    if(hierarchy->free_handles_count > 0) {
+        node = hierarchy->free_handles[--hierarchy->free_handles_count];
+    } else {
+        node = (GLXTTransformNode)(++hierarchy->handles_count);
+    }
+
+    size_t index = hierarchy->count++;
+    int32_t parent_index = parent != 0 ? (int32_t)hierarchy->indices[parent - 1] : -1;
+    uint32_t depth = parent_index >= 0 ? hierarchy->depths[parent_index] + 1 : 0;
+    hierarchy->indices[node - 1] = (uint32_t)index;
+    hierarchy->nodes[index] = node;
+    hierarchy->parents[index] = parent_index;
+    hierarchy->depths[index] = depth;
+    hierarchy->positions[index] = vec3(0.0f, 0.0f, 0.0f);
+    hierarchy->rotations[index] = vec3(0.0f, 0.0f, 0.0f);
+    hierarchy->scales[index] = vec3(1.0f, 1.0f, 1.0f);
+    hierarchy->flags[index] = 0;
+    _glxt_transform_mark_dirty(hierarchy, index);
+
+    // Appending keeps the level order only when the depth does not go back
+    uint32_t last_depth = index > 0 ? hierarchy->depths[index - 1] : 0;
+    if(hierarchy->needs_sort || depth < last_depth || depth > last_depth + 1) {
+        hierarchy->needs_sort = true;
+    } else if(index == 0 || depth == last_depth + 1) {
+        if(hierarchy->levels_count + 2 > hierarchy->levels_capacity) {
+            size_t capacity = hierarchy->levels_capacity == 0 ? 16 : hierarchy->levels_capacity * 2;
+            if(!_glxt_transform_grow((void**)&hierarchy->levels, sizeof(size_t), capacity)) {
+                hierarchy->needs_sort = true;
+                return node;
+            }
+            hierarchy->levels_capacity = capacity;
+        }
+        hierarchy->levels[hierarchy->levels_count++] = index;
+        hierarchy->levels[hierarchy->levels_count] = hierarchy->count;
+    } else {
+        hierarchy->levels[hierarchy->levels_count] = hierarchy->count;
+    }
+    return node;
+}
+
+void glxt_transform_destroy(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return;
+    }
+
+    // Depths of dead nodes are set to UINT32_MAX, the sort drops them.
+    // A descendant may come before the node while the order is broken,
+    // so descendants are found by walking up their parent chains.
+    size_t index = hierarchy->indices[node - 1];
+    hierarchy->depths[index] = _GLXT_TRANSFORM_DEAD;
+    for(size_t i = 0; i < hierarchy->count; ++i) {
+        if(hierarchy->depths[i] == _GLXT_TRANSFORM_DEAD) continue;
+        for(int32_t ancestor = hierarchy->parents[i]; ancestor >= 0; ancestor = hierarchy->parents[ancestor]) {
+            if((size_t)ancestor == index) {
+                hierarchy->depths[i] = _GLXT_TRANSFORM_DEAD;
+                break;
+            }
+        }
+    }
+    // Rows killed by an earlier destroy stay until the sort, their handles
+    // are already free and may have been reused by a new row since. Only a
+    // row its handle still points to was killed by this call.
+    for(size_t i = 0; i < hierarchy->count; ++i) {
+        if(hierarchy->depths[i] != _GLXT_TRANSFORM_DEAD) continue;
+        GLXTTransformNode dead = hierarchy->nodes[i];
+        if(hierarchy->indices[dead - 1] != i) continue;
+        hierarchy->indices[dead - 1] = _GLXT_TRANSFORM_DEAD;
+        hierarchy->free_handles[hierarchy->free_handles_count++] = dead;
+    }
+    hierarchy->needs_sort = true;
+    hierarchy->dirty = true;
+}
+
+bool glxt_transform_set_parent(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, GLXTTransformNode parent)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)
+        || (parent != 0 && !_glxt_transform_valid(hierarchy, parent))) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return false;
+    }
+
+    size_t index = hierarchy->indices[node - 1];
+    int32_t parent_index = parent != 0 ? (int32_t)hierarchy->indices[parent - 1] : -1;
+    for(int32_t ancestor = parent_index; ancestor >= 0; ancestor = hierarchy->parents[ancestor]) {
+        if((size_t)ancestor == index) {
+            // A node can not become a child of its own subtree
+            GLXT.last_failure = GLXT_OPENGL_INVALID_VALUE;
+            return false;
+        }
+    }
+    hierarchy->parents[index] = parent_index;
+    _glxt_transform_mark_dirty(hierarchy, index);
+    hierarchy->needs_sort = true;
+    return true;
+}
+
+void glxt_transform_set_local(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node,
+    vec3_t position, vec3_t rotation, vec3_t scale)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return;
+    }
+    size_t index = hierarchy->indices[node - 1];
+    hierarchy->positions[index] = position;
+    hierarchy->rotations[index] = rotation;
+    hierarchy->scales[index] = scale;
+    _glxt_transform_mark_dirty(hierarchy, index);
+}
+
+void glxt_transform_set_position(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, vec3_t position)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return;
+    }
+    size_t index = hierarchy->indices[node - 1];
+    hierarchy->positions[index] = position;
+    _glxt_transform_mark_dirty(hierarchy, index);
+}
+
+void glxt_transform_set_rotation(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, vec3_t rotation)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return;
+    }
+    size_t index = hierarchy->indices[node - 1];
+    hierarchy->rotations[index] = rotation;
+    _glxt_transform_mark_dirty(hierarchy, index);
+}
+
+void glxt_transform_set_scale(GLXTTransformHierarchy* hierarchy, GLXTTransformNode node, vec3_t scale)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)) {
+        GLXT.last_failure = GLXT_INVALID_TRANSFORM_NODE;
+        return;
+    }
+    size_t index = hierarchy->indices[node - 1];
+    hierarchy->scales[index] = scale;
+    _glxt_transform_mark_dirty(hierarchy, index);
+}
+
+// Moves element i of array to order[i], through the hierarchy scratch
+static void _glxt_transform_permute(GLXTTransformHierarchy* hierarchy, void* array, size_t element_size,
+    const uint32_t* order, size_t count)
+{
+    uint8_t* sorted = hierarchy->scratch;
+    const uint8_t* source = array;
+    for(size_t i = 0; i < count; ++i) {
+        if(order[i] == _GLXT_TRANSFORM_DEAD) continue;
+        memcpy(sorted + (size_t)order[i] * element_size, source + i * element_size, element_size);
+    }
+    memcpy(array, sorted, element_size * count);
+}
+
+/**
+ * Restores the level order: depths are recomputed from the parent chains
+ * (a reparented subtree changes depth as a whole), then a stable counting
+ * sort by depth gives every node its new index. Dead nodes are dropped.
+ */
+static bool _glxt_transform_sort(GLXTTransformHierarchy* hierarchy)
+{
+    size_t count = hierarchy->count;
+    if(hierarchy->scratch_size < sizeof(mat4_t) * count) {
+        if(!_glxt_transform_grow(&hierarchy->scratch, sizeof(mat4_t), hierarchy->capacity)) {
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return false;
+        }
+        hierarchy->scratch_size = sizeof(mat4_t) * hierarchy->capacity;
+    }
+    uint32_t* order = malloc(sizeof(uint32_t) * (count > 0 ? count : 1));
+    if(order == NULL) {
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+
+    // Walks up to the first node whose depth is known in this pass, marked
+    // with order[i] == 1, then fills in the depths on the way back down
+    uint32_t* depths = hierarchy->depths;
+    uint32_t max_depth = 0;
+    for(size_t i = 0; i < count; ++i) order[i] = depths[i] == _GLXT_TRANSFORM_DEAD ? 1 : 0;
+    for(size_t i = 0; i < count; ++i) {
+        if(order[i] != 0) continue;
+        size_t length = 0;
+        int32_t top = (int32_t)i;
+        while(top >= 0 && order[top] == 0) {
+            length += 1;
+            top = hierarchy->parents[top];
+        }
+        uint32_t depth = top >= 0 ? depths[top] + (uint32_t)length : (uint32_t)length - 1;
+        for(int32_t node = (int32_t)i; node != top; node = hierarchy->parents[node]) {
+            depths[node] = depth--;
+            order[node] = 1;
+        }
+        if(depths[i] > max_depth) max_depth = depths[i];
+    }
+
+    size_t levels_count = count > 0 ? (size_t)max_depth + 1 : 0;
+    if(levels_count + 1 > hierarchy->levels_capacity) {
+        if(!_glxt_transform_grow((void**)&hierarchy->levels, sizeof(size_t), levels_count + 1)) {
+            free(order);
+            GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+            return false;
+        }
+        hierarchy->levels_capacity = levels_count + 1;
+    }
+    size_t* levels = hierarchy->levels;
+    memset(levels, 0, sizeof(size_t) * (levels_count + 1));
+    for(size_t i = 0; i < count; ++i)
+        if(depths[i] != _GLXT_TRANSFORM_DEAD) levels[depths[i] + 1] += 1;
+    for(size_t level = 0; level < levels_count; ++level) levels[level + 1] += levels[level];
+
+    size_t alive = levels_count > 0 ? levels[levels_count] : 0;
+    size_t cursors[64];
+    size_t* cursor = levels_count <= 64 ? cursors : malloc(sizeof(size_t) * levels_count);
+    if(cursor == NULL) {
+        free(order);
+        GLXT.last_failure = GLXT_OUT_OF_MEMORY;
+        return false;
+    }
+    memcpy(cursor, levels, sizeof(size_t) * levels_count);
+    for(size_t i = 0; i < count; ++i)
+        order[i] = depths[i] == _GLXT_TRANSFORM_DEAD ? _GLXT_TRANSFORM_DEAD : (uint32_t)cursor[depths[i]]++;
+    if(cursor != cursors) free(cursor);
+
+    // Parents are indices, they move with the nodes
+    for(size_t i = 0; i < count; ++i)
+        if(order[i] != _GLXT_TRANSFORM_DEAD && hierarchy->parents[i] >= 0)
+            hierarchy->parents[i] = (int32_t)order[hierarchy->parents[i]];
+
+    _glxt_transform_permute(hierarchy, hierarchy->positions, sizeof(vec3_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->rotations, sizeof(vec3_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->scales, sizeof(vec3_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->parents, sizeof(int32_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->depths, sizeof(uint32_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->flags, sizeof(uint8_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->nodes, sizeof(GLXTTransformNode), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->locals, sizeof(mat4_t), order, count);
+    _glxt_transform_permute(hierarchy, hierarchy->worlds, sizeof(mat4_t), order, count);
+    free(order);
+
+    hierarchy->count = alive;
+    hierarchy->levels_count = levels_count;
+    for(size_t i = 0; i < alive; ++i) hierarchy->indices[hierarchy->nodes[i] - 1] = (uint32_t)i;
+    hierarchy->needs_sort = false;
+    hierarchy->stats.sorts += 1;
+    return true;
+}
+
+void glxt_transform_update(GLXTTransformHierarchy* hierarchy)
+{
+    if(hierarchy == NULL) {
+        GLXT.last_failure = GLXT_INVALID_NULL_ARGUMENTS;
+        return;
+    }
+    hierarchy->stats.updated = 0;
+    hierarchy->stats.visited = 0;
+    if(!hierarchy->dirty) return;
+
+    if(hierarchy->needs_sort) {
+        if(!_glxt_transform_sort(hierarchy)) return;
+        // Indices moved, the first dirty node is not known anymore
+        hierarchy->first_dirty = 0;
+    }
+
+    size_t first = hierarchy->first_dirty;
+    for(size_t level = 0; level < hierarchy->levels_count; ++level) {
+        size_t begin = hierarchy->levels[level], end = hierarchy->levels[level + 1];
+        if(end <= first) continue;
+        if(begin < first) begin = first;
+
+        if(hierarchy->workers != NULL && end - begin >= GLXT_TRANSFORM_PARALLEL_MINIMUM)
+            hierarchy->stats.updated += _glxt_transform_update_parallel(hierarchy, begin, end);
+        else
+            hierarchy->stats.updated += _glxt_transform_update_range(hierarchy, begin, end);
+        hierarchy->stats.visited += end - begin;
+    }
+
+    // Every flag at or after the first dirty node is stale now
+    memset(hierarchy->flags + first, 0, hierarchy->count - first);
+    hierarchy->dirty = false;
+}
+
+const mat4_t* glxt_transform_world(const GLXTTransformHierarchy* hierarchy, GLXTTransformNode node)
+{
+    if(hierarchy == NULL || !_glxt_transform_valid(hierarchy, node)) return NULL;
+    return &hierarchy->worlds[hierarchy->indices[node - 1]];
+}
+
+GLXTTransformStats glxt_transform_stats(const GLXTTransformHierarchy* hierarchy)
+{
+    GLXTTransformStats stats = hierarchy->stats;
+    stats.nodes = hierarchy->count;
+    stats.levels = hierarchy->levels_count;
+    return stats;
+}
+
+#endif // GLXT_TRANSFORM_IMPLEMENTATION
@@ -1,16 +1,9 @@
 workspace "OpenGL Template"
-	configurations { "Debug", "Release" }
+	configurations { "Debug", "Release", "Profile" }
 	architecture "x86_64"
 
-project "opengl-app"
-    kind "ConsoleApp"
-    language "C"
-    targetdir "%{wks.location}/build/bin"
-    objdir "%{wks.location}/build/bin-int"
-    location "%{wks.location}/build/scripts"
-
-	files {
-		"src/**.c",
+-- GLFW sources shared by every project, the null platform is always built in
+local glfw_files = {
 		"./build/dependencies/src/glad.c",
 		"./build/dependencies/include/GLFW/glfw3.h",
 		"./build/dependencies/include/GLFW/glfw3native.h",
@@ -32,16 +25,34 @@ project "opengl-app"
 		"./build/dependencies/src/null_init.c",
 		"./build/dependencies/src/null_monitor.c",
 		"./build/dependencies/src/null_window.c",
-    }
+}
 
-	includedirs {
+local include_dirs = {
 		"include",
 		"src",
 		"./build/dependencies/include",
         "./build/dependencies/include/glad",
 		"./build/dependencies/include/GLFW",
 		"./build/dependencies/include/KHR",
-	}
+}
+
+project "opengl-app"
+    kind "ConsoleApp"
+    language "C"
+    targetdir "%{wks.location}/build/bin"
+    objdir "%{wks.location}/build/bin-int"
+    location "%{wks.location}/build/scripts"
+
+	files {
+		"src/**.c",
+		glfw_files,
+    }
+
+	includedirs { include_dirs }
+
+	filter "configurations:Profile"
+		defines { "GLXT_PROFILER_ENABLED=1" }
+		optimize "On"
 
 	filter "system:windows"
 		files {
@@ -66,6 +77,7 @@ project "opengl-app"
 			"Dwmapi",
 			"gdi32",
 			"opengl32",
+			"winmm",
 		}
 
 	filter "system:linux"
@@ -89,6 +101,114 @@ project "opengl-app"
 		links {
 			"X11",
 			"GL",
-			"m"
+			"m",
+			"pthread"
+		}
+    
+
+-- Headless benchmark: GLFW null platform with an OSMesa context, no display or GPU needed
+project "opengl-bench"
+    kind "ConsoleApp"
+    language "C"
+    targetdir "%{wks.location}/build/bin"
+    objdir "%{wks.location}/build/bin-int"
+    location "%{wks.location}/build/scripts"
+
+	files {
+		"bench/**.c",
+		glfw_files,
+    }
+
+	includedirs { include_dirs }
+
+	filter "configurations:Release or Profile"
+		optimize "On"
+
+	filter "system:windows"
+		files {
+			"./build/dependencies/src/win32_module.c",
+			"./build/dependencies/src/win32_time.c",
+			"./build/dependencies/src/win32_thread.c",
+		}
+		defines {
+			"_CRT_SECURE_NO_WARNINGS"
+		}
+
+	filter "system:linux"
+		files {
+			"./build/dependencies/src/posix_time.c",
+			"./build/dependencies/src/posix_thread.c",
+			"./build/dependencies/src/posix_module.c",
+			"./build/dependencies/src/posix_poll.c",
+		}
+		links {
+			"m",
+			"dl",
+			"pthread"
+		}
+
+-- OBJ to binary mesh converter, CPU only so it needs no GLFW
+project "obj2mesh"
+    kind "ConsoleApp"
+    language "C"
+    targetdir "%{wks.location}/build/bin"
+    objdir "%{wks.location}/build/bin-int"
+    location "%{wks.location}/build/scripts"
+
+	files {
+		"tools/obj2mesh.c",
+		"./build/dependencies/src/glad.c",
+    }
+
+	includedirs { include_dirs }
+
+	filter "configurations:Release or Profile"
+		optimize "On"
+
+	filter "system:windows"
+		defines {
+			"_CRT_SECURE_NO_WARNINGS"
+		}
+
+	filter "system:linux"
+		links {
+			"m",
+			"dl"
+		}
+
+-- CPU tests, no GL context needed; the llama kernels are built once per SIMD level
+project "opengl-tests"
+    kind "ConsoleApp"
+    language "C"
+    targetdir "%{wks.location}/build/bin"
+    objdir "%{wks.location}/build/bin-int"
+    location "%{wks.location}/build/scripts"
+
+	files {
+		"tests/**.c",
+		"tests/**.h",
+		"./build/dependencies/src/glad.c",
+    }
+
+	includedirs { include_dirs }
+
+	filter "configurations:Release or Profile"
+		optimize "On"
+
+	filter { "files:tests/llama_avx.c", "system:windows" }
+		buildoptions { "/arch:AVX" }
+
+	filter { "files:tests/llama_avx.c", "system:not windows" }
+		buildoptions { "-mavx" }
+
+	filter "system:windows"
+		defines {
+			"_CRT_SECURE_NO_WARNINGS"
+		}
+
+	filter "system:linux"
+		links {
+			"m",
+			"dl",
+			"pthread"
 		}
-    
\ No newline at end of file
@@ -2,9 +2,19 @@
  * If you're going to implement glxt in the file where you include glfw,
  * you should include glxt and create the implentation first then you include glfw
  */
-#define GLXT_IMPLENTATION 
+#define GLXT_IMPLEMENTATION
 #define GLXT_WITH_IO_HELPER 1
 #include "glxt.h"
+#define GLXT_LOADER_IMPLEMENTATION
+#include "glxt_loader.h"
+#define GLXT_ATLAS_IMPLEMENTATION
+#include "glxt_atlas.h"
+#define GLXT_PROFILER_IMPLEMENTATION
+#include "glxt_profiler.h"
+#define GLXT_FRAME_IMPLEMENTATION
+#include "glxt_frame.h"
+#define GLXT_TEXT_IMPLEMENTATION
+#include "glxt_text.h"
 
 #include <GLFW/glfw3.h>
 #include <stdio.h>
@@ -15,6 +25,13 @@
 #define WINDOW_TITLE "OpenGL Template"
 #define VERT_SHADER_SOURCE_PATH "./src/main.vert"
 #define FRAG_SHADER_SOURCE_PATH "./src/main.frag"
+#define LOADER_WORKERS 2
+#define LOADER_BUDGET_SECONDS 0.002
+#define PROFILER_TRACE_PATH "./trace.json"
+#define SIMULATION_HZ 60.0
+#define TARGET_FPS 60.0
+#define SWAP_INTERVAL 1
+#define HUD_TEXT_SIZE 16.0f
 
 #define GLXT_CHECK_ERROR() do {\
     if(glxt_has_failure()) { \
@@ -23,19 +40,33 @@
     } \
 } while(0)
 
-typedef struct {
-    struct { float x, y; } pos;
-    struct { float r, g, b, a; } color;
-} Vertex;
-
 #define MAXIMUM_VERTICES 1000
-static Vertex vertices[MAXIMUM_VERTICES] = {
+static const GLXTBatchVertex triangle[3] = {
     { .pos = { .x =  0.0f, .y =  0.5f }, .color = { 0.5f, 0.2f, 0.8f, 1.0f } },
     { .pos = { .x = -0.5f, .y = -0.5f }, .color = { 0.2f, 0.8f, 0.5f, 1.0f } },
     { .pos = { .x =  0.5f, .y = -0.5f }, .color = { 0.8f, 0.5f, 0.2f, 1.0f } },
-    // { .pos = { .x = 0.0f, .y = 1.0f }, .color = { 0.2f, 0.5f, 0.8f, 1.0f } },
 };
-static size_t vertices_count = 3;
+
+static const float hud_color[4] = { 1.0f, 1.0f, 1.0f, 0.8f };
+
+static uint32_t shader_program = 0;
+static GLXTUniform u_random_number = 0;
+
+static void on_shader_program_loaded(const GLXTLoadResult* result,
+    const GLXTLoadPayload* payload, void* user_data)
+{
+    // The pump reports the job's failure through GLXT too, glxt_failure_reason describes it
+    if(!result->ok) {
+        fprintf(stderr, "Failed to load the shader program: %s\n", glxt_failure_reason());
+        exit(EXIT_FAILURE);
+    }
+    shader_program = result->handle;
+    u_random_number = glxt_get_shader_uniform(shader_program, "u_random_number");
+    if(u_random_number == 0) {
+        fprintf(stderr, "%s\n", glxt_failure_reason());
+        exit(EXIT_FAILURE);
+    }
+}
 
 int main(int argc, char** argv)
 {
@@ -58,60 +89,106 @@ int main(int argc, char** argv)
     glfwMakeContextCurrent(window);
     gladLoadGLES2Loader((GLADloadproc)glfwGetProcAddress);
 
-    uint32_t vao = glxt_create_vertex_array();
-    glxt_enable_vertex_array(vao);
-
-    FILE* vf = fopen(VERT_SHADER_SOURCE_PATH, "r");
-    if(vf == NULL) {
-        fprintf(stderr, "%s\n", "Failed to open vertex shader source file");
-        exit(EXIT_FAILURE);
-    }
-
-    FILE* ff = fopen(FRAG_SHADER_SOURCE_PATH, "r");
-    if(vf == NULL) {
-        fprintf(stderr, "%s\n", "Failed to open fragment shader source file");
-        exit(EXIT_FAILURE);
-    }
-
-    size_t vfsize = glxt_get_file_size(vf);
-    size_t ffsize = glxt_get_file_size(ff);
-    char* vert_source = malloc(sizeof(char) * vfsize);
-    char* frag_source = malloc(sizeof(char) * ffsize);
-
-    glxt_read_file_data(vf, vert_source);
+    glxt_batch_init(MAXIMUM_VERTICES);
     GLXT_CHECK_ERROR();
 
-    glxt_read_file_data(ff, frag_source);
+    glxt_loader_init(LOADER_WORKERS);
     GLXT_CHECK_ERROR();
 
-    uint32_t shader_program =  glxt_create_shader_program(vert_source, frag_source);
+    GLXT_PROFILER_INIT();
+
+    GLXTFont hud_font;
+    GLXTTextRenderer hud;
+    glxt_font_init(&hud_font, &(GLXTFontDesc){ .sdf = true });
+    glxt_text_renderer_init(&hud);
     GLXT_CHECK_ERROR();
 
-    uint32_t vbo = glxt_create_vertex_buffer(MAXIMUM_VERTICES, (const void*)vertices);
-    glxt_enable_vertex_buffer(vbo);
-    glxt_set_vertex_attrib(0, 2, GL_FLOAT, false, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-    glxt_set_vertex_attrib(1, 4, GL_FLOAT, false, sizeof(Vertex), (const void*)offsetof(Vertex, color));
+    GLXTFrameLoopDesc frame_desc = {
+        .simulation_hz = SIMULATION_HZ,
+        .target_fps = TARGET_FPS,
+        .swap_interval = SWAP_INTERVAL,
+    };
+    GLXTFrameLoop frame_loop;
+    glxt_frame_loop_init(&frame_loop, &frame_desc);
+
+    GLXTLoadRequest shader_request = {
+        .kind = GLXT_LOAD_SHADER_PROGRAM,
+        .paths = { VERT_SHADER_SOURCE_PATH, FRAG_SHADER_SOURCE_PATH },
+        .done = on_shader_program_loaded,
+    };
+    glxt_loader_submit(&shader_request);
+    GLXT_CHECK_ERROR();
 
     float a = 0.0f;
-    float velocity = 0.01f;
+    float previous_a = 0.0f;
+    float velocity = 0.6f;
 
     while(!glfwWindowShouldClose(window)) {
+        GLXT_PROFILE_FRAME_BEGIN();
         glfwPollEvents();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glxt_enable_shader_program(shader_program);
 
-        glxt_set_shader_uniform(shader_program, "u_random_color", 
-        (const void*)&a, GLXT_SHADER_UNIFORM_FLOAT, 1);
+        int steps = glxt_frame_loop_begin(&frame_loop);
+        while(steps-- > 0) {
+            previous_a = a;
+            a += velocity * (float)frame_loop.step_seconds;
+            if(a >= 1.0f || a <= 0.0f)
+                velocity *= -1;
+        }
 
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 3);
-        glfwSwapBuffers(window);
+        GLXT_PROFILE_BEGIN("loader");
+        glxt_loader_pump(LOADER_BUDGET_SECONDS);
+        GLXT_PROFILE_END();
 
-        a += velocity;
-        if(a >= 1.0f || a <= 0.0f)
-            velocity *= -1;
+        GLXT_PROFILE_BEGIN("render");
+        GLXT_PROFILE_GPU_BEGIN("render");
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if(shader_program != 0) {
+            float alpha = glxt_frame_loop_alpha(&frame_loop);
+            float rendered_a = previous_a + (a - previous_a) * alpha;
+            glxt_enable_shader_program(shader_program);
+            glxt_set_uniform(u_random_number, (const void*)&rendered_a, 1);
+
+            glxt_batch_begin();
+            glxt_batch_set_material(shader_program, 0);
+            glxt_batch_push_vertices(GLXT_BATCH_TRIANGLES, triangle, 3);
+            glxt_batch_end();
+        }
+
+        // The title stays cached, only the frame time after it is shaped again
+        int width = 0, height = 0;
+        char frame_text[64];
+        size_t last = (frame_loop.history_index + GLXT_FRAME_LOOP_HISTORY - 1) % GLXT_FRAME_LOOP_HISTORY;
+        glfwGetWindowSize(window, &width, &height);
+        snprintf(frame_text, sizeof(frame_text), "%.2f ms", frame_loop.frame_seconds[last] * 1000.0);
+        glxt_text_begin(&hud);
+        glxt_text_add(&hud, &hud_font, WINDOW_TITLE, 8.0f, 8.0f, HUD_TEXT_SIZE, hud_color);
+        glxt_text_add(&hud, &hud_font, frame_text, 8.0f, 8.0f + HUD_TEXT_SIZE, HUD_TEXT_SIZE, hud_color);
+        glxt_text_draw(&hud, (uint32_t)width, (uint32_t)height);
+        GLXT_PROFILE_GPU_END();
+        GLXT_PROFILE_END();
+
+        GLXT_PROFILE_BEGIN("swap");
+        glfwSwapBuffers(window);
+        GLXT_PROFILE_END();
+        glxt_frame_loop_end(&frame_loop);
+        GLXT_PROFILE_FRAME_END();
     }
 
-    glxt_destroy_vertex_array(vao);
+    GLXTFrameLoopStats frame_stats = glxt_frame_loop_stats(&frame_loop);
+    printf("frames: %zu, %.1f fps, frame p99 %.2f ms, latency mean %.2f ms p99 %.2f ms\n",
+        frame_stats.frames, frame_stats.fps, frame_stats.frame_ms_p99,
+        frame_stats.latency_ms_mean, frame_stats.latency_ms_p99);
+    glxt_frame_loop_deinit(&frame_loop);
+
+    GLXT_PROFILER_EXPORT(PROFILER_TRACE_PATH);
+    GLXT_PROFILER_DEINIT();
+    glxt_loader_deinit();
+    glxt_text_renderer_deinit(&hud);
+    glxt_font_deinit(&hud_font);
+    glxt_batch_deinit();
+    glxt_scratch_deinit();
+    if(shader_program != 0) glxt_destroy_shader_program(shader_program);
 
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -0,0 +1,4 @@
+// Built with AVX enabled (-mavx, /arch:AVX), only called when the CPU has it
+#define LLAMA_KERNELS_NAME "avx"
+#define LLAMA_KERNELS_TABLE llama_avx_kernels
+#include "llama_kernels.h"
@@ -0,0 +1,47 @@
+/**
+ * The batch kernels of llama.h, compiled once per SIMD level so the tests
+ * can run them side by side: llama_scalar.c with LLAMA_NO_SIMD,
+ * llama_sse.c with the default flags and llama_avx.c with AVX enabled.
+ */
+#ifndef LLAMA_KERNELS_H
+#define LLAMA_KERNELS_H
+
+#include <llama.h>
+#include <stddef.h>
+
+typedef struct LlamaKernels {
+    const char* name;
+    void (*dot_array)(const mat4_t* a, const mat4_t* b, mat4_t* dst, size_t count);
+    void (*inverse_array)(const mat4_t* src, mat4_t* dst, size_t count);
+    void (*transform_vec4_array)(mat4_t m, const vec4_t* src, vec4_t* dst, size_t count);
+    void (*transform_vec3_array)(mat4_t m, const vec3_t* src, vec3_t* dst, size_t count);
+} LlamaKernels;
+
+extern const LlamaKernels llama_scalar_kernels;
+extern const LlamaKernels llama_sse_kernels;
+extern const LlamaKernels llama_avx_kernels;
+
+#endif // LLAMA_KERNELS_H
+
+// Included again by each kernel file with LLAMA_KERNELS_NAME and _TABLE defined
+#if defined(LLAMA_KERNELS_TABLE)
+
+static void kernels_dot_array(const mat4_t* a, const mat4_t* b, mat4_t* dst, size_t count)
+{
+    mat4_dot_array(a, b, dst, count);
+}
+
+static void kernels_inverse_array(const mat4_t* src, mat4_t* dst, size_t count)
+{
+    for(size_t i = 0; i < count; ++i) dst[i] = mat4_inverse(src[i]);
+}
+
+const LlamaKernels LLAMA_KERNELS_TABLE = {
+    LLAMA_KERNELS_NAME,
+    kernels_dot_array,
+    kernels_inverse_array,
+    mat4_transform_vec4_array,
+    mat4_transform_vec3_array,
+};
+
+#endif
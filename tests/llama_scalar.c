@@ -0,0 +1,4 @@
+#define LLAMA_NO_SIMD
+#define LLAMA_KERNELS_NAME "scalar"
+#define LLAMA_KERNELS_TABLE llama_scalar_kernels
+#include "llama_kernels.h"
@@ -0,0 +1,3 @@
+#define LLAMA_KERNELS_NAME "sse"
+#define LLAMA_KERNELS_TABLE llama_sse_kernels
+#include "llama_kernels.h"
@@ -0,0 +1,572 @@
+/**
+ * CPU tests.
+ * Checks what needs no GL context: the SIMD kernels of llama.h against
+ * its scalar code, the handle bookkeeping of glxt_transform, the mesh
+ * optimizations of glxt_mesh, the OBJ conversion of obj2mesh, the
+ * shader preprocessor of glxt_shader and the steady state of the
+ * glxt_allocator allocators. Prints one line per failed check and a summary, and exits
+ * non-zero when anything failed.
+ *
+ * usage: opengl-tests
+ */
+#define GLXT_IMPLEMENTATION
+#include "glxt.h"
+#define GLXT_TRANSFORM_IMPLEMENTATION
+#include "glxt_transform.h"
+#define GLXT_ALLOCATOR_IMPLEMENTATION
+#include "glxt_allocator.h"
+#define GLXT_SHADER_IMPLEMENTATION
+#include "glxt_shader.h"
+#define OBJ2MESH_NO_MAIN
+#include "../tools/obj2mesh.c"
+
+#include "llama_kernels.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LLAMA_TEST_MATRICES 4096
+// Relative to the larger magnitude, absolute below 1
+#define LLAMA_TEST_TOLERANCE 1e-4f
+
+static size_t checks_count = 0;
+static size_t failures_count = 0;
+
+#define CHECK(CONDITION, ...) do { \
+    checks_count += 1; \
+    if(!(CONDITION)) { \
+        failures_count += 1; \
+        printf("%s:%d: %s: ", __FILE__, __LINE__, #CONDITION); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while(0)
+
+static float test_random(float low, float high)
+{
+    return low + (high - low) * ((float)rand() / (float)RAND_MAX);
+}
+
+static bool test_close(float a, float b)
+{
+    float magnitude = fabsf(a) > fabsf(b) ? fabsf(a) : fabsf(b);
+    if(magnitude < 1.0f) magnitude = 1.0f;
+    return fabsf(a - b) <= LLAMA_TEST_TOLERANCE * magnitude;
+}
+
+// Index of the first element further apart than the tolerance, -1 when all match
+static long test_compare(const float* a, const float* b, size_t count)
+{
+    for(size_t i = 0; i < count; ++i) {
+        if(!test_close(a[i], b[i])) return (long)i;
+    }
+    return -1;
+}
+
+// Rotation, scale and translation, so the inverse is well conditioned
+static mat4_t test_random_affine(void)
+{
+    mat4_t scale = mat4_scale(vec3(test_random(0.5f, 2.0f), test_random(0.5f, 2.0f), test_random(0.5f, 2.0f)));
+    mat4_t rotation = mat4_euler_xyz(test_random(-3.0f, 3.0f), test_random(-3.0f, 3.0f), test_random(-3.0f, 3.0f));
+    mat4_t translation = mat4_translation(vec3(test_random(-50.0f, 50.0f), test_random(-50.0f, 50.0f),
+        test_random(-50.0f, 50.0f)));
+    return mat4_dot(mat4_dot(scale, rotation), translation);
+}
+
+static bool test_has_avx(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx");
+#else
+    return true;
+#endif
+}
+
+static void test_llama_kernels(const LlamaKernels* simd)
+{
+    const LlamaKernels* scalar = &llama_scalar_kernels;
+    mat4_t* a = malloc(sizeof(mat4_t) * LLAMA_TEST_MATRICES);
+    mat4_t* b = malloc(sizeof(mat4_t) * LLAMA_TEST_MATRICES);
+    mat4_t* expected = malloc(sizeof(mat4_t) * LLAMA_TEST_MATRICES);
+    mat4_t* actual = malloc(sizeof(mat4_t) * LLAMA_TEST_MATRICES);
+    vec4_t* points = malloc(sizeof(vec4_t) * LLAMA_TEST_MATRICES);
+    vec4_t* expected_points = malloc(sizeof(vec4_t) * LLAMA_TEST_MATRICES);
+    vec4_t* actual_points = malloc(sizeof(vec4_t) * LLAMA_TEST_MATRICES);
+    vec3_t* positions = malloc(sizeof(vec3_t) * LLAMA_TEST_MATRICES);
+    vec3_t* expected_positions = malloc(sizeof(vec3_t) * LLAMA_TEST_MATRICES);
+    vec3_t* actual_positions = malloc(sizeof(vec3_t) * LLAMA_TEST_MATRICES);
+    if(a == NULL || b == NULL || expected == NULL || actual == NULL || points == NULL || expected_points == NULL
+        || actual_points == NULL || positions == NULL || expected_positions == NULL || actual_positions == NULL) {
+        CHECK(false, "out of memory");
+        return;
+    }
+
+    srand(9);
+    for(size_t i = 0; i < LLAMA_TEST_MATRICES; ++i) {
+        for(size_t j = 0; j < 16; ++j) {
+            a[i].elements[j] = test_random(-10.0f, 10.0f);
+            b[i].elements[j] = test_random(-10.0f, 10.0f);
+        }
+        points[i] = vec4(test_random(-100.0f, 100.0f), test_random(-100.0f, 100.0f),
+            test_random(-100.0f, 100.0f), test_random(-2.0f, 2.0f));
+        positions[i] = vec3(test_random(-100.0f, 100.0f), test_random(-100.0f, 100.0f), test_random(-100.0f, 100.0f));
+    }
+
+    long mismatch = 0;
+    scalar->dot_array(a, b, expected, LLAMA_TEST_MATRICES);
+    simd->dot_array(a, b, actual, LLAMA_TEST_MATRICES);
+    mismatch = test_compare(expected[0].elements, actual[0].elements, LLAMA_TEST_MATRICES * 16);
+    CHECK(mismatch < 0, "%s mat4_dot_array, matrix %ld element %ld", simd->name, mismatch / 16, mismatch % 16);
+
+    for(size_t i = 0; i < LLAMA_TEST_MATRICES; ++i) a[i] = test_random_affine();
+    scalar->inverse_array(a, expected, LLAMA_TEST_MATRICES);
+    simd->inverse_array(a, actual, LLAMA_TEST_MATRICES);
+    mismatch = test_compare(expected[0].elements, actual[0].elements, LLAMA_TEST_MATRICES * 16);
+    CHECK(mismatch < 0, "%s mat4_inverse, matrix %ld element %ld", simd->name, mismatch / 16, mismatch % 16);
+
+    scalar->transform_vec4_array(a[0], points, expected_points, LLAMA_TEST_MATRICES);
+    simd->transform_vec4_array(a[0], points, actual_points, LLAMA_TEST_MATRICES);
+    mismatch = test_compare(expected_points[0].elements, actual_points[0].elements, LLAMA_TEST_MATRICES * 4);
+    CHECK(mismatch < 0, "%s mat4_transform_vec4_array, vector %ld", simd->name, mismatch / 4);
+
+    scalar->transform_vec3_array(a[1], positions, expected_positions, LLAMA_TEST_MATRICES);
+    simd->transform_vec3_array(a[1], positions, actual_positions, LLAMA_TEST_MATRICES);
+    mismatch = test_compare(expected_positions[0].elements, actual_positions[0].elements, LLAMA_TEST_MATRICES * 3);
+    CHECK(mismatch < 0, "%s mat4_transform_vec3_array, vector %ld", simd->name, mismatch / 3);
+
+    free(a);
+    free(b);
+    free(expected);
+    free(actual);
+    free(points);
+    free(expected_points);
+    free(actual_points);
+    free(positions);
+    free(expected_positions);
+    free(actual_positions);
+}
+
+static bool test_translated(const mat4_t* world, float x, float y, float z)
+{
+    return world != NULL && test_close(world->elements[12], x) && test_close(world->elements[13], y)
+        && test_close(world->elements[14], z);
+}
+
+// Two destroys before one update: the second must not free the handles
+// of rows the first killed, one of them may already be reused
+static void test_transform_destroy(void)
+{
+    GLXTTransformHierarchy hierarchy;
+    if(!glxt_transform_hierarchy_init(&hierarchy, 0, 0)) {
+        CHECK(false, "glxt_transform_hierarchy_init: %s", glxt_failure_reason());
+        return;
+    }
+
+    GLXTTransformNode a = glxt_transform_create(&hierarchy, 0);
+    GLXTTransformNode b = glxt_transform_create(&hierarchy, a);
+    GLXTTransformNode c = glxt_transform_create(&hierarchy, a);
+    GLXTTransformNode d = glxt_transform_create(&hierarchy, b);
+    glxt_transform_set_position(&hierarchy, a, vec3(1.0f, 0.0f, 0.0f));
+    glxt_transform_set_position(&hierarchy, b, vec3(0.0f, 2.0f, 0.0f));
+    glxt_transform_update(&hierarchy);
+
+    glxt_transform_destroy(&hierarchy, c);
+    GLXTTransformNode e = glxt_transform_create(&hierarchy, b);
+    CHECK(e == c, "the freed handle %u is reused, got %u", c, e);
+    glxt_transform_set_position(&hierarchy, e, vec3(0.0f, 0.0f, 3.0f));
+    glxt_transform_destroy(&hierarchy, d);
+    glxt_transform_update(&hierarchy);
+
+    CHECK(glxt_transform_world(&hierarchy, d) == NULL, "destroyed node %u still has a world matrix", d);
+    CHECK(test_translated(glxt_transform_world(&hierarchy, e), 1.0f, 2.0f, 3.0f),
+        "node %u created between two destroys lost its transform", e);
+    GLXTTransformStats stats = glxt_transform_stats(&hierarchy);
+    CHECK(stats.nodes == 3, "%zu nodes left, expected 3", stats.nodes);
+
+    // Handle e must not be on the free list, the next creates get d then a new one
+    GLXTTransformNode f = glxt_transform_create(&hierarchy, 0);
+    GLXTTransformNode g = glxt_transform_create(&hierarchy, 0);
+    CHECK(f != e && g != e && f != g, "handle %u handed out while live, got %u and %u", e, f, g);
+    glxt_transform_update(&hierarchy);
+    CHECK(test_translated(glxt_transform_world(&hierarchy, e), 1.0f, 2.0f, 3.0f),
+        "node %u moved after unrelated creates", e);
+
+    glxt_transform_hierarchy_deinit(&hierarchy);
+}
+
+#define MESH_TEST_GRID 32
+
+typedef struct MeshTestTriangle {
+    float corners[9];
+} MeshTestTriangle;
+
+static int test_compare_triangles(const void* a, const void* b)
+{
+    return memcmp(a, b, sizeof(MeshTestTriangle));
+}
+
+// Rotated so the smallest corner comes first, which keeps the winding
+static MeshTestTriangle test_canonical_triangle(const float* a, const float* b, const float* c)
+{
+    const float* corners[3] = { a, b, c };
+    size_t first = 0;
+    for(size_t i = 1; i < 3; ++i)
+        if(memcmp(corners[i], corners[first], sizeof(float) * 3) < 0) first = i;
+    MeshTestTriangle triangle;
+    for(size_t i = 0; i < 3; ++i) memcpy(triangle.corners + i * 3, corners[(first + i) % 3], sizeof(float) * 3);
+    return triangle;
+}
+
+static uint32_t test_mesh_index(const GLXTMesh* mesh, size_t i)
+{
+    return mesh->index_type == GL_UNSIGNED_SHORT ? ((const uint16_t*)mesh->indices)[i]
+        : ((const uint32_t*)mesh->indices)[i];
+}
+
+// A grid of quads as an unindexed triangle list, welded and reordered it must draw the same triangles
+static void test_mesh_grid(void)
+{
+    size_t triangles_count = MESH_TEST_GRID * MESH_TEST_GRID * 2;
+    float* positions = malloc(sizeof(float) * 9 * triangles_count);
+    MeshTestTriangle* expected = malloc(sizeof(MeshTestTriangle) * triangles_count);
+    MeshTestTriangle* actual = malloc(sizeof(MeshTestTriangle) * triangles_count);
+    if(positions == NULL || expected == NULL || actual == NULL) {
+        CHECK(false, "out of memory");
+        free(positions);
+        free(expected);
+        free(actual);
+        return;
+    }
+
+    float* corner = positions;
+    for(size_t y = 0; y < MESH_TEST_GRID; ++y) {
+        for(size_t x = 0; x < MESH_TEST_GRID; ++x) {
+            const float quad[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+            for(size_t i = 0; i < 6; ++i, corner += 3) {
+                corner[0] = (float)x + quad[i][0];
+                corner[1] = (float)y + quad[i][1];
+                corner[2] = 0.0f;
+            }
+        }
+    }
+    for(size_t i = 0; i < triangles_count; ++i)
+        expected[i] = test_canonical_triangle(positions + i * 9, positions + i * 9 + 3, positions + i * 9 + 6);
+
+    GLXTMesh mesh;
+    GLXTMeshStats stats;
+    if(!glxt_mesh_build(&mesh, positions, sizeof(float) * 3, triangles_count * 3, NULL, 0, &stats)) {
+        CHECK(false, "glxt_mesh_build: %s", glxt_failure_reason());
+        free(positions);
+        free(expected);
+        free(actual);
+        return;
+    }
+
+    size_t grid_vertices = (MESH_TEST_GRID + 1) * (MESH_TEST_GRID + 1);
+    CHECK(mesh.vertices_count == grid_vertices, "%zu welded vertices, expected %zu", mesh.vertices_count, grid_vertices);
+    CHECK(mesh.indices_count == triangles_count * 3, "%zu indices, expected %zu", mesh.indices_count,
+        triangles_count * 3);
+    CHECK(stats.acmr_after <= stats.acmr_before, "ACMR went from %.3f to %.3f", stats.acmr_before, stats.acmr_after);
+    if(mesh.indices_count == triangles_count * 3) {
+        const float* vertices = mesh.vertices;
+        for(size_t i = 0; i < triangles_count; ++i) {
+            actual[i] = test_canonical_triangle(vertices + test_mesh_index(&mesh, i * 3) * 3,
+                vertices + test_mesh_index(&mesh, i * 3 + 1) * 3, vertices + test_mesh_index(&mesh, i * 3 + 2) * 3);
+        }
+        qsort(expected, triangles_count, sizeof(MeshTestTriangle), test_compare_triangles);
+        qsort(actual, triangles_count, sizeof(MeshTestTriangle), test_compare_triangles);
+        CHECK(memcmp(expected, actual, sizeof(MeshTestTriangle) * triangles_count) == 0,
+            "the welded grid draws different triangles");
+    }
+
+    // Shuffled triangles are the worst case for the post-transform cache
+    size_t indices_count = mesh.indices_count;
+    uint32_t* shuffled = malloc(sizeof(uint32_t) * indices_count);
+    uint32_t* optimized = malloc(sizeof(uint32_t) * indices_count);
+    if(shuffled != NULL && optimized != NULL) {
+        for(size_t i = 0; i < indices_count; ++i) shuffled[i] = test_mesh_index(&mesh, i);
+        srand(15);
+        for(size_t i = indices_count / 3; i-- > 1;) {
+            size_t j = (size_t)rand() % (i + 1);
+            for(size_t k = 0; k < 3; ++k) {
+                uint32_t index = shuffled[i * 3 + k];
+                shuffled[i * 3 + k] = shuffled[j * 3 + k];
+                shuffled[j * 3 + k] = index;
+            }
+        }
+        float before = glxt_mesh_acmr(shuffled, indices_count, mesh.vertices_count, GLXT_MESH_CACHE_SIZE);
+        bool done = glxt_mesh_optimize_vertex_cache(optimized, shuffled, indices_count, mesh.vertices_count);
+        float after = glxt_mesh_acmr(optimized, indices_count, mesh.vertices_count, GLXT_MESH_CACHE_SIZE);
+        CHECK(done && after <= before, "Tipsify took the ACMR of shuffled triangles from %.3f to %.3f", before, after);
+    } else {
+        CHECK(false, "out of memory");
+    }
+
+    free(shuffled);
+    free(optimized);
+    glxt_mesh_free(&mesh);
+    free(positions);
+    free(expected);
+    free(actual);
+}
+
+// Distinct vertices all used by a strip of triangles, built as an indexed mesh
+static bool test_mesh_build_distinct(GLXTMesh* mesh, size_t vertices_count)
+{
+    size_t triangles_count = vertices_count - 2;
+    float* positions = malloc(sizeof(float) * 3 * vertices_count);
+    uint32_t* indices = malloc(sizeof(uint32_t) * 3 * triangles_count);
+    bool built = false;
+    if(positions != NULL && indices != NULL) {
+        for(size_t i = 0; i < vertices_count; ++i) {
+            positions[i * 3] = (float)(i / 2);
+            positions[i * 3 + 1] = (float)(i % 2);
+            positions[i * 3 + 2] = 0.0f;
+        }
+        for(size_t i = 0; i < triangles_count; ++i) {
+            indices[i * 3] = (uint32_t)i;
+            indices[i * 3 + 1] = (uint32_t)i + 1;
+            indices[i * 3 + 2] = (uint32_t)i + 2;
+        }
+        built = glxt_mesh_build(mesh, positions, sizeof(float) * 3, vertices_count, indices, triangles_count * 3, NULL);
+    }
+    free(positions);
+    free(indices);
+    return built;
+}
+
+// 16-bit indices address 0x10000 vertices, one more needs 32-bit indices
+static void test_mesh_index_type(void)
+{
+    CHECK(glxt_mesh_index_type(0x10000) == GL_UNSIGNED_SHORT, "0x10000 vertices do not get 16-bit indices");
+    CHECK(glxt_mesh_index_type(0x10001) == GL_UNSIGNED_INT, "0x10001 vertices get 16-bit indices");
+
+    GLXTMesh mesh;
+    if(test_mesh_build_distinct(&mesh, 0x10000)) {
+        uint32_t largest = 0;
+        for(size_t i = 0; i < mesh.indices_count; ++i)
+            if(test_mesh_index(&mesh, i) > largest) largest = test_mesh_index(&mesh, i);
+        CHECK(mesh.vertices_count == 0x10000 && mesh.index_type == GL_UNSIGNED_SHORT && mesh.index_size == 2,
+            "%zu vertices built with index type 0x%x", mesh.vertices_count, mesh.index_type);
+        CHECK(largest == 0xFFFF, "largest 16-bit index is 0x%x, expected 0xffff", largest);
+        glxt_mesh_free(&mesh);
+    } else {
+        CHECK(false, "glxt_mesh_build of 0x10000 vertices: %s", glxt_failure_reason());
+    }
+    if(test_mesh_build_distinct(&mesh, 0x10001)) {
+        CHECK(mesh.vertices_count == 0x10001 && mesh.index_type == GL_UNSIGNED_INT && mesh.index_size == 4,
+            "%zu vertices built with index type 0x%x", mesh.vertices_count, mesh.index_type);
+        glxt_mesh_free(&mesh);
+    } else {
+        CHECK(false, "glxt_mesh_build of 0x10001 vertices: %s", glxt_failure_reason());
+    }
+}
+
+#define OBJ_TEST_MESH_PATH "./opengl-tests-relative.mesh"
+
+// Two objects whose faces both use relative indices, each must keep its own triangle
+static void test_obj_relative_indices(void)
+{
+    static const char* source =
+        "o first\n"
+        "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+        "f -3 -2 -1\n"
+        "o second\n"
+        "v 5 5 5\nv 6 5 5\nv 5 6 5\n"
+        "f -3 -2 -1\n";
+    static const float expected[6][3] = {
+        { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+        { 5.0f, 5.0f, 5.0f }, { 6.0f, 5.0f, 5.0f }, { 5.0f, 6.0f, 5.0f },
+    };
+
+    if(!convert_obj(source, OBJ_TEST_MESH_PATH, false, false)) {
+        CHECK(false, "convert_obj: %s", glxt_failure_reason());
+        return;
+    }
+    GLXTMeshFile file;
+    if(!glxt_mesh_file_open(&file, OBJ_TEST_MESH_PATH)) {
+        CHECK(false, "glxt_mesh_file_open: %s", glxt_failure_reason());
+        remove(OBJ_TEST_MESH_PATH);
+        return;
+    }
+
+    const GLXTMeshFileHeader* header = file.header;
+    CHECK(header->indices_count == 6, "%llu indices, expected 6", (unsigned long long)header->indices_count);
+    CHECK(header->vertices_count == 6, "%llu vertices, expected 6", (unsigned long long)header->vertices_count);
+    for(size_t i = 0; i < 6 && header->vertex_size == sizeof(float) * 3; ++i) {
+        bool found = false;
+        for(size_t v = 0; v < header->vertices_count && !found; ++v) {
+            const float* position = (const float*)file.vertices + v * 3;
+            found = memcmp(position, expected[i], sizeof(expected[i])) == 0;
+        }
+        CHECK(found, "vertex %g %g %g lost in the conversion", expected[i][0], expected[i][1], expected[i][2]);
+    }
+
+    glxt_mesh_file_close(&file);
+    remove(OBJ_TEST_MESH_PATH);
+}
+
+#define SHADER_TEST_CHAIN_LENGTH (GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH + 1)
+
+// Include chain[0] of a table where every entry includes the next one and the last is plain code
+static char* test_shader_chain(size_t length)
+{
+    static char names[SHADER_TEST_CHAIN_LENGTH][32];
+    static char sources[SHADER_TEST_CHAIN_LENGTH][48];
+    GLXTShaderInclude includes[SHADER_TEST_CHAIN_LENGTH];
+    for(size_t i = 0; i < length; ++i) {
+        snprintf(names[i], sizeof(names[i]), "chain%zu", i);
+        if(i + 1 < length) snprintf(sources[i], sizeof(sources[i]), "#include \"chain%zu\"\n", i + 1);
+        else snprintf(sources[i], sizeof(sources[i]), "float leaf;\n");
+        includes[i] = (GLXTShaderInclude){ names[i], sources[i] };
+    }
+    return glxt_shader_preprocess("#include \"chain0\"\n", NULL, 0, includes, length);
+}
+
+static void test_shader_preprocess(void)
+{
+    static const GLXTShaderInclude includes[] = {
+        { "common.glsl", "vec3 tint(vec3 c) { return c * 0.5; }\n#include <inner.glsl>" },
+        { "inner.glsl", "float inner;" },
+    };
+    static const GLXTShaderDefine defines[] = { { "LIGHTS", "4" }, { "SHADOWS", NULL } };
+
+    // Nested includes are expanded in place, each ends its line
+    char* text = glxt_shader_preprocess("#version 330 core\n  #include \"common.glsl\"\nvoid main() {}\n",
+        NULL, 0, includes, 2);
+    CHECK(text != NULL && strcmp(text,
+        "#version 330 core\n"
+        "vec3 tint(vec3 c) { return c * 0.5; }\n"
+        "float inner;\n"
+        "void main() {}\n") == 0, "includes expanded to [%s]", text != NULL ? text : glxt_failure_reason());
+    free(text);
+
+    GLXT.last_failure = GLXT_NO_ERROR;
+    text = glxt_shader_preprocess("#include \"missing.glsl\"\n", NULL, 0, includes, 2);
+    CHECK(text == NULL && GLXT.last_failure == GLXT_SHADER_INCLUDE_NOT_FOUND, "missing include: %s",
+        glxt_failure_reason());
+    free(text);
+
+    // The source itself is depth 0, so a chain of GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH includes still fits
+    GLXT.last_failure = GLXT_NO_ERROR;
+    text = test_shader_chain(GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH);
+    CHECK(text != NULL && strcmp(text, "float leaf;\n") == 0, "%d nested includes: %s",
+        GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH, text != NULL ? text : glxt_failure_reason());
+    free(text);
+    text = test_shader_chain(GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH + 1);
+    CHECK(text == NULL && GLXT.last_failure == GLXT_SHADER_INCLUDE_TOO_DEEP, "%d nested includes: %s",
+        GLXT_SHADER_MAXIMUM_INCLUDE_DEPTH + 1, glxt_failure_reason());
+    free(text);
+    GLXT.last_failure = GLXT_NO_ERROR;
+
+    // #version has to stay the first line, defines follow it or open a source without one
+    text = glxt_shader_preprocess("\n#version 330 core\nvoid main() {}\n", defines, 2, NULL, 0);
+    CHECK(text != NULL && strcmp(text,
+        "\n#version 330 core\n"
+        "#define LIGHTS 4\n"
+        "#define SHADOWS\n"
+        "void main() {}\n") == 0, "defines after #version: [%s]", text != NULL ? text : glxt_failure_reason());
+    free(text);
+    text = glxt_shader_preprocess("#version 330", defines, 1, NULL, 0);
+    CHECK(text != NULL && strcmp(text, "#version 330\n#define LIGHTS 4\n") == 0,
+        "defines after a last line #version: [%s]", text != NULL ? text : glxt_failure_reason());
+    free(text);
+    text = glxt_shader_preprocess("void main() {}\n", defines, 1, NULL, 0);
+    CHECK(text != NULL && strcmp(text, "#define LIGHTS 4\nvoid main() {}\n") == 0,
+        "defines without #version: [%s]", text != NULL ? text : glxt_failure_reason());
+    free(text);
+}
+
+#define ALLOCATOR_TEST_WARMUP_FRAMES 8
+#define ALLOCATOR_TEST_FRAMES 32
+#define ALLOCATOR_TEST_POOL_ELEMENTS 512
+
+// A frame of transient data, its size cycles over 4 frames
+static bool test_allocator_frame(GLXTFrameArena* arena, GLXTPool* pool, void** live, size_t frame)
+{
+    size_t blocks = (frame % 4 + 1) * 100;
+    for(size_t i = 0; i < blocks; ++i) {
+        uint8_t* block = glxt_frame_arena_alloc(arena, 64, 0);
+        if(block == NULL) return false;
+        memset(block, (int)i, 64);
+    }
+    if(glxt_frame_arena_alloc(arena, 1024, 256) == NULL) return false;
+
+    // Half of the elements die and are replaced every frame
+    for(size_t i = frame % 2; i < ALLOCATOR_TEST_POOL_ELEMENTS; i += 2) {
+        if(live[i] != NULL) glxt_pool_free(pool, live[i]);
+        live[i] = glxt_pool_alloc(pool);
+        if(live[i] == NULL) return false;
+    }
+
+    void* scratch = glxt_scratch_alloc(4096);
+    if(scratch == NULL) return false;
+    glxt_scratch_free(scratch);
+
+    glxt_frame_arena_swap(arena);
+    return true;
+}
+
+// After warm-up, frames of the same sizes must not touch the heap
+static void test_allocator_steady_state(void)
+{
+    GLXTFrameArena arena;
+    GLXTPool pool;
+    void* live[ALLOCATOR_TEST_POOL_ELEMENTS] = {0};
+    if(!glxt_frame_arena_init(&arena, 1024) || !glxt_pool_init(&pool, 48, 128)) {
+        CHECK(false, "allocator init: %s", glxt_failure_reason());
+        return;
+    }
+
+    bool ok = true;
+    size_t frame = 0;
+    for(; frame < ALLOCATOR_TEST_WARMUP_FRAMES && ok; ++frame) ok = test_allocator_frame(&arena, &pool, live, frame);
+    GLXTAllocatorStats arena_warm = glxt_frame_arena_stats(&arena);
+    GLXTAllocatorStats pool_warm = glxt_pool_stats(&pool);
+    GLXTAllocatorStats scratch_warm = glxt_scratch_stats();
+    for(; frame < ALLOCATOR_TEST_FRAMES && ok; ++frame) ok = test_allocator_frame(&arena, &pool, live, frame);
+    CHECK(ok, "allocation failed in frame %zu: %s", frame, glxt_failure_reason());
+
+    GLXTAllocatorStats arena_stats = glxt_frame_arena_stats(&arena);
+    GLXTAllocatorStats pool_stats = glxt_pool_stats(&pool);
+    GLXTAllocatorStats scratch_stats = glxt_scratch_stats();
+    CHECK(arena_stats.heap_allocations == arena_warm.heap_allocations,
+        "frame arena heap allocations %zu -> %zu after warm-up", arena_warm.heap_allocations,
+        arena_stats.heap_allocations);
+    CHECK(pool_stats.heap_allocations == pool_warm.heap_allocations,
+        "pool heap allocations %zu -> %zu after warm-up", pool_warm.heap_allocations, pool_stats.heap_allocations);
+    CHECK(scratch_stats.heap_allocations == scratch_warm.heap_allocations,
+        "scratch heap allocations %zu -> %zu after warm-up", scratch_warm.heap_allocations,
+        scratch_stats.heap_allocations);
+    CHECK(pool_stats.bytes_in_use == ALLOCATOR_TEST_POOL_ELEMENTS * pool.element_size,
+        "pool holds %zu bytes, expected %zu", pool_stats.bytes_in_use,
+        (size_t)ALLOCATOR_TEST_POOL_ELEMENTS * pool.element_size);
+
+    printf("frame arena: %zu allocations, high water %zu, %zu heap allocations\n",
+        arena_stats.allocations, arena_stats.high_water, arena_stats.heap_allocations);
+    printf("pool: %zu allocations, high water %zu, %zu heap allocations\n",
+        pool_stats.allocations, pool_stats.high_water, pool_stats.heap_allocations);
+    printf("scratch: %zu allocations, high water %zu, %zu heap allocations\n",
+        scratch_stats.allocations, scratch_stats.high_water, scratch_stats.heap_allocations);
+
+    for(size_t i = 0; i < ALLOCATOR_TEST_POOL_ELEMENTS; ++i) glxt_pool_free(&pool, live[i]);
+    glxt_pool_deinit(&pool);
+    glxt_frame_arena_deinit(&arena);
+}
+
+int main(int argc, char** argv)
+{
+    test_llama_kernels(&llama_sse_kernels);
+    if(test_has_avx()) test_llama_kernels(&llama_avx_kernels);
+    else printf("skipped the avx kernels, the CPU does not support AVX\n");
+    test_transform_destroy();
+    test_mesh_grid();
+    test_mesh_index_type();
+    test_obj_relative_indices();
+    test_shader_preprocess();
+    test_allocator_steady_state();
+
+    printf("%zu checks, %zu failed\n", checks_count, failures_count);
+    return failures_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
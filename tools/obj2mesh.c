@@ -0,0 +1,305 @@
+/**
+ * Converts a Wavefront OBJ file to the glxt binary mesh format.
+ * Faces are triangulated as fans, vertices are welded and the result is
+ * optimized with glxt_mesh_build before being written.
+ *
+ * Vertex layout, tightly packed floats:
+ *   location 0: vec3 position
+ *   location 1: vec3 normal  (when the file has normals)
+ *   location 2: vec2 uv      (when the file has texture coordinates)
+ *
+ * usage: obj2mesh [--no-normals] [--no-uvs] input.obj output.mesh
+ */
+#define GLXT_IMPLEMENTATION
+#include "glxt.h"
+#define GLXT_MESH_IMPLEMENTATION
+#include "glxt_mesh.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct FloatArray {
+    float* data;
+    size_t count;
+    size_t capacity;
+} FloatArray;
+
+static bool float_array_push(FloatArray* array, const float* values, size_t count)
+{
+    if(array->count + count > array->capacity) {
+        size_t capacity = array->capacity == 0 ? 1024 : array->capacity;
+        while(capacity < array->count + count) capacity *= 2;
+        float* data = realloc(array->data, sizeof(float) * capacity);
+        if(data == NULL) return false;
+        array->data = data;
+        array->capacity = capacity;
+    }
+    memcpy(array->data + array->count, values, sizeof(float) * count);
+    array->count += count;
+    return true;
+}
+
+static const char* skip_spaces(const char* cursor)
+{
+    while(*cursor == ' ' || *cursor == '\t') cursor += 1;
+    return cursor;
+}
+
+static const char* next_line(const char* cursor)
+{
+    while(*cursor != '\0' && *cursor != '\n') cursor += 1;
+    return *cursor == '\n' ? cursor + 1 : cursor;
+}
+
+static size_t parse_floats(const char* cursor, float* values, size_t max_count)
+{
+    size_t count = 0;
+    while(count < max_count) {
+        char* end = NULL;
+        float value = strtof(cursor, &end);
+        if(end == cursor) break;
+        values[count++] = value;
+        cursor = end;
+    }
+    return count;
+}
+
+/**
+ * OBJ indices are 1 based, negative ones count back from the last element
+ * defined before the face, seen of them, out of count in the whole file
+ */
+static bool resolve_index(long index, size_t seen, size_t count, size_t* resolved)
+{
+    if(index > 0 && (size_t)index <= count) {
+        *resolved = (size_t)index - 1;
+        return true;
+    }
+    if(index < 0 && (size_t)(-index) <= seen) {
+        *resolved = seen - (size_t)(-index);
+        return true;
+    }
+    return false;
+}
+
+typedef struct ObjCorner {
+    long position;
+    long uv;
+    long normal;
+} ObjCorner;
+
+static const char* parse_corner(const char* cursor, ObjCorner* corner)
+{
+    char* end = NULL;
+    memset(corner, 0, sizeof(*corner));
+    corner->position = strtol(cursor, &end, 10);
+    if(end == cursor) return NULL;
+    cursor = end;
+    if(*cursor == '/') {
+        cursor += 1;
+        if(*cursor != '/') {
+            corner->uv = strtol(cursor, &end, 10);
+            cursor = end;
+        }
+        if(*cursor == '/') {
+            cursor += 1;
+            corner->normal = strtol(cursor, &end, 10);
+            cursor = end;
+        }
+    }
+    return cursor;
+}
+
+typedef struct ObjData {
+    FloatArray positions;
+    FloatArray normals;
+    FloatArray uvs;
+    FloatArray vertices;
+} ObjData;
+
+// Attributes defined so far, relative indices of a face count back from them
+typedef struct ObjCounts {
+    size_t positions;
+    size_t normals;
+    size_t uvs;
+} ObjCounts;
+
+static bool emit_corner(ObjData* obj, const ObjCorner* corner, const ObjCounts* seen,
+    bool with_normals, bool with_uvs)
+{
+    float vertex[8] = {0};
+    size_t size = 0;
+    size_t index = 0;
+
+    if(!resolve_index(corner->position, seen->positions, obj->positions.count / 3, &index)) return false;
+    memcpy(vertex, obj->positions.data + index * 3, sizeof(float) * 3);
+    size = 3;
+    if(with_normals) {
+        if(corner->normal != 0 && resolve_index(corner->normal, seen->normals, obj->normals.count / 3, &index))
+            memcpy(vertex + size, obj->normals.data + index * 3, sizeof(float) * 3);
+        size += 3;
+    }
+    if(with_uvs) {
+        if(corner->uv != 0 && resolve_index(corner->uv, seen->uvs, obj->uvs.count / 2, &index))
+            memcpy(vertex + size, obj->uvs.data + index * 2, sizeof(float) * 2);
+        size += 2;
+    }
+    return float_array_push(&obj->vertices, vertex, size);
+}
+
+/**
+ * Two passes: the attribute arrays first so the layout is known, then the
+ * faces expanded into an unindexed triangle list. The second pass counts
+ * the attribute lines again so relative indices resolve against what was
+ * defined before each face, not against the whole file.
+ */
+static bool parse_obj(const char* source, ObjData* obj, bool* with_normals, bool* with_uvs)
+{
+    for(const char* line = source; *line != '\0'; line = next_line(line)) {
+        line = skip_spaces(line);
+        float values[3] = {0};
+        if(line[0] == 'v' && line[1] == ' ') {
+            parse_floats(line + 2, values, 3);
+            if(!float_array_push(&obj->positions, values, 3)) return false;
+        } else if(line[0] == 'v' && line[1] == 'n' && line[2] == ' ') {
+            parse_floats(line + 3, values, 3);
+            if(!float_array_push(&obj->normals, values, 3)) return false;
+        } else if(line[0] == 'v' && line[1] == 't' && line[2] == ' ') {
+            parse_floats(line + 3, values, 2);
+            if(!float_array_push(&obj->uvs, values, 2)) return false;
+        }
+    }
+    *with_normals = *with_normals && obj->normals.count > 0;
+    *with_uvs = *with_uvs && obj->uvs.count > 0;
+
+    ObjCounts seen = {0};
+    size_t line_number = 1;
+    for(const char* line = source; *line != '\0'; line = next_line(line), ++line_number) {
+        line = skip_spaces(line);
+        if(line[0] == 'v' && line[1] == ' ') seen.positions += 1;
+        else if(line[0] == 'v' && line[1] == 'n' && line[2] == ' ') seen.normals += 1;
+        else if(line[0] == 'v' && line[1] == 't' && line[2] == ' ') seen.uvs += 1;
+        if(line[0] != 'f' || line[1] != ' ') continue;
+
+        ObjCorner first, previous, corner;
+        const char* cursor = line + 2;
+        size_t corners = 0;
+        while(true) {
+            cursor = skip_spaces(cursor);
+            if(*cursor == '\n' || *cursor == '\r' || *cursor == '\0') break;
+            cursor = parse_corner(cursor, &corner);
+            if(cursor == NULL) {
+                fprintf(stderr, "line %zu: malformed face\n", line_number);
+                return false;
+            }
+            if(corners == 0) first = corner;
+            if(corners >= 2) {
+                if(!emit_corner(obj, &first, &seen, *with_normals, *with_uvs)
+                    || !emit_corner(obj, &previous, &seen, *with_normals, *with_uvs)
+                    || !emit_corner(obj, &corner, &seen, *with_normals, *with_uvs)) {
+                    fprintf(stderr, "line %zu: face index out of range\n", line_number);
+                    return false;
+                }
+            }
+            previous = corner;
+            corners += 1;
+        }
+    }
+    return true;
+}
+
+// Parses an OBJ source, zero terminated, and writes the optimized mesh to output_path
+static bool convert_obj(const char* source, const char* output_path, bool with_normals, bool with_uvs)
+{
+    ObjData obj = {0};
+    bool converted = false;
+    bool parsed = parse_obj(source, &obj, &with_normals, &with_uvs);
+    if(!parsed || obj.vertices.count == 0) {
+        fprintf(stderr, "%s\n", parsed ? "no faces" : "failed to parse");
+        goto cleanup;
+    }
+
+    GLXTMeshAttrib attribs[3];
+    size_t attribs_count = 0;
+    uint32_t floats = 0;
+    attribs[attribs_count++] = (GLXTMeshAttrib){ 0, 3, GL_FLOAT, 0, floats * sizeof(float) };
+    floats += 3;
+    if(with_normals) {
+        attribs[attribs_count++] = (GLXTMeshAttrib){ 1, 3, GL_FLOAT, 0, floats * sizeof(float) };
+        floats += 3;
+    }
+    if(with_uvs) {
+        attribs[attribs_count++] = (GLXTMeshAttrib){ 2, 2, GL_FLOAT, 0, floats * sizeof(float) };
+        floats += 2;
+    }
+
+    GLXTMesh mesh;
+    GLXTMeshStats stats;
+    size_t vertex_size = floats * sizeof(float);
+    if(!glxt_mesh_build(&mesh, obj.vertices.data, vertex_size, obj.vertices.count / floats, NULL, 0, &stats)) {
+        fprintf(stderr, "%s: %s\n", output_path, glxt_failure_reason());
+        goto cleanup;
+    }
+    converted = glxt_mesh_save(&mesh, attribs, attribs_count, output_path);
+    if(converted) {
+        printf("%s: %zu triangles, %zu -> %zu vertices, ACMR %.3f -> %.3f, %s indices\n",
+            output_path, mesh.indices_count / 3, stats.vertices_before, stats.vertices_after,
+            stats.acmr_before, stats.acmr_after, mesh.index_type == GL_UNSIGNED_SHORT ? "16-bit" : "32-bit");
+    } else {
+        fprintf(stderr, "%s: %s\n", output_path, glxt_failure_reason());
+    }
+    glxt_mesh_free(&mesh);
+
+cleanup:
+    free(obj.positions.data);
+    free(obj.normals.data);
+    free(obj.uvs.data);
+    free(obj.vertices.data);
+    return converted;
+}
+
+// tests/tests.c includes this file with OBJ2MESH_NO_MAIN to convert sources in memory
+#ifndef OBJ2MESH_NO_MAIN
+int main(int argc, char** argv)
+{
+    bool with_normals = true;
+    bool with_uvs = true;
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+    bool usage = false;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--no-normals") == 0) with_normals = false;
+        else if(strcmp(argv[i], "--no-uvs") == 0) with_uvs = false;
+        else if(input_path == NULL) input_path = argv[i];
+        else if(output_path == NULL) output_path = argv[i];
+        else usage = true;
+    }
+    if(usage || input_path == NULL || output_path == NULL) {
+        fprintf(stderr, "usage: %s [--no-normals] [--no-uvs] input.obj output.mesh\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    GLXTFileView view = {0};
+    if(!glxt_load_file(input_path, &view)) {
+        fprintf(stderr, "%s: %s\n", input_path, glxt_failure_reason());
+        return EXIT_FAILURE;
+    }
+    // The parser relies on a terminating zero, the file view has none
+    char* source = malloc(view.size + 1);
+    if(source == NULL) {
+        fprintf(stderr, "%s\n", "Out of memory");
+        return EXIT_FAILURE;
+    }
+    memcpy(source, view.data, view.size);
+    source[view.size] = '\0';
+    glxt_release_file(&view);
+
+    if(!convert_obj(source, output_path, with_normals, with_uvs)) {
+        fprintf(stderr, "%s: conversion failed\n", input_path);
+        free(source);
+        return EXIT_FAILURE;
+    }
+    free(source);
+    return EXIT_SUCCESS;
+}
+#endif